@@ -0,0 +1,18 @@
+"""
+Benchmarks de desempenho dos caminhos críticos do sistema DAQ.
+
+Execução: python -m benchmarks (ver __main__) ou pytest benchmarks.
+"""
+
+from .harness import REGISTRY, Benchmark, BenchmarkResult, run, compare, load_baseline, save_baseline
+from . import bench_communication, bench_data
+
+__all__ = [
+    'REGISTRY',
+    'Benchmark',
+    'BenchmarkResult',
+    'run',
+    'compare',
+    'load_baseline',
+    'save_baseline'
+]
@@ -0,0 +1,84 @@
+"""
+Executa os benchmarks e compara com a baseline gravada.
+
+Uso:
+    python -m benchmarks                   # mede e compara com baseline.json
+    python -m benchmarks -k protocol       # apenas benchmarks cujo nome contém 'protocol'
+    python -m benchmarks --save-baseline   # grava os resultados como nova baseline
+    python -m benchmarks --quick           # medição curta (smoke test)
+
+O código de saída é 1 se algum benchmark regrediu além dos limites.
+"""
+
+import argparse
+import json
+import sys
+from pathlib import Path
+
+# Adiciona diretório pai ao path para importações
+sys.path.append(str(Path(__file__).parent.parent))
+
+from benchmarks import REGISTRY, run, compare, load_baseline, save_baseline
+from benchmarks.harness import BASELINE_PATH, format_result, missing_requirements, results_as_dicts
+
+
+def main(argv=None) -> int:
+    """Função principal dos benchmarks."""
+    parser = argparse.ArgumentParser(description="Benchmarks do Sistema DAQ")
+    parser.add_argument("-k", dest="keyword", help="Filtra benchmarks pelo nome")
+    parser.add_argument("--baseline", type=Path, default=BASELINE_PATH, help="Arquivo de baseline")
+    parser.add_argument("--save-baseline", action="store_true",
+                        help="Grava os resultados como baseline em vez de comparar")
+    parser.add_argument("--quick", action="store_true", help="Medição curta (0.05 s por benchmark)")
+    parser.add_argument("--min-time", type=float, help="Tempo mínimo de medição por benchmark (s)")
+    parser.add_argument("--json", type=Path, help="Grava os resultados em JSON")
+    parser.add_argument("--list", action="store_true", help="Lista os benchmarks e sai")
+    args = parser.parse_args(argv)
+
+    selected = [bench for name, bench in sorted(REGISTRY.items())
+                if not args.keyword or args.keyword in name]
+    if args.list:
+        for bench in selected:
+            print(bench.name)
+        return 0
+
+    min_time = args.min_time if args.min_time is not None else (0.05 if args.quick else None)
+    baseline = load_baseline(args.baseline)
+    results = []
+    failures = 0
+
+    for bench in selected:
+        missing = missing_requirements(bench)
+        if missing:
+            print(f"{bench.name:<44} pulado (requer {', '.join(missing)})")
+            continue
+        try:
+            result = run(bench, min_time=min_time)
+        except Exception as e:
+            print(f"Erro no benchmark {bench.name}: {e}")
+            failures += 1
+            continue
+        results.append(result)
+        regressions = [] if args.save_baseline else compare(result, baseline)
+        print(format_result(result, regressions), flush=True)
+        for regression in regressions:
+            print(f"    {regression}")
+        failures += bool(regressions)
+
+    if args.json:
+        with open(args.json, 'w', encoding='utf-8') as f:
+            json.dump(results_as_dicts(results), f, indent=2, ensure_ascii=False)
+
+    if args.save_baseline:
+        save_baseline(results, args.baseline)
+        print(f"Baseline gravada em {args.baseline} ({len(results)} benchmarks)")
+        return 0
+
+    if failures:
+        print(f"{failures} benchmark(s) com regressão ou erro")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
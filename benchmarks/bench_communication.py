@@ -0,0 +1,150 @@
+"""
+Benchmarks do protocolo de comunicação.
+
+Cobre criação e análise de mensagens com payload JSON e colunar binário,
+a compressão de séries temporais (TIMESERIES), a transferência fragmentada,
+o escalonador de ingestão multi-link e o CRC16 do cabeçalho.
+"""
+
+from datetime import datetime
+
+from src.core.config import COMMUNICATION_CONFIG
+from src.core.models import DataPacket
+from src.communication import (
+    ColumnarCodec,
+    CompressionType,
+    DataPacketEncoder,
+    FragmentSender,
+    FrameDecoder,
+    IngestScheduler,
+    LinkManager,
+    MessageProtocol,
+    MessageType,
+    PayloadEncoding,
+    TimeSeriesCodec,
+    TransferReceiver
+)
+from .harness import benchmark, make_readings
+
+
+def _packet(readings_per_packet: int) -> DataPacket:
+    readings = make_readings(readings_per_packet)
+    return DataPacket(packet_id='bench_00000001', sensor_id=readings[0].sensor_id,
+                      readings=readings, timestamp=datetime.now())
+
+
+def _json_payload() -> dict:
+    # Pacote JSON típico do firmware: poucas leituras por mensagem
+    packet = _packet(10)
+    return {
+        'packet_id': packet.packet_id,
+        'sensor_id': packet.sensor_id,
+        'readings': [DataPacketEncoder.encode_strain_reading(r) for r in packet.readings]
+    }
+
+
+def _columnar_payload() -> bytes:
+    limit = COMMUNICATION_CONFIG['max_packet_size']
+    count = ColumnarCodec.max_readings(limit, 'bench_00000001', 'BENCH_000')
+    return ColumnarCodec.encode_packet(_packet(count))
+
+
+@benchmark('protocol.create_message[json]', unit='msgs')
+def create_json(tmp):
+    payload = _json_payload()
+    yield lambda: MessageProtocol.create_message(MessageType.DATA_BATCH, payload)
+
+
+@benchmark('protocol.parse_message[json]', unit='msgs')
+def parse_json(tmp):
+    message = MessageProtocol.create_message(MessageType.DATA_BATCH, _json_payload())
+    yield lambda: MessageProtocol.parse_message(message)
+
+
+@benchmark('protocol.create_message[columnar]', unit='msgs')
+def create_columnar(tmp):
+    payload = _columnar_payload()
+    yield lambda: MessageProtocol.create_message(
+        MessageType.DATA_BATCH, payload, CompressionType.NONE, PayloadEncoding.COLUMNAR
+    )
+
+
+@benchmark('protocol.parse_message[columnar]', unit='msgs')
+def parse_columnar(tmp):
+    message = MessageProtocol.create_message(
+        MessageType.DATA_BATCH, _columnar_payload(), CompressionType.NONE, PayloadEncoding.COLUMNAR
+    )
+    yield lambda: MessageProtocol.parse_message(message)
+
+
+@benchmark('protocol.columnar_encode_packet', items=33, unit='readings')
+def encode_packet(tmp):
+    packet = _packet(33)
+    yield lambda: ColumnarCodec.encode_packet(packet)
+
+
+@benchmark('protocol.timeseries_encode_packet', items=500, unit='readings')
+def timeseries_encode(tmp):
+    packet = _packet(500)
+    yield lambda: TimeSeriesCodec.encode_packet(packet)
+
+
+@benchmark('protocol.timeseries_decode', items=500, unit='readings')
+def timeseries_decode(tmp):
+    payload = TimeSeriesCodec.encode_packet(_packet(500))
+    yield lambda: TimeSeriesCodec.decode(payload)
+
+
+@benchmark('transfer.roundtrip[64KiB]', items=65536, unit='bytes')
+def transfer_roundtrip(tmp):
+    # Fragmentação, enquadramento, remontagem e ACKs em um link sem perdas
+    payload = bytes(range(256)) * 256
+
+    def roundtrip():
+        sender = FragmentSender(MessageType.DATA_BUFFER, payload, mtu=244)
+        receiver = TransferReceiver()
+        decoder = FrameDecoder()
+        now = 0.0
+        while not sender.complete:
+            now += 0.01
+            for message in sender.poll(now):
+                for frame in decoder.feed(message):
+                    ack = receiver.handle(frame, now)
+                    if ack is not None:
+                        sender.on_ack(memoryview(ack)[MessageProtocol.HEADER_SIZE:])
+        return receiver.pop_completed()
+
+    yield roundtrip
+
+
+@benchmark('ingest.scheduler_drain[100 links]', items=100 * 4 * 33, unit='readings')
+def scheduler_drain(tmp):
+    # 100 sensores, 4 pacotes colunares de 33 leituras cada por drenagem
+    manager = LinkManager()
+    scheduler = IngestScheduler(manager, lambda batch: None)
+    messages = []
+    for node in range(100):
+        readings = make_readings(33, prefix=f'NODE{node:03d}')
+        packet = DataPacket(packet_id='bench_00000001', sensor_id=readings[0].sensor_id,
+                            readings=readings, timestamp=datetime.now())
+        messages.append((f'link{node:03d}', DataPacketEncoder.create_batch_message(packet)))
+
+    def drain():
+        for _ in range(4):
+            for address, message in messages:
+                manager.receive(address, message, now=0.0)
+        return scheduler.drain(now=0.0)
+
+    yield drain
+
+
+@benchmark('protocol.crc16[512B]', items=512, unit='bytes')
+def crc16_small(tmp):
+    data = bytes(range(256)) * 2
+    yield lambda: MessageProtocol._calculate_crc16(data)
+
+
+@benchmark('protocol.crc16[8KiB]', items=8192, unit='bytes')
+def crc16_max_payload(tmp):
+    data = bytes(range(256)) * 32
+    yield lambda: MessageProtocol._calculate_crc16(data)
@@ -0,0 +1,231 @@
+"""
+Benchmarks da camada de dados.
+
+Cobre o buffer em memória, o streamer do osciloscópio, a análise de
+fadiga, a persistência no banco em vários tamanhos de lote, a consulta de
+leituras recentes (com e sem limite), a partida rápida e todos os
+exportadores.
+"""
+
+import shutil
+
+from src.core.models import StrainBatch
+from src.data.data_manager import (
+    DataBuffer,
+    DataExporter,
+    DataManager,
+    DatabaseManager,
+    OscilloscopeStreamer
+)
+from src.data.alarms import AlarmEngine
+from src.data.fatigue import FatigueMonitor
+from .harness import benchmark, make_readings
+
+
+# Leituras por chamada nos caminhos de ingestão
+INGEST_BATCH = 1000
+
+# Leituras exportadas por chamada
+EXPORT_SIZE = 10000
+
+# Lotes pré-gerados por tamanho de store_readings (cada lote é inserido uma vez)
+STORE_BATCHES = {100: 200, 1000: 40, 10000: 8}
+
+
+def _packet_batches(count: int, sensors: int):
+    """Um StrainBatch de `count` leituras por sensor."""
+    readings = make_readings(count, sensors=sensors)
+    return [StrainBatch.from_readings(readings[sensor::sensors]) for sensor in range(sensors)]
+
+
+@benchmark('buffer.add_reading', items=INGEST_BATCH, unit='readings')
+def buffer_add_reading(tmp):
+    buffer = DataBuffer(max_size=INGEST_BATCH * 10)
+    readings = make_readings(INGEST_BATCH, sensors=1)
+
+    def call():
+        for reading in readings:
+            buffer.add_reading(reading)
+    yield call
+
+
+@benchmark('buffer.add_readings', items=INGEST_BATCH, unit='readings')
+def buffer_add_readings(tmp):
+    buffer = DataBuffer(max_size=INGEST_BATCH * 10)
+    readings = make_readings(INGEST_BATCH // 4, sensors=4)
+    yield lambda: buffer.add_readings(readings)
+
+
+@benchmark('buffer.add_batch', items=INGEST_BATCH, unit='readings')
+def buffer_add_batch(tmp):
+    # Lotes de um sensor, como chegam decodificados de cada pacote
+    buffer = DataBuffer(max_size=INGEST_BATCH * 10)
+    batches = _packet_batches(INGEST_BATCH // 4, sensors=4)
+
+    def call():
+        for batch in batches:
+            buffer.add_batch(batch)
+    yield call
+
+
+@benchmark('buffer.get_readings[sensor]', items=2500, unit='readings')
+def buffer_get_readings(tmp):
+    buffer = DataBuffer(max_size=10000)
+    readings = make_readings(2500, sensors=4)
+    buffer.add_readings(readings)
+    yield lambda: buffer.get_readings(sensor_id='BENCH_001')
+
+
+@benchmark('buffer.get_readings[window]', items=1000, unit='readings')
+def buffer_get_window(tmp):
+    buffer = DataBuffer(max_size=10000)
+    readings = make_readings(10000)
+    buffer.add_readings(readings)
+    start = readings[4000].timestamp
+    end = readings[4999].timestamp
+    yield lambda: buffer.get_readings(start_time=start, end_time=end)
+
+
+@benchmark('streamer.add_readings', items=INGEST_BATCH, unit='readings')
+def streamer_ingest(tmp):
+    streamer = OscilloscopeStreamer(max_points=1000)
+    readings = make_readings(INGEST_BATCH // 10, sensors=10)
+    yield lambda: streamer.add_readings(readings)
+
+
+@benchmark('streamer.add_batch', items=INGEST_BATCH, unit='readings')
+def streamer_ingest_batch(tmp):
+    streamer = OscilloscopeStreamer(max_points=1000)
+    batches = _packet_batches(INGEST_BATCH // 10, sensors=10)
+
+    def call():
+        for batch in batches:
+            streamer.add_batch(batch)
+    yield call
+
+
+@benchmark('fatigue.add_batch', items=INGEST_BATCH, unit='readings')
+def fatigue_ingest_batch(tmp):
+    # Rainflow + Miner + PSD de 10 sensores, como no caminho de ingestão
+    monitor = FatigueMonitor()
+    batches = _packet_batches(INGEST_BATCH // 10, sensors=10)
+
+    def call():
+        for batch in batches:
+            monitor.add_batch(batch)
+    yield call
+
+
+@benchmark('alarms.add_batch', items=INGEST_BATCH, unit='readings')
+def alarms_ingest_batch(tmp):
+    # Regras padrão (ALARM_CONFIG) sobre 10 sensores, sem transições
+    engine = AlarmEngine()
+    batches = _packet_batches(INGEST_BATCH // 10, sensors=10)
+
+    def call():
+        for batch in batches:
+            engine.add_batch(batch)
+    yield call
+
+
+@benchmark('streamer.get_stream_stats[10x1000]', unit='ops')
+def streamer_stats(tmp):
+    streamer = OscilloscopeStreamer(max_points=1000)
+    streamer.add_readings(make_readings(1000, sensors=10))
+    yield streamer.get_stream_stats
+
+
+def _store_benchmark(batch_size: int):
+    batches = STORE_BATCHES[batch_size]
+
+    @benchmark(f'database.store_readings[{batch_size}]', items=batch_size,
+               unit='readings', min_calls=min(5, batches - 2), max_calls=batches)
+    def store(tmp):
+        db = DatabaseManager(tmp / 'bench.db', migrate_in_background=False)
+        readings = make_readings(batch_size * batches)
+        pending = iter([readings[i:i + batch_size] for i in range(0, len(readings), batch_size)])
+        yield lambda: db.store_readings(next(pending))
+        db.close()
+
+    return store
+
+
+for _batch_size in STORE_BATCHES:
+    _store_benchmark(_batch_size)
+
+
+@benchmark('data_manager.get_recent_readings', items=6000, unit='readings')
+def recent_readings(tmp):
+    # Metade das leituras no banco, metade ainda no buffer
+    data_manager = DataManager(tmp / 'bench.db')
+    readings = make_readings(6000)
+    data_manager.add_readings(readings[:3000])
+    data_manager.flush()
+    data_manager.add_readings(readings[3000:])
+    yield lambda: data_manager.get_recent_readings(minutes=60)
+    data_manager.close()
+
+
+def _recent_limit_benchmark(span: int):
+    @benchmark(f'data_manager.get_recent_readings[last 100 of {span}]', items=100,
+               unit='readings')
+    def recent_limit(tmp):
+        # Custo deve depender do limite, não do tamanho do intervalo
+        data_manager = DataManager(tmp / 'bench.db')
+        readings = make_readings(span // 4, sensors=4)
+        for start in range(0, len(readings), 10000):
+            data_manager.add_readings(readings[start:start + 10000])
+            data_manager.flush()
+        yield lambda: data_manager.get_recent_readings(minutes=60, max_count=100)
+        data_manager.close()
+
+    return recent_limit
+
+
+for _span in (10000, 100000):
+    _recent_limit_benchmark(_span)
+
+
+@benchmark('data_manager.warm_start[snapshot 10x1000]', items=10000, unit='readings')
+def warm_start_snapshot(tmp):
+    # Janelas cheias de 10 sensores restauradas do snapshot (mmap)
+    data_manager = DataManager(tmp / 'bench.db', warm_start=True)
+    data_manager.add_readings(make_readings(1000, sensors=10))
+    data_manager.close()
+    saved = tmp / 'saved.daqsnap'
+    shutil.copyfile(data_manager._snapshot_path, saved)
+
+    def call():
+        shutil.copyfile(saved, data_manager._snapshot_path)
+        data_manager._restore_snapshot()
+    yield call
+
+
+@benchmark('data_manager.warm_start[database 10x1000]', items=10000, unit='readings')
+def warm_start_database(tmp):
+    # Sem snapshot: cauda de cada sensor pela chave primária
+    data_manager = DataManager(tmp / 'bench.db', warm_start=False)
+    data_manager.add_readings(make_readings(5000, sensors=10))
+    data_manager.flush()
+    yield data_manager._restore_from_database
+    data_manager.close()
+
+
+def _export_benchmark(name: str, method: str, suffix: str, requires: tuple = ()):
+    @benchmark(f'export.{name}', items=EXPORT_SIZE, unit='readings', requires=requires)
+    def export(tmp):
+        readings = make_readings(EXPORT_SIZE)
+        exporter = getattr(DataExporter, method)
+        output = tmp / f'bench{suffix}'
+        yield lambda: exporter(readings, output)
+
+    return export
+
+
+for _args in (('csv', 'export_to_csv', '.csv'),
+              ('json', 'export_to_json', '.json'),
+              ('jsonl', 'export_to_jsonl', '.jsonl'),
+              ('excel', 'export_to_excel', '.xlsx', ('openpyxl',)),
+              ('parquet', 'export_to_parquet', '.parquet', ('pyarrow',)),
+              ('arrow', 'export_to_arrow', '.arrow', ('pyarrow',))):
+    _export_benchmark(*_args)
@@ -0,0 +1,304 @@
+"""
+Infraestrutura dos benchmarks de desempenho.
+
+Cada benchmark é uma função geradora registrada com @benchmark: o código
+antes do yield prepara o estado, o objeto produzido é a chamada medida e
+o código após o yield faz a limpeza (como uma fixture do pytest).
+
+Para cada caminho são medidos:
+- throughput: itens processados por segundo (unidade definida no registro)
+- p50/p99: latência por chamada em µs
+- pico de RAM: maior alocação Python durante uma chamada (tracemalloc),
+  medida em uma execução separada para não distorcer os tempos
+
+Os resultados podem ser gravados como baseline (JSON) e comparados em
+execuções seguintes; uma piora além do limite configurado em qualquer
+métrica conta como regressão.
+"""
+
+import gc
+import json
+import math
+import platform
+import tempfile
+import time
+import tracemalloc
+from dataclasses import dataclass, asdict
+from datetime import datetime, timedelta
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterator, List, Optional
+
+from src.core.models import StrainReading
+
+
+BASELINE_PATH = Path(__file__).parent / 'baseline.json'
+BASELINE_VERSION = 1
+
+# Limites padrão de regressão (fração relativa à baseline)
+DEFAULT_THRESHOLDS = {
+    'throughput': 0.30,  # queda máxima de throughput
+    'p99_us': 0.50,      # aumento máximo da latência p99
+    'peak_kib': 0.25     # aumento máximo do pico de RAM
+}
+
+# Folga absoluta de memória: alocações pequenas variam entre versões do Python
+MEMORY_SLACK_KIB = 64.0
+
+
+@dataclass
+class Benchmark:
+    """Definição registrada de um benchmark."""
+    name: str
+    factory: Callable[[Path], Iterator[Callable[[], Any]]]
+    items: int = 1
+    unit: str = 'ops'
+    min_time: float = 0.5
+    min_calls: int = 5
+    max_calls: int = 100000
+    requires: tuple = ()
+
+
+@dataclass
+class BenchmarkResult:
+    """Medição de um benchmark."""
+    name: str
+    unit: str
+    items: int
+    calls: int
+    throughput: float
+    p50_us: float
+    p99_us: float
+    peak_kib: float
+
+
+REGISTRY: Dict[str, Benchmark] = {}
+
+
+def benchmark(name: str, items: int = 1, unit: str = 'ops',
+              min_calls: int = 5, max_calls: int = 100000,
+              requires: tuple = ()) -> Callable:
+    """
+    Registra uma função geradora como benchmark.
+
+    Args:
+        name: Nome único (grupo.caminho[variação])
+        items: Itens processados por chamada medida
+        unit: Unidade dos itens (ops, msgs, readings, bytes)
+        min_calls: Chamadas mínimas medidas
+        max_calls: Chamadas máximas, incluindo aquecimento e medição de
+            memória (para estado pré-gerado limitado)
+        requires: Módulos opcionais necessários (benchmark pulado sem eles)
+
+    Returns:
+        Decorador
+    """
+    def decorator(factory):
+        if name in REGISTRY:
+            raise ValueError(f"Benchmark duplicado: {name}")
+        REGISTRY[name] = Benchmark(name, factory, items, unit,
+                                   min_calls=min_calls, max_calls=max_calls,
+                                   requires=tuple(requires))
+        return factory
+    return decorator
+
+
+def missing_requirements(bench: Benchmark) -> List[str]:
+    """Módulos opcionais ausentes para um benchmark."""
+    import importlib.util
+    return [module for module in bench.requires if importlib.util.find_spec(module) is None]
+
+
+def percentile(sorted_values: List[float], fraction: float) -> float:
+    """Percentil por posição mais próxima de uma lista ordenada."""
+    if not sorted_values:
+        return 0.0
+    rank = max(0, math.ceil(fraction * len(sorted_values)) - 1)
+    return sorted_values[min(rank, len(sorted_values) - 1)]
+
+
+def run(bench: Benchmark, min_time: Optional[float] = None) -> BenchmarkResult:
+    """
+    Executa um benchmark.
+
+    Args:
+        bench: Benchmark registrado
+        min_time: Tempo mínimo de medição em segundos (padrão do registro)
+
+    Returns:
+        Resultado medido
+    """
+    min_time = bench.min_time if min_time is None else min_time
+    with tempfile.TemporaryDirectory(prefix='daq_bench_') as tmp:
+        generator = bench.factory(Path(tmp))
+        call = next(generator)
+        try:
+            # Aquecimento (caches, imports tardios)
+            call()
+            calls = 1
+
+            gc.collect()
+            samples: List[int] = []
+            clock = time.perf_counter_ns
+            deadline = clock() + int(min_time * 1e9)
+            # A última chamada permitida fica reservada para a medição de memória
+            while (calls < bench.max_calls - 1 and
+                   (len(samples) < bench.min_calls or clock() < deadline)):
+                started = clock()
+                call()
+                samples.append(clock() - started)
+                calls += 1
+
+            gc.collect()
+            tracemalloc.start()
+            try:
+                call()
+                peak_kib = tracemalloc.get_traced_memory()[1] / 1024
+            finally:
+                tracemalloc.stop()
+        finally:
+            generator.close()
+
+    samples.sort()
+    total_seconds = sum(samples) / 1e9
+    return BenchmarkResult(
+        name=bench.name,
+        unit=bench.unit,
+        items=bench.items,
+        calls=len(samples),
+        throughput=bench.items * len(samples) / total_seconds if total_seconds > 0 else 0.0,
+        p50_us=percentile(samples, 0.50) / 1000,
+        p99_us=percentile(samples, 0.99) / 1000,
+        peak_kib=peak_kib
+    )
+
+
+def load_baseline(path: Path = BASELINE_PATH) -> Dict[str, Any]:
+    """
+    Carrega a baseline gravada.
+
+    Returns:
+        Dicionário com 'thresholds' e 'results' (vazio se não existir)
+    """
+    if not path.exists():
+        return {'thresholds': dict(DEFAULT_THRESHOLDS), 'results': {}}
+    with open(path, 'r', encoding='utf-8') as f:
+        data = json.load(f)
+    if data.get('version') != BASELINE_VERSION:
+        raise ValueError(f"Versão de baseline não suportada: {data.get('version')}")
+    thresholds = dict(DEFAULT_THRESHOLDS)
+    thresholds.update(data.get('thresholds', {}))
+    data['thresholds'] = thresholds
+    return data
+
+
+def save_baseline(results: List[BenchmarkResult], path: Path = BASELINE_PATH,
+                  thresholds: Optional[Dict[str, float]] = None) -> None:
+    """
+    Grava resultados como baseline, preservando entradas não medidas.
+
+    Args:
+        results: Resultados da execução
+        path: Arquivo da baseline
+        thresholds: Limites de regressão (padrão: os já gravados)
+    """
+    current = load_baseline(path)
+    entries = current.get('results', {})
+    for result in results:
+        entries[result.name] = {
+            'throughput': round(result.throughput, 3),
+            'p99_us': round(result.p99_us, 3),
+            'peak_kib': round(result.peak_kib, 3),
+            'unit': result.unit
+        }
+    data = {
+        'version': BASELINE_VERSION,
+        'recorded': datetime.now().isoformat(timespec='seconds'),
+        'machine': f"{platform.system()} {platform.machine()} / Python {platform.python_version()}",
+        'thresholds': thresholds or current['thresholds'],
+        'results': dict(sorted(entries.items()))
+    }
+    with open(path, 'w', encoding='utf-8') as f:
+        json.dump(data, f, indent=2, ensure_ascii=False)
+        f.write('\n')
+
+
+def compare(result: BenchmarkResult, baseline: Dict[str, Any]) -> List[str]:
+    """
+    Compara um resultado com a baseline.
+
+    Args:
+        result: Resultado medido
+        baseline: Dados de load_baseline()
+
+    Returns:
+        Descrições das regressões (vazia se dentro dos limites ou sem baseline)
+    """
+    reference = baseline.get('results', {}).get(result.name)
+    if not reference:
+        return []
+    limits = baseline['thresholds']
+    regressions = []
+
+    floor = reference['throughput'] * (1 - limits['throughput'])
+    if result.throughput < floor:
+        regressions.append(
+            f"throughput {result.throughput:.0f} {result.unit}/s < {floor:.0f} "
+            f"(baseline {reference['throughput']:.0f})"
+        )
+    ceiling = reference['p99_us'] * (1 + limits['p99_us'])
+    if result.p99_us > ceiling:
+        regressions.append(
+            f"p99 {result.p99_us:.1f} µs > {ceiling:.1f} (baseline {reference['p99_us']:.1f})"
+        )
+    memory = reference['peak_kib'] * (1 + limits['peak_kib']) + MEMORY_SLACK_KIB
+    if result.peak_kib > memory:
+        regressions.append(
+            f"pico de RAM {result.peak_kib:.0f} KiB > {memory:.0f} "
+            f"(baseline {reference['peak_kib']:.0f})"
+        )
+    return regressions
+
+
+def format_result(result: BenchmarkResult, regressions: List[str]) -> str:
+    """Linha da tabela de resultados."""
+    status = 'REGRESSÃO' if regressions else 'ok'
+    return (f"{result.name:<44} {result.throughput:>14,.0f} {result.unit + '/s':<11} "
+            f"p50 {result.p50_us:>10.1f} µs  p99 {result.p99_us:>10.1f} µs  "
+            f"pico {result.peak_kib:>9.1f} KiB  {status}")
+
+
+def make_readings(count: int, sensors: int = 1, start: Optional[datetime] = None,
+                  period_ms: int = 10, prefix: str = 'BENCH') -> List[StrainReading]:
+    """
+    Gera leituras sintéticas determinísticas.
+
+    Args:
+        count: Leituras por sensor
+        sensors: Número de sensores (intercalados no tempo)
+        start: Timestamp da primeira leitura (padrão: count períodos atrás)
+        period_ms: Período de amostragem
+        prefix: Prefixo dos IDs de sensor
+
+    Returns:
+        Leituras em ordem temporal
+    """
+    start = start or datetime.now() - timedelta(milliseconds=count * period_ms)
+    readings = []
+    for index in range(count):
+        timestamp = start + timedelta(milliseconds=index * period_ms)
+        for sensor in range(sensors):
+            value = 100.0 * math.sin(index / 50.0) + sensor
+            readings.append(StrainReading(
+                timestamp=timestamp,
+                strain_value=round(value, 3),
+                raw_adc_value=int(value * 1000),
+                sensor_id=f"{prefix}_{sensor:03d}",
+                battery_level=90,
+                temperature=25.0 + sensor * 0.1
+            ))
+    return readings
+
+
+def results_as_dicts(results: List[BenchmarkResult]) -> List[Dict[str, Any]]:
+    """Resultados serializáveis (saída --json)."""
+    return [asdict(result) for result in results]
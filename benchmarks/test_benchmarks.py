@@ -0,0 +1,36 @@
+"""
+Gate de regressão de desempenho via pytest.
+
+Roda cada benchmark registrado e falha se alguma métrica piorar além dos
+limites da baseline (benchmarks/baseline.json). Não faz parte de
+testpaths; execute com: pytest benchmarks -m benchmark
+"""
+
+import pytest
+import sys
+from pathlib import Path
+
+# Adiciona diretório pai ao path para importações
+sys.path.append(str(Path(__file__).parent.parent))
+
+from benchmarks import REGISTRY, run, compare, load_baseline
+from benchmarks.harness import format_result, missing_requirements
+
+
+BASELINE = load_baseline()
+
+
+@pytest.mark.benchmark
+@pytest.mark.parametrize("name", sorted(REGISTRY))
+def test_benchmark_within_baseline(name):
+    """Testa que o benchmark não regrediu em relação à baseline."""
+    bench = REGISTRY[name]
+    missing = missing_requirements(bench)
+    if missing:
+        pytest.skip(f"requer {', '.join(missing)}")
+    
+    result = run(bench)
+    regressions = compare(result, BASELINE)
+    print(format_result(result, regressions))
+    
+    assert not regressions, f"{name}: " + "; ".join(regressions)
@@ -8,7 +8,8 @@ import asyncio
 import qasync
 from pathlib import Path
 from datetime import datetime, timedelta
-from typing import Optional, List, Dict
+from collections import deque
+from typing import Optional, List, Dict, Tuple
 
 from PyQt5.QtWidgets import (
     QApplication, QMainWindow, QVBoxLayout, QHBoxLayout, QGridLayout,
@@ -19,7 +20,6 @@ from PyQt5.QtWidgets import (
 from PyQt5.QtCore import QTimer, pyqtSignal, QThread, Qt
 from PyQt5.QtGui import QFont, QPixmap, QPalette, QColor
 
-import matplotlib.pyplot as plt
 from matplotlib.backends.backend_qt5agg import FigureCanvasQTAgg as FigureCanvas
 from matplotlib.figure import Figure
 import numpy as np
@@ -30,10 +30,74 @@ sys.path.append(str(Path(__file__).parent.parent))
 from main import DAQSystemApplication
 from simulator import SimulatorConfig
 from src.core.models import StrainReading, SensorConfiguration
+from src.core.config import config as system_config
+from src.data.ring_buffer import ColumnRing
+
+
+class PlotTrace:
+    """
+    Série de um sensor no gráfico em tempo real.
+    
+    Pontos ficam em um buffer circular colunar (ver ring_buffer) e os
+    extremos da janela de tempo visível são mantidos por deques
+    monotônicos de (índice absoluto, valor), em O(1) amortizado por
+    ponto, sem varrer a janela a cada quadro.
+    """
+    
+    def __init__(self, capacity: int, window_seconds: float):
+        self.ring = ColumnRing(capacity, (('t', 'd'), ('v', 'd')))
+        self.window_seconds = window_seconds
+        self._min: deque = deque()  # valores crescentes
+        self._max: deque = deque()  # valores decrescentes
+    
+    def __len__(self) -> int:
+        return len(self.ring)
+    
+    def append(self, t: float, value: float) -> None:
+        """Acrescenta ponto (t em segundos desde epoch)."""
+        index = self.ring.append((t, value))
+        while self._min and self._min[-1][1] >= value:
+            self._min.pop()
+        self._min.append((index, value))
+        while self._max and self._max[-1][1] <= value:
+            self._max.pop()
+        self._max.append((index, value))
+    
+    def newest(self) -> float:
+        """Timestamp do ponto mais recente."""
+        return self.ring.value('t', self.ring.end_index - 1)
+    
+    def visible(self, newest: float) -> Tuple[int, int]:
+        """Índices absolutos [início, fim) dentro da janela até newest."""
+        return self.ring.search('t', newest - self.window_seconds), self.ring.end_index
+    
+    def extrema(self, first: int) -> Tuple[float, float]:
+        """Mínimo e máximo a partir do índice absoluto first."""
+        first = max(first, self.ring.first_index)
+        while self._min[0][0] < first:
+            self._min.popleft()
+        while self._max[0][0] < first:
+            self._max.popleft()
+        return self._min[0][1], self._max[0][1]
+    
+    def clear(self) -> None:
+        self.ring.discard_all()
+        self._min.clear()
+        self._max.clear()
 
 
 class RealtimePlotWidget(FigureCanvas):
-    """Widget para gráficos em tempo real."""
+    """
+    Widget para gráficos em tempo real, com um traço por sensor.
+    
+    add_data_point apenas grava no buffer do sensor; o desenho acontece
+    em um QTimer a cada GUI_UPDATE_INTERVAL ms e só quando chegaram
+    dados novos. O eixo X é o tempo relativo à leitura mais recente
+    (janela fixa de OSCILLOSCOPE_TIME_WINDOW s), de modo que fundo, eixos
+    e legenda são reaproveitados (blitting) e apenas as linhas são
+    redesenhadas. Redesenho completo só ocorre quando a escala vertical
+    muda (com histerese) ou um sensor novo aparece.
+    """
     
     def __init__(self, parent=None, width=8, height=4, dpi=100):
         """Inicializa widget de gráfico."""
@@ -42,73 +106,123 @@ class RealtimePlotWidget(FigureCanvas):
         self.setParent(parent)
         
         # Configuração dos gráficos
+        self.window_seconds = system_config.OSCILLOSCOPE_TIME_WINDOW
         self.axes = self.figure.add_subplot(111)
         self.axes.set_title('Strain em Tempo Real')
-        self.axes.set_xlabel('Tempo (s)')
+        self.axes.set_xlabel('Tempo relativo (s)')
         self.axes.set_ylabel('Strain (µε)')
         self.axes.grid(True, alpha=0.3)
+        self.axes.set_xlim(-self.window_seconds, 0)
+        self.axes.set_ylim(-10, 10)
+        
+        # Dados para plotagem: um buffer por sensor
+        self.max_points = system_config.PLOT_MAX_POINTS
+        self.traces: Dict[str, PlotTrace] = {}
+        self.lines: Dict[str, object] = {}
+        self.auto_scale = True
+        self._dirty = False
+        self._layout_changed = True
+        self._background = None
         
-        # Dados para plotagem
-        self.max_points = 500  # Últimos 500 pontos
-        self.time_data = []
-        self.strain_data = []
-        self.start_time = datetime.now()
-        
-        # Linha do gráfico
-        self.line, = self.axes.plot([], [], 'b-', linewidth=1.5, label='Strain')
-        self.axes.legend()
-        
-        # Atualiza layout
         self.figure.tight_layout()
+        self.mpl_connect('draw_event', self._on_draw)
+        
+        # Desenho desacoplado da ingestão
+        self.render_timer = QTimer(self)
+        self.render_timer.timeout.connect(self.render)
+        self.render_timer.start(system_config.GUI_UPDATE_INTERVAL)
     
     def add_data_point(self, reading: StrainReading) -> None:
         """
-        Adiciona novo ponto ao gráfico.
+        Adiciona novo ponto ao gráfico (sem desenhar).
         
         Args:
             reading: Leitura de strain
         """
-        # Calcula tempo relativo
-        elapsed = (reading.timestamp - self.start_time).total_seconds()
-        
-        # Adiciona dados
-        self.time_data.append(elapsed)
-        self.strain_data.append(reading.strain)
-        
-        # Mantém apenas os últimos pontos
-        if len(self.time_data) > self.max_points:
-            self.time_data.pop(0)
-            self.strain_data.pop(0)
-        
-        # Atualiza gráfico
-        self.update_plot()
+        trace = self.traces.get(reading.sensor_id)
+        if trace is None:
+            trace = self.traces[reading.sensor_id] = PlotTrace(self.max_points, self.window_seconds)
+        trace.append(reading.timestamp.timestamp(), reading.strain_value)
+        self._dirty = True
+    
+    def set_auto_scale(self, enabled: bool) -> None:
+        """Habilita ou desabilita a escala vertical automática."""
+        self.auto_scale = bool(enabled)
+        self._dirty = True
     
-    def update_plot(self) -> None:
-        """Atualiza visualização do gráfico."""
-        if not self.time_data:
+    def render(self) -> None:
+        """Desenha os dados recebidos desde o último quadro."""
+        if not self._dirty or not self.traces:
+            return
+        self._dirty = False
+        
+        newest = max(trace.newest() for trace in self.traces.values() if len(trace))
+        low, high = float('inf'), float('-inf')
+        for sensor_id, trace in self.traces.items():
+            line = self.lines.get(sensor_id)
+            if line is None:
+                line, = self.axes.plot([], [], linewidth=1.5, label=sensor_id, animated=True)
+                self.lines[sensor_id] = line
+                legend = self.axes.legend(loc='upper left')
+                # Amostras da legenda fazem parte do fundo estático
+                for handle in getattr(legend, 'legend_handles', None) or legend.legendHandles:
+                    handle.set_animated(False)
+                self._layout_changed = True
+            if not len(trace):
+                line.set_data([], [])
+                continue
+            
+            first, end = trace.visible(newest)
+            times = np.frombuffer(trace.ring.view('t', first, end), dtype=np.float64)
+            values = np.array(trace.ring.view('v', first, end), dtype=np.float64)
+            line.set_data(times - newest, values)
+            if end > first:
+                trace_low, trace_high = trace.extrema(first)
+                low, high = min(low, trace_low), max(high, trace_high)
+        
+        if self.auto_scale and low <= high:
+            self._rescale(low, high)
+        
+        if self._layout_changed or self._background is None:
+            self._layout_changed = False
+            self.draw()
             return
         
-        # Atualiza dados da linha
-        self.line.set_data(self.time_data, self.strain_data)
-        
-        # Ajusta limites dos eixos
-        self.axes.set_xlim(min(self.time_data), max(self.time_data))
-        
-        y_min, y_max = min(self.strain_data), max(self.strain_data)
-        y_range = y_max - y_min
-        margin = y_range * 0.1 if y_range > 0 else 10
-        
-        self.axes.set_ylim(y_min - margin, y_max + margin)
-        
-        # Redesenha
-        self.draw()
+        self.restore_region(self._background)
+        for line in self.lines.values():
+            self.axes.draw_artist(line)
+        self.blit(self.axes.bbox)
+    
+    def _rescale(self, low: float, high: float) -> None:
+        """Ajusta o eixo Y quando os dados saem da faixa ou ocupam menos da metade."""
+        y_min, y_max = self.axes.get_ylim()
+        span = y_max - y_min
+        if low >= y_min and high <= y_max and (high - low) >= 0.5 * span:
+            return
+        data_range = high - low
+        margin = data_range * 0.1 if data_range > 0 else 10
+        self.axes.set_ylim(low - margin, high + margin)
+        self._layout_changed = True
+    
+    def _on_draw(self, event) -> None:
+        """Guarda o fundo após redesenho completo e desenha as linhas."""
+        self._background = self.copy_from_bbox(self.axes.bbox)
+        for line in self.lines.values():
+            self.axes.draw_artist(line)
+    
+    def resizeEvent(self, event) -> None:
+        """Redimensionamento invalida o fundo guardado."""
+        self._background = None
+        self._dirty = True
+        super().resizeEvent(event)
     
     def clear_plot(self) -> None:
         """Limpa o gráfico."""
-        self.time_data.clear()
-        self.strain_data.clear()
-        self.start_time = datetime.now()
-        self.line.set_data([], [])
+        for trace in self.traces.values():
+            trace.clear()
+        for line in self.lines.values():
+            line.set_data([], [])
+        self._background = None
         self.draw()
 
 
@@ -365,6 +479,7 @@ class DAQMainWindow(QMainWindow):
         
         self.auto_scale_check = QCheckBox("Auto Scale")
         self.auto_scale_check.setChecked(True)
+        self.auto_scale_check.toggled.connect(self.plot_widget.set_auto_scale)
         plot_controls.addWidget(self.auto_scale_check)
         
         plot_controls.addStretch()
@@ -15,8 +15,12 @@ sys.path.append(str(Path(__file__).parent.parent))
 
 from simulator import DAQSystemSimulator, SimulatorConfig
 from src.data import DataManager
-from src.communication import BLESimulator
+from src.communication import BLESimulator, LinkManager, IngestScheduler
+from src.core.config import config as system_config
+from src.data.oscilloscope_api import OscilloscopeAPI, WebSocketStreamer
+from src.data.websocket_server import OscilloscopeWebSocketServer
 from src.core.models import StrainReading, SensorInfo, SensorConfiguration
+from src.core.metrics import MetricsHTTPServer
 
 
 class DAQSystemApplication:
@@ -27,11 +31,33 @@ class DAQSystemApplication:
     em uma interface unificada de controle.
     """
     
-    def __init__(self):
-        """Inicializa a aplicação."""
+    def __init__(self, websocket_port: Optional[int] = None,
+                 replay_path: Optional[Path] = None,
+                 replay_speed: Optional[float] = 1.0,
+                 metrics_port: Optional[int] = None):
+        """
+        Inicializa a aplicação.
+        
+        Args:
+            websocket_port: Porta do servidor WebSocket do osciloscópio (None = desabilitado)
+            replay_path: Captura .daqcap reproduzida como fonte de dados
+            replay_speed: Velocidade do replay (1.0 = tempo real, None = máxima)
+            metrics_port: Porta do endpoint Prometheus /metrics (None = desabilitado)
+        """
         self.simulator: Optional[DAQSystemSimulator] = None
         self.data_manager = DataManager()
         self.ble_comm = BLESimulator()
+        self.links = LinkManager(export_metrics=True)
+        self.ingest = IngestScheduler(self.links, self._on_link_batch)
+        self._ingest_task: Optional[asyncio.Task] = None
+        self._link_task: Optional[asyncio.Task] = None
+        self.websocket_port = websocket_port
+        self.websocket_server: Optional[OscilloscopeWebSocketServer] = None
+        self.metrics_port = metrics_port
+        self.metrics_server: Optional[MetricsHTTPServer] = None
+        self.replay_path = replay_path
+        self.replay_speed = replay_speed
+        self._replay_task: Optional[asyncio.Task] = None
         self._running = False
         self._shutdown_event = asyncio.Event()
         
@@ -87,6 +113,11 @@ class DAQSystemApplication:
         import time
         self.stats['start_time'] = time.time()
         
+        warm = self.data_manager.warm_start_info
+        if warm['source']:
+            print(f"✓ Osciloscópio restaurado ({warm['source']}): {warm['points']} pontos "
+                  f"de {warm['sensors']} sensores em {warm['seconds'] * 1000:.0f} ms")
+        
         # 1. Inicia simulador
         if config.auto_start:
             print("Iniciando simulador...")
@@ -103,11 +134,35 @@ class DAQSystemApplication:
         if config.enable_ble:
             print("Configurando comunicação BLE...")
             self.ble_comm.add_connection_callback(self._on_ble_connection)
-            self.ble_comm.add_data_callback(self._on_ble_data)
-            await self.ble_comm.start_advertising()
+            # Dados dos links são enfileirados por link e drenados pelo escalonador
+            self.links.attach(self.ble_comm)
+            self._ingest_task = asyncio.create_task(self.ingest.run())
+            # Conexões, reconexões com backoff e ACKs ficam com o LinkManager
+            for address in self.ble_comm.discovered_devices:
+                self.links.track(address)
+            self._link_task = asyncio.create_task(
+                self.links.maintain(self.ble_comm.connect, self.ble_comm.send_data)
+            )
             print("✓ BLE configurado")
         
-        # 3. Aplicação pronta
+        # 3. Servidor WebSocket do osciloscópio
+        if self.websocket_port is not None:
+            streamer = WebSocketStreamer(OscilloscopeAPI(self.data_manager))
+            self.websocket_server = OscilloscopeWebSocketServer(streamer, port=self.websocket_port)
+            await self.websocket_server.start()
+            print(f"✓ WebSocket em ws://localhost:{self.websocket_server.port}/oscilloscope")
+        
+        if self.metrics_port is not None:
+            self.metrics_server = MetricsHTTPServer(port=self.metrics_port)
+            await self.metrics_server.start()
+            print(f"✓ Métricas em http://localhost:{self.metrics_server.port}/metrics")
+        
+        # 4. Replay de captura
+        if self.replay_path is not None:
+            print(f"Reproduzindo captura {self.replay_path}...")
+            self._replay_task = asyncio.create_task(self._run_replay())
+        
+        # 5. Aplicação pronta
         self._running = True
         print("✓ Sistema DAQ pronto!")
         print()
@@ -145,6 +200,27 @@ class DAQSystemApplication:
         
         self._running = False
     
+    async def _run_replay(self) -> None:
+        """Reproduz a captura pelo caminho de ingestão e encerra ao terminar."""
+        from src.data.capture import CaptureReader
+        from src.data.replay import CaptureReplayer
+        
+        try:
+            with CaptureReader(self.replay_path) as reader:
+                replayer = CaptureReplayer(reader, self.data_manager, speed=self.replay_speed)
+                stats = await replayer.run_async()
+            self.stats['readings_received'] += stats['readings']
+            self.stats['readings_stored'] += stats['readings']
+            print(f"✓ Replay concluído: {stats['readings']} leituras em "
+                  f"{stats['elapsed_seconds']:.1f}s")
+            print(f"  Ingestão: {stats['ingest_rate']:.0f} leituras/s "
+                  f"(sustentada com banco: {stats['sustained_rate']:.0f} leituras/s)")
+            print(f"  Atraso máximo: {stats['max_lag_ms']:.1f} ms, erros: {stats['errors']}")
+        except Exception as e:
+            print(f"Erro no replay: {e}")
+        finally:
+            self._shutdown_event.set()
+    
     async def _show_system_status(self) -> None:
         """Mostra status inicial do sistema."""
         print("Status do Sistema:")
@@ -227,15 +303,16 @@ class DAQSystemApplication:
         else:
             print(f"[BLE] Cliente desconectado: {device.name}")
     
-    async def _on_ble_data(self, address: str, data: bytes) -> None:
+    def _on_link_batch(self, batch) -> None:
         """
-        Callback para dados recebidos via BLE.
+        Sink do escalonador de ingestão: lote agrupado de um sensor.
         
         Args:
-            address: Endereço do dispositivo
-            data: Dados recebidos
+            batch: StrainBatch com as leituras recebidas pelos links
         """
-        print(f"[BLE] Dados recebidos de {address}: {len(data)} bytes")
+        self.stats['readings_received'] += len(batch)
+        self.data_manager.add_batch(batch)
+        self.stats['readings_stored'] += len(batch)
     
     # Controle do sistema
     async def set_scenario(self, scenario_name: str) -> bool:
@@ -307,8 +384,36 @@ class DAQSystemApplication:
             await self.simulator.stop()
             print("✓ Simulador parado")
         
+        # Para replay
+        if self._replay_task and not self._replay_task.done():
+            self._replay_task.cancel()
+            await asyncio.gather(self._replay_task, return_exceptions=True)
+        
+        # Para servidor WebSocket
+        if self.websocket_server:
+            await self.websocket_server.stop()
+            print("✓ Servidor WebSocket encerrado")
+        
+        # Para endpoint de métricas
+        if self.metrics_server:
+            await self.metrics_server.stop()
+            print("✓ Endpoint de métricas encerrado")
+        
+        # Para escalonador de ingestão dos links
+        if self._ingest_task and not self._ingest_task.done():
+            self.ingest.stop()
+            self._ingest_task.cancel()
+            await asyncio.gather(self._ingest_task, return_exceptions=True)
+            self.ingest.drain()
+        
+        # Para reconexões e envio de ACKs dos links
+        if self._link_task and not self._link_task.done():
+            self.links.stop()
+            self._link_task.cancel()
+            await asyncio.gather(self._link_task, return_exceptions=True)
+        
         # Para comunicação BLE
-        await self.ble_comm.stop_scan()
+        await self.ble_comm.stop()
         print("✓ Comunicação BLE encerrada")
         
         # Fecha gerenciador de dados
@@ -336,6 +441,9 @@ Exemplos de uso:
   python main.py --name "Field_Test"       # Nome personalizado
   python main.py --speed 2.0 --scenario transport  # Simulação acelerada
   python main.py --no-ble --export csv     # Sem BLE, exporta CSV ao final
+  python main.py --websocket               # Streaming em ws://localhost:8765/oscilloscope
+  python main.py --metrics                 # Prometheus em http://localhost:9108/metrics
+  python main.py --replay pista.daqcap --replay-speed max  # Taxa máxima de ingestão
   python main.py --config sensor_config.json       # Configuração externa
         """
     )
@@ -379,9 +487,40 @@ Exemplos de uso:
         help="Inicia apenas como estação receptora"
     )
     
+    parser.add_argument(
+        "--websocket", 
+        type=int,
+        nargs="?",
+        const=system_config.WEBSOCKET_PORT,
+        metavar="PORTA",
+        help=f"Inicia servidor WebSocket do osciloscópio (padrão: {system_config.WEBSOCKET_PORT})"
+    )
+    
+    parser.add_argument(
+        "--metrics", 
+        type=int,
+        nargs="?",
+        const=system_config.METRICS_PORT,
+        metavar="PORTA",
+        help=f"Expõe métricas Prometheus em /metrics (padrão: {system_config.METRICS_PORT})"
+    )
+    
+    parser.add_argument(
+        "--replay", 
+        type=Path,
+        metavar="CAPTURA",
+        help="Reproduz captura .daqcap pelo caminho de ingestão (implica --no-simulator)"
+    )
+    
+    parser.add_argument(
+        "--replay-speed", 
+        default="1.0",
+        help="Velocidade do replay: fator (1.0 = tempo real) ou 'max'"
+    )
+    
     parser.add_argument(
         "--export", 
-        choices=["csv", "json", "excel"], 
+        choices=["csv", "json", "jsonl", "excel", "parquet", "arrow"], 
         help="Exporta dados ao final da execução"
     )
     
@@ -413,7 +552,7 @@ Exemplos de uso:
         simulation_speed=args.speed,
         enable_ble=not args.no_ble,
         enable_wifi=args.wifi,
-        auto_start=not args.no_simulator,
+        auto_start=not (args.no_simulator or args.replay),
         realistic_loads=True
     )
     
@@ -436,7 +575,11 @@ Exemplos de uso:
             return 1
     
     # Cria e executa aplicação
-    app = DAQSystemApplication()
+    replay_speed = None if args.replay_speed == "max" else float(args.replay_speed)
+    app = DAQSystemApplication(websocket_port=args.websocket,
+                               replay_path=args.replay,
+                               replay_speed=replay_speed,
+                               metrics_port=args.metrics)
     
     try:
         await app.start(config)
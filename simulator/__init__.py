@@ -2,6 +2,7 @@
 
 from .hx711_simulator import HX711Simulator, HX711SimulatorConfig
 from .esp32_simulator import ESP32Simulator, ESP32Config, ESP32PowerMode, WiFiStatus, BLEStatus  
+from .transmission_scheduler import TransmissionConfig, TransmissionScheduler
 from .daq_simulator import DAQSystemSimulator, SimulatorConfig
 
 __all__ = [
@@ -12,6 +13,8 @@ __all__ = [
     'ESP32PowerMode',
     'WiFiStatus',
     'BLEStatus',
+    'TransmissionConfig',
+    'TransmissionScheduler',
     'DAQSystemSimulator',
     'SimulatorConfig'
 ]
@@ -4,15 +4,65 @@ Integra ESP32 e HX711 simuladores com interface de comunicação.
 """
 
 import asyncio
-import time
+import copy
+import math
+import random
 from datetime import datetime
 from typing import Dict, List, Optional, Callable, Any
 from dataclasses import dataclass
 
 from .esp32_simulator import ESP32Simulator, ESP32Config
 from .hx711_simulator import HX711Simulator, HX711SimulatorConfig
-from ..core.models import StrainReading, SensorConfiguration, SensorInfo, SensorStatus, CommunicationProtocol
-from ..communication import BLESimulator, MessageProtocol, MessageType, DataPacketEncoder
+from src.core.clock import Clock, WallClock
+from src.core.models import StrainReading, SensorConfiguration, SensorInfo, SensorStatus, CommunicationProtocol
+from src.communication import BLESimulator, MessageProtocol, MessageType, DataPacketEncoder
+
+
+# Cenários de carga para simulação realística (compartilhados com fleet_simulator)
+LOAD_SCENARIOS: Dict[str, Dict[str, Any]] = {
+    "idle": {
+        "description": "Máquina parada",
+        "base_strain": 0.0,
+        "amplitude": 5.0,
+        "frequency": 0.1,
+        "noise_level": 0.05
+    },
+    "transport": {
+        "description": "Transporte em estrada",
+        "base_strain": 10.0,
+        "amplitude": 30.0,
+        "frequency": 2.0,
+        "noise_level": 0.1
+    },
+    "field_work_light": {
+        "description": "Trabalho leve no campo",
+        "base_strain": 50.0,
+        "amplitude": 100.0,
+        "frequency": 1.5,
+        "noise_level": 0.15
+    },
+    "field_work_heavy": {
+        "description": "Trabalho pesado no campo",
+        "base_strain": 200.0,
+        "amplitude": 300.0,
+        "frequency": 3.0,
+        "noise_level": 0.2
+    },
+    "harvest": {
+        "description": "Operação de colheita",
+        "base_strain": 150.0,
+        "amplitude": 250.0,
+        "frequency": 4.0,
+        "noise_level": 0.18
+    },
+    "overload": {
+        "description": "Sobrecarga do sistema",
+        "base_strain": 400.0,
+        "amplitude": 200.0,
+        "frequency": 1.0,
+        "noise_level": 0.1
+    }
+}
 
 
 @dataclass
@@ -25,6 +75,7 @@ class SimulatorConfig:
     enable_wifi: bool = False
     battery_simulation: bool = True
     realistic_loads: bool = True
+    seed: Optional[int] = None  # Semente (saída reprodutível com VirtualClock)
 
 
 class DAQSystemSimulator:
@@ -35,19 +86,31 @@ class DAQSystemSimulator:
     para criar um ambiente de teste realístico sem hardware físico.
     """
     
-    def __init__(self, config: Optional[SimulatorConfig] = None):
+    def __init__(self, config: Optional[SimulatorConfig] = None,
+                 clock: Optional[Clock] = None):
         """
         Inicializa o simulador completo.
         
         Args:
             config: Configuração do simulador
+            clock: Relógio da simulação (padrão: relógio de parede acelerado
+                por simulation_speed; VirtualClock para eventos discretos)
         """
         self.config = config or SimulatorConfig()
+        self.clock = clock or WallClock(self.config.simulation_speed)
+        
+        # Com semente, cada componente recebe um gerador próprio derivado dela
+        seeded = self.config.seed is not None
+        self._rng = random.Random(self.config.seed) if seeded else random
+        
+        def child_rng() -> Optional[random.Random]:
+            return random.Random(self._rng.getrandbits(64)) if seeded else None
         
         # Componentes do sistema
-        self.esp32 = ESP32Simulator(ESP32Config(device_name=self.config.device_name))
+        self.esp32 = ESP32Simulator(ESP32Config(device_name=self.config.device_name),
+                                    clock=self.clock, rng=child_rng())
         self.hx711 = self.esp32.hx711  # Usa o HX711 do ESP32
-        self.ble_comm = BLESimulator()
+        self.ble_comm = BLESimulator(clock=self.clock, rng=child_rng())
         
         # Estado do simulador
         self._is_running = False
@@ -70,50 +133,7 @@ class DAQSystemSimulator:
     
     def _create_load_scenarios(self) -> Dict[str, Dict[str, Any]]:
         """Cria cenários de carga para simulação realística."""
-        return {
-            "idle": {
-                "description": "Máquina parada",
-                "base_strain": 0.0,
-                "amplitude": 5.0,
-                "frequency": 0.1,
-                "noise_level": 0.05
-            },
-            "transport": {
-                "description": "Transporte em estrada",
-                "base_strain": 10.0,
-                "amplitude": 30.0,
-                "frequency": 2.0,
-                "noise_level": 0.1
-            },
-            "field_work_light": {
-                "description": "Trabalho leve no campo",
-                "base_strain": 50.0,
-                "amplitude": 100.0,
-                "frequency": 1.5,
-                "noise_level": 0.15
-            },
-            "field_work_heavy": {
-                "description": "Trabalho pesado no campo",
-                "base_strain": 200.0,
-                "amplitude": 300.0,
-                "frequency": 3.0,
-                "noise_level": 0.2
-            },
-            "harvest": {
-                "description": "Operação de colheita",
-                "base_strain": 150.0,
-                "amplitude": 250.0,
-                "frequency": 4.0,
-                "noise_level": 0.18
-            },
-            "overload": {
-                "description": "Sobrecarga do sistema",
-                "base_strain": 400.0,
-                "amplitude": 200.0,
-                "frequency": 1.0,
-                "noise_level": 0.1
-            }
-        }
+        return copy.deepcopy(LOAD_SCENARIOS)
     
     def _setup_communication(self) -> None:
         """Configura callbacks de comunicação."""
@@ -136,7 +156,7 @@ class DAQSystemSimulator:
         await self.esp32.start()
         
         if self.config.enable_ble:
-            await self.ble_comm.start_advertising()
+            await self.esp32.ble_start_advertising()
         
         # Inicia tasks de simulação
         self._simulation_tasks = [
@@ -161,10 +181,30 @@ class DAQSystemSimulator:
         
         # Para componentes
         await self.esp32.stop()
-        await self.ble_comm.stop_scan()
+        await self.ble_comm.stop()
         
         print("Simulador DAQ parado")
     
+    async def run_for(self, duration_s: float) -> Dict[str, Any]:
+        """
+        Executa a simulação por um intervalo no relógio da simulação.
+        
+        Com VirtualClock, use clock.run(simulator.run_for(...)): o intervalo
+        é percorrido tão rápido quanto a CPU permite.
+        
+        Args:
+            duration_s: Segundos simulados
+            
+        Returns:
+            Estatísticas dos dados ao final
+        """
+        await self.start()
+        try:
+            await self.clock.sleep(duration_s)
+        finally:
+            await self.stop()
+        return self.get_statistics()
+    
     async def _load_simulation_loop(self) -> None:
         """Loop de simulação de cargas dinâmicas."""
         while self._is_running:
@@ -173,9 +213,8 @@ class DAQSystemSimulator:
                     scenario = self._load_scenarios[self._current_scenario]
                     
                     # Aplica carga baseada no cenário atual
-                    current_time = time.time() * self.config.simulation_speed
+                    current_time = self.clock.simulated_time()
                     
-                    import math
                     strain = (
                         scenario["base_strain"] +
                         scenario["amplitude"] * math.sin(
@@ -184,17 +223,16 @@ class DAQSystemSimulator:
                     )
                     
                     # Adiciona ruído
-                    import random
-                    noise = random.gauss(0, scenario["noise_level"] * abs(strain))
+                    noise = self._rng.gauss(0, scenario["noise_level"] * abs(strain))
                     strain += noise
                     
                     self.hx711.apply_load(strain)
                 
-                await asyncio.sleep(0.1 / self.config.simulation_speed)
+                await self.clock.sleep(0.1)
                 
             except Exception as e:
                 print(f"Erro na simulação de carga: {e}")
-                await asyncio.sleep(1.0)
+                await self.clock.sleep(1.0)
     
     async def _data_collection_loop(self) -> None:
         """Loop de coleta e processamento de dados."""
@@ -206,7 +244,7 @@ class DAQSystemSimulator:
                 
                 # Cria leitura
                 reading = StrainReading(
-                    timestamp=datetime.now(),
+                    timestamp=self.clock.now(),
                     strain_value=strain_value,
                     raw_adc_value=raw_adc,
                     sensor_id=self.esp32.device_id,
@@ -221,13 +259,11 @@ class DAQSystemSimulator:
                 await self._notify_data_callbacks(reading)
                 
                 # Simula intervalo de amostragem
-                await asyncio.sleep(
-                    self._sensor_config.sampling_rate_ms / 1000.0 / self.config.simulation_speed
-                )
+                await self.clock.sleep(self._sensor_config.sampling_rate_ms / 1000.0)
                 
             except Exception as e:
                 print(f"Erro na coleta de dados: {e}")
-                await asyncio.sleep(1.0)
+                await self.clock.sleep(1.0)
     
     async def _status_monitoring_loop(self) -> None:
         """Loop de monitoramento de status."""
@@ -241,7 +277,7 @@ class DAQSystemSimulator:
                     sensor_id=self.esp32.device_id,
                     name=self.config.device_name,
                     status=SensorStatus.ONLINE if self._is_running else SensorStatus.OFFLINE,
-                    last_seen=datetime.now(),
+                    last_seen=self.clock.now(),
                     protocol=CommunicationProtocol.BLE if self.config.enable_ble else None,
                     signal_strength=-50,  # RSSI simulado
                     firmware_version="1.0.0-sim",
@@ -251,11 +287,11 @@ class DAQSystemSimulator:
                 # Notifica callbacks de status
                 await self._notify_status_callbacks(sensor_info)
                 
-                await asyncio.sleep(5.0)  # Status a cada 5 segundos
+                await self.clock.sleep(5.0)  # Status a cada 5 segundos
                 
             except Exception as e:
                 print(f"Erro no monitoramento: {e}")
-                await asyncio.sleep(5.0)
+                await self.clock.sleep(5.0)
     
     def _add_to_history(self, reading: StrainReading) -> None:
         """Adiciona leitura ao histórico."""
@@ -357,7 +393,7 @@ class DAQSystemSimulator:
             sensor_id=status['device_id'],
             name=status['device_name'],
             status=SensorStatus.ONLINE,
-            last_seen=datetime.now(),
+            last_seen=self.clock.now(),
             protocol=CommunicationProtocol.BLE
         )
         
@@ -5,13 +5,22 @@ Simula o comportamento do ESP32 incluindo modos de energia e comunicação.
 
 import asyncio
 import random
-import time
-import uuid
-from typing import Optional, Dict, Any, Callable
+from collections import deque
+from typing import Optional, Dict, Any, Callable, List
 from enum import Enum
-from dataclasses import dataclass
+from dataclasses import dataclass, field
 
 from .hx711_simulator import HX711Simulator
+from .transmission_scheduler import TransmissionConfig, TransmissionScheduler
+from src.core.clock import Clock, WallClock
+from src.communication import (
+    ColumnarCodec,
+    CompressionType,
+    MessageProtocol,
+    MessageType,
+    PayloadEncoding,
+    TimeSeriesCodec
+)
 
 
 class ESP32PowerMode(Enum):
@@ -53,6 +62,9 @@ class ESP32Config:
     current_ble_tx: float = 12.0
     current_light_sleep: float = 0.8
     current_deep_sleep: float = 0.005
+    
+    # Política de transmissão (ver transmission_scheduler)
+    transmission: TransmissionConfig = field(default_factory=TransmissionConfig)
 
 
 class ESP32Simulator:
@@ -66,42 +78,65 @@ class ESP32Simulator:
     - Processamento e buffering de dados
     """
     
-    def __init__(self, config: Optional[ESP32Config] = None):
+    def __init__(self, config: Optional[ESP32Config] = None,
+                 clock: Optional[Clock] = None, rng: Optional[random.Random] = None):
         """
         Inicializa o simulador ESP32.
         
         Args:
             config: Configuração do simulador
+            clock: Relógio da simulação (padrão: relógio de parede)
+            rng: Gerador aleatório (padrão: módulo random)
         """
         self.config = config or ESP32Config()
-        self.device_id = str(uuid.uuid4())[:8]
+        self._clock = clock or WallClock()
+        self._rng = rng or random
+        self.device_id = f"{self._rng.getrandbits(32):08x}"
         
         # Estado do sistema
         self._power_mode = ESP32PowerMode.ACTIVE
         self._wifi_status = WiFiStatus.DISCONNECTED
         self._ble_status = BLEStatus.DISABLED
         self._is_running = False
-        self._boot_time = time.time()
+        self._boot_time = self._clock.time()
         
-        # Simulador do HX711
-        self.hx711 = HX711Simulator()
+        # Simulador do HX711 (com gerador próprio, derivado da semente)
+        self.hx711 = HX711Simulator(
+            clock=self._clock,
+            rng=random.Random(self._rng.getrandbits(64)) if rng is not None else None
+        )
         
         # Bateria simulada
         self._battery_capacity_mah = 2000.0  # Capacidade típica de bateria LiPo
         self._battery_level = 100.0  # Percentual inicial
         self._battery_voltage = 4.2  # Voltagem inicial (LiPo carregada)
+        self._last_battery_update = self._clock.simulated_time()
         
-        # Buffer de dados
-        self._data_buffer = []
+        # Buffer de dados (descarta as amostras mais antigas quando cheio)
         self._max_buffer_size = 1000
+        self._data_buffer = deque(maxlen=self._max_buffer_size)
+        self._buffer_overruns = 0
         
         # Conectividade
         self._wifi_ssid = None
         self._wifi_password = None
         self._connected_clients = set()
+        self._rssi_dbm = -60.0
+        
+        # Transmissão em lotes
+        self._sample_interval = 0.1  # segundos por leitura no loop de simulação
+        self.scheduler = TransmissionScheduler(
+            self.config,
+            self.config.transmission,
+            capacity_mah=self._battery_capacity_mah,
+            buffer_size=self._max_buffer_size,
+            sample_rate_hz=1.0 / self._sample_interval
+        )
+        self._sequence = 0
         
         # Callbacks para eventos
         self._data_callbacks = []
+        self._batch_callbacks = []
         self._status_callbacks = []
         
         # Task de simulação
@@ -113,7 +148,8 @@ class ESP32Simulator:
             return
             
         self._is_running = True
-        self._boot_time = time.time()
+        self._boot_time = self._clock.time()
+        self._last_battery_update = self._clock.simulated_time()
         
         # Inicia task de simulação
         self._simulation_task = asyncio.create_task(self._simulation_loop())
@@ -154,11 +190,11 @@ class ESP32Simulator:
                     await self._enter_deep_sleep()
                 
                 # Intervalo de simulação
-                await asyncio.sleep(0.1)  # 100ms
+                await self._clock.sleep(self._sample_interval)
                 
             except Exception as e:
                 print(f"Erro na simulação ESP32: {e}")
-                await asyncio.sleep(1.0)
+                await self._clock.sleep(1.0)
     
     def _update_battery(self) -> None:
         """Atualiza o nível da bateria baseado no consumo atual."""
@@ -168,11 +204,14 @@ class ESP32Simulator:
         # Calcula consumo atual baseado no modo de operação
         current_consumption = self._get_current_consumption()
         
-        # Calcula descarga (assumindo 1 segundo)
-        discharge_rate = (current_consumption / self._battery_capacity_mah) * 100
+        # Intervalo desde a última atualização no relógio da simulação
+        now = self._clock.simulated_time()
+        elapsed_hours = max(0.0, now - self._last_battery_update) / 3600
+        self._last_battery_update = now
         
         # Aplica descarga
-        self._battery_level = max(0, self._battery_level - discharge_rate / 3600)  # Por hora
+        discharge = (current_consumption * elapsed_hours / self._battery_capacity_mah) * 100
+        self._battery_level = max(0, self._battery_level - discharge)
         
         # Atualiza voltagem baseada no nível da bateria
         # LiPo: 4.2V (100%) -> 3.0V (0%)
@@ -208,7 +247,7 @@ class ESP32Simulator:
             
             # Cria pacote de dados
             data_point = {
-                'timestamp': time.time(),
+                'timestamp': self._clock.time(),
                 'strain_value': strain_value,
                 'raw_adc_value': raw_adc,
                 'sensor_id': self.device_id,
@@ -218,12 +257,9 @@ class ESP32Simulator:
             }
             
             # Adiciona ao buffer
-            if len(self._data_buffer) < self._max_buffer_size:
-                self._data_buffer.append(data_point)
-            else:
-                # Remove dados mais antigos se buffer cheio
-                self._data_buffer.pop(0)
-                self._data_buffer.append(data_point)
+            if len(self._data_buffer) == self._max_buffer_size:
+                self._buffer_overruns += 1
+            self._data_buffer.append(data_point)
             
             # Notifica callbacks
             await self._notify_data_callbacks(data_point)
@@ -232,36 +268,101 @@ class ESP32Simulator:
             print(f"Erro na leitura do sensor: {e}")
     
     async def _transmit_buffered_data(self) -> None:
-        """Simula transmissão dos dados em buffer."""
+        """
+        Transmite o buffer em lotes quando o escalonador acorda o rádio.
+        
+        Cada lote vira um único quadro DATA_BATCH binário, entregue aos
+        callbacks de lote.
+        """
         if not self._data_buffer:
             return
-            
-        # Simula latência de transmissão
-        await asyncio.sleep(0.01)  # 10ms
         
-        # Transmite alguns dados do buffer
-        batch_size = min(10, len(self._data_buffer))
-        transmitted_data = self._data_buffer[:batch_size]
-        self._data_buffer = self._data_buffer[batch_size:]
+        self.scheduler.set_link(
+            'wifi' if self._wifi_status == WiFiStatus.CONNECTED else 'ble',
+            self._rssi_dbm
+        )
+        oldest_age = self._clock.time() - self._data_buffer[0]['timestamp']
+        count = self.scheduler.plan(len(self._data_buffer), oldest_age)
+        if not count:
+            return
         
-        # Simula envio para clientes conectados
-        for callback in self._data_callbacks:
+        # Simula latência de transmissão
+        await self._clock.sleep(0.01)  # 10ms
+        
+        batch_size = self.scheduler.batch_size
+        while count > 0 and self._data_buffer:
+            size = min(batch_size, count, len(self._data_buffer))
+            points = [self._data_buffer.popleft() for _ in range(size)]
+            count -= size
+            
             try:
-                for data_point in transmitted_data:
-                    await callback(data_point)
-            except Exception as e:
-                print(f"Erro no callback de dados: {e}")
+                frame = self._encode_batch(points)
+            except ValueError as e:
+                print(f"Erro ao codificar lote: {e}")
+                continue
+            
+            self.scheduler.record(size, len(frame), self._clock.time() - points[0]['timestamp'])
+            await self._notify_batch_callbacks(frame)
+    
+    def _encode_batch(self, points: List[Dict[str, Any]]) -> bytes:
+        """
+        Codifica um lote de amostras como quadro DATA_BATCH.
+        
+        Args:
+            points: Amostras do buffer, em ordem
+            
+        Returns:
+            Quadro pronto para o link
+            
+        Raises:
+            ValueError: Se algum valor não couber no formato
+        """
+        sequence = self._sequence
+        self._sequence = (sequence + 1) & 0xFFFF
+        timestamps = [int(point['timestamp'] * 1e6) for point in points]
+        columns = dict(
+            packet_id=f"{self.device_id}_{sequence:05d}",
+            sensor_id=self.device_id,
+            packet_timestamp_us=timestamps[-1],
+            timestamps_us=timestamps,
+            strain_values=[point['strain_value'] for point in points],
+            raw_adc_values=[point['raw_adc_value'] for point in points],
+            temperatures=[point['temperature'] for point in points],
+            battery_levels=[point['battery_level'] for point in points],
+            sequence_number=sequence
+        )
+        
+        if self.scheduler.config.compression == CompressionType.TIMESERIES:
+            return MessageProtocol.frame_payload(
+                MessageType.DATA_BATCH,
+                CompressionType.TIMESERIES | PayloadEncoding.COLUMNAR,
+                TimeSeriesCodec.encode_columns(**columns)
+            )
+        return MessageProtocol.create_message(
+            MessageType.DATA_BATCH, ColumnarCodec.encode_columns(**columns),
+            CompressionType.NONE, PayloadEncoding.COLUMNAR
+        )
     
     async def _enter_deep_sleep(self) -> None:
         """Simula entrada em modo deep sleep."""
         self._power_mode = ESP32PowerMode.DEEP_SLEEP
         
         # Deep sleep por período configurável (simula 1 segundo)
-        await asyncio.sleep(1.0)
+        await self._clock.sleep(1.0)
         
-        # Acorda do deep sleep
+        # Acorda do deep sleep (o período dormindo é cobrado na corrente de sleep)
+        self._update_battery()
         self._power_mode = ESP32PowerMode.ACTIVE
     
+    def set_rssi(self, rssi_dbm: float) -> None:
+        """
+        Define a qualidade do link simulado.
+        
+        Args:
+            rssi_dbm: RSSI do link ativo
+        """
+        self._rssi_dbm = rssi_dbm
+    
     def _is_connected(self) -> bool:
         """Verifica se há conexões ativas."""
         return (self._wifi_status == WiFiStatus.CONNECTED or 
@@ -284,10 +385,10 @@ class ESP32Simulator:
         self._wifi_password = password
         
         # Simula tempo de conexão
-        await asyncio.sleep(2.0)
+        await self._clock.sleep(2.0)
         
         # Simula sucesso/falha (95% de sucesso)
-        if random.random() < 0.95:
+        if self._rng.random() < 0.95:
             self._wifi_status = WiFiStatus.CONNECTED
             return True
         else:
@@ -351,6 +452,16 @@ class ESP32Simulator:
             
             if 'temperature' in config:
                 self.hx711.set_temperature(config['temperature'])
+            
+            if 'transmission_interval' in config:
+                self.scheduler.configure(
+                    transmission_interval_s=float(config['transmission_interval'])
+                )
+            
+            if 'target_battery_life_h' in config:
+                self.scheduler.configure(
+                    target_battery_life_h=float(config['target_battery_life_h'])
+                )
                 
             return True
         except Exception as e:
@@ -362,6 +473,10 @@ class ESP32Simulator:
         """Adiciona callback para dados."""
         self._data_callbacks.append(callback)
     
+    def add_batch_callback(self, callback: Callable) -> None:
+        """Adiciona callback para quadros DATA_BATCH transmitidos."""
+        self._batch_callbacks.append(callback)
+    
     def add_status_callback(self, callback: Callable) -> None:
         """Adiciona callback para status."""
         self._status_callbacks.append(callback)
@@ -377,6 +492,17 @@ class ESP32Simulator:
             except Exception as e:
                 print(f"Erro no callback: {e}")
     
+    async def _notify_batch_callbacks(self, frame: bytes) -> None:
+        """Notifica callbacks de lote."""
+        for callback in self._batch_callbacks:
+            try:
+                if asyncio.iscoroutinefunction(callback):
+                    await callback(frame)
+                else:
+                    callback(frame)
+            except Exception as e:
+                print(f"Erro no callback de lote: {e}")
+    
     async def _notify_status_callbacks(self) -> None:
         """Notifica callbacks de status."""
         status = self.get_status()
@@ -405,9 +531,12 @@ class ESP32Simulator:
             'ble_status': self._ble_status.value,
             'battery_level': int(self._battery_level),
             'battery_voltage': round(self._battery_voltage, 2),
-            'uptime_seconds': time.time() - self._boot_time,
+            'uptime_seconds': self._clock.time() - self._boot_time,
             'buffer_size': len(self._data_buffer),
+            'buffer_overruns': self._buffer_overruns,
             'connected_clients': len(self._connected_clients),
+            'rssi_dbm': self._rssi_dbm,
+            'transmission': self.scheduler.get_stats(),
             'hx711_status': self.hx711.get_status()
         }
     
@@ -0,0 +1,373 @@
+"""
+Simulador de frota: centenas de nós sensores sintetizados em lote.
+
+Em vez de um conjunto de tasks asyncio e duas chamadas escalares ao
+HX711Simulator por amostra, o estado dos N nós fica em arrays numpy e
+cada tick sintetiza N sensores x M amostras de uma vez, pelo mesmo
+pipeline do HX711Simulator.read_adc_raw:
+
+1. Carga do cenário: base + amplitude * sin(2*pi*f*t + fase) + ruído
+2. Conversão strain -> ADC (2 mV/V por 1000 µε, ganho 128, ponte de 5 V)
+3. Deriva temporal acumulada e efeito de temperatura
+4. Ruído gaussiano proporcional ao valor e limite de 24 bits
+
+O strain reportado é derivado da mesma amostra ADC (com calibração), de
+modo que raw_adc_value e strain_value de uma leitura são consistentes.
+
+Cada nó emite pacotes DATA_BATCH colunares enquadrados por
+MessageProtocol, exatamente como o firmware envia no campo, para
+estressar o receptor (FrameDecoder + DataManager) a partir de uma única
+máquina.
+"""
+
+import asyncio
+import time
+from dataclasses import dataclass, field
+from typing import Any, Awaitable, Callable, Dict, List, Optional, Union
+
+import numpy as np
+
+from .hx711_simulator import HX711SimulatorConfig
+from .daq_simulator import LOAD_SCENARIOS
+from src.core.config import COMMUNICATION_CONFIG
+from src.communication import (
+    ColumnarCodec,
+    CompressionType,
+    MessageProtocol,
+    MessageType,
+    PayloadEncoding
+)
+
+
+# Parâmetros de cenário vetorizados por nó
+_SCENARIO_FIELDS = ('base_strain', 'amplitude', 'frequency', 'noise_level')
+
+# Sensibilidade da ponte: µε -> fração do fundo de escala do ADC
+_STRAIN_TO_FULL_SCALE = (0.002 / 1000.0) * 128 / 5.0
+
+# Sink de mensagens do run(): recebe a lista de frames de um tick
+FleetSink = Callable[[List[bytes]], Union[None, Awaitable[None]]]
+
+
+@dataclass
+class FleetConfig:
+    """Configuração do simulador de frota."""
+    node_count: int = 500
+    sample_rate_hz: float = 100.0
+    tick_interval: float = 0.1  # Segundos sintetizados por tick
+    sensor_prefix: str = "FLEET"
+    seed: Optional[int] = None
+    scenario_mix: Optional[Dict[str, float]] = None  # Peso por cenário (None = uniforme)
+    hx711: HX711SimulatorConfig = field(default_factory=HX711SimulatorConfig)
+    ambient_temperature: float = 25.0
+    temperature_spread: float = 10.0  # Variação de temperatura entre nós (± °C)
+    temperature_walk: float = 0.01  # Desvio do passeio aleatório por tick (°C)
+    calibration_spread: float = 0.02  # Variação do fator de calibração (±)
+    battery_drain_per_hour: float = 5.0  # % por hora
+    packet_size: Optional[int] = None  # Leituras por pacote (padrão: cabe no max_packet_size)
+
+
+class FleetSimulator:
+    """
+    Gerador de carga com N nós sensores simulados.
+
+    tick() avança o relógio simulado em um intervalo e devolve os frames
+    de todos os nós; run() repete ticks em tempo real (ou o mais rápido
+    possível) entregando os frames a um sink.
+    """
+
+    def __init__(self, config: Optional[FleetConfig] = None):
+        """
+        Inicializa a frota.
+
+        Args:
+            config: Configuração da frota
+        """
+        self.config = config or FleetConfig()
+        if self.config.node_count <= 0:
+            raise ValueError("A frota precisa de pelo menos um nó")
+        if self.config.sample_rate_hz <= 0 or self.config.tick_interval <= 0:
+            raise ValueError("Taxa de amostragem e intervalo de tick devem ser positivos")
+
+        count = self.config.node_count
+        self.rng = np.random.default_rng(self.config.seed)
+        self.sensor_ids = [f"{self.config.sensor_prefix}_{index:04d}" for index in range(count)]
+
+        # Amostras por tick e período de amostragem em µs
+        self.samples_per_tick = max(1, round(self.config.sample_rate_hz * self.config.tick_interval))
+        self.period_us = int(round(1e6 / self.config.sample_rate_hz))
+
+        limit = COMMUNICATION_CONFIG['max_packet_size']
+        self.packet_size = self.config.packet_size or max(1, min(
+            ColumnarCodec.max_readings(limit, 'fleet_00000000', sensor_id)
+            for sensor_id in self.sensor_ids
+        ))
+
+        # Estado por nó
+        self.scenario_names = list(LOAD_SCENARIOS)
+        self.scenarios = self._pick_scenarios(count)
+        self.phases = self.rng.uniform(0.0, 2 * np.pi, count)
+        spread = self.config.temperature_spread
+        self.temperatures = self.config.ambient_temperature + self.rng.uniform(-spread, spread, count)
+        spread = self.config.calibration_spread
+        self.calibration = 1.0 + self.rng.uniform(-spread, spread, count)
+        self.drift = np.zeros(count)
+        self.battery = self.rng.uniform(60.0, 100.0, count)
+        self.sequences = np.zeros(count, dtype=np.int64)
+
+        self._origin_us: Optional[int] = None
+        self._clock_us: Optional[int] = None
+        self._running = False
+        self._reset_stats()
+
+    def _reset_stats(self) -> None:
+        self.stats: Dict[str, Any] = {
+            'ticks': 0,
+            'readings': 0,
+            'packets': 0,
+            'bytes': 0,
+            'synth_seconds': 0.0,
+            'encode_seconds': 0.0,
+            'sink_seconds': 0.0,
+            'elapsed_seconds': 0.0,
+            'late_ticks': 0,
+            'max_lag_ms': 0.0
+        }
+
+    def _pick_scenarios(self, count: int) -> np.ndarray:
+        """Sorteia o cenário de cada nó segundo scenario_mix."""
+        mix = self.config.scenario_mix
+        if not mix:
+            return self.rng.integers(0, len(self.scenario_names), count)
+        unknown = set(mix) - set(self.scenario_names)
+        if unknown:
+            raise ValueError(f"Cenários desconhecidos: {sorted(unknown)}")
+        weights = np.array([mix.get(name, 0.0) for name in self.scenario_names], dtype=float)
+        if weights.sum() <= 0:
+            raise ValueError("scenario_mix precisa de pelo menos um peso positivo")
+        return self.rng.choice(len(self.scenario_names), size=count, p=weights / weights.sum())
+
+    def set_scenario(self, scenario_name: str, nodes: Optional[List[int]] = None) -> None:
+        """
+        Altera o cenário de carga de alguns nós (ou de todos).
+
+        Args:
+            scenario_name: Nome do cenário (LOAD_SCENARIOS)
+            nodes: Índices dos nós (None = todos)
+        """
+        if scenario_name not in LOAD_SCENARIOS:
+            raise ValueError(f"Cenário inválido: {scenario_name}")
+        index = self.scenario_names.index(scenario_name)
+        if nodes is None:
+            self.scenarios[:] = index
+        else:
+            self.scenarios[np.asarray(nodes, dtype=np.int64)] = index
+
+    def _scenario_columns(self) -> Dict[str, np.ndarray]:
+        """Parâmetros do cenário atual de cada nó, shape (N,)."""
+        table = {
+            name: np.array([LOAD_SCENARIOS[s][name] for s in self.scenario_names], dtype=float)
+            for name in _SCENARIO_FIELDS
+        }
+        return {name: values[self.scenarios] for name, values in table.items()}
+
+    def synthesize(self, start_us: int) -> Dict[str, np.ndarray]:
+        """
+        Sintetiza um tick de amostras para todos os nós.
+
+        Args:
+            start_us: Timestamp da primeira amostra do tick (µs desde epoch)
+
+        Returns:
+            Dicionário com 'timestamps_us' (M,), 'raw_adc' e 'strain'
+            (N, M), 'temperature' e 'battery' (N,)
+        """
+        hx = self.config.hx711
+        samples = self.samples_per_tick
+        count = self.config.node_count
+        if self._origin_us is None:
+            self._origin_us = start_us
+
+        offsets = np.arange(samples, dtype=np.int64) * self.period_us
+        timestamps = start_us + offsets
+        seconds = (timestamps - self._origin_us) / 1e6
+
+        # 1. Carga do cenário com ruído proporcional
+        scenario = self._scenario_columns()
+        angle = (2 * np.pi * scenario['frequency'][:, None] * seconds[None, :]
+                 + self.phases[:, None])
+        load = scenario['base_strain'][:, None] + scenario['amplitude'][:, None] * np.sin(angle)
+        load += self.rng.standard_normal((count, samples)) * (scenario['noise_level'][:, None] * np.abs(load))
+
+        # 2. Strain -> ADC (truncamento como int() no HX711Simulator)
+        adc = np.trunc(load * _STRAIN_TO_FULL_SCALE * hx.max_value)
+
+        # 3. Deriva acumulada amostra a amostra e efeito de temperatura
+        dt = self.period_us / 1e6
+        drift = self.drift[:, None] + hx.drift_rate * dt * np.arange(1, samples + 1)[None, :]
+        self.drift = drift[:, -1].copy()
+        adc += np.trunc(drift * hx.max_value)
+        temp_effect = (self.temperatures - 25.0) * hx.temperature_coefficient / 100
+        adc += np.trunc(temp_effect[:, None] * adc)
+
+        # 4. Ruído do conversor e limite de 24 bits
+        adc += np.trunc(self.rng.standard_normal((count, samples)) * (hx.noise_level * np.abs(adc)))
+        raw_adc = np.clip(adc, -hx.max_value, hx.max_value).astype(np.int64)
+
+        # Strain reportado: inverso da conversão, com calibração do nó
+        strain = (raw_adc / hx.max_value) * (5.0 / 128) / 0.002 * 1000.0 * self.calibration[:, None]
+
+        # Estado lento: temperatura (passeio aleatório) e bateria
+        self.temperatures += self.rng.normal(0.0, self.config.temperature_walk, count)
+        elapsed_hours = samples * dt / 3600
+        self.battery = np.maximum(0.0, self.battery - self.config.battery_drain_per_hour * elapsed_hours)
+
+        return {
+            'timestamps_us': timestamps,
+            'raw_adc': raw_adc,
+            'strain': strain,
+            'temperature': np.round(self.temperatures, 2),
+            'battery': self.battery.astype(np.int64)
+        }
+
+    def encode(self, block: Dict[str, np.ndarray]) -> List[bytes]:
+        """
+        Enquadra um tick sintetizado como mensagens DATA_BATCH colunares.
+
+        Os pacotes dos nós são intercalados (primeiro pacote de todos os
+        nós, depois o segundo...), como chegariam de nós independentes.
+
+        Args:
+            block: Resultado de synthesize()
+
+        Returns:
+            Frames prontos para o receptor
+        """
+        timestamps = block['timestamps_us'].tolist()
+        strain = block['strain'].tolist()
+        raw_adc = block['raw_adc'].tolist()
+        temperatures = block['temperature'].tolist()
+        battery = block['battery'].tolist()
+
+        messages: List[bytes] = []
+        samples = len(timestamps)
+        for start in range(0, samples, self.packet_size):
+            stop = min(start + self.packet_size, samples)
+            chunk_timestamps = timestamps[start:stop]
+            width = stop - start
+            for node, sensor_id in enumerate(self.sensor_ids):
+                sequence = int(self.sequences[node])
+                self.sequences[node] = sequence + 1
+                payload = ColumnarCodec.encode_columns(
+                    packet_id=f"fleet_{sequence:08d}",
+                    sensor_id=sensor_id,
+                    packet_timestamp_us=chunk_timestamps[-1],
+                    timestamps_us=chunk_timestamps,
+                    strain_values=strain[node][start:stop],
+                    raw_adc_values=raw_adc[node][start:stop],
+                    temperatures=[temperatures[node]] * width,
+                    battery_levels=[battery[node]] * width,
+                    sequence_number=sequence & 0xFFFF
+                )
+                messages.append(MessageProtocol.create_message(
+                    MessageType.DATA_BATCH, payload,
+                    CompressionType.NONE, PayloadEncoding.COLUMNAR
+                ))
+        return messages
+
+    def tick(self) -> List[bytes]:
+        """
+        Avança a frota um intervalo e devolve os frames gerados.
+
+        O relógio simulado começa no instante atual e avança exatamente
+        samples_per_tick períodos a cada chamada.
+
+        Returns:
+            Frames DATA_BATCH de todos os nós
+        """
+        if self._clock_us is None:
+            self._clock_us = int(time.time() * 1e6)
+
+        started = time.perf_counter()
+        block = self.synthesize(self._clock_us)
+        synthesized = time.perf_counter()
+        messages = self.encode(block)
+        self._clock_us += self.samples_per_tick * self.period_us
+
+        self.stats['synth_seconds'] += synthesized - started
+        self.stats['encode_seconds'] += time.perf_counter() - synthesized
+        self.stats['ticks'] += 1
+        self.stats['readings'] += self.samples_per_tick * self.config.node_count
+        self.stats['packets'] += len(messages)
+        self.stats['bytes'] += sum(len(message) for message in messages)
+        return messages
+
+    def stop(self) -> None:
+        """Interrompe run() após o tick atual."""
+        self._running = False
+
+    async def run(self, sink: FleetSink, duration: Optional[float] = None,
+                  realtime: bool = True) -> Dict[str, Any]:
+        """
+        Gera ticks continuamente e entrega os frames ao sink.
+
+        Args:
+            sink: Função (ou corrotina) que recebe os frames de cada tick
+            duration: Segundos simulados a gerar (None = até stop())
+            realtime: Se True, cada tick é entregue no seu instante de
+                tempo real; se False, o mais rápido possível
+
+        Returns:
+            Estatísticas da geração (ver get_stats)
+        """
+        self._running = True
+        tick_seconds = self.samples_per_tick * self.period_us / 1e6
+        started = time.perf_counter()
+        deadline = started
+
+        while self._running:
+            if duration is not None and self.stats['ticks'] * tick_seconds >= duration:
+                break
+
+            messages = self.tick()
+            sink_started = time.perf_counter()
+            try:
+                result = sink(messages)
+                if asyncio.iscoroutine(result):
+                    await result
+            except Exception as e:
+                print(f"Erro no sink da frota: {e}")
+            self.stats['sink_seconds'] += time.perf_counter() - sink_started
+
+            if realtime:
+                deadline += tick_seconds
+                delay = deadline - time.perf_counter()
+                if delay < 0:
+                    self.stats['late_ticks'] += 1
+                    self.stats['max_lag_ms'] = max(self.stats['max_lag_ms'], -delay * 1000)
+                await asyncio.sleep(max(0.0, delay))
+            else:
+                await asyncio.sleep(0)
+
+        self._running = False
+        self.stats['elapsed_seconds'] = time.perf_counter() - started
+        return self.get_stats()
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Retorna estatísticas da geração.
+
+        Returns:
+            Contadores, tempos e taxas. generation_rate considera só a
+            síntese e o enquadramento (leituras/s), offered_rate a carga
+            nominal da frota e output_rate o que foi efetivamente gerado
+            por segundo de relógio.
+        """
+        stats = dict(self.stats)
+        busy = stats['synth_seconds'] + stats['encode_seconds']
+        stats['nodes'] = self.config.node_count
+        stats['offered_rate'] = self.config.node_count * 1e6 / self.period_us
+        stats['generation_rate'] = stats['readings'] / busy if busy > 0 else 0.0
+        stats['output_rate'] = (stats['readings'] / stats['elapsed_seconds']
+                                if stats['elapsed_seconds'] > 0 else 0.0)
+        return stats
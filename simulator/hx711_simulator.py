@@ -9,6 +9,8 @@ import math
 from typing import Optional
 from dataclasses import dataclass
 
+from src.core.clock import Clock, WallClock
+
 
 @dataclass
 class HX711SimulatorConfig:
@@ -28,19 +30,24 @@ class HX711Simulator:
     deriva temporal e efeitos de temperatura.
     """
     
-    def __init__(self, config: Optional[HX711SimulatorConfig] = None):
+    def __init__(self, config: Optional[HX711SimulatorConfig] = None,
+                 clock: Optional[Clock] = None, rng: Optional[random.Random] = None):
         """
         Inicializa o simulador HX711.
         
         Args:
             config: Configuração do simulador
+            clock: Relógio da simulação (padrão: relógio de parede)
+            rng: Gerador aleatório (padrão: módulo random)
         """
         self.config = config or HX711SimulatorConfig()
+        self._clock = clock or WallClock()
+        self._rng = rng or random
         self._baseline_value = 0  # Valor de referência (zero strain)
         self._current_strain = 0.0  # Deformação atual em microstrains
         self._temperature = 25.0  # Temperatura atual em °C
         self._drift_accumulator = 0.0  # Acumulador de deriva
-        self._last_reading_time = time.time()
+        self._last_reading_time = self._clock.simulated_time()
         self._calibration_factor = 1.0  # Fator de calibração
         self._is_ready = True
         
@@ -84,12 +91,12 @@ class HX711Simulator:
         Args:
             time_factor: Fator de velocidade da simulação
         """
-        current_time = time.time() * time_factor
+        current_time = self._clock.simulated_time() * time_factor
         
         # Simula diferentes componentes de frequência
         base_component = math.sin(2 * math.pi * self._base_frequency * current_time)
         high_freq_component = 0.3 * math.sin(2 * math.pi * self._base_frequency * 5 * current_time)
-        random_component = 0.1 * (random.random() - 0.5)
+        random_component = 0.1 * (self._rng.random() - 0.5)
         
         # Combina componentes para criar um sinal realístico
         total_strain = (
@@ -109,7 +116,7 @@ class HX711Simulator:
         if not self._is_ready:
             raise RuntimeError("ADC não está pronto para leitura")
         
-        current_time = time.time()
+        current_time = self._clock.simulated_time()
         time_delta = current_time - self._last_reading_time
         self._last_reading_time = current_time
         
@@ -132,7 +139,7 @@ class HX711Simulator:
         adc_value += int(temp_effect * adc_value)
         
         # Adiciona ruído
-        noise = random.gauss(0, self.config.noise_level * abs(adc_value))
+        noise = self._rng.gauss(0, self.config.noise_level * abs(adc_value))
         adc_value += int(noise)
         
         # Limita aos valores válidos do ADC
@@ -204,7 +211,7 @@ class HX711Simulator:
         self._baseline_value = 0
         self._current_strain = 0.0
         self._drift_accumulator = 0.0
-        self._last_reading_time = time.time()
+        self._last_reading_time = self._clock.simulated_time()
         self._calibration_factor = 1.0
         self._temperature = 25.0
         self._is_ready = True
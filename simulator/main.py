@@ -8,12 +8,15 @@ import argparse
 import sys
 import time
 from pathlib import Path
+from typing import Optional
 
 # Adiciona diretório pai ao path para importações
 sys.path.append(str(Path(__file__).parent.parent))
 
 from simulator.daq_simulator import DAQSystemSimulator, SimulatorConfig
+from src.core.clock import VirtualClock
 from src.core.models import StrainReading, SensorInfo
+from src.communication import FrameDecoder, ProtocolError
 
 
 class SimulatorCLI:
@@ -62,6 +65,145 @@ class SimulatorCLI:
         # Loop de comandos
         await self._command_loop()
     
+    async def run_fleet(self, node_count: int, sample_rate_hz: float,
+                        duration: float, realtime: bool = True,
+                        seed: Optional[int] = None, shards: int = 0) -> None:
+        """
+        Gera carga de uma frota simulada contra o caminho real de ingestão.
+
+        Os frames de cada tick passam por FrameDecoder e entram no
+        DataManager, como chegariam dos nós no campo. Com shards > 0 os
+        frames são distribuídos por sensor entre processos worker
+        (data.shards), que decodificam em paralelo e devolvem os lotes ao
+        DataManager. Ao final
+        são exibidas as taxas de geração e de ingestão.
+
+        Args:
+            node_count: Número de nós sensores
+            sample_rate_hz: Taxa de amostragem por nó
+            duration: Segundos simulados
+            realtime: Se False, gera o mais rápido possível (teto de ingestão)
+            seed: Semente do gerador aleatório
+            shards: Workers de ingestão (0 = no processo principal)
+        """
+        # Importações tardias: numpy e DataManager só são necessários neste modo
+        from simulator.fleet_simulator import FleetSimulator, FleetConfig
+        from src.data.data_manager import DataManager
+
+        fleet = FleetSimulator(FleetConfig(
+            node_count=node_count,
+            sample_rate_hz=sample_rate_hz,
+            seed=seed
+        ))
+        data_manager = DataManager()
+        decoder = FrameDecoder(link='fleet')
+        ingest = {'readings': 0, 'errors': 0, 'seconds': 0.0}
+        sharded = None
+        if shards:
+            from src.data.shards import ShardedIngest
+            sharded = ShardedIngest(shards=shards, data_manager=data_manager)
+            sharded.start()
+
+        def sink_sharded(messages):
+            # Mensagens do tick em ordem de nó: a i-ésima vem do nó i % node_count
+            started = time.perf_counter()
+            for index, message in enumerate(messages):
+                sharded.submit(fleet.sensor_ids[index % node_count], message)
+            sharded.dispatch()
+            ingest['seconds'] += time.perf_counter() - started
+
+        def sink(messages):
+            started = time.perf_counter()
+            for message in messages:
+                try:
+                    for frame in decoder.feed(message):
+                        batch = frame.to_batch()
+                        data_manager.add_batch(batch)
+                        ingest['readings'] += len(batch)
+                except (ProtocolError, ValueError) as e:
+                    ingest['errors'] += 1
+                    print(f"Erro na ingestão da frota: {e}")
+            ingest['seconds'] += time.perf_counter() - started
+
+        print("=== Simulador de Frota ===")
+        print(f"Nós: {node_count} | Taxa: {sample_rate_hz:g} Hz | "
+              f"Modo: {'tempo real' if realtime else 'máximo'}"
+              + (f" | Workers: {shards}" if shards else ""))
+        print("-" * 40)
+
+        try:
+            stats = await fleet.run(sink_sharded if sharded else sink,
+                                    duration=duration, realtime=realtime)
+            flush_started = time.perf_counter()
+            if sharded:
+                sharded.sync()
+                shard_stats = sharded.get_stats()
+                ingest['readings'] = shard_stats.get('readings', 0)
+                ingest['errors'] = shard_stats.get('errors', 0)
+                # Tempo de ingestão medido até os workers confirmarem
+                ingest['seconds'] += time.perf_counter() - flush_started
+            data_manager.flush()
+            flush_seconds = time.perf_counter() - flush_started
+        finally:
+            if sharded:
+                sharded.stop()
+            data_manager.close()
+
+        ingest_rate = ingest['readings'] / ingest['seconds'] if ingest['seconds'] > 0 else 0.0
+        total_seconds = stats['elapsed_seconds'] + flush_seconds
+        print(f"Leituras geradas: {stats['readings']} em {stats['packets']} pacotes "
+              f"({stats['bytes'] / 1e6:.2f} MB)")
+        print(f"Carga nominal: {stats['offered_rate']:.0f} leituras/s")
+        print(f"Geração (síntese + enquadramento): {stats['generation_rate']:.0f} leituras/s")
+        print(f"Ingestão (decodificação + DataManager): {ingest_rate:.0f} leituras/s")
+        print(f"Sustentado (com flush): {ingest['readings'] / total_seconds:.0f} leituras/s")
+        if realtime:
+            print(f"Ticks atrasados: {stats['late_ticks']} (máx. {stats['max_lag_ms']:.1f} ms)")
+        if ingest['errors']:
+            print(f"Erros de ingestão: {ingest['errors']}")
+
+    def run_virtual(self, config: SimulatorConfig, duration: float,
+                    scenario: str = "idle") -> None:
+        """
+        Executa o simulador em tempo virtual (eventos discretos), sem CLI.
+
+        O intervalo simulado é percorrido tão rápido quanto a CPU permite;
+        com config.seed definido, a saída é idêntica a cada execução.
+
+        Args:
+            config: Configuração do simulador
+            duration: Segundos simulados
+            scenario: Cenário de carga
+        """
+        clock = VirtualClock()
+        self.simulator = DAQSystemSimulator(config, clock=clock)
+        self.simulator.set_load_scenario(scenario)
+        readings = {'count': 0}
+
+        def count_reading(reading: StrainReading) -> None:
+            readings['count'] += 1
+
+        self.simulator.add_data_callback(count_reading)
+
+        print("=== Simulador DAQ (tempo virtual) ===")
+        print(f"Duração: {duration:g} s simulados | Semente: {config.seed}")
+        print("-" * 40)
+
+        started = time.perf_counter()
+        stats = clock.run(self.simulator.run_for(duration))
+        elapsed = time.perf_counter() - started
+
+        transmission = self.simulator.esp32.get_status()['transmission']
+        print(f"Leituras: {readings['count']} em {elapsed:.2f} s "
+              f"({clock.elapsed / elapsed:.0f}x tempo real)")
+        if stats.get('total_readings'):
+            print(f"Strain: min {stats['strain_stats']['min']:+.2f} | "
+                  f"máx {stats['strain_stats']['max']:+.2f} µε")
+        print(f"Bateria: {stats.get('battery_level', 0.0):.1f}%")
+        if transmission['transmissions']:
+            print(f"Amostras transmitidas: {transmission['samples_sent']} em "
+                  f"{transmission['transmissions']} lotes")
+
     async def _command_loop(self) -> None:
         """Loop de processamento de comandos."""
         while self._running:
@@ -193,9 +335,30 @@ async def main():
     parser.add_argument("--no-ble", action="store_true", help="Desabilita BLE")
     parser.add_argument("--wifi", action="store_true", help="Habilita WiFi")
     parser.add_argument("--scenario", default="idle", help="Cenário inicial")
+    parser.add_argument("--fleet", type=int, metavar="NOS",
+                        help="Modo frota: gera carga de NOS sensores contra o DataManager")
+    parser.add_argument("--fleet-rate", type=float, default=100.0,
+                        help="Taxa de amostragem por nó no modo frota (Hz)")
+    parser.add_argument("--duration", type=float, default=10.0,
+                        help="Segundos simulados nos modos frota e virtual")
+    parser.add_argument("--max-speed", action="store_true",
+                        help="Modo frota sem pacing de tempo real (mede o teto de ingestão)")
+    parser.add_argument("--seed", type=int, help="Semente aleatória dos modos frota e virtual")
+    parser.add_argument("--virtual", action="store_true",
+                        help="Tempo virtual: simula --duration segundos o mais rápido possível")
+    parser.add_argument("--shards", type=int, default=0, metavar="N",
+                        help="Modo frota com N processos de ingestão (0 = processo único)")
     
     args = parser.parse_args()
     
+    cli = SimulatorCLI()
+    
+    if args.fleet:
+        await cli.run_fleet(args.fleet, args.fleet_rate, args.duration,
+                            realtime=not args.max_speed, seed=args.seed,
+                            shards=args.shards)
+        return
+    
     # Cria configuração
     config = SimulatorConfig(
         device_name=args.name,
@@ -203,12 +366,16 @@ async def main():
         enable_ble=not args.no_ble,
         enable_wifi=args.wifi,
         auto_start=True,
-        realistic_loads=True
+        realistic_loads=True,
+        seed=args.seed
     )
     
-    # Inicia CLI
-    cli = SimulatorCLI()
+    if args.virtual:
+        # O relógio virtual roda o próprio event loop, fora do loop atual
+        await asyncio.to_thread(cli.run_virtual, config, args.duration, args.scenario)
+        return
     
+    # Inicia CLI
     try:
         await cli.start_simulator(config)
     except KeyboardInterrupt:
@@ -0,0 +1,347 @@
+"""
+Escalonador de transmissão do ESP32 simulado, orientado a energia.
+
+Decide quantas amostras acumular por lote e quando acordar o rádio a
+partir de três entradas:
+
+1. Ocupação do buffer: acima da marca d'água o lote é enviado na hora
+2. Qualidade do link (RSSI): a taxa de erro de bit cresce uma década a
+   cada ber_slope_db abaixo de rssi_reference_dbm; quadros longos em
+   link ruim exigem mais retransmissões
+3. Orçamento de energia: autonomia alvo da bateria
+
+Modelo de carga por acordar do rádio (mA·s):
+
+    Q(n) = I_tx * (t_wakeup + tentativas(n) * bytes(n) / vazão)
+
+com I_tx = corrente ativa + corrente de TX do rádio, bytes(n) =
+overhead + n * bytes_por_amostra (aprendido dos quadros enviados) e
+tentativas(n) o número esperado de envios com sucesso por quadro
+p = (1 - BER)^(8 * bytes(n)) e até max_attempts tentativas. A corrente
+média com lotes de n amostras a uma taxa r é
+
+    I(n) = I_base + (r / n) * Q(n)
+
+onde I_base é o light sleep entre amostras mais o tempo ativo de cada
+leitura. A carga por amostra entregue, Q(n) / (n * entrega(n)), cai com n
+(o acordar é amortizado) até o ponto em que as retransmissões e quadros
+perdidos dominam; lotes maiores que esse ótimo gastam mais energia e têm
+mais latência, e por isso nunca são escolhidos.
+
+Sem orçamento o lote acompanha o intervalo de transmissão configurado
+(SensorConfiguration.transmission_interval_s). Com orçamento, o lote é
+esticado até o menor tamanho que cabe nele, limitado por max_latency_s.
+"""
+
+import math
+from dataclasses import dataclass
+from typing import TYPE_CHECKING, Any, Dict, List, Optional, Sequence
+
+from src.communication import CompressionType
+
+if TYPE_CHECKING:
+    from .esp32_simulator import ESP32Config
+
+
+@dataclass
+class TransmissionConfig:
+    """Política de transmissão e parâmetros do modelo de rádio."""
+    transmission_interval_s: float = 1.0  # latência nominal por lote
+    max_latency_s: float = 30.0  # teto quando o orçamento exige lotes maiores
+    target_battery_life_h: float = 0.0  # autonomia alvo (0 = sem orçamento)
+    max_batch_samples: int = 512  # amostras por quadro
+    high_watermark: float = 0.75  # fração do buffer que força transmissão
+    compression: int = CompressionType.TIMESERIES
+
+    # Modelo de link
+    wifi_wakeup_s: float = 0.05  # reassociação saindo do modem sleep
+    ble_wakeup_s: float = 0.0075  # um evento de conexão BLE
+    wifi_throughput_bytes_s: float = 250000.0
+    ble_throughput_bytes_s: float = 20000.0
+    frame_overhead_bytes: int = 64  # cabeçalhos de frame, pacote e link
+    rssi_reference_dbm: float = -60.0
+    ber_reference: float = 1e-7  # BER em rssi_reference_dbm
+    ber_slope_db: float = 10.0  # dB por década de BER
+    max_attempts: int = 8  # tentativas por quadro antes de descartar
+
+    # Custo de cada leitura do sensor (HX711 + processamento)
+    sample_active_s: float = 0.002
+
+
+# Bytes por amostra antes do primeiro quadro enviado
+_INITIAL_BYTES_PER_SAMPLE = {
+    CompressionType.NONE: 14.0,
+    CompressionType.TIMESERIES: 6.0
+}
+
+
+class TransmissionScheduler:
+    """
+    Escolhe tamanho de lote e instante de transmissão do ESP32.
+
+    O tamanho de lote é recalculado só quando uma entrada do modelo muda
+    (link, RSSI, taxa de amostragem, política ou bytes por amostra).
+    """
+
+    def __init__(self, power: 'ESP32Config', config: Optional[TransmissionConfig] = None,
+                 capacity_mah: float = 2000.0, buffer_size: int = 1000,
+                 sample_rate_hz: float = 10.0):
+        """
+        Inicializa o escalonador.
+
+        Args:
+            power: Configuração do ESP32 (correntes do modelo de energia)
+            config: Política de transmissão
+            capacity_mah: Capacidade da bateria
+            buffer_size: Capacidade do buffer de amostras
+            sample_rate_hz: Taxa de amostragem do sensor
+        """
+        self.power = power
+        self.config = config or TransmissionConfig()
+        self.capacity_mah = capacity_mah
+        self.buffer_size = buffer_size
+        self._sample_rate = sample_rate_hz
+        self._link = 'ble'
+        self._rssi_dbm = self.config.rssi_reference_dbm
+        self._bytes_per_sample = _INITIAL_BYTES_PER_SAMPLE.get(self.config.compression, 14.0)
+        self._batch_size: Optional[int] = None
+
+        self.stats = {
+            'transmissions': 0,
+            'samples_sent': 0,
+            'bytes_sent': 0,
+            'charge_mah': 0.0,
+            'max_latency_s': 0.0
+        }
+
+    # Entradas do modelo
+    def set_sample_rate(self, sample_rate_hz: float) -> None:
+        """Atualiza a taxa de amostragem (Hz)."""
+        if sample_rate_hz <= 0:
+            raise ValueError("Taxa de amostragem deve ser positiva")
+        if sample_rate_hz != self._sample_rate:
+            self._sample_rate = sample_rate_hz
+            self._batch_size = None
+
+    def set_link(self, link: str, rssi_dbm: float) -> None:
+        """
+        Atualiza o rádio em uso e a qualidade do link.
+
+        Args:
+            link: 'wifi' ou 'ble'
+            rssi_dbm: RSSI do link
+        """
+        if link not in ('wifi', 'ble'):
+            raise ValueError(f"Link desconhecido: {link}")
+        if link != self._link or abs(rssi_dbm - self._rssi_dbm) >= 1.0:
+            self._link = link
+            self._rssi_dbm = rssi_dbm
+            self._batch_size = None
+
+    def configure(self, **policy: Any) -> None:
+        """
+        Altera campos da política (ex.: transmission_interval_s).
+
+        Raises:
+            ValueError: Campo inexistente
+        """
+        for name, value in policy.items():
+            if not hasattr(self.config, name):
+                raise ValueError(f"Parâmetro de transmissão desconhecido: {name}")
+            setattr(self.config, name, value)
+        self._batch_size = None
+
+    # Modelo de energia
+    def _radio(self) -> tuple:
+        """(corrente em mA, tempo de acordar, vazão) do rádio atual."""
+        config = self.config
+        if self._link == 'wifi':
+            return (self.power.current_active + self.power.current_wifi_tx,
+                    config.wifi_wakeup_s, config.wifi_throughput_bytes_s)
+        return (self.power.current_active + self.power.current_ble_tx,
+                config.ble_wakeup_s, config.ble_throughput_bytes_s)
+
+    def _base_current(self) -> float:
+        """Corrente média fora do rádio: light sleep + leituras."""
+        duty = min(1.0, self._sample_rate * self.config.sample_active_s)
+        return (self.power.current_light_sleep +
+                duty * (self.power.current_active - self.power.current_light_sleep))
+
+    def _frame_bytes(self, samples: int) -> float:
+        return self.config.frame_overhead_bytes + samples * self._bytes_per_sample
+
+    def _link_cost(self, frame_bytes: float) -> tuple:
+        """(tentativas esperadas, probabilidade de entrega) de um quadro."""
+        config = self.config
+        ber = config.ber_reference * 10 ** ((config.rssi_reference_dbm - self._rssi_dbm) /
+                                            config.ber_slope_db)
+        success = math.exp(8 * frame_bytes * math.log1p(-min(ber, 0.5)))
+        if success <= 0:
+            return float(config.max_attempts), 0.0
+        delivery = 1.0 - (1.0 - success) ** config.max_attempts
+        return delivery / success, delivery
+
+    def _charge_per_wakeup(self, samples: int) -> float:
+        """Carga (mA·s) para acordar o rádio e enviar um lote."""
+        current, wakeup, throughput = self._radio()
+        frame_bytes = self._frame_bytes(samples)
+        attempts, _ = self._link_cost(frame_bytes)
+        return current * (wakeup + attempts * frame_bytes / throughput)
+
+    def _charge_per_sample(self, samples: int) -> float:
+        """Carga (mA·s) por amostra entregue."""
+        _, delivery = self._link_cost(self._frame_bytes(samples))
+        if delivery <= 0:
+            return math.inf
+        return self._charge_per_wakeup(samples) / (samples * delivery)
+
+    def _average_current(self, samples: int) -> float:
+        return (self._base_current() +
+                self._sample_rate / samples * self._charge_per_wakeup(samples))
+
+    def model(self, batch_samples: int) -> Dict[str, float]:
+        """
+        Avalia uma política de lote fixo.
+
+        Args:
+            batch_samples: Amostras por lote
+
+        Returns:
+            Latência (pior caso e média), fração de quadros entregues,
+            corrente média, autonomia e amostras entregues por mAh
+        """
+        batch_samples = max(1, int(batch_samples))
+        _, wakeup, throughput = self._radio()
+        frame_bytes = self._frame_bytes(batch_samples)
+        attempts, delivery = self._link_cost(frame_bytes)
+        airtime = wakeup + attempts * frame_bytes / throughput
+        current = self._average_current(batch_samples)
+        return {
+            'batch_samples': batch_samples,
+            'latency_s': batch_samples / self._sample_rate + airtime,
+            'mean_latency_s': (batch_samples - 1) / (2 * self._sample_rate) + airtime,
+            'delivery_ratio': delivery,
+            'average_current_ma': current,
+            'battery_life_h': self.capacity_mah / current,
+            'samples_per_mah': self._sample_rate * delivery * 3600.0 / current
+        }
+
+    def tradeoff(self, batch_sizes: Optional[Sequence[int]] = None) -> List[Dict[str, float]]:
+        """
+        Curva autonomia x latência.
+
+        Args:
+            batch_sizes: Tamanhos de lote avaliados (padrão: potências de 2
+                até o maior lote permitido)
+
+        Returns:
+            Lista de model() por tamanho de lote
+        """
+        if batch_sizes is None:
+            limit = self._batch_limit()
+            batch_sizes = [1 << i for i in range(limit.bit_length()) if 1 << i <= limit]
+        return [self.model(samples) for samples in batch_sizes]
+
+    # Decisão
+    def _batch_limit(self) -> int:
+        """Maior lote permitido por quadro, buffer e latência máxima."""
+        config = self.config
+        return max(1, min(config.max_batch_samples,
+                          int(self.buffer_size * config.high_watermark),
+                          int(self._sample_rate * config.max_latency_s)))
+
+    def _choose_batch(self) -> int:
+        limit = self._batch_limit()
+        # Ótimo de energia por amostra: lotes maiores são dominados
+        best = min(range(1, limit + 1), key=self._charge_per_sample)
+        nominal = min(best, max(1, round(self._sample_rate * self.config.transmission_interval_s)))
+
+        target_h = self.config.target_battery_life_h
+        if target_h <= 0:
+            return nominal
+        budget_ma = self.capacity_mah / target_h
+        for samples in range(nominal, best + 1):
+            if self._average_current(samples) <= budget_ma:
+                return samples
+        return best
+
+    @property
+    def batch_size(self) -> int:
+        """Amostras por lote na política atual."""
+        if self._batch_size is None:
+            self._batch_size = self._choose_batch()
+        return self._batch_size
+
+    def plan(self, fill: int, oldest_age_s: float) -> int:
+        """
+        Decide se o rádio acorda agora.
+
+        Args:
+            fill: Amostras no buffer
+            oldest_age_s: Idade da amostra mais antiga do buffer
+
+        Returns:
+            Amostras a enviar agora (0 = aguardar). Prazo vencido ou buffer
+            acima da marca d'água esvaziam o buffer.
+        """
+        if fill <= 0:
+            return 0
+        batch = self.batch_size
+        if (fill >= self.buffer_size * self.config.high_watermark or
+                oldest_age_s >= batch / self._sample_rate):
+            return fill
+        # Só lotes completos; o resto espera o próximo acordar
+        return fill - fill % batch
+
+    def next_wakeup_s(self, fill: int, oldest_age_s: float) -> float:
+        """Segundos até o próximo acordar do rádio."""
+        batch = self.batch_size
+        until_full = (batch - fill) / self._sample_rate
+        if fill <= 0:
+            return until_full
+        return max(0.0, min(until_full, batch / self._sample_rate - oldest_age_s))
+
+    def record(self, samples: int, frame_bytes: int, latency_s: float) -> None:
+        """
+        Contabiliza um quadro enviado.
+
+        Args:
+            samples: Amostras no quadro
+            frame_bytes: Tamanho do quadro codificado
+            latency_s: Idade da amostra mais antiga no envio
+        """
+        current, wakeup, throughput = self._radio()
+        attempts, _ = self._link_cost(frame_bytes)
+        charge = current * (wakeup + attempts * frame_bytes / throughput)
+        stats = self.stats
+        stats['transmissions'] += 1
+        stats['samples_sent'] += samples
+        stats['bytes_sent'] += frame_bytes
+        stats['charge_mah'] += charge / 3600.0
+        stats['max_latency_s'] = max(stats['max_latency_s'], latency_s)
+
+        # Bytes por amostra aprendidos dos quadros reais (média móvel)
+        if samples:
+            observed = max(0.0, frame_bytes - self.config.frame_overhead_bytes) / samples
+            estimate = 0.8 * self._bytes_per_sample + 0.2 * observed
+            if abs(estimate - self._bytes_per_sample) >= 0.25:
+                self._batch_size = None
+            self._bytes_per_sample = estimate
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Retorna política atual, autonomia modelada e contadores.
+
+        Returns:
+            Dicionário com estatísticas do escalonador
+        """
+        stats = dict(self.stats)
+        stats.update({
+            'link': self._link,
+            'rssi_dbm': self._rssi_dbm,
+            'bytes_per_sample': round(self._bytes_per_sample, 2),
+            'samples_per_mah_tx': (stats['samples_sent'] / stats['charge_mah']
+                                   if stats['charge_mah'] else 0.0),
+            'model': self.model(self.batch_size)
+        })
+        return stats
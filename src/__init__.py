@@ -2,7 +2,25 @@
 
 from .core import *
 from .communication import *
-from .data import *
+# Submódulos opcionais de data (captura, fadiga, alarmes, shards) ficam
+# para o primeiro acesso: apenas os nomes carregados na importação
+from .data import (
+    DataManager,
+    DataStorageError,
+    DataBuffer,
+    ReadingColumns,
+    DatabaseManager,
+    DataExporter,
+    OscilloscopeStreamer,
+    ColumnRing,
+    ReadingQuery,
+    QueryCursor,
+    SnapshotReader,
+    SnapshotError,
+    OscilloscopeAPI,
+    OscilloscopeConfig,
+    WebSocketStreamer
+)
 
 __version__ = "1.0.0"
 __author__ = "Gabriel Hiro Furukawa, Rafael Perassi Zanchetta"
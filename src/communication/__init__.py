@@ -4,6 +4,9 @@ from .protocol import (
     MessageProtocol,
     MessageType,
     CompressionType,
+    PayloadEncoding,
+    Frame,
+    FrameDecoder,
     DataPacketEncoder,
     ConfigurationProtocol,
     StatusProtocol,
@@ -13,6 +16,17 @@ from .protocol import (
     create_error_message
 )
 
+from .columnar import ColumnarCodec
+from .timeseries import TimeSeriesCodec, TimeSeriesEncoder, TimeSeriesDecoder
+from .transfer import FragmentSender, TransferReceiver, fragment_capacity
+from .link_manager import (
+    LinkManager,
+    LinkState,
+    Link,
+    IngestScheduler,
+    ReconnectBackoff
+)
+
 from .ble_simulator import (
     BLESimulator,
     BLEDevice,
@@ -25,6 +39,9 @@ __all__ = [
     'MessageProtocol',
     'MessageType',
     'CompressionType',
+    'PayloadEncoding',
+    'Frame',
+    'FrameDecoder',
     'DataPacketEncoder',
     'ConfigurationProtocol',
     'StatusProtocol',
@@ -32,6 +49,18 @@ __all__ = [
     'create_ping_message',
     'create_pong_message',
     'create_error_message',
+    'ColumnarCodec',
+    'TimeSeriesCodec',
+    'TimeSeriesEncoder',
+    'TimeSeriesDecoder',
+    'FragmentSender',
+    'TransferReceiver',
+    'fragment_capacity',
+    'LinkManager',
+    'LinkState',
+    'Link',
+    'IngestScheduler',
+    'ReconnectBackoff',
     
     # BLE Simulator
     'BLESimulator',
@@ -1,17 +1,21 @@
 """
 Simulador de comunicação BLE (Bluetooth Low Energy).
 Simula descoberta, conexão e troca de dados via BLE.
+
+Todas as conexões são mantidas por uma única task, e os callbacks nunca
+são aguardados em série: os síncronos rodam na hora e as corrotinas viram
+tasks, de modo que um consumidor lento não atrasa os demais links.
 """
 
 import asyncio
 import random
-import time
-import uuid
-from typing import Dict, List, Optional, Callable, Any
+from functools import partial
+from typing import Dict, List, Optional, Callable, Any, Set
 from dataclasses import dataclass
 from enum import Enum
 
 from .protocol import MessageProtocol, MessageType, ProtocolError
+from ..core.clock import Clock, WallClock
 
 
 class BLEDeviceType(Enum):
@@ -57,9 +61,18 @@ class BLESimulator:
     - Gerenciamento de múltiplas conexões
     """
     
-    def __init__(self):
-        """Inicializa o simulador BLE."""
-        self._state = BLEConnectionState.DISCONNECTED
+    def __init__(self, clock: Optional[Clock] = None, rng: Optional[random.Random] = None):
+        """
+        Inicializa o simulador BLE.
+        
+        Args:
+            clock: Relógio da simulação (padrão: relógio de parede)
+            rng: Gerador aleatório (padrão: módulo random)
+        """
+        self._clock = clock or WallClock()
+        self._rng = rng or random
+        self._state = BLEConnectionState.DISCONNECTED  # Estado do adaptador
+        self._link_states: Dict[str, BLEConnectionState] = {}
         self._discovered_devices: Dict[str, BLEDevice] = {}
         self._connected_devices: Dict[str, BLEDevice] = {}
         self._scan_callbacks: List[Callable] = []
@@ -71,20 +84,21 @@ class BLESimulator:
         
         # Tasks de simulação
         self._scan_task: Optional[asyncio.Task] = None
-        self._connection_tasks: Dict[str, asyncio.Task] = {}
+        self._link_task: Optional[asyncio.Task] = None
+        self._callback_tasks: Set[asyncio.Task] = set()
         
     def _simulate_nearby_devices(self) -> None:
         """Simula dispositivos DAQ próximos."""
         # Simula 2-3 sensores DAQ próximos
-        for i in range(random.randint(2, 3)):
-            device_id = f"DAQ_{uuid.uuid4().hex[:6].upper()}"
+        for i in range(self._rng.randint(2, 3)):
+            device_id = f"DAQ_{self._rng.getrandbits(24):06X}"
             address = self._generate_mac_address()
             
             device = BLEDevice(
                 address=address,
                 name=f"DAQ Sensor {i+1}",
                 device_type=BLEDeviceType.DAQ_SENSOR,
-                rssi=random.randint(-80, -30),
+                rssi=self._rng.randint(-80, -30),
                 service_uuids=["12345678-1234-1234-1234-123456789abc"],
                 manufacturer_data=b"CNH_DAQ"
             )
@@ -94,7 +108,7 @@ class BLESimulator:
     def _generate_mac_address(self) -> str:
         """Gera um endereço MAC simulado."""
         return ":".join([
-            f"{random.randint(0, 255):02X}" for _ in range(6)
+            f"{self._rng.randint(0, 255):02X}" for _ in range(6)
         ])
     
     async def start_scan(self, timeout: float = 10.0) -> None:
@@ -122,20 +136,28 @@ class BLESimulator:
         if self._state == BLEConnectionState.SCANNING:
             self._state = BLEConnectionState.DISCONNECTED
     
+    async def stop(self) -> None:
+        """Para a varredura, desconecta todos os dispositivos e aguarda os callbacks."""
+        await self.stop_scan()
+        for address in list(self._connected_devices):
+            await self.disconnect(address)
+        if self._callback_tasks:
+            await asyncio.gather(*self._callback_tasks, return_exceptions=True)
+    
     async def _scan_loop(self, timeout: float) -> None:
         """Loop de varredura de dispositivos."""
-        start_time = time.time()
+        start_time = self._clock.time()
         
         try:
-            while time.time() - start_time < timeout:
+            while self._clock.time() - start_time < timeout:
                 # Simula descoberta de novos dispositivos periodicamente
-                if random.random() < 0.3:  # 30% chance por iteração
-                    await self._simulate_device_discovery()
+                if self._rng.random() < 0.3:  # 30% chance por iteração
+                    self._simulate_device_discovery()
                 
                 # Simula mudanças no RSSI dos dispositivos conhecidos
-                await self._update_device_rssi()
+                self._update_device_rssi()
                 
-                await asyncio.sleep(0.5)  # Intervalo de varredura
+                await self._clock.sleep(0.5)  # Intervalo de varredura
                 
         except asyncio.CancelledError:
             pass
@@ -143,29 +165,22 @@ class BLESimulator:
             if self._state == BLEConnectionState.SCANNING:
                 self._state = BLEConnectionState.DISCONNECTED
     
-    async def _simulate_device_discovery(self) -> None:
+    def _simulate_device_discovery(self) -> None:
         """Simula descoberta de um novo dispositivo."""
         # Ocasionalmente "descobre" dispositivos já conhecidos
         # (simula dispositivos entrando/saindo de alcance)
         
         for address, device in self._discovered_devices.items():
             # Simula dispositivo aparecendo/desaparecendo
-            if random.random() < 0.1:  # 10% chance
+            if self._rng.random() < 0.1:  # 10% chance
                 # Notifica callbacks de descoberta
-                for callback in self._scan_callbacks:
-                    try:
-                        if asyncio.iscoroutinefunction(callback):
-                            await callback(device)
-                        else:
-                            callback(device)
-                    except Exception as e:
-                        print(f"Erro no callback de scan: {e}")
+                self._dispatch(self._scan_callbacks, (device,), "scan")
     
-    async def _update_device_rssi(self) -> None:
+    def _update_device_rssi(self) -> None:
         """Atualiza RSSI dos dispositivos (simula movimento)."""
         for device in self._discovered_devices.values():
             # Simula pequenas variações no RSSI
-            variation = random.randint(-5, 5)
+            variation = self._rng.randint(-5, 5)
             device.rssi = max(-100, min(-20, device.rssi + variation))
     
     async def connect(self, address: str, timeout: float = 30.0) -> bool:
@@ -188,32 +203,34 @@ class BLESimulator:
         
         # Inicia processo de conexão
         self._state = BLEConnectionState.CONNECTING
+        self._link_states[address] = BLEConnectionState.CONNECTING
         
         try:
             # Simula tempo de conexão
-            connection_time = random.uniform(1.0, 3.0)
-            await asyncio.sleep(connection_time)
+            connection_time = self._rng.uniform(1.0, 3.0)
+            await self._clock.sleep(connection_time)
             
             # Simula falha ocasional (5% de chance)
-            if random.random() < 0.05:
+            if self._rng.random() < 0.05:
                 raise Exception("Falha simulada na conexão")
             
             # Conexão bem-sucedida
             self._connected_devices[address] = device
             self._state = BLEConnectionState.CONNECTED
+            self._link_states[address] = BLEConnectionState.CONNECTED
             
-            # Inicia task de manutenção da conexão
-            self._connection_tasks[address] = asyncio.create_task(
-                self._maintain_connection(address)
-            )
+            # Task única de manutenção das conexões
+            if self._link_task is None:
+                self._link_task = asyncio.create_task(self._maintain_links())
             
             # Notifica callbacks
-            await self._notify_connection_callbacks(device, True)
+            self._notify_connection_callbacks(device, True)
             
             return True
             
         except Exception as e:
             self._state = BLEConnectionState.ERROR
+            self._link_states[address] = BLEConnectionState.ERROR
             print(f"Erro na conexão BLE: {e}")
             return False
     
@@ -229,50 +246,52 @@ class BLESimulator:
         
         device = self._connected_devices[address]
         
-        # Para task de manutenção
-        if address in self._connection_tasks:
-            self._connection_tasks[address].cancel()
-            try:
-                await self._connection_tasks[address]
-            except asyncio.CancelledError:
-                pass
-            del self._connection_tasks[address]
-        
         # Remove da lista de conectados
         del self._connected_devices[address]
+        self._link_states[address] = BLEConnectionState.DISCONNECTED
         
-        # Atualiza estado se não há mais conexões
+        # Atualiza estado e para a manutenção se não há mais conexões
         if not self._connected_devices:
             self._state = BLEConnectionState.DISCONNECTED
+            task = self._link_task
+            if task is not None and task is not asyncio.current_task():
+                self._link_task = None
+                task.cancel()
+                try:
+                    await task
+                except asyncio.CancelledError:
+                    pass
         
         # Notifica callbacks
-        await self._notify_connection_callbacks(device, False)
+        self._notify_connection_callbacks(device, False)
     
-    async def _maintain_connection(self, address: str) -> None:
+    async def _maintain_links(self) -> None:
         """
-        Mantém a conexão com um dispositivo.
+        Mantém todas as conexões ativas.
         
-        Args:
-            address: Endereço do dispositivo
+        A cada segundo simula, para cada dispositivo conectado, perda
+        ocasional da conexão ou dados chegando.
         """
         try:
-            while address in self._connected_devices:
-                # Simula perda ocasional de conexão (1% chance)
-                if random.random() < 0.01:
-                    print(f"Conexão perdida com {address}")
-                    await self.disconnect(address)
-                    break
+            while self._connected_devices:
+                for address in list(self._connected_devices):
+                    # Simula perda ocasional de conexão (1% chance)
+                    if self._rng.random() < 0.01:
+                        print(f"Conexão perdida com {address}")
+                        await self.disconnect(address)
+                    # Simula dados chegando do dispositivo
+                    elif self._rng.random() < 0.8:  # 80% chance de ter dados
+                        self._simulate_incoming_data(address)
                 
-                # Simula dados chegando do dispositivo
-                if random.random() < 0.8:  # 80% chance de ter dados
-                    await self._simulate_incoming_data(address)
-                
-                await asyncio.sleep(1.0)  # Verifica a cada segundo
+                await self._clock.sleep(1.0)  # Verifica a cada segundo
                 
         except asyncio.CancelledError:
             pass
+        finally:
+            if self._link_task is asyncio.current_task():
+                self._link_task = None
     
-    async def _simulate_incoming_data(self, address: str) -> None:
+    def _simulate_incoming_data(self, address: str) -> None:
         """
         Simula dados chegando de um dispositivo conectado.
         
@@ -290,35 +309,35 @@ class BLESimulator:
             MessageType.STATUS_RESPONSE
         ]
         
-        msg_type = random.choice(message_types)
+        msg_type = self._rng.choice(message_types)
         
         # Cria payload simulado baseado no tipo
         if msg_type == MessageType.DATA_SINGLE:
             payload = {
-                'timestamp': time.time(),
-                'strain_value': random.uniform(-100, 100),
-                'raw_adc_value': random.randint(-8388608, 8388607),
+                'timestamp': self._clock.time(),
+                'strain_value': self._rng.uniform(-100, 100),
+                'raw_adc_value': self._rng.randint(-8388608, 8388607),
                 'sensor_id': device.address,
-                'battery_level': random.randint(20, 100),
-                'temperature': random.uniform(20, 40)
+                'battery_level': self._rng.randint(20, 100),
+                'temperature': self._rng.uniform(20, 40)
             }
         elif msg_type == MessageType.STATUS_RESPONSE:
             payload = {
                 'device_id': device.address,
-                'battery_level': random.randint(20, 100),
+                'battery_level': self._rng.randint(20, 100),
                 'wifi_status': 'disconnected',
                 'ble_status': 'connected',
-                'uptime': random.randint(100, 10000)
+                'uptime': self._rng.randint(100, 10000)
             }
         else:  # DATA_BATCH
             payload = {
                 'readings': [
                     {
-                        'timestamp': time.time() - i,
-                        'strain_value': random.uniform(-100, 100),
-                        'raw_adc_value': random.randint(-8388608, 8388607),
-                        'battery_level': random.randint(20, 100),
-                        'temperature': random.uniform(20, 40)
+                        'timestamp': self._clock.time() - i,
+                        'strain_value': self._rng.uniform(-100, 100),
+                        'raw_adc_value': self._rng.randint(-8388608, 8388607),
+                        'battery_level': self._rng.randint(20, 100),
+                        'temperature': self._rng.uniform(20, 40)
                     }
                     for i in range(5)  # Batch de 5 leituras
                 ]
@@ -329,14 +348,7 @@ class BLESimulator:
             message_data = MessageProtocol.create_message(msg_type, payload)
             
             # Notifica callbacks de dados
-            for callback in self._data_callbacks:
-                try:
-                    if asyncio.iscoroutinefunction(callback):
-                        await callback(address, message_data)
-                    else:
-                        callback(address, message_data)
-                except Exception as e:
-                    print(f"Erro no callback de dados: {e}")
+            self._dispatch(self._data_callbacks, (address, message_data), "dados")
                     
         except Exception as e:
             print(f"Erro ao criar mensagem simulada: {e}")
@@ -357,10 +369,10 @@ class BLESimulator:
         
         try:
             # Simula latência de transmissão
-            await asyncio.sleep(random.uniform(0.01, 0.05))
+            await self._clock.sleep(self._rng.uniform(0.01, 0.05))
             
             # Simula falha ocasional (2% chance)
-            if random.random() < 0.02:
+            if self._rng.random() < 0.02:
                 raise Exception("Falha simulada na transmissão")
             
             # Simula processamento da mensagem pelo dispositivo
@@ -387,15 +399,15 @@ class BLESimulator:
             if message['type'] == MessageType.PING:
                 # Responde com PONG
                 response = MessageProtocol.create_message(MessageType.PONG, {})
-                await asyncio.sleep(0.01)  # Simula tempo de resposta
-                await self._simulate_device_response(address, response)
+                await self._clock.sleep(0.01)  # Simula tempo de resposta
+                self._simulate_device_response(address, response)
                 
             elif message['type'] == MessageType.STATUS_REQUEST:
                 # Responde com status
                 status_payload = {
                     'device_id': address,
-                    'battery_level': random.randint(20, 100),
-                    'temperature': random.uniform(20, 40),
+                    'battery_level': self._rng.randint(20, 100),
+                    'temperature': self._rng.uniform(20, 40),
                     'wifi_status': 'disconnected',
                     'ble_status': 'connected'
                 }
@@ -403,12 +415,12 @@ class BLESimulator:
                     MessageType.STATUS_RESPONSE, 
                     status_payload
                 )
-                await self._simulate_device_response(address, response)
+                self._simulate_device_response(address, response)
                 
         except ProtocolError as e:
             print(f"Erro no protocolo: {e}")
     
-    async def _simulate_device_response(self, address: str, response: bytes) -> None:
+    def _simulate_device_response(self, address: str, response: bytes) -> None:
         """
         Simula resposta do dispositivo.
         
@@ -417,25 +429,39 @@ class BLESimulator:
             response: Dados de resposta
         """
         # Notifica callbacks como se fosse dados recebidos
-        for callback in self._data_callbacks:
-            try:
-                if asyncio.iscoroutinefunction(callback):
-                    await callback(address, response)
-                else:
-                    callback(address, response)
-            except Exception as e:
-                print(f"Erro no callback de resposta: {e}")
+        self._dispatch(self._data_callbacks, (address, response), "resposta")
     
-    async def _notify_connection_callbacks(self, device: BLEDevice, connected: bool) -> None:
+    def _notify_connection_callbacks(self, device: BLEDevice, connected: bool) -> None:
         """Notifica callbacks de conexão."""
-        for callback in self._connection_callbacks:
+        self._dispatch(self._connection_callbacks, (device, connected), "conexão")
+    
+    def _dispatch(self, callbacks: List[Callable], args: tuple, kind: str) -> None:
+        """
+        Entrega um evento aos callbacks sem esperar por eles.
+        
+        Callbacks síncronos rodam na hora; corrotinas são agendadas como
+        tasks, na ordem dos eventos.
+        
+        Args:
+            callbacks: Callbacks registrados
+            args: Argumentos do evento
+            kind: Tipo do evento (para mensagens de erro)
+        """
+        for callback in callbacks:
             try:
-                if asyncio.iscoroutinefunction(callback):
-                    await callback(device, connected)
-                else:
-                    callback(device, connected)
+                result = callback(*args)
+                if asyncio.iscoroutine(result):
+                    task = asyncio.ensure_future(result)
+                    self._callback_tasks.add(task)
+                    task.add_done_callback(partial(self._callback_done, kind))
             except Exception as e:
-                print(f"Erro no callback de conexão: {e}")
+                print(f"Erro no callback de {kind}: {e}")
+    
+    def _callback_done(self, kind: str, task: asyncio.Task) -> None:
+        """Descarta a task de um callback concluído e reporta seu erro."""
+        self._callback_tasks.discard(task)
+        if not task.cancelled() and task.exception() is not None:
+            print(f"Erro no callback de {kind}: {task.exception()}")
     
     # Métodos para registro de callbacks
     def add_scan_callback(self, callback: Callable) -> None:
@@ -466,6 +492,10 @@ class BLESimulator:
         """Dispositivos conectados."""
         return self._connected_devices.copy()
     
+    def link_state(self, address: str) -> BLEConnectionState:
+        """Estado da conexão com um dispositivo específico."""
+        return self._link_states.get(address, BLEConnectionState.DISCONNECTED)
+    
     def is_connected(self, address: str) -> bool:
         """Verifica se está conectado a um dispositivo específico."""
         return address in self._connected_devices
@@ -0,0 +1,352 @@
+"""
+Codificação binária colunar para payloads de dados (DATA_BATCH / DATA_BUFFER).
+
+Substitui o JSON por leitura por um layout struct-of-arrays versionado:
+o sensor_id é enviado uma única vez por pacote, os timestamps são
+codificados como base + deltas e os valores numéricos usam ponto fixo.
+
+Layout v1 (little-endian):
+
+CABEÇALHO (28 bytes + strings):
+- Versão (1 byte): versão do layout (1)
+- Flags (1 byte): reservado
+- Contagem (2 bytes): número de leituras N
+- Sequence Number (2 bytes): posição do pacote na sequência
+- Total Packets (2 bytes): total de pacotes na sequência
+- Timestamp do pacote (8 bytes): µs desde epoch
+- Timestamp base (8 bytes): µs desde epoch (primeira leitura)
+- Reservado (4 bytes)
+- packet_id (1 byte de tamanho + UTF-8)
+- sensor_id (1 byte de tamanho + UTF-8)
+
+COLUNAS (N elementos cada, 14 bytes por leitura):
+- Deltas de timestamp (int32): µs em relação à leitura anterior
+- ADC bruto (int24 compactado): valor de 24 bits do HX711
+- Strain (int32): µε em ponto fixo (x STRAIN_SCALE)
+- Temperatura (int16): °C em ponto fixo (x TEMPERATURE_SCALE)
+- Bateria (uint8): 0-100%
+"""
+
+import struct
+import sys
+from array import array
+from itertools import accumulate, islice
+from typing import Dict, Any, List, Sequence
+
+from ..core.models import StrainBatch, DataPacket, datetime_to_us, us_to_datetime
+
+
+LAYOUT_VERSION = 1
+
+# Escalas de ponto fixo
+STRAIN_SCALE = 1000.0       # resolução de 0.001 µε
+TEMPERATURE_SCALE = 100.0   # resolução de 0.01 °C
+
+_HEADER = struct.Struct('<BBHHHqq4x')
+_INT24_MIN = -2**23
+_INT24_MAX = 2**23 - 1
+
+# Tabela para extensão de sinal do byte mais significativo do int24
+_SIGN_EXTEND = bytes(0xFF if b & 0x80 else 0x00 for b in range(256))
+
+_LITTLE_ENDIAN = sys.byteorder == 'little'
+
+assert array('i').itemsize == 4 and array('h').itemsize == 2 and array('q').itemsize == 8
+
+# Bytes por leitura nas colunas (delta + adc + strain + temperatura + bateria)
+BYTES_PER_READING = 4 + 3 + 4 + 2 + 1
+
+
+def _column_bytes(values: array) -> bytes:
+    """Serializa coluna tipada em little-endian."""
+    if not _LITTLE_ENDIAN:
+        values = array(values.typecode, values)
+        values.byteswap()
+    return values.tobytes()
+
+
+def _column_from_bytes(typecode: str, data: bytes) -> array:
+    """Desserializa coluna tipada a partir de bytes little-endian."""
+    values = array(typecode)
+    values.frombytes(data)
+    if not _LITTLE_ENDIAN:
+        values.byteswap()
+    return values
+
+
+def _pack_int24(values: array) -> bytes:
+    """Compacta valores int32 em 3 bytes por elemento."""
+    raw = _column_bytes(values)
+    packed = bytearray(len(values) * 3)
+    packed[0::3] = raw[0::4]
+    packed[1::3] = raw[1::4]
+    packed[2::3] = raw[2::4]
+    return bytes(packed)
+
+
+def _unpack_int24(data: bytes, count: int) -> array:
+    """Expande valores int24 compactados para int32 com sinal."""
+    expanded = bytearray(count * 4)
+    expanded[0::4] = data[0::3]
+    expanded[1::4] = data[1::3]
+    msb = data[2::3]
+    expanded[2::4] = msb
+    expanded[3::4] = msb.translate(_SIGN_EXTEND)
+    return _column_from_bytes('i', bytes(expanded))
+
+
+def _check_range(values: Sequence[int], low: int, high: int, name: str) -> None:
+    """Garante que a coluna cabe no tipo de ponto fixo."""
+    if values and (min(values) < low or max(values) > high):
+        raise ValueError(f"Coluna '{name}' fora da faixa do formato colunar")
+
+
+def _encode_string(value: str) -> bytes:
+    """Codifica string com prefixo de tamanho (1 byte)."""
+    encoded = value.encode('utf-8')
+    if len(encoded) > 255:
+        raise ValueError(f"String muito longa para o formato colunar: {value!r}")
+    return bytes([len(encoded)]) + encoded
+
+
+class ColumnarCodec:
+    """
+    Codificador/decodificador do layout colunar de lotes de leituras.
+
+    A decodificação produz colunas tipadas (array) diretamente a partir
+    dos bytes, sem criar dicionários ou objetos por leitura.
+    """
+
+    @staticmethod
+    def max_readings(payload_limit: int, packet_id: str = '', sensor_id: str = '') -> int:
+        """
+        Calcula quantas leituras cabem em um payload.
+
+        Args:
+            payload_limit: Tamanho máximo do payload em bytes
+            packet_id: ID do pacote
+            sensor_id: ID do sensor
+
+        Returns:
+            Número máximo de leituras por payload
+        """
+        overhead = (_HEADER.size + 2 + len(packet_id.encode('utf-8')) +
+                    len(sensor_id.encode('utf-8')))
+        return max(0, min(0xFFFF, (payload_limit - overhead) // BYTES_PER_READING))
+
+    @staticmethod
+    def encode_columns(packet_id: str,
+                       sensor_id: str,
+                       packet_timestamp_us: int,
+                       timestamps_us: Sequence[int],
+                       strain_values: Sequence[float],
+                       raw_adc_values: Sequence[int],
+                       temperatures: Sequence[float],
+                       battery_levels: Sequence[int],
+                       sequence_number: int = 0,
+                       total_packets: int = 1) -> bytes:
+        """
+        Codifica colunas de leituras de um único sensor.
+
+        Args:
+            packet_id: ID do pacote
+            sensor_id: ID do sensor
+            packet_timestamp_us: Timestamp do pacote (µs desde epoch)
+            timestamps_us: Timestamps das leituras (µs desde epoch)
+            strain_values: Valores de strain (µε)
+            raw_adc_values: Valores ADC brutos (24 bits)
+            temperatures: Temperaturas (°C)
+            battery_levels: Níveis de bateria (0-100%)
+            sequence_number: Número sequencial do pacote
+            total_packets: Total de pacotes na sequência
+
+        Returns:
+            Payload binário
+
+        Raises:
+            ValueError: Se algum valor não couber no formato
+        """
+        count = len(timestamps_us)
+        if not (len(strain_values) == len(raw_adc_values) == len(temperatures) ==
+                len(battery_levels) == count):
+            raise ValueError("Colunas com tamanhos diferentes")
+        if count > 0xFFFF:
+            raise ValueError(f"Leituras demais para um pacote: {count}")
+
+        base_us = timestamps_us[0] if count else packet_timestamp_us
+
+        try:
+            deltas = array('i', [0] * count)
+            previous = base_us
+            for index, value in enumerate(timestamps_us):
+                deltas[index] = value - previous
+                previous = value
+
+            adc = array('i', raw_adc_values)
+            strain = array('i', [round(v * STRAIN_SCALE) for v in strain_values])
+            temperature = array('h', [round(v * TEMPERATURE_SCALE) for v in temperatures])
+            battery = array('B', battery_levels)
+        except OverflowError as e:
+            raise ValueError(f"Valor fora da faixa do formato colunar: {e}")
+
+        _check_range(adc, _INT24_MIN, _INT24_MAX, 'raw_adc_value')
+
+        header = _HEADER.pack(
+            LAYOUT_VERSION,
+            0,
+            count,
+            sequence_number,
+            total_packets,
+            packet_timestamp_us,
+            base_us
+        )
+
+        return b''.join((
+            header,
+            _encode_string(packet_id),
+            _encode_string(sensor_id),
+            _column_bytes(deltas),
+            _pack_int24(adc),
+            _column_bytes(strain),
+            _column_bytes(temperature),
+            _column_bytes(battery)
+        ))
+
+    @staticmethod
+    def encode_packet(packet: DataPacket) -> bytes:
+        """
+        Codifica um DataPacket no layout colunar.
+
+        Todas as leituras devem pertencer ao sensor do pacote.
+
+        Args:
+            packet: Pacote a ser codificado
+
+        Returns:
+            Payload binário
+        """
+        readings = packet.readings
+        for reading in readings:
+            if reading.sensor_id != packet.sensor_id:
+                raise ValueError(
+                    f"Leitura de outro sensor no pacote: {reading.sensor_id}"
+                )
+
+        return ColumnarCodec.encode_columns(
+            packet_id=packet.packet_id,
+            sensor_id=packet.sensor_id,
+            packet_timestamp_us=datetime_to_us(packet.timestamp),
+            timestamps_us=[r.timestamp_us for r in readings],
+            strain_values=[r.strain_value for r in readings],
+            raw_adc_values=[r.raw_adc_value for r in readings],
+            temperatures=[r.temperature for r in readings],
+            battery_levels=[r.battery_level for r in readings],
+            sequence_number=packet.sequence_number,
+            total_packets=packet.total_packets
+        )
+
+    @staticmethod
+    def decode(data: bytes) -> Dict[str, Any]:
+        """
+        Decodifica um payload colunar em colunas tipadas.
+
+        Args:
+            data: Payload binário
+
+        Returns:
+            Dicionário com metadados do pacote e colunas (array)
+
+        Raises:
+            ValueError: Se payload inválido ou versão não suportada
+        """
+        data = bytes(data)
+        if len(data) < _HEADER.size:
+            raise ValueError("Payload colunar truncado")
+
+        (version, _flags, count, sequence_number, total_packets,
+         packet_timestamp_us, base_us) = _HEADER.unpack_from(data, 0)
+
+        if version != LAYOUT_VERSION:
+            raise ValueError(f"Versão do formato colunar não suportada: {version}")
+
+        offset = _HEADER.size
+        strings = []
+        for _ in range(2):
+            if offset >= len(data):
+                raise ValueError("Payload colunar truncado")
+            length = data[offset]
+            strings.append(data[offset + 1:offset + 1 + length].decode('utf-8'))
+            offset += 1 + length
+        packet_id, sensor_id = strings
+
+        if len(data) - offset != count * BYTES_PER_READING:
+            raise ValueError("Tamanho das colunas não confere com a contagem")
+
+        def take(size: int) -> bytes:
+            nonlocal offset
+            chunk = data[offset:offset + size]
+            offset += size
+            return chunk
+
+        deltas = _column_from_bytes('i', take(count * 4))
+        raw_adc = _unpack_int24(take(count * 3), count)
+        strain_fixed = _column_from_bytes('i', take(count * 4))
+        temperature_fixed = _column_from_bytes('h', take(count * 2))
+        battery = _column_from_bytes('B', take(count))
+
+        timestamps = array('q', islice(accumulate(deltas, initial=base_us), 1, None))
+
+        return {
+            'version': version,
+            'packet_id': packet_id,
+            'sensor_id': sensor_id,
+            'timestamp': us_to_datetime(packet_timestamp_us),
+            'sequence_number': sequence_number,
+            'total_packets': total_packets,
+            'count': count,
+            'timestamps_us': timestamps,
+            'strain_values': array('d', [value / STRAIN_SCALE for value in strain_fixed]),
+            'raw_adc_values': raw_adc,
+            'temperatures': array('d', [value / TEMPERATURE_SCALE for value in temperature_fixed]),
+            'battery_levels': battery
+        }
+
+    @staticmethod
+    def to_batch(columns: Dict[str, Any]) -> StrainBatch:
+        """
+        Envolve as colunas decodificadas em um StrainBatch, sem cópia.
+
+        Args:
+            columns: Resultado de decode()
+
+        Returns:
+            Lote de um único sensor
+        """
+        return StrainBatch.for_sensor(
+            columns['sensor_id'],
+            columns['timestamps_us'],
+            columns['strain_values'],
+            columns['raw_adc_values'],
+            columns['battery_levels'],
+            columns['temperatures']
+        )
+
+    @staticmethod
+    def to_packet(columns: Dict[str, Any]) -> DataPacket:
+        """
+        Materializa colunas decodificadas em um DataPacket.
+
+        Args:
+            columns: Resultado de decode()
+
+        Returns:
+            Objeto DataPacket com leituras
+        """
+        return DataPacket(
+            packet_id=columns['packet_id'],
+            sensor_id=columns['sensor_id'],
+            readings=ColumnarCodec.to_batch(columns).to_readings(),
+            timestamp=columns['timestamp'],
+            sequence_number=columns['sequence_number'],
+            total_packets=columns['total_packets']
+        )
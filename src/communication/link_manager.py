@@ -0,0 +1,653 @@
+"""
+Gerência de múltiplos links de sensores e escalonamento da ingestão.
+
+Um gateway com dezenas de nós BLE/WiFi não pode deixar que um consumidor
+lento ou um link ruidoso atrase os demais. A recepção e o processamento
+ficam separados:
+
+- LinkManager: estado por link (conexão, backoff de reconexão) e fila de
+  recepção limitada por link. receive() só enfileira e retorna, podendo
+  ser chamado direto do callback do transporte; quando a fila enche, os
+  blocos mais antigos daquele link são descartados.
+- IngestScheduler: esvazia as filas com deficit round robin (cada link
+  recebe `quantum` bytes por rodada, de modo que um link com backlog não
+  monopoliza a ingestão), decodifica os frames por link e agrupa os
+  lotes por sensor antes de entregá-los ao DataManager, reduzindo o
+  custo fixo por chamada.
+
+Fragmentos de transferências grandes (TRANSFER_FRAGMENT) são remontados
+por link; os ACKs ficam em Link.outbox. LinkManager.maintain() envia as
+outboxes e reconecta os links cujo backoff expirou.
+"""
+
+import asyncio
+import random
+import time
+from collections import deque
+from enum import Enum
+from typing import Any, Awaitable, Callable, Deque, Dict, List, Optional, Tuple
+
+from ..core.config import COMMUNICATION_CONFIG
+from ..core.metrics import metrics, COUNTER, GAUGE
+from ..core.models import StrainBatch
+from .protocol import Frame, FrameDecoder, MessageType
+from .transfer import TransferReceiver
+
+
+# Tipos de mensagem entregues como lotes de leituras
+_DATA_TYPES = (MessageType.DATA_BATCH, MessageType.DATA_BUFFER)
+
+
+class LinkState(Enum):
+    """Estados de um link de sensor."""
+    DISCONNECTED = "disconnected"
+    CONNECTING = "connecting"
+    CONNECTED = "connected"
+    BACKOFF = "backoff"
+
+
+class ReconnectBackoff:
+    """
+    Atraso exponencial com jitter entre tentativas de reconexão.
+
+    O jitter espalha as reconexões quando muitos nós caem juntos (ex:
+    reinício do gateway), evitando que todos tentem no mesmo instante.
+    """
+
+    def __init__(self, base: Optional[float] = None, maximum: Optional[float] = None,
+                 jitter: float = 0.5, rng: Optional[random.Random] = None):
+        """
+        Inicializa o backoff.
+
+        Args:
+            base: Atraso da primeira tentativa (padrão: 'retry_delay')
+            maximum: Teto do atraso (padrão: 'reconnect_max_delay')
+            jitter: Fração máxima removida aleatoriamente de cada atraso
+            rng: Gerador aleatório (para testes determinísticos)
+        """
+        self.base = COMMUNICATION_CONFIG['retry_delay'] if base is None else base
+        self.maximum = COMMUNICATION_CONFIG['reconnect_max_delay'] if maximum is None else maximum
+        self.jitter = jitter
+        self._rng = rng or random.Random()
+        self.attempts = 0
+
+    def next_delay(self) -> float:
+        """
+        Retorna o atraso até a próxima tentativa e avança o expoente.
+
+        Returns:
+            Atraso em segundos
+        """
+        delay = min(self.maximum, self.base * (2 ** min(self.attempts, 32)))
+        self.attempts += 1
+        return delay * (1.0 - self.jitter * self._rng.random())
+
+    def reset(self) -> None:
+        """Volta ao atraso inicial (após conexão bem-sucedida)."""
+        self.attempts = 0
+
+
+class Link:
+    """Estado e fila de recepção de um link de sensor."""
+
+    def __init__(self, address: str, max_queue_bytes: int,
+                 export_metrics: bool = False, rng: Optional[random.Random] = None):
+        """
+        Inicializa o link.
+
+        Args:
+            address: Endereço do dispositivo (MAC, IP:porta)
+            max_queue_bytes: Bytes máximos aguardando ingestão
+            export_metrics: Exporta os contadores do FrameDecoder do link
+            rng: Gerador aleatório do backoff
+        """
+        self.address = address
+        self.state = LinkState.DISCONNECTED
+        self.max_queue_bytes = max_queue_bytes
+        # (instante, bloco); bloco None marca o reset do decoder após uma queda
+        self.queue: Deque[Tuple[float, Optional[bytes]]] = deque()
+        self.queued_bytes = 0
+        self.decoder = FrameDecoder(link=address if export_metrics else None)
+        self.transfers = TransferReceiver()
+        self.outbox: Deque[bytes] = deque()
+        self.backoff = ReconnectBackoff(rng=rng)
+        self.next_attempt = 0.0
+        self.deficit = 0
+
+        # Contadores
+        self.chunks_received = 0
+        self.bytes_received = 0
+        self.chunks_dropped = 0
+        self.bytes_dropped = 0
+        self.frames = 0
+        self.readings = 0
+        self.errors = 0
+        self.disconnects = 0
+        self.max_delay = 0.0
+
+    def push(self, data: bytes, now: float) -> bool:
+        """
+        Enfileira um bloco recebido, descartando os mais antigos se necessário.
+
+        Args:
+            data: Bloco recebido
+            now: Instante da recepção
+
+        Returns:
+            True se nenhum bloco foi descartado
+        """
+        self.chunks_received += 1
+        self.bytes_received += len(data)
+        intact = True
+        while self.queue and self.queued_bytes + len(data) > self.max_queue_bytes:
+            _, dropped = self.queue.popleft()
+            if dropped is None:
+                # Tudo o que vinha antes da queda já saiu da fila
+                self.decoder.reset()
+                continue
+            self.queued_bytes -= len(dropped)
+            self.chunks_dropped += 1
+            self.bytes_dropped += len(dropped)
+            intact = False
+        if len(data) > self.max_queue_bytes:
+            self.chunks_dropped += 1
+            self.bytes_dropped += len(data)
+            return False
+        self.queue.append((now, data))
+        self.queued_bytes += len(data)
+        return intact
+
+    def reset_decoder(self, now: float) -> None:
+        """
+        Descarta o frame parcial do decoder depois dos blocos já enfileirados.
+
+        Os blocos recebidos antes da queda ainda precisam ser decodificados;
+        o reset entra na fila como marcador e é aplicado na ordem.
+
+        Args:
+            now: Instante da queda
+        """
+        if self.queue:
+            self.queue.append((now, None))
+        else:
+            self.decoder.reset()
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Retorna estado e contadores do link.
+
+        Returns:
+            Dicionário com estado e contadores
+        """
+        return {
+            'state': self.state.value,
+            'queued_bytes': self.queued_bytes,
+            'queued_chunks': len(self.queue),
+            'chunks_received': self.chunks_received,
+            'bytes_received': self.bytes_received,
+            'chunks_dropped': self.chunks_dropped,
+            'bytes_dropped': self.bytes_dropped,
+            'frames': self.frames,
+            'readings': self.readings,
+            'errors': self.errors,
+            'disconnects': self.disconnects,
+            'max_delay_ms': self.max_delay * 1000,
+            'pending_acks': len(self.outbox)
+        }
+
+
+class LinkManager:
+    """
+    Gerenciador de conexões de múltiplos sensores.
+
+    Mantém um Link por endereço; os callbacks do transporte chamam
+    receive(), connected() e disconnected(), que nunca bloqueiam.
+    """
+
+    def __init__(self, max_queue_bytes: Optional[int] = None,
+                 export_metrics: bool = False, seed: Optional[int] = None):
+        """
+        Inicializa o gerenciador.
+
+        Args:
+            max_queue_bytes: Fila máxima por link (padrão: 'link_queue_bytes')
+            export_metrics: Exporta métricas por link no registro global
+            seed: Semente do jitter de reconexão
+        """
+        self.max_queue_bytes = max_queue_bytes or COMMUNICATION_CONFIG['link_queue_bytes']
+        self.export_metrics = export_metrics
+        self.links: Dict[str, Link] = {}
+        self._rng = random.Random(seed)
+        self._wakeup = asyncio.Event()
+        self._maintaining = False
+
+        if export_metrics:
+            metrics.register_collector(LinkManager._collect_metrics, owner=self)
+
+    def _collect_metrics(self) -> List[tuple]:
+        """Coletor de métricas das filas por link."""
+        samples = []
+        for address, link in list(self.links.items()):
+            labels = {'link': address}
+            samples.append(('daq_link_queue_bytes', GAUGE,
+                            'Bytes aguardando ingestão no link', labels, link.queued_bytes))
+            samples.append(('daq_link_queue_dropped_bytes_total', COUNTER,
+                            'Bytes descartados por fila cheia', labels, link.bytes_dropped))
+        return samples
+
+    def link(self, address: str) -> Link:
+        """
+        Retorna o link de um endereço, criando-o se necessário.
+
+        Args:
+            address: Endereço do dispositivo
+
+        Returns:
+            Link do endereço
+        """
+        link = self.links.get(address)
+        if link is None:
+            link = self.links[address] = Link(address, self.max_queue_bytes,
+                                              self.export_metrics, self._rng)
+        return link
+
+    def remove(self, address: str) -> None:
+        """Remove um link e descarta sua fila."""
+        self.links.pop(address, None)
+
+    def receive(self, address: str, data: bytes, now: Optional[float] = None) -> bool:
+        """
+        Enfileira bytes recebidos de um link (não bloqueia).
+
+        Args:
+            address: Endereço do dispositivo
+            data: Bloco recebido
+            now: Instante atual (time.monotonic() se None)
+
+        Returns:
+            False se a fila do link descartou dados
+        """
+        now = time.monotonic() if now is None else now
+        intact = self.link(address).push(bytes(data), now)
+        self._wakeup.set()
+        return intact
+
+    def connected(self, address: str) -> None:
+        """Registra conexão estabelecida e reinicia o backoff."""
+        link = self.link(address)
+        link.state = LinkState.CONNECTED
+        link.backoff.reset()
+
+    def disconnected(self, address: str, now: Optional[float] = None) -> float:
+        """
+        Registra queda do link e agenda a reconexão.
+
+        O FrameDecoder descarta o frame parcial depois de decodificar os
+        blocos já enfileirados; transferências fragmentadas sobrevivem à
+        reconexão.
+
+        Args:
+            address: Endereço do dispositivo
+            now: Instante atual (time.monotonic() se None)
+
+        Returns:
+            Atraso até a próxima tentativa, em segundos
+        """
+        now = time.monotonic() if now is None else now
+        link = self.link(address)
+        if link.state == LinkState.CONNECTED:
+            link.disconnects += 1
+        link.reset_decoder(now)
+        delay = link.backoff.next_delay()
+        link.state = LinkState.BACKOFF
+        link.next_attempt = now + delay
+        return delay
+
+    def track(self, address: str, now: Optional[float] = None) -> None:
+        """
+        Agenda a primeira conexão de um link no próximo reconnect_due().
+
+        Args:
+            address: Endereço do dispositivo
+            now: Instante atual (time.monotonic() se None)
+        """
+        link = self.link(address)
+        if link.state == LinkState.DISCONNECTED:
+            link.state = LinkState.BACKOFF
+            link.next_attempt = time.monotonic() if now is None else now
+
+    def due_reconnects(self, now: Optional[float] = None) -> List[str]:
+        """
+        Retorna os links cujo backoff expirou, marcando-os como CONNECTING.
+
+        Args:
+            now: Instante atual (time.monotonic() se None)
+
+        Returns:
+            Endereços a reconectar
+        """
+        now = time.monotonic() if now is None else now
+        due = [address for address, link in self.links.items()
+               if link.state == LinkState.BACKOFF and link.next_attempt <= now]
+        for address in due:
+            self.links[address].state = LinkState.CONNECTING
+        return due
+
+    async def reconnect_due(self, connect: Callable[[str], Awaitable[bool]],
+                            now: Optional[float] = None) -> int:
+        """
+        Tenta reconectar, em paralelo, os links com backoff expirado.
+
+        Args:
+            connect: Corrotina de conexão do transporte (ex: BLESimulator.connect)
+            now: Instante atual (time.monotonic() se None)
+
+        Returns:
+            Número de links reconectados
+        """
+        due = self.due_reconnects(now)
+        if not due:
+            return 0
+        results = await asyncio.gather(*(connect(address) for address in due),
+                                       return_exceptions=True)
+        reconnected = 0
+        for address, result in zip(due, results):
+            if result is True:
+                self.connected(address)
+                reconnected += 1
+            else:
+                if isinstance(result, Exception):
+                    print(f"Erro ao reconectar {address}: {result}")
+                self.disconnected(address)
+        return reconnected
+
+    async def send_acks(self, send: Callable[[str, bytes], Awaitable[bool]]) -> int:
+        """
+        Envia, em paralelo entre links, os ACKs pendentes nas outboxes.
+
+        ACKs de links desconectados esperam a reconexão. Se um envio falha,
+        o ACK volta para o início da outbox e o link tenta de novo na
+        próxima chamada.
+
+        Args:
+            send: Corrotina de envio do transporte (ex: BLESimulator.send_data)
+
+        Returns:
+            Número de ACKs enviados
+        """
+        links = [link for link in self.links.values()
+                 if link.outbox and link.state == LinkState.CONNECTED]
+        if not links:
+            return 0
+        results = await asyncio.gather(*(self._send_outbox(link, send) for link in links))
+        return sum(results)
+
+    async def _send_outbox(self, link: Link,
+                           send: Callable[[str, bytes], Awaitable[bool]]) -> int:
+        """Envia a outbox de um link, em ordem, até esvaziar ou falhar."""
+        sent = 0
+        while link.outbox:
+            ack = link.outbox.popleft()
+            try:
+                delivered = await send(link.address, ack)
+            except Exception as e:
+                print(f"Erro ao enviar ACK para {link.address}: {e}")
+                delivered = False
+            if delivered is not True:
+                link.outbox.appendleft(ack)
+                break
+            sent += 1
+        return sent
+
+    async def maintain(self, connect: Callable[[str], Awaitable[bool]],
+                       send: Callable[[str, bytes], Awaitable[bool]],
+                       interval: float = 0.05) -> None:
+        """
+        Reconecta links e envia ACKs continuamente até stop().
+
+        Args:
+            connect: Corrotina de conexão do transporte
+            send: Corrotina de envio do transporte
+            interval: Intervalo entre verificações, em segundos
+        """
+        self._maintaining = True
+        while self._maintaining:
+            try:
+                await self.reconnect_due(connect)
+                await self.send_acks(send)
+            except Exception as e:
+                print(f"Erro na manutenção dos links: {e}")
+            await asyncio.sleep(interval)
+
+    def stop(self) -> None:
+        """Interrompe maintain() após a verificação atual."""
+        self._maintaining = False
+
+    def attach(self, transport: Any) -> None:
+        """
+        Registra os callbacks de dados e conexão de um transporte.
+
+        Args:
+            transport: Objeto com add_data_callback(address, data) e
+                add_connection_callback(device, connected) (ex: BLESimulator)
+        """
+        transport.add_data_callback(self.receive)
+
+        def on_connection(device, connected: bool) -> None:
+            if connected:
+                self.connected(device.address)
+            else:
+                self.disconnected(device.address)
+        transport.add_connection_callback(on_connection)
+
+    async def wait(self, timeout: Optional[float] = None) -> bool:
+        """
+        Aguarda dados em qualquer link.
+
+        Args:
+            timeout: Tempo máximo de espera em segundos
+
+        Returns:
+            True se chegaram dados
+        """
+        try:
+            await asyncio.wait_for(self._wakeup.wait(), timeout)
+            return True
+        except asyncio.TimeoutError:
+            return False
+        finally:
+            self._wakeup.clear()
+
+    @property
+    def queued_bytes(self) -> int:
+        """Bytes aguardando ingestão em todos os links."""
+        return sum(link.queued_bytes for link in self.links.values())
+
+    def get_stats(self) -> Dict[str, Dict[str, Any]]:
+        """
+        Retorna estatísticas por link.
+
+        Returns:
+            Dicionário endereço -> estatísticas do link
+        """
+        return {address: link.get_stats() for address, link in self.links.items()}
+
+
+class IngestScheduler:
+    """
+    Escalonador central que drena os links com justiça e agrupa lotes.
+
+    A cada rodada do deficit round robin cada link com dados recebe
+    `quantum_bytes` de crédito e processa blocos enquanto houver crédito.
+    Os lotes decodificados são acumulados por sensor e entregues ao sink
+    (DataManager.add_batch) em um lote por sensor ao fim de cada drenagem
+    ou quando o acumulado passa de `max_batch_readings`.
+    """
+
+    def __init__(self, manager: LinkManager, sink: Callable[[StrainBatch], Any],
+                 quantum_bytes: Optional[int] = None,
+                 max_batch_readings: Optional[int] = None,
+                 on_frame: Optional[Callable[[str, Frame], Any]] = None):
+        """
+        Inicializa o escalonador.
+
+        Args:
+            manager: Gerenciador de links
+            sink: Destino dos lotes (ex: DataManager.add_batch)
+            quantum_bytes: Crédito por link por rodada (padrão: 'ingest_quantum_bytes')
+            max_batch_readings: Leituras acumuladas que forçam entrega
+                (padrão: 'ingest_batch_readings')
+            on_frame: Callback síncrono para frames que não são dados
+                (status, configuração), chamado como on_frame(endereço, frame)
+        """
+        self.manager = manager
+        self.sink = sink
+        self.quantum_bytes = quantum_bytes or COMMUNICATION_CONFIG['ingest_quantum_bytes']
+        self.max_batch_readings = (max_batch_readings or
+                                   COMMUNICATION_CONFIG['ingest_batch_readings'])
+        self.on_frame = on_frame
+
+        self._pending: Dict[str, List[StrainBatch]] = {}
+        self._pending_readings = 0
+        self._cursor = 0
+        self._running = False
+
+        # Contadores
+        self.batches_delivered = 0
+        self.readings_delivered = 0
+        self.drains = 0
+
+    def drain(self, now: Optional[float] = None,
+              budget_bytes: Optional[int] = None) -> int:
+        """
+        Processa as filas dos links e entrega os lotes acumulados.
+
+        Args:
+            now: Instante atual (time.monotonic() se None)
+            budget_bytes: Bytes máximos processados nesta chamada (None = tudo)
+
+        Returns:
+            Leituras entregues ao sink
+        """
+        now = time.monotonic() if now is None else now
+        delivered = self.readings_delivered
+        links = list(self.manager.links.values())
+        if links:
+            # Começa de um link diferente a cada drenagem
+            self._cursor %= len(links)
+            links = links[self._cursor:] + links[:self._cursor]
+            self._cursor += 1
+        active = [link for link in links if link.queue]
+        processed = 0
+
+        while active and (budget_bytes is None or processed < budget_bytes):
+            remaining = []
+            for link in active:
+                link.deficit += self.quantum_bytes
+                queue = link.queue
+                while queue and (queue[0][1] is None or len(queue[0][1]) <= link.deficit):
+                    received_at, data = queue.popleft()
+                    if data is None:
+                        link.decoder.reset()
+                        continue
+                    link.queued_bytes -= len(data)
+                    link.deficit -= len(data)
+                    processed += len(data)
+                    if now - received_at > link.max_delay:
+                        link.max_delay = now - received_at
+                    self._process(link, data, now)
+                if queue:
+                    remaining.append(link)
+                else:
+                    link.deficit = 0
+            active = remaining
+            if self._pending_readings >= self.max_batch_readings:
+                self.flush()
+
+        self.flush()
+        self.drains += 1
+        return self.readings_delivered - delivered
+
+    def flush(self) -> None:
+        """Entrega ao sink os lotes acumulados, um por sensor."""
+        pending, self._pending = self._pending, {}
+        self._pending_readings = 0
+        for sensor_id, batches in pending.items():
+            batch = StrainBatch.concat(batches)
+            try:
+                self.sink(batch)
+            except Exception as e:
+                print(f"Erro na ingestão do sensor {sensor_id}: {e}")
+                continue
+            self.batches_delivered += 1
+            self.readings_delivered += len(batch)
+
+    async def run(self, interval: float = 0.05, budget_bytes: int = 256 * 1024) -> None:
+        """
+        Drena os links continuamente até stop().
+
+        Entre fatias de `budget_bytes` o controle volta ao loop asyncio,
+        para que a recepção dos links não espere um backlog grande.
+
+        Args:
+            interval: Espera máxima por dados entre drenagens, em segundos
+            budget_bytes: Bytes processados por fatia
+        """
+        self._running = True
+        while self._running:
+            await self.manager.wait(interval)
+            self.drain(budget_bytes=budget_bytes)
+            while self._running and self.manager.queued_bytes:
+                await asyncio.sleep(0)
+                self.drain(budget_bytes=budget_bytes)
+
+    def stop(self) -> None:
+        """Interrompe run() após a drenagem atual."""
+        self._running = False
+
+    def get_stats(self) -> Dict[str, int]:
+        """
+        Retorna contadores do escalonador.
+
+        Returns:
+            Dicionário com contadores
+        """
+        return {
+            'drains': self.drains,
+            'batches_delivered': self.batches_delivered,
+            'readings_delivered': self.readings_delivered,
+            'queued_bytes': self.manager.queued_bytes
+        }
+
+    def _process(self, link: Link, data: bytes, now: float) -> None:
+        """Decodifica um bloco do link e despacha seus frames."""
+        for frame in link.decoder.feed(data):
+            try:
+                self._dispatch(link, frame, now)
+            except Exception as e:
+                # Payload inválido afeta só o frame; o escalonador continua
+                link.errors += 1
+                print(f"Erro no frame do link {link.address}: {e}")
+
+    def _dispatch(self, link: Link, frame: Frame, now: float) -> None:
+        link.frames += 1
+        message_type = frame.message_type
+        if message_type in _DATA_TYPES:
+            batch = frame.to_batch()
+            if not len(batch):
+                return
+            link.readings += len(batch)
+            if len(batch.sensor_names) == 1:
+                self._pending.setdefault(batch.sensor_names[0], []).append(batch)
+            else:
+                for sensor_id, part in batch.by_sensor():
+                    self._pending.setdefault(sensor_id, []).append(part)
+            self._pending_readings += len(batch)
+        elif message_type == MessageType.TRANSFER_FRAGMENT:
+            ack = link.transfers.handle(frame, now)
+            if ack is not None:
+                link.outbox.append(ack)
+            for completed in link.transfers.pop_completed():
+                self._dispatch(link, completed, now)
+        elif self.on_frame is not None:
+            self.on_frame(link.address, frame)
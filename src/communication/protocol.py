@@ -6,11 +6,18 @@ Define o formato de dados e protocolos de comunicação BLE/WiFi.
 import json
 import struct
 import zlib
-from typing import Dict, Any, List, Optional, Union
+import binascii
+from array import array
+from typing import Dict, Any, List, Optional, Union, Iterable, Iterator
 from datetime import datetime
 from dataclasses import asdict
 
-from ..core.models import StrainReading, DataPacket, SensorConfiguration
+from ..core.models import (
+    StrainReading, StrainBatch, DataPacket, SensorConfiguration, datetime_to_us
+)
+from ..core.metrics import metrics, COUNTER
+from .columnar import ColumnarCodec
+from .timeseries import TimeSeriesCodec
 
 
 class ProtocolError(Exception):
@@ -35,6 +42,9 @@ class MessageType:
     DATA_SINGLE = 0x30
     DATA_BATCH = 0x31
     DATA_BUFFER = 0x32
+    TRANSFER_FRAGMENT = 0x33  # Fragmento de transferência grande (ver transfer)
+    TRANSFER_ACK = 0x34       # ACK cumulativo + bitmap seletivo
+    TRANSFER_NACK = 0x35      # Remontagem descartada: o emissor reinicia
     
     # Status
     STATUS_REQUEST = 0x40
@@ -46,6 +56,23 @@ class CompressionType:
     """Tipos de compressão suportados."""
     NONE = 0x00
     ZLIB = 0x01
+    TIMESERIES = 0x02  # Gorilla/delta por coluna, só com payload colunar (ver timeseries)
+    MASK = 0x0F
+
+
+class PayloadEncoding:
+    """
+    Codificação do payload.
+    
+    Ocupa o nibble superior do byte de compressão do header, mantendo
+    compatibilidade com mensagens antigas (nibble zero = JSON).
+    """
+    JSON = 0x00
+    COLUMNAR = 0x10
+    MASK = 0xF0
+    
+    # Tipos de mensagem que aceitam payload colunar
+    COLUMNAR_TYPES = (MessageType.DATA_BATCH, MessageType.DATA_BUFFER)
 
 
 class MessageProtocol:
@@ -58,23 +85,26 @@ class MessageProtocol:
     HEADER (8 bytes):
     - Magic Number (2 bytes): 0xDACC (Data Acquisition Communication)
     - Message Type (1 byte): Tipo da mensagem
-    - Compression (1 byte): Tipo de compressão
+    - Compression (1 byte): Tipo de compressão (nibble inferior) e
+      codificação do payload (nibble superior, ver PayloadEncoding)
     - Payload Length (2 bytes): Tamanho do payload
     - Checksum (2 bytes): CRC16 do payload
     
     PAYLOAD (variável):
-    - Dados da mensagem (JSON ou binário)
+    - Dados da mensagem (JSON, colunar binário ou bytes brutos)
     """
     
     MAGIC_NUMBER = 0xDACC
     HEADER_SIZE = 8
     MAX_PAYLOAD_SIZE = 8192  # 8KB máximo
+    HEADER_STRUCT = struct.Struct('>HBBHH')
     
     @classmethod
     def create_message(cls, 
                       message_type: int, 
                       payload: Union[Dict, bytes], 
-                      compression: int = CompressionType.NONE) -> bytes:
+                      compression: int = CompressionType.NONE,
+                      encoding: int = PayloadEncoding.JSON) -> bytes:
         """
         Cria uma mensagem no formato do protocolo.
         
@@ -82,6 +112,7 @@ class MessageProtocol:
             message_type: Tipo da mensagem
             payload: Dados da mensagem
             compression: Tipo de compressão
+            encoding: Codificação do payload (PayloadEncoding)
             
         Returns:
             Mensagem codificada em bytes
@@ -90,6 +121,18 @@ class MessageProtocol:
             ProtocolError: Se erro na criação da mensagem
         """
         try:
+            if encoding == PayloadEncoding.COLUMNAR:
+                if message_type not in PayloadEncoding.COLUMNAR_TYPES:
+                    raise ProtocolError(
+                        f"Codificação colunar não suportada para tipo {message_type:#04x}"
+                    )
+                if not isinstance(payload, bytes):
+                    raise ProtocolError("Payload colunar deve ser bytes")
+            elif encoding != PayloadEncoding.JSON:
+                raise ProtocolError(f"Codificação desconhecida: {encoding:#04x}")
+            if compression == CompressionType.TIMESERIES and encoding != PayloadEncoding.COLUMNAR:
+                raise ProtocolError("Compressão de série temporal requer payload colunar")
+            
             # Serializa payload
             if isinstance(payload, dict):
                 payload_bytes = json.dumps(payload, default=cls._json_serializer).encode('utf-8')
@@ -101,29 +144,42 @@ class MessageProtocol:
             # Aplica compressão se necessário
             if compression == CompressionType.ZLIB:
                 payload_bytes = zlib.compress(payload_bytes)
+            elif compression == CompressionType.TIMESERIES:
+                payload_bytes = TimeSeriesCodec.from_columnar(payload_bytes)
             
-            # Verifica tamanho
-            if len(payload_bytes) > cls.MAX_PAYLOAD_SIZE:
-                raise ProtocolError(f"Payload muito grande: {len(payload_bytes)} bytes")
-            
-            # Calcula checksum
-            checksum = cls._calculate_crc16(payload_bytes)
-            
-            # Monta header
-            header = struct.pack(
-                '>HBBHH',
-                cls.MAGIC_NUMBER,
-                message_type,
-                compression,
-                len(payload_bytes),
-                checksum
-            )
-            
-            return header + payload_bytes
+            return cls.frame_payload(message_type, compression | encoding, payload_bytes)
             
         except Exception as e:
             raise ProtocolError(f"Erro ao criar mensagem: {e}")
     
+    @classmethod
+    def frame_payload(cls, message_type: int, flags: int, payload_bytes: bytes) -> bytes:
+        """
+        Enquadra um payload já serializado e comprimido.
+        
+        Args:
+            message_type: Tipo da mensagem
+            flags: Compressão | codificação do payload
+            payload_bytes: Payload final
+            
+        Returns:
+            Mensagem codificada em bytes
+            
+        Raises:
+            ProtocolError: Se o payload exceder MAX_PAYLOAD_SIZE
+        """
+        if len(payload_bytes) > cls.MAX_PAYLOAD_SIZE:
+            raise ProtocolError(f"Payload muito grande: {len(payload_bytes)} bytes")
+        
+        header = cls.HEADER_STRUCT.pack(
+            cls.MAGIC_NUMBER,
+            message_type,
+            flags,
+            len(payload_bytes),
+            cls._calculate_crc16(payload_bytes)
+        )
+        return header + payload_bytes
+    
     @classmethod
     def parse_message(cls, data: bytes) -> Dict[str, Any]:
         """
@@ -143,9 +199,7 @@ class MessageProtocol:
                 raise ProtocolError("Dados insuficientes para header")
             
             # Extrai header
-            magic, msg_type, compression, payload_len, checksum = struct.unpack(
-                '>HBBHH', data[:cls.HEADER_SIZE]
-            )
+            magic, msg_type, flags, payload_len, checksum = cls.HEADER_STRUCT.unpack_from(data, 0)
             
             # Verifica magic number
             if magic != cls.MAGIC_NUMBER:
@@ -155,58 +209,95 @@ class MessageProtocol:
             if len(data) < cls.HEADER_SIZE + payload_len:
                 raise ProtocolError("Dados insuficientes para payload")
             
-            # Extrai payload
-            payload_bytes = data[cls.HEADER_SIZE:cls.HEADER_SIZE + payload_len]
+            # Extrai payload (sem cópia)
+            payload_bytes = memoryview(data)[cls.HEADER_SIZE:cls.HEADER_SIZE + payload_len]
             
             # Verifica checksum
             if cls._calculate_crc16(payload_bytes) != checksum:
                 raise ProtocolError("Checksum inválido")
             
+            return cls.decode_payload(msg_type, flags, payload_bytes, checksum)
+            
+        except Exception as e:
+            raise ProtocolError(f"Erro ao analisar mensagem: {e}")
+    
+    @classmethod
+    def decode_payload(cls, msg_type: int, flags: int,
+                       payload_bytes: Union[bytes, memoryview],
+                       checksum: int) -> Dict[str, Any]:
+        """
+        Decodifica o payload de um frame já validado.
+        
+        Args:
+            msg_type: Tipo da mensagem
+            flags: Byte de compressão/codificação do header
+            payload_bytes: Payload bruto (CRC já verificado)
+            checksum: CRC16 do header
+            
+        Returns:
+            Dicionário com campos da mensagem
+            
+        Raises:
+            ProtocolError: Se erro na decodificação
+        """
+        compression = flags & CompressionType.MASK
+        encoding = flags & PayloadEncoding.MASK
+        
+        try:
             # Descomprime se necessário
             if compression == CompressionType.ZLIB:
                 payload_bytes = zlib.decompress(payload_bytes)
             
             # Decodifica payload
-            try:
-                payload = json.loads(payload_bytes.decode('utf-8'))
-            except (json.JSONDecodeError, UnicodeDecodeError):
-                # Se não é JSON válido, mantém como bytes
-                payload = payload_bytes
+            if encoding == PayloadEncoding.COLUMNAR:
+                if msg_type not in PayloadEncoding.COLUMNAR_TYPES:
+                    raise ProtocolError(
+                        f"Codificação colunar não suportada para tipo {msg_type:#04x}"
+                    )
+                if compression == CompressionType.TIMESERIES:
+                    payload = TimeSeriesCodec.decode(payload_bytes)
+                else:
+                    payload = ColumnarCodec.decode(payload_bytes)
+            elif compression == CompressionType.TIMESERIES:
+                raise ProtocolError("Compressão de série temporal requer payload colunar")
+            elif encoding == PayloadEncoding.JSON:
+                payload_bytes = bytes(payload_bytes)
+                try:
+                    payload = json.loads(payload_bytes.decode('utf-8'))
+                except (json.JSONDecodeError, UnicodeDecodeError):
+                    # Se não é JSON válido, mantém como bytes
+                    payload = payload_bytes
+            else:
+                raise ProtocolError(f"Codificação desconhecida: {encoding:#04x}")
             
             return {
                 'type': msg_type,
                 'compression': compression,
+                'encoding': encoding,
                 'payload': payload,
                 'checksum': checksum
             }
             
+        except ProtocolError:
+            raise
         except Exception as e:
-            raise ProtocolError(f"Erro ao analisar mensagem: {e}")
+            raise ProtocolError(f"Erro ao decodificar payload: {e}")
     
     @staticmethod
-    def _calculate_crc16(data: bytes) -> int:
+    def _calculate_crc16(data: Union[bytes, memoryview]) -> int:
         """
         Calcula CRC16 para verificação de integridade.
         
+        CRC-16/CCITT-FALSE (polinômio 0x1021, valor inicial 0xFFFF),
+        calculado pela implementação nativa do binascii.
+        
         Args:
             data: Dados para calcular CRC
             
         Returns:
             Valor CRC16
         """
-        crc = 0xFFFF
-        polynomial = 0x1021
-        
-        for byte in data:
-            crc ^= (byte << 8)
-            for _ in range(8):
-                if crc & 0x8000:
-                    crc = (crc << 1) ^ polynomial
-                else:
-                    crc <<= 1
-                crc &= 0xFFFF
-        
-        return crc
+        return binascii.crc_hqx(data, 0xFFFF)
     
     @staticmethod
     def _json_serializer(obj) -> str:
@@ -216,6 +307,273 @@ class MessageProtocol:
         raise TypeError(f"Objeto não serializável: {type(obj)}")
 
 
+class Frame:
+    """
+    Frame completo extraído de um stream de bytes.
+    
+    O payload é um memoryview sobre o buffer de entrada (sem cópia).
+    Copie com bytes() se precisar retê-lo depois de reutilizar o
+    buffer passado ao decoder.
+    """
+    
+    __slots__ = ('message_type', 'flags', 'checksum', 'payload')
+    
+    def __init__(self, message_type: int, flags: int, checksum: int, payload: memoryview):
+        self.message_type = message_type
+        self.flags = flags
+        self.checksum = checksum
+        self.payload = payload
+    
+    @property
+    def compression(self) -> int:
+        """Tipo de compressão do frame."""
+        return self.flags & CompressionType.MASK
+    
+    @property
+    def encoding(self) -> int:
+        """Codificação do payload do frame."""
+        return self.flags & PayloadEncoding.MASK
+    
+    def decode(self) -> Dict[str, Any]:
+        """
+        Decodifica o frame no mesmo formato de parse_message.
+        
+        Returns:
+            Dicionário com campos da mensagem
+        """
+        return MessageProtocol.decode_payload(
+            self.message_type, self.flags, self.payload, self.checksum
+        )
+    
+    def to_batch(self) -> StrainBatch:
+        """
+        Decodifica um frame de dados direto em StrainBatch.
+        
+        Returns:
+            Lote de leituras do frame
+            
+        Raises:
+            ProtocolError: Se o frame não contém leituras
+        """
+        return DataPacketEncoder.decode_batch(self.decode()['payload'])
+
+
+class FrameDecoder:
+    """
+    Decodificador incremental de frames para links BLE/TCP.
+    
+    Recebe blocos de bytes de tamanho arbitrário, ressincroniza no
+    magic number após corrupção e retorna cada frame completo com CRC
+    válido. Apenas bytes de frames que cruzam a fronteira entre blocos
+    são copiados; os demais payloads referenciam o bloco recebido.
+    """
+    
+    _MAGIC = struct.pack('>H', MessageProtocol.MAGIC_NUMBER)
+    
+    # Contadores exportados como daq_link_<nome>_total{link=...}
+    _METRICS = (
+        ('bytes_received', 'Bytes recebidos do link'),
+        ('frames_decoded', 'Frames válidos decodificados'),
+        ('bytes_dropped', 'Bytes descartados (ruído, frames corrompidos)'),
+        ('crc_failures', 'Frames descartados por CRC inválido'),
+        ('invalid_headers', 'Cabeçalhos descartados (tamanho inválido)'),
+        ('resyncs', 'Ressincronizações no magic number')
+    )
+    
+    def __init__(self, max_payload_size: int = MessageProtocol.MAX_PAYLOAD_SIZE,
+                 link: Optional[str] = None):
+        """
+        Inicializa o decodificador.
+        
+        Args:
+            max_payload_size: Maior payload aceito (headers acima são descartados)
+            link: Nome do link nas métricas (None = contadores não exportados)
+        """
+        self._max_payload_size = max_payload_size
+        self._pending = bytearray()
+        self.link = link
+        
+        # Contadores
+        self.bytes_received = 0
+        self.frames_decoded = 0
+        self.bytes_dropped = 0
+        self.crc_failures = 0
+        self.invalid_headers = 0
+        self.resyncs = 0
+        
+        if link is not None:
+            # Lidos apenas no scrape; o laço de decodificação não muda
+            metrics.register_collector(FrameDecoder._collect_metrics, owner=self)
+    
+    def _collect_metrics(self) -> List[tuple]:
+        """Coletor de métricas por link."""
+        labels = {'link': self.link}
+        return [(f'daq_link_{name}_total', COUNTER, documentation, labels, getattr(self, name))
+                for name, documentation in self._METRICS]
+    
+    def feed(self, data: Union[bytes, bytearray, memoryview]) -> List[Frame]:
+        """
+        Processa um bloco de bytes recebido.
+        
+        Um frame parcial do bloco anterior é completado no buffer pendente
+        (o bloco é acrescentado uma vez, e só o payload desse frame é
+        copiado); o restante do bloco é varrido direto, sem cópia.
+        
+        Args:
+            data: Bloco recebido do link
+            
+        Returns:
+            Frames completos encontrados (possivelmente vazia)
+        """
+        view = memoryview(data)
+        if view.format != 'B' or view.ndim != 1:
+            view = view.cast('B')
+        self.bytes_received += len(view)
+        
+        # Objeto com find() para a ressincronização, sem copiar a cauda
+        if isinstance(data, (bytes, bytearray)):
+            buffer = data
+        elif isinstance(view.obj, (bytes, bytearray)) and len(view) == len(view.obj):
+            buffer = view.obj
+        else:
+            buffer = bytes(view)
+            view = memoryview(buffer)
+        
+        frames: List[Frame] = []
+        start = 0
+        if self._pending:
+            pending = self._pending
+            boundary = len(pending)
+            pending += view
+            frames, pos = self._scan(pending, memoryview(pending), 0, boundary, copy=True)
+            if pos < boundary:
+                # Frame pendente ainda incompleto
+                del pending[:pos]
+                return frames
+            pending.clear()
+            start = pos - boundary
+        
+        more, consumed = self._scan(buffer, view, start)
+        frames.extend(more)
+        
+        if consumed < len(view):
+            self._pending += view[consumed:]
+        
+        return frames
+    
+    def decode_stream(self, chunks: Iterable[Union[bytes, bytearray, memoryview]]) -> Iterator[Frame]:
+        """
+        Gera frames a partir de uma sequência de blocos.
+        
+        Args:
+            chunks: Blocos recebidos do link
+            
+        Yields:
+            Frames completos na ordem de chegada
+        """
+        for chunk in chunks:
+            yield from self.feed(chunk)
+    
+    def _scan(self, buffer: Union[bytes, bytearray], view: memoryview, pos: int = 0,
+              stop: Optional[int] = None, copy: bool = False) -> tuple:
+        """
+        Extrai frames de view a partir de pos.
+        
+        Args:
+            buffer: Objeto sob view (usado em find() na ressincronização)
+            view: Bytes a varrer
+            pos: Posição inicial
+            stop: Não inicia frames em posições >= stop (None = até o fim)
+            copy: Copia os payloads (view sobre o buffer pendente, que é reutilizado)
+            
+        Returns:
+            (frames, posição após o último byte consumido)
+        """
+        header = MessageProtocol.HEADER_STRUCT
+        header_size = MessageProtocol.HEADER_SIZE
+        magic_hi, magic_lo = self._MAGIC
+        frames = []
+        size = len(view)
+        if stop is None:
+            stop = size
+        
+        while size - pos >= 2 and pos < stop:
+            if view[pos] != magic_hi or view[pos + 1] != magic_lo:
+                # Ressincroniza no próximo magic number
+                index = buffer.find(self._MAGIC, pos)
+                if index < 0:
+                    keep = 1 if view[size - 1] == magic_hi else 0
+                    self.bytes_dropped += size - keep - pos
+                    pos = size - keep
+                    break
+                self.bytes_dropped += index - pos
+                self.resyncs += 1
+                pos = index
+                if pos >= stop:
+                    break
+            
+            if size - pos < header_size:
+                break
+            
+            _, msg_type, flags, length, checksum = header.unpack_from(view, pos)
+            
+            if length > self._max_payload_size:
+                self.invalid_headers += 1
+                self.bytes_dropped += 1
+                pos += 1
+                continue
+            
+            end = pos + header_size + length
+            if end > size:
+                break  # Frame incompleto: aguarda mais dados
+            
+            payload = view[pos + header_size:end]
+            if binascii.crc_hqx(payload, 0xFFFF) != checksum:
+                self.crc_failures += 1
+                self.bytes_dropped += 1
+                pos += 1
+                continue
+            
+            if copy:
+                payload = memoryview(bytes(payload))
+            frames.append(Frame(msg_type, flags, checksum, payload))
+            self.frames_decoded += 1
+            pos = end
+        
+        if size - pos == 1 and view[pos] != magic_hi:
+            self.bytes_dropped += 1
+            pos = size
+        
+        return frames, pos
+    
+    @property
+    def pending_bytes(self) -> int:
+        """Bytes aguardando o restante de um frame."""
+        return len(self._pending)
+    
+    def reset(self) -> None:
+        """Descarta dados pendentes (ex: após reconexão)."""
+        self.bytes_dropped += len(self._pending)
+        self._pending = bytearray()
+    
+    def get_stats(self) -> Dict[str, int]:
+        """
+        Retorna contadores do decodificador.
+        
+        Returns:
+            Dicionário com contadores
+        """
+        return {
+            'bytes_received': self.bytes_received,
+            'frames_decoded': self.frames_decoded,
+            'bytes_dropped': self.bytes_dropped,
+            'crc_failures': self.crc_failures,
+            'invalid_headers': self.invalid_headers,
+            'resyncs': self.resyncs,
+            'pending_bytes': len(self._pending)
+        }
+
+
 class DataPacketEncoder:
     """Codificador/decodificador especializado para pacotes de dados."""
     
@@ -308,6 +666,101 @@ class DataPacketEncoder:
             total_packets=data['total_packets'],
             readings=readings
         )
+    
+    @staticmethod
+    def decode_batch(payload: Dict[str, Any]) -> StrainBatch:
+        """
+        Converte o payload de uma mensagem de dados em StrainBatch.
+        
+        Payloads colunares são envolvidos sem cópia; pacotes JSON são
+        transpostos direto para colunas, sem criar StrainReading.
+        
+        Args:
+            payload: Payload colunar (decode do ColumnarCodec) ou pacote JSON
+            
+        Returns:
+            Lote de leituras
+            
+        Raises:
+            ProtocolError: Se o payload não for de dados
+        """
+        if not isinstance(payload, dict):
+            raise ProtocolError("Payload de dados inválido")
+        if 'timestamps_us' in payload:
+            return ColumnarCodec.to_batch(payload)
+        if 'readings' not in payload:
+            raise ProtocolError("Payload sem leituras")
+        
+        readings = payload['readings']
+        if len({reading['sensor_id'] for reading in readings}) > 1:
+            return StrainBatch.from_readings([
+                DataPacketEncoder.decode_strain_reading(reading) for reading in readings
+            ])
+        return StrainBatch.for_sensor(
+            readings[0]['sensor_id'] if readings else payload.get('sensor_id', ''),
+            array('q', [datetime_to_us(datetime.fromisoformat(r['timestamp'])) for r in readings]),
+            array('d', [r['strain_value'] for r in readings]),
+            array('i', [r['raw_adc_value'] for r in readings]),
+            array('h', [r['battery_level'] for r in readings]),
+            array('d', [r['temperature'] for r in readings])
+        )
+    
+    @staticmethod
+    def create_batch_message(packet: DataPacket,
+                             message_type: int = MessageType.DATA_BATCH,
+                             compression: int = CompressionType.NONE) -> bytes:
+        """
+        Cria mensagem de dados com payload colunar binário.
+        
+        Args:
+            packet: Pacote de leituras de um único sensor
+            message_type: DATA_BATCH ou DATA_BUFFER
+            compression: Tipo de compressão (TIMESERIES para transferências em massa)
+            
+        Returns:
+            Mensagem codificada
+        """
+        if compression == CompressionType.TIMESERIES:
+            # Codifica direto no formato de série temporal, sem passar pelo colunar
+            if message_type not in PayloadEncoding.COLUMNAR_TYPES:
+                raise ProtocolError(
+                    f"Codificação colunar não suportada para tipo {message_type:#04x}"
+                )
+            try:
+                payload = TimeSeriesCodec.encode_packet(packet)
+            except ValueError as e:
+                raise ProtocolError(f"Erro ao codificar série temporal: {e}")
+            return MessageProtocol.frame_payload(
+                message_type, compression | PayloadEncoding.COLUMNAR, payload
+            )
+        
+        try:
+            payload = ColumnarCodec.encode_packet(packet)
+        except ValueError as e:
+            raise ProtocolError(f"Erro ao codificar pacote colunar: {e}")
+        
+        return MessageProtocol.create_message(
+            message_type,
+            payload,
+            compression,
+            PayloadEncoding.COLUMNAR
+        )
+    
+    @staticmethod
+    def decode_columnar_packet(columns: Dict[str, Any]) -> DataPacket:
+        """
+        Converte payload colunar decodificado em DataPacket.
+        
+        Prefira consumir as colunas diretamente; este método existe
+        para código que ainda trabalha com objetos StrainReading.
+        
+        Args:
+            columns: Payload retornado por parse_message
+            
+        Returns:
+            Objeto DataPacket
+        """
+        return ColumnarCodec.to_packet(columns)
 
 
 class ConfigurationProtocol:
@@ -0,0 +1,517 @@
+"""
+Compressão de séries temporais para lotes de leituras (CompressionType.TIMESERIES).
+
+Alternativa ao zlib para transferências em massa (DATA_BUFFER) a partir do
+formato colunar: cada coluna usa a codificação adequada ao seu sinal, no
+estilo do Gorilla (Facebook, 2015):
+
+- Timestamps: delta-of-delta com prefixos de tamanho variável
+  ('0' para amostragem regular, até 64 bits para saltos)
+- Strain e temperatura: XOR com o valor anterior ('0' se igual; '10' +
+  bits significativos reaproveitando a janela anterior; '11' + 6 bits de
+  zeros à esquerda + 6 bits de tamanho + bits significativos)
+- Bateria: '0' se igual à anterior, senão '1' + 8 bits
+- ADC bruto: deltas em zigzag-varint, em um fluxo de bytes separado
+
+O XOR é aplicado aos valores em ponto fixo do formato colunar (mesmas
+escalas, após zigzag), não ao float64: leituras decimais quantizadas
+têm mantissas completas e o XOR de doubles vizinhos quase não zera bits.
+Assim a compressão é sem perdas em relação ao DATA_BATCH colunar.
+
+Layout v1 (little-endian):
+
+CABEÇALHO (28 bytes + strings):
+- Versão (1 byte), Flags (1 byte), Contagem (2 bytes)
+- Sequence Number (2 bytes), Total Packets (2 bytes)
+- Timestamp do pacote (8 bytes) e timestamp base (8 bytes), µs desde epoch
+- Tamanho do fluxo de bits (4 bytes)
+- packet_id e sensor_id (1 byte de tamanho + UTF-8)
+
+DADOS:
+- Fluxo de bits (timestamps, strain, temperatura e bateria intercalados
+  por leitura, MSB primeiro)
+- Fluxo de bytes dos deltas do ADC (até o fim do payload)
+
+Codificador e decodificador são incrementais: leituras podem ser
+acrescentadas aos poucos (TimeSeriesEncoder.append_columns) e lidas em
+blocos (TimeSeriesDecoder.read), sem materializar o lote inteiro.
+"""
+
+import struct
+from array import array
+from typing import Any, Dict, Optional, Sequence
+
+from ..core.models import DataPacket, datetime_to_us, us_to_datetime
+from .columnar import STRAIN_SCALE, TEMPERATURE_SCALE, ColumnarCodec, _encode_string
+
+
+LAYOUT_VERSION = 1
+
+_HEADER = struct.Struct('<BBHHHqqI')
+
+_MASK64 = (1 << 64) - 1
+_INT32_MIN = -2**31
+_INT32_MAX = 2**31 - 1
+
+# Faixas do delta-of-delta (após zigzag): (prefixo, bits do prefixo, bits do valor)
+_DOD_BUCKETS = (
+    (0b10, 2, 7),
+    (0b110, 3, 9),
+    (0b1110, 4, 12),
+    (0b11110, 5, 20),
+    (0b11111, 5, 64)
+)
+
+
+def _zigzag(value: int) -> int:
+    """Mapeia inteiro com sinal para sem sinal (0, -1, 1, -2 -> 0, 1, 2, 3)."""
+    return value << 1 if value >= 0 else ((-value) << 1) - 1
+
+
+def _unzigzag(value: int) -> int:
+    """Inverso de _zigzag."""
+    return (value >> 1) ^ -(value & 1)
+
+
+class _BitWriter:
+    """Acumula bits (MSB primeiro) em palavras de 64 bits."""
+
+    __slots__ = ('_out', '_acc', '_bits')
+
+    def __init__(self):
+        self._out = bytearray()
+        self._acc = 0
+        self._bits = 0
+
+    def write(self, value: int, bits: int) -> None:
+        self._acc = (self._acc << bits) | value
+        self._bits += bits
+        if self._bits >= 64:
+            rest = self._bits - 64
+            self._out += (self._acc >> rest).to_bytes(8, 'big')
+            self._acc &= (1 << rest) - 1
+            self._bits = rest
+
+    @property
+    def nbytes(self) -> int:
+        return len(self._out) + (self._bits + 7) // 8
+
+    def getvalue(self) -> bytes:
+        tail = b''
+        if self._bits:
+            size = (self._bits + 7) // 8
+            tail = (self._acc << (size * 8 - self._bits)).to_bytes(size, 'big')
+        return bytes(self._out) + tail
+
+
+class _BitReader:
+    """Lê bits (MSB primeiro) de um bloco de bytes."""
+
+    __slots__ = ('_data', '_pos', '_acc', '_bits')
+
+    def __init__(self, data: bytes):
+        self._data = data
+        self._pos = 0
+        self._acc = 0
+        self._bits = 0
+
+    def read(self, bits: int) -> int:
+        while self._bits < bits:
+            chunk = self._data[self._pos:self._pos + 8]
+            if not chunk:
+                raise ValueError("Fluxo de bits truncado")
+            self._pos += len(chunk)
+            self._acc = (self._acc << (8 * len(chunk))) | int.from_bytes(chunk, 'big')
+            self._bits += 8 * len(chunk)
+        rest = self._bits - bits
+        value = self._acc >> rest
+        self._acc &= (1 << rest) - 1
+        self._bits = rest
+        return value
+
+
+class _XorState:
+    """Estado do XOR do Gorilla para uma coluna."""
+
+    __slots__ = ('previous', 'leading', 'trailing')
+
+    def __init__(self):
+        self.previous = 0
+        self.leading = -1
+        self.trailing = 0
+
+
+def _write_xor(writer: _BitWriter, state: _XorState, value: int) -> None:
+    current = _zigzag(value)
+    xor = current ^ state.previous
+    state.previous = current
+    if xor == 0:
+        writer.write(0, 1)
+        return
+    leading = min(63, 64 - xor.bit_length())
+    trailing = (xor & -xor).bit_length() - 1
+    if state.leading >= 0 and leading >= state.leading and trailing >= state.trailing:
+        size = 64 - state.leading - state.trailing
+        writer.write(0b10, 2)
+        writer.write(xor >> state.trailing, size)
+        return
+    size = 64 - leading - trailing
+    writer.write(0b11, 2)
+    writer.write(leading, 6)
+    writer.write(size - 1, 6)
+    writer.write(xor >> trailing, size)
+    state.leading, state.trailing = leading, trailing
+
+
+def _read_xor(reader: _BitReader, state: _XorState) -> int:
+    if reader.read(1):
+        if reader.read(1):
+            state.leading = reader.read(6)
+            size = reader.read(6) + 1
+            state.trailing = 64 - state.leading - size
+        else:
+            size = 64 - state.leading - state.trailing
+        state.previous ^= reader.read(size) << state.trailing
+    return _unzigzag(state.previous)
+
+
+class TimeSeriesEncoder:
+    """
+    Codificador incremental de leituras de um sensor.
+
+    As leituras podem ser acrescentadas em vários blocos; nbytes informa o
+    tamanho atual do payload para encher um frame até o limite.
+    """
+
+    def __init__(self, sensor_id: str, packet_id: str = ''):
+        """
+        Inicializa o codificador.
+
+        Args:
+            sensor_id: ID do sensor
+            packet_id: ID do pacote
+        """
+        self.sensor_id = sensor_id
+        self.packet_id = packet_id
+        self.count = 0
+        self.base_us: Optional[int] = None
+        self._strings = _encode_string(packet_id) + _encode_string(sensor_id)
+        self._bits = _BitWriter()
+        self._adc = bytearray()
+        self._last_us = 0
+        self._last_delta = 0
+        self._last_adc = 0
+        self._last_battery = 0
+        self._strain = _XorState()
+        self._temperature = _XorState()
+
+    @property
+    def nbytes(self) -> int:
+        """Tamanho do payload se finalizado agora."""
+        return _HEADER.size + len(self._strings) + self._bits.nbytes + len(self._adc)
+
+    def append_columns(self, timestamps_us: Sequence[int], strain_values: Sequence[float],
+                       raw_adc_values: Sequence[int], temperatures: Sequence[float],
+                       battery_levels: Sequence[int]) -> None:
+        """
+        Acrescenta leituras (colunas do mesmo tamanho, em ordem temporal).
+
+        Args:
+            timestamps_us: Timestamps (µs desde epoch)
+            strain_values: Valores de strain (µε)
+            raw_adc_values: Valores ADC brutos
+            temperatures: Temperaturas (°C)
+            battery_levels: Níveis de bateria (0-100%)
+
+        Raises:
+            ValueError: Se colunas de tamanhos diferentes ou valor fora de faixa
+        """
+        count = len(timestamps_us)
+        if not (len(strain_values) == len(raw_adc_values) == len(temperatures) ==
+                len(battery_levels) == count):
+            raise ValueError("Colunas com tamanhos diferentes")
+        if self.count + count > 0xFFFF:
+            raise ValueError(f"Leituras demais para um pacote: {self.count + count}")
+        if count and self.base_us is None:
+            self.base_us = self._last_us = timestamps_us[0]
+
+        write = self._bits.write
+        adc_out = self._adc
+        strain_state, temperature_state = self._strain, self._temperature
+        for ts, strain, adc, temperature, battery in zip(
+                timestamps_us, strain_values, raw_adc_values, temperatures, battery_levels):
+            # Timestamp: delta-of-delta
+            delta = ts - self._last_us
+            dod = _zigzag(delta - self._last_delta)
+            self._last_us, self._last_delta = ts, delta
+            if dod == 0:
+                write(0, 1)
+            else:
+                for prefix, prefix_bits, value_bits in _DOD_BUCKETS:
+                    if dod < (1 << value_bits):
+                        write(prefix, prefix_bits)
+                        write(dod, value_bits)
+                        break
+                else:
+                    raise ValueError(f"Salto de timestamp fora da faixa: {delta} µs")
+
+            _write_xor(self._bits, strain_state, round(strain * STRAIN_SCALE))
+            _write_xor(self._bits, temperature_state, round(temperature * TEMPERATURE_SCALE))
+
+            if battery == self._last_battery:
+                write(0, 1)
+            else:
+                if not 0 <= battery <= 0xFF:
+                    raise ValueError(f"Bateria fora da faixa: {battery}")
+                write(0x100 | battery, 9)
+                self._last_battery = battery
+
+            # ADC: zigzag-varint do delta
+            if not _INT32_MIN <= adc <= _INT32_MAX:
+                raise ValueError(f"ADC fora da faixa: {adc}")
+            value = _zigzag(adc - self._last_adc)
+            self._last_adc = adc
+            while value > 0x7F:
+                adc_out.append((value & 0x7F) | 0x80)
+                value >>= 7
+            adc_out.append(value)
+        self.count += count
+
+    def finish(self, packet_timestamp_us: Optional[int] = None,
+               sequence_number: int = 0, total_packets: int = 1) -> bytes:
+        """
+        Gera o payload com as leituras acrescentadas.
+
+        Args:
+            packet_timestamp_us: Timestamp do pacote (padrão: última leitura)
+            sequence_number: Número sequencial do pacote
+            total_packets: Total de pacotes na sequência
+
+        Returns:
+            Payload binário
+        """
+        if packet_timestamp_us is None:
+            packet_timestamp_us = self._last_us
+        bits = self._bits.getvalue()
+        header = _HEADER.pack(
+            LAYOUT_VERSION, 0, self.count, sequence_number, total_packets,
+            packet_timestamp_us,
+            self.base_us if self.base_us is not None else packet_timestamp_us,
+            len(bits)
+        )
+        return b''.join((header, self._strings, bits, bytes(self._adc)))
+
+
+class TimeSeriesDecoder:
+    """
+    Decodificador incremental de um payload TIMESERIES.
+
+    read(n) devolve as próximas n leituras como colunas tipadas, no mesmo
+    formato de ColumnarCodec.decode.
+    """
+
+    def __init__(self, data: bytes):
+        """
+        Lê o cabeçalho do payload.
+
+        Args:
+            data: Payload binário
+
+        Raises:
+            ValueError: Se payload inválido ou versão não suportada
+        """
+        data = bytes(data)
+        if len(data) < _HEADER.size:
+            raise ValueError("Payload de série temporal truncado")
+        (version, _flags, self.count, self.sequence_number, self.total_packets,
+         self.packet_timestamp_us, self.base_us, bits_size) = _HEADER.unpack_from(data, 0)
+        if version != LAYOUT_VERSION:
+            raise ValueError(f"Versão do formato de série temporal não suportada: {version}")
+
+        offset = _HEADER.size
+        strings = []
+        for _ in range(2):
+            if offset >= len(data):
+                raise ValueError("Payload de série temporal truncado")
+            length = data[offset]
+            strings.append(data[offset + 1:offset + 1 + length].decode('utf-8'))
+            offset += 1 + length
+        self.packet_id, self.sensor_id = strings
+        if offset + bits_size > len(data):
+            raise ValueError("Payload de série temporal truncado")
+
+        self._bits = _BitReader(data[offset:offset + bits_size])
+        self._adc = data[offset + bits_size:]
+        self._adc_pos = 0
+        self.remaining = self.count
+        self._last_us = self.base_us
+        self._last_delta = 0
+        self._last_adc = 0
+        self._last_battery = 0
+        self._strain = _XorState()
+        self._temperature = _XorState()
+
+    def read(self, max_count: Optional[int] = None) -> Dict[str, array]:
+        """
+        Decodifica as próximas leituras.
+
+        Args:
+            max_count: Máximo de leituras (None = todas as restantes)
+
+        Returns:
+            Colunas 'timestamps_us', 'strain_values', 'raw_adc_values',
+            'temperatures' e 'battery_levels'
+
+        Raises:
+            ValueError: Se o payload estiver truncado ou corrompido
+        """
+        count = self.remaining if max_count is None else min(max_count, self.remaining)
+        timestamps = array('q', bytes(8 * count))
+        strain = array('d', bytes(8 * count))
+        adc = array('i', bytes(4 * count))
+        temperature = array('d', bytes(8 * count))
+        battery = array('B', bytes(count))
+
+        read = self._bits.read
+        data, pos = self._adc, self._adc_pos
+        strain_state, temperature_state = self._strain, self._temperature
+        for index in range(count):
+            if read(1):
+                for prefix, prefix_bits, value_bits in _DOD_BUCKETS[:-1]:
+                    if not read(1):
+                        break
+                else:
+                    value_bits = _DOD_BUCKETS[-1][2]
+                self._last_delta += _unzigzag(read(value_bits))
+            self._last_us += self._last_delta
+            timestamps[index] = self._last_us
+
+            strain[index] = _read_xor(self._bits, strain_state) / STRAIN_SCALE
+            temperature[index] = _read_xor(self._bits, temperature_state) / TEMPERATURE_SCALE
+            if read(1):
+                self._last_battery = read(8)
+            battery[index] = self._last_battery
+
+            value = shift = 0
+            while True:
+                if pos >= len(data):
+                    raise ValueError("Fluxo de ADC truncado")
+                byte = data[pos]
+                pos += 1
+                value |= (byte & 0x7F) << shift
+                if byte < 0x80:
+                    break
+                shift += 7
+            self._last_adc += _unzigzag(value)
+            adc[index] = self._last_adc
+
+        self._adc_pos = pos
+        self.remaining -= count
+        return {
+            'timestamps_us': timestamps,
+            'strain_values': strain,
+            'raw_adc_values': adc,
+            'temperatures': temperature,
+            'battery_levels': battery
+        }
+
+
+class TimeSeriesCodec:
+    """Codificação de lotes completos no formato TIMESERIES."""
+
+    @staticmethod
+    def encode_columns(packet_id: str, sensor_id: str, packet_timestamp_us: int,
+                       timestamps_us: Sequence[int], strain_values: Sequence[float],
+                       raw_adc_values: Sequence[int], temperatures: Sequence[float],
+                       battery_levels: Sequence[int], sequence_number: int = 0,
+                       total_packets: int = 1) -> bytes:
+        """
+        Codifica colunas de leituras de um único sensor.
+
+        Mesmos argumentos de ColumnarCodec.encode_columns.
+
+        Returns:
+            Payload binário
+
+        Raises:
+            ValueError: Se algum valor não couber no formato
+        """
+        encoder = TimeSeriesEncoder(sensor_id, packet_id)
+        encoder.append_columns(timestamps_us, strain_values, raw_adc_values,
+                               temperatures, battery_levels)
+        return encoder.finish(packet_timestamp_us, sequence_number, total_packets)
+
+    @staticmethod
+    def encode_packet(packet: DataPacket) -> bytes:
+        """
+        Codifica um DataPacket (leituras de um único sensor).
+
+        Args:
+            packet: Pacote a ser codificado
+
+        Returns:
+            Payload binário
+        """
+        readings = packet.readings
+        for reading in readings:
+            if reading.sensor_id != packet.sensor_id:
+                raise ValueError(f"Leitura de outro sensor no pacote: {reading.sensor_id}")
+        return TimeSeriesCodec.encode_columns(
+            packet_id=packet.packet_id,
+            sensor_id=packet.sensor_id,
+            packet_timestamp_us=datetime_to_us(packet.timestamp),
+            timestamps_us=[r.timestamp_us for r in readings],
+            strain_values=[r.strain_value for r in readings],
+            raw_adc_values=[r.raw_adc_value for r in readings],
+            temperatures=[r.temperature for r in readings],
+            battery_levels=[r.battery_level for r in readings],
+            sequence_number=packet.sequence_number,
+            total_packets=packet.total_packets
+        )
+
+    @staticmethod
+    def from_columnar(data: bytes) -> bytes:
+        """
+        Recodifica um payload colunar (DATA_BATCH) no formato TIMESERIES.
+
+        Args:
+            data: Payload colunar
+
+        Returns:
+            Payload TIMESERIES equivalente
+        """
+        columns = ColumnarCodec.decode(data)
+        return TimeSeriesCodec.encode_columns(
+            columns['packet_id'], columns['sensor_id'],
+            datetime_to_us(columns['timestamp']),
+            columns['timestamps_us'], columns['strain_values'], columns['raw_adc_values'],
+            columns['temperatures'], columns['battery_levels'],
+            columns['sequence_number'], columns['total_packets']
+        )
+
+    @staticmethod
+    def decode(data: bytes) -> Dict[str, Any]:
+        """
+        Decodifica um payload completo.
+
+        Args:
+            data: Payload binário
+
+        Returns:
+            Dicionário no formato de ColumnarCodec.decode
+
+        Raises:
+            ValueError: Se payload inválido ou versão não suportada
+        """
+        decoder = TimeSeriesDecoder(data)
+        columns = decoder.read()
+        return {
+            'version': LAYOUT_VERSION,
+            'packet_id': decoder.packet_id,
+            'sensor_id': decoder.sensor_id,
+            'timestamp': us_to_datetime(decoder.packet_timestamp_us),
+            'sequence_number': decoder.sequence_number,
+            'total_packets': decoder.total_packets,
+            'count': decoder.count,
+            **columns
+        }
@@ -0,0 +1,608 @@
+"""
+Transferência fragmentada de payloads grandes (ex: backlog DATA_BUFFER).
+
+MessageProtocol limita cada frame a MAX_PAYLOAD_SIZE; um nó que volta a
+se conectar depois de horas offline precisa enviar muito mais que isso.
+Esta camada divide o payload em fragmentos do tamanho do MTU do link,
+cada um enquadrado normalmente (TRANSFER_FRAGMENT, com CRC16 próprio), e
+o receptor os remonta fora de ordem em um buffer pré-alocado.
+
+A confirmação é por janela deslizante com ACK seletivo: cada
+TRANSFER_ACK leva o índice cumulativo (todos os fragmentos anteriores
+recebidos) e um bitmap dos fragmentos seguintes. O emissor mantém até
+`window` fragmentos em trânsito e só reenvia os que faltam:
+- perda detectada: um fragmento enviado depois dele já foi confirmado
+  (links BLE/TCP entregam em ordem)
+- timeout: sem confirmação após `rto` segundos (perdas no fim da janela
+  ou ACKs perdidos)
+
+Se o payload remontado não confere com o CRC32, o receptor descarta a
+remontagem e responde TRANSFER_NACK; o emissor rearma todos os
+fragmentos e recomeça, até `max_restarts` vezes, e depois marca a
+transferência como falha (failed).
+
+Layout do fragmento (little-endian, 20 bytes + dados):
+- Transfer ID (2 bytes), Índice (2 bytes), Total de fragmentos (2 bytes)
+- Tipo e flags da mensagem original (1 byte cada)
+- Offset dos dados (4 bytes), Tamanho total (4 bytes)
+- CRC32 do payload completo (4 bytes)
+
+Layout do ACK (5 bytes + bitmap):
+- Transfer ID (2 bytes), Cumulativo (2 bytes), Tamanho do bitmap (1 byte)
+- Bitmap: bit i (LSB primeiro) = fragmento cumulativo + i recebido
+
+Layout do NACK (2 bytes):
+- Transfer ID (2 bytes)
+
+A mensagem remontada é entregue como Frame, com o mesmo decode/to_batch
+dos frames de FrameDecoder.
+"""
+
+import binascii
+import struct
+import time
+import zlib
+from collections import OrderedDict
+from typing import Dict, List, Optional, Union
+
+from ..core.config import COMMUNICATION_CONFIG
+from ..core.models import DataPacket
+from .columnar import ColumnarCodec
+from .protocol import (
+    MessageProtocol,
+    MessageType,
+    CompressionType,
+    PayloadEncoding,
+    Frame,
+    ProtocolError
+)
+from .timeseries import TimeSeriesCodec
+
+
+_FRAGMENT = struct.Struct('<HHHBBIII')
+_ACK = struct.Struct('<HHB')
+_NACK = struct.Struct('<H')
+
+MAX_FRAGMENTS = 0xFFFF
+MAX_BITMAP_BYTES = 0xFF
+
+# Transferências concluídas lembradas para reconfirmar fragmentos repetidos
+_FINISHED_MEMORY = 16
+
+
+def fragment_capacity(mtu: int) -> int:
+    """
+    Bytes de dados por fragmento para um MTU.
+
+    Args:
+        mtu: Tamanho máximo da mensagem no link (header incluído)
+
+    Returns:
+        Bytes do payload original por fragmento
+    """
+    return mtu - MessageProtocol.HEADER_SIZE - _FRAGMENT.size
+
+
+class FragmentSender:
+    """
+    Emissor de uma transferência fragmentada.
+
+    Não faz E/S: poll() retorna as mensagens a transmitir agora e on_ack()
+    processa as confirmações recebidas, deixando o transporte (BLE, TCP,
+    simulador) a cargo de quem chama.
+    """
+
+    def __init__(self, message_type: int, payload: bytes, flags: int = 0,
+                 transfer_id: int = 0, mtu: Optional[int] = None,
+                 window: Optional[int] = None, rto: Optional[float] = None,
+                 max_restarts: Optional[int] = None):
+        """
+        Inicializa a transferência.
+
+        Args:
+            message_type: Tipo da mensagem original (ex: DATA_BUFFER)
+            payload: Payload já serializado e comprimido
+            flags: Compressão | codificação do payload original
+            transfer_id: Identificador (0-65535) único no link
+            mtu: Tamanho máximo de cada mensagem (padrão:
+                COMMUNICATION_CONFIG['max_packet_size'])
+            window: Fragmentos em trânsito (padrão: 'transfer_window')
+            rto: Timeout de retransmissão em segundos (padrão: 'packet_timeout')
+            max_restarts: Reinícios por NACK antes de falhar (padrão:
+                'transfer_max_restarts')
+
+        Raises:
+            ProtocolError: Se o MTU não comporta dados ou o payload exige
+                fragmentos demais
+        """
+        mtu = mtu or COMMUNICATION_CONFIG['max_packet_size']
+        self.chunk_size = fragment_capacity(mtu)
+        if self.chunk_size <= 0:
+            raise ProtocolError(f"MTU pequeno demais para fragmentação: {mtu} bytes")
+        if mtu - MessageProtocol.HEADER_SIZE > MessageProtocol.MAX_PAYLOAD_SIZE:
+            raise ProtocolError(f"MTU acima do payload máximo do protocolo: {mtu} bytes")
+
+        self.message_type = message_type
+        self.flags = flags
+        self.transfer_id = transfer_id & 0xFFFF
+        self.window = max(1, window or COMMUNICATION_CONFIG['transfer_window'])
+        self.rto = COMMUNICATION_CONFIG['packet_timeout'] if rto is None else rto
+        self.max_restarts = (COMMUNICATION_CONFIG['transfer_max_restarts']
+                             if max_restarts is None else max_restarts)
+
+        self._payload = memoryview(bytes(payload))
+        self.size = len(self._payload)
+        self.total = max(1, -(-self.size // self.chunk_size))
+        if self.total > MAX_FRAGMENTS:
+            raise ProtocolError(f"Payload grande demais para uma transferência: {self.size} bytes")
+        self._crc32 = zlib.crc32(self._payload)
+
+        self._seq = 0            # Ordem de envio (inclui retransmissões)
+        self._rearm()
+        self.failed = False
+
+        # Contadores
+        self.fragments_sent = 0
+        self.retransmissions = 0
+        self.acks_received = 0
+        self.restarts = 0
+
+    @classmethod
+    def for_packet(cls, packet: DataPacket, transfer_id: int = 0,
+                   compression: int = CompressionType.TIMESERIES, **kwargs) -> 'FragmentSender':
+        """
+        Cria a transferência de um DataPacket grande como DATA_BUFFER colunar.
+
+        Args:
+            packet: Pacote com as leituras (até 65535, um único sensor)
+            transfer_id: Identificador da transferência
+            compression: CompressionType aplicado ao payload colunar
+            **kwargs: mtu, window e rto (ver __init__)
+
+        Returns:
+            Emissor pronto para poll()
+        """
+        if compression == CompressionType.TIMESERIES:
+            payload = TimeSeriesCodec.encode_packet(packet)
+        else:
+            payload = ColumnarCodec.encode_packet(packet)
+            if compression == CompressionType.ZLIB:
+                payload = zlib.compress(payload)
+        return cls(MessageType.DATA_BUFFER, payload, compression | PayloadEncoding.COLUMNAR,
+                   transfer_id, **kwargs)
+
+    @property
+    def complete(self) -> bool:
+        """Todos os fragmentos foram confirmados."""
+        return self._remaining == 0
+
+    @property
+    def in_flight(self) -> int:
+        """Fragmentos enviados e ainda não confirmados."""
+        return self._next - self._base - sum(self._acked[self._base:self._next])
+
+    def poll(self, now: Optional[float] = None) -> List[bytes]:
+        """
+        Retorna as mensagens a transmitir agora.
+
+        Primeiro as retransmissões (perdas detectadas e timeouts), depois os
+        fragmentos novos que cabem na janela.
+
+        Args:
+            now: Instante atual (time.monotonic() se None)
+
+        Returns:
+            Mensagens TRANSFER_FRAGMENT enquadradas (possivelmente vazia)
+        """
+        if self.failed:
+            return []
+        now = time.monotonic() if now is None else now
+        messages = []
+        acked = self._acked
+        for index in range(self._base, self._next):
+            if not acked[index] and (self._send_seq[index] < self._acked_seq or
+                                     now - self._sent_at[index] >= self.rto):
+                messages.append(self._send(index, now))
+                self.retransmissions += 1
+
+        limit = min(self.total, self._base + self.window)
+        while self._next < limit:
+            messages.append(self._send(self._next, now))
+            self._next += 1
+        return messages
+
+    def on_ack(self, payload: Union[bytes, memoryview]) -> bool:
+        """
+        Processa o payload de um TRANSFER_ACK.
+
+        Args:
+            payload: Payload do ACK (Frame.payload ou parse_message)
+
+        Returns:
+            True se a transferência está completa
+
+        Raises:
+            ProtocolError: Se o ACK está truncado
+        """
+        if len(payload) < _ACK.size:
+            raise ProtocolError("ACK de transferência truncado")
+        transfer_id, cumulative, nbytes = _ACK.unpack_from(payload, 0)
+        if transfer_id != self.transfer_id:
+            return self.complete
+        if len(payload) < _ACK.size + nbytes:
+            raise ProtocolError("Bitmap do ACK truncado")
+        self.acks_received += 1
+
+        for index in range(self._base, min(cumulative, self._next)):
+            self._mark(index)
+        bitmap = payload[_ACK.size:_ACK.size + nbytes]
+        for byte_index, byte in enumerate(bitmap):
+            if not byte:
+                continue
+            first = cumulative + 8 * byte_index
+            for bit in range(8):
+                if byte >> bit & 1 and first + bit < self._next:
+                    self._mark(first + bit)
+
+        while self._base < self.total and self._acked[self._base]:
+            self._base += 1
+        return self.complete
+
+    def on_nack(self, payload: Union[bytes, memoryview]) -> bool:
+        """
+        Processa o payload de um TRANSFER_NACK: rearma todos os fragmentos.
+
+        Após max_restarts reinícios a transferência passa a failed e poll()
+        não envia mais nada; cabe à aplicação decidir (ex.: nova
+        transferência com outro ID).
+
+        Args:
+            payload: Payload do NACK
+
+        Returns:
+            True se a transferência foi reiniciada; False se falhou (ou se
+            o NACK é de outra transferência)
+
+        Raises:
+            ProtocolError: Se o NACK está truncado
+        """
+        if len(payload) < _NACK.size:
+            raise ProtocolError("NACK de transferência truncado")
+        transfer_id, = _NACK.unpack_from(payload, 0)
+        if transfer_id != self.transfer_id or self.failed:
+            return False
+        if self.restarts >= self.max_restarts:
+            self.failed = True
+            print(f"Erro na transferência {self.transfer_id}: "
+                  f"CRC32 inválido após {self.restarts} reinícios")
+            return False
+        self.restarts += 1
+        self._rearm()
+        return True
+
+    def handle(self, frame: Frame) -> bool:
+        """
+        Processa um frame recebido de FrameDecoder.
+
+        Args:
+            frame: Frame do link (TRANSFER_ACK ou TRANSFER_NACK)
+
+        Returns:
+            True se a transferência está completa
+        """
+        if frame.message_type == MessageType.TRANSFER_ACK:
+            return self.on_ack(frame.payload)
+        if frame.message_type == MessageType.TRANSFER_NACK:
+            self.on_nack(frame.payload)
+        return self.complete
+
+    def get_stats(self) -> Dict[str, int]:
+        """
+        Retorna contadores da transferência.
+
+        Returns:
+            Dicionário com contadores
+        """
+        return {
+            'fragments': self.total,
+            'acked': self.total - self._remaining,
+            'in_flight': self.in_flight,
+            'fragments_sent': self.fragments_sent,
+            'retransmissions': self.retransmissions,
+            'acks_received': self.acks_received,
+            'restarts': self.restarts
+        }
+
+    def _rearm(self) -> None:
+        """Marca todos os fragmentos como nunca enviados nem confirmados."""
+        self._acked = bytearray(self.total)
+        self._sent_at = [0.0] * self.total
+        self._send_seq = [0] * self.total
+        self._remaining = self.total
+        self._base = 0           # Menor fragmento não confirmado
+        self._next = 0           # Próximo fragmento nunca enviado
+        self._acked_seq = 0      # Maior ordem de envio já confirmada
+
+    def _mark(self, index: int) -> None:
+        if not self._acked[index]:
+            self._acked[index] = 1
+            self._remaining -= 1
+            if self._send_seq[index] > self._acked_seq:
+                self._acked_seq = self._send_seq[index]
+
+    def _send(self, index: int, now: float) -> bytes:
+        self._seq += 1
+        self._send_seq[index] = self._seq
+        self._sent_at[index] = now
+        self.fragments_sent += 1
+        offset = index * self.chunk_size
+        header = _FRAGMENT.pack(self.transfer_id, index, self.total, self.message_type,
+                                self.flags, offset, self.size, self._crc32)
+        return MessageProtocol.frame_payload(
+            MessageType.TRANSFER_FRAGMENT, 0,
+            header + self._payload[offset:offset + self.chunk_size]
+        )
+
+
+class _Reassembly:
+    """Estado de uma transferência em remontagem."""
+
+    __slots__ = ('message_type', 'flags', 'total', 'size', 'crc32', 'buffer',
+                 'received', 'count', 'cumulative', 'highest', 'since_ack', 'updated')
+
+    def __init__(self, message_type: int, flags: int, total: int, size: int,
+                 crc32: int, now: float):
+        self.message_type = message_type
+        self.flags = flags
+        self.total = total
+        self.size = size
+        self.crc32 = crc32
+        self.buffer = bytearray(size)
+        self.received = bytearray(total)
+        self.count = 0
+        self.cumulative = 0
+        self.highest = -1
+        self.since_ack = 0
+        self.updated = now
+
+
+class TransferReceiver:
+    """
+    Receptor de transferências fragmentadas de um link.
+
+    Cada transferência ganha um buffer do tamanho final no primeiro
+    fragmento recebido; os fragmentos são copiados direto para o seu
+    offset, em qualquer ordem. O número de transferências simultâneas e o
+    total pré-alocado são limitados: cada transferência nova primeiro
+    descarta as expiradas e, se ainda não couber, é recusada (o emissor
+    a retransmite após o timeout). ACKs são gerados a cada `ack_interval`
+    fragmentos novos, ao detectar um buraco, ao preencher um buraco, no
+    último fragmento e em fragmentos repetidos (ACK anterior perdido).
+    """
+
+    def __init__(self, ack_interval: Optional[int] = None,
+                 max_transfer_size: Optional[int] = None,
+                 timeout: Optional[float] = None,
+                 max_transfers: Optional[int] = None,
+                 max_buffered_bytes: Optional[int] = None):
+        """
+        Inicializa o receptor.
+
+        Args:
+            ack_interval: Fragmentos novos por ACK (padrão: 'transfer_ack_interval')
+            max_transfer_size: Maior payload aceito (padrão: 'max_transfer_size')
+            timeout: Segundos sem fragmentos até descartar uma transferência
+                incompleta (padrão: 'transfer_timeout')
+            max_transfers: Transferências em remontagem ao mesmo tempo
+                (padrão: 'max_concurrent_transfers')
+            max_buffered_bytes: Total pré-alocado para as remontagens
+                (padrão: 'max_reassembly_bytes')
+        """
+        self.ack_interval = max(1, ack_interval or COMMUNICATION_CONFIG['transfer_ack_interval'])
+        self.max_transfer_size = max_transfer_size or COMMUNICATION_CONFIG['max_transfer_size']
+        self.timeout = COMMUNICATION_CONFIG['transfer_timeout'] if timeout is None else timeout
+        self.max_transfers = max_transfers or COMMUNICATION_CONFIG['max_concurrent_transfers']
+        self.max_buffered_bytes = (max_buffered_bytes or
+                                   COMMUNICATION_CONFIG['max_reassembly_bytes'])
+
+        self._transfers: Dict[int, _Reassembly] = {}
+        self._buffered_bytes = 0
+        self._finished: 'OrderedDict[int, tuple]' = OrderedDict()
+        self._completed: List[Frame] = []
+
+        # Contadores
+        self.fragments_received = 0
+        self.duplicates = 0
+        self.transfers_completed = 0
+        self.transfers_failed = 0
+        self.transfers_rejected = 0
+        self.crc_failures = 0
+
+    def handle(self, frame: Frame, now: Optional[float] = None) -> Optional[bytes]:
+        """
+        Processa um frame recebido de FrameDecoder.
+
+        Args:
+            frame: Frame do link (apenas TRANSFER_FRAGMENT é considerado)
+            now: Instante atual (time.monotonic() se None)
+
+        Returns:
+            Mensagem TRANSFER_ACK (ou TRANSFER_NACK) a enviar ao emissor, ou None
+
+        Raises:
+            ProtocolError: Se o fragmento é inválido
+        """
+        if frame.message_type != MessageType.TRANSFER_FRAGMENT:
+            return None
+        return self.on_fragment(frame.payload, now)
+
+    def on_fragment(self, payload: Union[bytes, memoryview],
+                    now: Optional[float] = None) -> Optional[bytes]:
+        """
+        Processa o payload de um TRANSFER_FRAGMENT.
+
+        Args:
+            payload: Payload do fragmento
+            now: Instante atual (time.monotonic() se None)
+
+        Returns:
+            Mensagem TRANSFER_ACK (ou TRANSFER_NACK) a enviar ao emissor, ou None
+
+        Raises:
+            ProtocolError: Se o fragmento é inválido
+        """
+        now = time.monotonic() if now is None else now
+        if len(payload) < _FRAGMENT.size:
+            raise ProtocolError("Fragmento truncado")
+        (transfer_id, index, total, message_type, flags,
+         offset, size, crc32) = _FRAGMENT.unpack_from(payload, 0)
+        data = memoryview(payload)[_FRAGMENT.size:]
+        if index >= total or offset + len(data) > size:
+            raise ProtocolError(f"Fragmento {index}/{total} fora dos limites da transferência")
+        if size > self.max_transfer_size:
+            raise ProtocolError(f"Transferência grande demais: {size} bytes")
+        self.fragments_received += 1
+
+        finished = self._finished.get(transfer_id)
+        if finished is not None and finished == (total, size, crc32):
+            # ACK final perdido: reconfirma a transferência inteira
+            self.duplicates += 1
+            return self._ack_message(transfer_id, total, b'')
+
+        state = self._transfers.get(transfer_id)
+        if state is None or (state.total, state.size, state.crc32) != (total, size, crc32):
+            # Nova transferência (ou o emissor reiniciou com o mesmo ID)
+            if state is not None:
+                self._discard(transfer_id)
+            self._admit(size, now)
+            state = _Reassembly(message_type, flags, total, size, crc32, now)
+            self._transfers[transfer_id] = state
+            self._buffered_bytes += size
+            self._finished.pop(transfer_id, None)
+        state.updated = now
+
+        if state.received[index]:
+            self.duplicates += 1
+            return self._ack(transfer_id, state)
+
+        state.buffer[offset:offset + len(data)] = data
+        state.received[index] = 1
+        state.count += 1
+        state.since_ack += 1
+        new_hole = index > state.highest + 1
+        filled_hole = index < state.highest
+        if index > state.highest:
+            state.highest = index
+        while state.cumulative < total and state.received[state.cumulative]:
+            state.cumulative += 1
+
+        if state.count == total:
+            return self._finish(transfer_id, state)
+        if (new_hole or filled_hole or index == total - 1 or
+                state.since_ack >= self.ack_interval):
+            return self._ack(transfer_id, state)
+        return None
+
+    def pop_completed(self) -> List[Frame]:
+        """
+        Retorna e remove as mensagens remontadas.
+
+        Returns:
+            Frames com o tipo, as flags e o payload originais
+        """
+        completed, self._completed = self._completed, []
+        return completed
+
+    def expire(self, now: Optional[float] = None) -> int:
+        """
+        Descarta transferências incompletas sem fragmentos há `timeout` segundos.
+
+        Args:
+            now: Instante atual (time.monotonic() se None)
+
+        Returns:
+            Número de transferências descartadas
+        """
+        now = time.monotonic() if now is None else now
+        stale = [transfer_id for transfer_id, state in self._transfers.items()
+                 if now - state.updated >= self.timeout]
+        for transfer_id in stale:
+            self._discard(transfer_id)
+        self.transfers_failed += len(stale)
+        return len(stale)
+
+    def get_stats(self) -> Dict[str, int]:
+        """
+        Retorna contadores do receptor.
+
+        Returns:
+            Dicionário com contadores
+        """
+        return {
+            'fragments_received': self.fragments_received,
+            'duplicates': self.duplicates,
+            'transfers_completed': self.transfers_completed,
+            'transfers_failed': self.transfers_failed,
+            'transfers_rejected': self.transfers_rejected,
+            'crc_failures': self.crc_failures,
+            'active_transfers': len(self._transfers),
+            'buffered_bytes': self._buffered_bytes
+        }
+
+    def _admit(self, size: int, now: float) -> None:
+        """
+        Garante espaço para uma transferência nova, descartando as expiradas.
+
+        Raises:
+            ProtocolError: Se os limites continuam excedidos
+        """
+        self.expire(now)
+        if len(self._transfers) >= self.max_transfers:
+            self.transfers_rejected += 1
+            raise ProtocolError(f"Limite de {self.max_transfers} transferências simultâneas")
+        if self._buffered_bytes + size > self.max_buffered_bytes:
+            self.transfers_rejected += 1
+            raise ProtocolError(f"Sem espaço para remontar {size} bytes "
+                                f"({self._buffered_bytes} bytes em uso)")
+
+    def _discard(self, transfer_id: int) -> _Reassembly:
+        """Remove uma transferência em remontagem e libera seu buffer."""
+        state = self._transfers.pop(transfer_id)
+        self._buffered_bytes -= state.size
+        return state
+
+    def _finish(self, transfer_id: int, state: _Reassembly) -> Optional[bytes]:
+        self._discard(transfer_id)
+        if zlib.crc32(state.buffer) != state.crc32:
+            # Fragmentos já confirmados: só o NACK faz o emissor reenviá-los
+            self.transfers_failed += 1
+            self.crc_failures += 1
+            print(f"Erro na transferência {transfer_id}: CRC32 do payload remontado inválido")
+            return MessageProtocol.frame_payload(MessageType.TRANSFER_NACK, 0,
+                                                 _NACK.pack(transfer_id))
+
+        self._finished[transfer_id] = (state.total, state.size, state.crc32)
+        while len(self._finished) > _FINISHED_MEMORY:
+            self._finished.popitem(last=False)
+        self.transfers_completed += 1
+        payload = memoryview(state.buffer)
+        self._completed.append(Frame(state.message_type, state.flags,
+                                     binascii.crc_hqx(payload, 0xFFFF), payload))
+        return self._ack_message(transfer_id, state.total, b'')
+
+    def _ack(self, transfer_id: int, state: _Reassembly) -> bytes:
+        state.since_ack = 0
+        start = state.cumulative
+        span = min(state.highest - start + 1, 8 * MAX_BITMAP_BYTES)
+        bitmap = bytearray((span + 7) // 8 if span > 0 else 0)
+        received = state.received
+        for offset in range(span):
+            if received[start + offset]:
+                bitmap[offset >> 3] |= 1 << (offset & 7)
+        return self._ack_message(transfer_id, start, bytes(bitmap))
+
+    @staticmethod
+    def _ack_message(transfer_id: int, cumulative: int, bitmap: bytes) -> bytes:
+        return MessageProtocol.frame_payload(
+            MessageType.TRANSFER_ACK, 0, _ACK.pack(transfer_id, cumulative, len(bitmap)) + bitmap
+        )
@@ -4,6 +4,7 @@ from .models import (
     SensorStatus,
     CommunicationProtocol,
     StrainReading,
+    StrainBatch,
     SensorConfiguration,
     SensorInfo,
     DataPacket
@@ -24,6 +25,7 @@ __all__ = [
     'SensorStatus',
     'CommunicationProtocol', 
     'StrainReading',
+    'StrainBatch',
     'SensorConfiguration',
     'SensorInfo',
     'DataPacket',
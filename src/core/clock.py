@@ -0,0 +1,198 @@
+"""
+Relógios injetáveis para os simuladores.
+
+Os simuladores (HX711, ESP32, BLE e DAQSystemSimulator) leem o tempo e
+esperam sempre por um Clock, nunca direto por time.time()/asyncio.sleep:
+
+- WallClock: tempo real, opcionalmente acelerado (simulation_speed). As
+  esperas são asyncio.sleep(segundos / speed); time() e now() continuam
+  sendo o relógio de parede, de modo que os timestamps das leituras nunca
+  ficam no futuro. Só simulated_time(), usado para durações físicas
+  (descarga da bateria, deriva, forma de onda da carga), avança speed
+  vezes mais rápido.
+- VirtualClock: eventos discretos. Roda as corrotinas em um
+  VirtualTimeEventLoop, em que o tempo só avança quando nenhuma task está
+  pronta: o loop salta direto para o próximo timer em vez de dormir. A
+  simulação roda tão rápido quanto a CPU permite, sem depender da
+  granularidade do sleep, e a ordem dos eventos é a mesma a cada execução
+  (com a mesma semente, a saída é idêntica).
+
+Uso em testes de longa duração:
+
+    clock = VirtualClock()
+    simulator = DAQSystemSimulator(SimulatorConfig(seed=7), clock=clock)
+    clock.run(simulator.run_for(24 * 3600))
+"""
+
+import asyncio
+import selectors
+import time
+from datetime import datetime
+from typing import Any, Awaitable
+
+
+# 2024-01-01T00:00:00Z: instante inicial padrão do relógio virtual
+VIRTUAL_EPOCH = 1704067200.0
+
+
+class Clock:
+    """Interface de relógio: tempo atual e espera."""
+
+    def time(self) -> float:
+        """Tempo atual em segundos desde a época Unix."""
+        raise NotImplementedError
+
+    def now(self) -> datetime:
+        """Tempo atual como datetime local."""
+        return datetime.fromtimestamp(self.time())
+
+    def simulated_time(self) -> float:
+        """
+        Tempo da simulação em segundos, para durações físicas.
+
+        Não deve ser usado como timestamp: em WallClock acelerado ele se
+        afasta do relógio de parede.
+        """
+        return self.time()
+
+    async def sleep(self, seconds: float) -> None:
+        """Espera o intervalo de tempo simulado."""
+        raise NotImplementedError
+
+
+class WallClock(Clock):
+    """Relógio de parede; speed acelera as esperas e simulated_time()."""
+
+    def __init__(self, speed: float = 1.0):
+        """
+        Inicializa o relógio.
+
+        Args:
+            speed: Multiplicador de velocidade da simulação
+        """
+        if speed <= 0:
+            raise ValueError("Velocidade da simulação deve ser positiva")
+        self.speed = speed
+        self._origin = time.time()
+
+    def time(self) -> float:
+        return time.time()
+
+    def simulated_time(self) -> float:
+        if self.speed == 1.0:
+            return time.time()
+        return self._origin + (time.time() - self._origin) * self.speed
+
+    async def sleep(self, seconds: float) -> None:
+        await asyncio.sleep(seconds / self.speed)
+
+
+class _VirtualSelector(selectors.BaseSelector):
+    """
+    Seletor que avança o tempo virtual em vez de bloquear.
+
+    Quando o loop espera por um timer (timeout > 0) e não há I/O pronto,
+    o tempo virtual salta o timeout inteiro e o timer vence na hora.
+    """
+
+    def __init__(self, loop: 'VirtualTimeEventLoop'):
+        self._selector = selectors.DefaultSelector()
+        self._loop = loop
+
+    def register(self, fileobj, events, data=None):
+        return self._selector.register(fileobj, events, data)
+
+    def unregister(self, fileobj):
+        return self._selector.unregister(fileobj)
+
+    def modify(self, fileobj, events, data=None):
+        return self._selector.modify(fileobj, events, data)
+
+    def select(self, timeout=None):
+        if timeout is None or timeout <= 0:
+            # Sem timers: só I/O real (ex.: call_soon_threadsafe) acorda o loop
+            return self._selector.select(timeout)
+        events = self._selector.select(0)
+        if not events:
+            self._loop.advance(timeout)
+        return events
+
+    def get_map(self):
+        return self._selector.get_map()
+
+    def close(self):
+        self._selector.close()
+
+
+class VirtualTimeEventLoop(asyncio.SelectorEventLoop):
+    """Event loop asyncio com tempo virtual (ver _VirtualSelector)."""
+
+    def __init__(self):
+        self._virtual_time = 0.0
+        super().__init__(_VirtualSelector(self))
+
+    def time(self) -> float:
+        return self._virtual_time
+
+    def advance(self, seconds: float) -> None:
+        """Avança o tempo virtual."""
+        self._virtual_time += seconds
+
+
+class VirtualClock(Clock):
+    """
+    Relógio de eventos discretos.
+
+    As esperas só podem ocorrer dentro de run(), que executa a corrotina
+    principal no VirtualTimeEventLoop do relógio.
+    """
+
+    def __init__(self, start: float = VIRTUAL_EPOCH):
+        """
+        Inicializa o relógio.
+
+        Args:
+            start: Instante inicial (segundos desde a época Unix)
+        """
+        self.start = start
+        self.loop = VirtualTimeEventLoop()
+
+    @property
+    def elapsed(self) -> float:
+        """Segundos virtuais desde o início."""
+        return self.loop.time()
+
+    def time(self) -> float:
+        return self.start + self.loop.time()
+
+    async def sleep(self, seconds: float) -> None:
+        await asyncio.sleep(seconds)
+
+    def run(self, main: Awaitable[Any]) -> Any:
+        """
+        Executa uma corrotina em tempo virtual até terminar.
+
+        Como asyncio.run: ao final as tasks pendentes são canceladas e o
+        loop é fechado, de modo que cada relógio executa uma única vez.
+
+        Args:
+            main: Corrotina principal
+
+        Returns:
+            Resultado da corrotina
+        """
+        loop = self.loop
+        asyncio.set_event_loop(loop)
+        try:
+            return loop.run_until_complete(main)
+        finally:
+            try:
+                pending = asyncio.all_tasks(loop)
+                for task in pending:
+                    task.cancel()
+                if pending:
+                    loop.run_until_complete(asyncio.gather(*pending, return_exceptions=True))
+                loop.run_until_complete(loop.shutdown_asyncgens())
+            finally:
+                asyncio.set_event_loop(None)
+                loop.close()
@@ -36,9 +36,27 @@ class SystemConfig:
     
     # Armazenamento e buffer
     MAX_BUFFER_SIZE: int = 10000  # número máximo de leituras em buffer
-    BUFFER_FLUSH_INTERVAL: int = 60  # segundos
     DATA_RETENTION_DAYS: int = 30  # dias para manter dados
     
+    # Persistência em segundo plano (write-behind)
+    PERSIST_BATCH_SIZE: int = 1000  # leituras por transação
+    PERSIST_MAX_LATENCY: float = 1.0  # segundos até a leitura ser gravada
+    PERSIST_QUEUE_SIZE: int = 16  # lotes aguardando gravação
+    PERSIST_BACKPRESSURE: str = "block"  # block, drop_oldest ou spill
+    PERSIST_SPILL_DIR: str = "spill"  # subdiretório de data/ para spill
+    
+    # Ingestão em múltiplos processos (ver data.shards)
+    INGEST_SHARDS: int = 0  # workers de ingestão (0 = no processo principal)
+    SHARD_SEND_CHUNKS: int = 64  # blocos acumulados por envio a um worker
+    
+    # Partida rápida (ver data.snapshot)
+    WARM_START: bool = True  # restaura as janelas do osciloscópio ao iniciar
+    WARM_START_MAX_AGE: float = 3600.0  # segundos; dados mais antigos não são restaurados
+    
+    # Captura bruta (.daqcap)
+    CAPTURE_SEGMENT_RECORDS: int = 4096  # registros por segmento de sensor
+    CAPTURE_INDEX_INTERVAL: int = 1024  # registros entre entradas do índice
+    
     # Interface de usuário
     GUI_UPDATE_INTERVAL: int = 100  # milissegundos
     PLOT_MAX_POINTS: int = 1000  # pontos máximos no gráfico em tempo real
@@ -72,6 +90,11 @@ class SystemConfig:
     OSCILLOSCOPE_UPDATE_RATE: float = 50.0  # Hz
     STREAMING_BUFFER_SIZE: int = 100  # pontos por update
     WEBSOCKET_HEARTBEAT: int = 30  # segundos
+    WEBSOCKET_PORT: int = 8765  # servidor de streaming do osciloscópio
+    
+    # Métricas e instrumentação
+    METRICS_PORT: int = 9108  # endpoint HTTP /metrics (Prometheus)
+    METRICS_SAMPLE_EVERY: int = 16  # temporizadores medem 1 a cada N chamadas
 
 
 # Instância global da configuração
@@ -104,6 +127,10 @@ EXPORT_CONFIG = {
     'json': {
         'indent': 2,
         'ensure_ascii': False
+    },
+    'parquet': {
+        'compression': 'zstd',
+        'row_group_size': 131072  # leituras por row group
     }
 }
 
@@ -111,9 +138,20 @@ EXPORT_CONFIG = {
 COMMUNICATION_CONFIG = {
     'retry_attempts': 3,
     'retry_delay': 1.0,  # segundos
+    'reconnect_max_delay': 60.0,  # teto do backoff de reconexão (segundos)
     'connection_keepalive': 30,  # segundos
     'packet_timeout': 5.0,  # segundos
-    'max_packet_size': 512  # bytes
+    'max_packet_size': 512,  # bytes
+    'transfer_window': 64,  # fragmentos em trânsito por transferência
+    'transfer_ack_interval': 8,  # fragmentos recebidos por ACK
+    'max_transfer_size': 4 * 1024 * 1024,  # bytes por transferência
+    'transfer_timeout': 60.0,  # segundos sem fragmentos até descartar
+    'transfer_max_restarts': 3,  # reinícios por NACK (CRC32 inválido) antes de falhar
+    'max_concurrent_transfers': 8,  # transferências em remontagem por link
+    'max_reassembly_bytes': 16 * 1024 * 1024,  # bytes pré-alocados por link
+    'link_queue_bytes': 256 * 1024,  # fila de recepção por link
+    'ingest_quantum_bytes': 4096,  # crédito por link por rodada do escalonador
+    'ingest_batch_readings': 8192  # leituras acumuladas que forçam entrega
 }
 
 # Configurações específicas do osciloscópio
@@ -141,11 +179,56 @@ OSCILLOSCOPE_CONFIG = {
     }
 }
 
+# Análise de fadiga em tempo real (ver data.fatigue)
+FATIGUE_CONFIG = {
+    'enabled': False,  # inicia a análise em todos os sensores com o DataManager
+    'modulus_mpa': 210000.0,  # módulo de elasticidade (aço) para µε -> MPa
+    'sn_curve': 'fat90',
+    # Curvas S-N (faixa de tensão em MPa): N = reference_cycles * (reference_range / S)^m,
+    # com inclinação m2 abaixo do joelho e sem dano abaixo de cutoff_range
+    'sn_curves': {
+        'fat90': {'reference_range': 90.0, 'm': 3.0, 'reference_cycles': 2e6,
+                  'knee_cycles': 5e6, 'm2': 5.0, 'cutoff_cycles': 1e8},
+        'fat71': {'reference_range': 71.0, 'm': 3.0, 'reference_cycles': 2e6,
+                  'knee_cycles': 5e6, 'm2': 5.0, 'cutoff_cycles': 1e8},
+        'fat160': {'reference_range': 160.0, 'm': 5.0, 'reference_cycles': 2e6,
+                   'knee_cycles': 5e6, 'm2': 9.0, 'cutoff_cycles': 1e8}
+    },
+    'rainflow_gate': 2.0,  # µε: reversões menores são tratadas como ruído
+    'range_bin': 10.0,  # µε por classe do histograma rainflow
+    'psd_segment': 256,  # amostras por segmento (potência de 2)
+    'psd_overlap': 0.5,  # sobreposição entre segmentos
+    'psd_averages': 32  # segmentos na média exponencial (0 = média acumulada)
+}
+
+# Alarmes avaliados na ingestão (ver data.alarms.AlarmRule)
+ALARM_CONFIG = {
+    'enabled': False,  # inicia o motor de alarmes com o DataManager
+    'history_size': 1000,  # eventos mantidos para consulta
+    'rules': [
+        {'name': 'strain_overload', 'field': 'strain', 'direction': 'outside',
+         'limit': 2000.0, 'clear': 1800.0, 'severity': 'critical'},
+        # Picos repetidos: 5 amostras com |ε| > 1500 µε em 1 s
+        {'name': 'strain_repeated_peaks', 'field': 'strain', 'kind': 'count',
+         'direction': 'outside', 'limit': 1500.0, 'count': 5, 'window_ms': 1000.0},
+        # Impacto: variação acima de 100000 µε/s entre amostras
+        {'name': 'strain_impact', 'field': 'strain', 'kind': 'rate',
+         'direction': 'outside', 'limit': 100000.0, 'clear': 50000.0},
+        {'name': 'low_battery', 'field': 'battery', 'direction': 'below',
+         'limit': config.MIN_BATTERY_LEVEL, 'clear': config.MIN_BATTERY_LEVEL + 5},
+        {'name': 'high_temperature', 'field': 'temperature', 'direction': 'above',
+         'limit': config.MAX_TEMPERATURE, 'clear': config.MAX_TEMPERATURE - 5.0},
+        {'name': 'low_temperature', 'field': 'temperature', 'direction': 'below',
+         'limit': config.MIN_TEMPERATURE, 'clear': config.MIN_TEMPERATURE + 5.0}
+    ]
+}
+
 # Configurações de streaming
 STREAMING_CONFIG = {
     'websocket': {
         'heartbeat_interval': 30,
-        'max_clients': 10,
+        'max_clients': 200,  # inclui conexões ainda em handshake
+        'handshake_timeout': 5.0,  # segundos para concluir o upgrade HTTP
         'buffer_size': 100,
         'compression': True
     },
@@ -0,0 +1,506 @@
+"""
+Instrumentação de baixo custo e registro de métricas do sistema DAQ.
+
+Tipos de métrica:
+- Counter: contador monotônico
+- Gauge: valor instantâneo, definido diretamente ou lido de uma função na coleta
+- Histogram: distribuição em buckets fixos
+
+Contadores e histogramas mantêm uma célula por thread: cada thread só
+escreve na própria célula, sem lock, e a coleta soma as células.
+Temporizadores dos caminhos quentes são amostrados (uma medição a cada N
+chamadas); nas demais chamadas o custo é um único next() em um contador.
+
+Valores que já existem como atributos de objetos (contadores do
+FrameDecoder, ocupação do buffer, fila do writer) são expostos por
+coletores, chamados apenas no momento da coleta.
+
+O registro global `metrics` é exposto em formato texto do Prometheus
+(0.0.4) por MetricsHTTPServer em /metrics e como JSON em /metrics.json.
+"""
+
+import asyncio
+import itertools
+import json
+import os
+import sys
+import threading
+import time
+import weakref
+from bisect import bisect_left
+from typing import Any, Callable, Dict, Iterable, List, Optional, Sequence, Tuple
+
+
+COUNTER = 'counter'
+GAUGE = 'gauge'
+HISTOGRAM = 'histogram'
+
+# Buckets padrão de latência (segundos)
+LATENCY_BUCKETS = (0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005,
+                   0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0)
+
+# Amostra coletada: (nome, rótulos, valor)
+Sample = Tuple[str, Dict[str, str], float]
+
+
+class _PerThread:
+    """Células por thread; a coleta percorre todas."""
+
+    def __init__(self, factory: Callable[[], list]):
+        self._factory = factory
+        self._local = threading.local()
+        self._cells: List[list] = []
+        self._lock = threading.Lock()
+
+    def cell(self) -> list:
+        try:
+            return self._local.cell
+        except AttributeError:
+            cell = self._factory()
+            with self._lock:
+                self._cells.append(cell)
+            self._local.cell = cell
+            return cell
+
+    def cells(self) -> List[list]:
+        with self._lock:
+            return list(self._cells)
+
+
+class _CounterChild:
+    def __init__(self):
+        self._cells = _PerThread(lambda: [0.0])
+
+    def inc(self, amount: float = 1.0) -> None:
+        """Incrementa o contador (amount >= 0)."""
+        self._cells.cell()[0] += amount
+
+    def value(self) -> float:
+        return sum(cell[0] for cell in self._cells.cells())
+
+
+class _GaugeChild:
+    def __init__(self):
+        self._value = 0.0
+        self._function: Optional[Callable[[], Optional[float]]] = None
+
+    def set(self, value: float) -> None:
+        """Define o valor."""
+        self._value = value
+
+    def inc(self, amount: float = 1.0) -> None:
+        self._value += amount
+
+    def dec(self, amount: float = 1.0) -> None:
+        self._value -= amount
+
+    def set_function(self, function: Callable[[], Optional[float]]) -> None:
+        """Lê o valor de function() no momento da coleta (None = omitido)."""
+        self._function = function
+
+    def value(self) -> Optional[float]:
+        if self._function is not None:
+            return self._function()
+        return self._value
+
+
+class SampledTimer:
+    """
+    Temporizador amostrado de um histograma.
+
+    Uso no caminho quente:
+        started = TIMER.start()
+        ...
+        TIMER.stop(started)
+
+    start() retorna None em (every - 1) de cada `every` chamadas, e
+    stop(None) não faz nada.
+    """
+
+    def __init__(self, histogram: '_HistogramChild', every: int):
+        self.histogram = histogram
+        self._observe = histogram.observe
+        self.every = max(1, int(every))
+        self._calls = itertools.count()
+
+    def start(self) -> Optional[float]:
+        """Inicia a medição se esta chamada for amostrada."""
+        if next(self._calls) % self.every:
+            return None
+        return time.perf_counter()
+
+    def stop(self, started: Optional[float]) -> None:
+        """Registra a duração desde start() (se amostrada)."""
+        if started is not None:
+            self._observe(time.perf_counter() - started)
+
+
+class _HistogramChild:
+    def __init__(self, bounds: Tuple[float, ...]):
+        self._bounds = bounds
+        size = len(bounds) + 1
+        # Célula: contagens por bucket (+Inf no final) e soma
+        self._cells = _PerThread(lambda: [[0] * size, 0.0])
+
+    def observe(self, value: float) -> None:
+        """Registra uma observação."""
+        cell = self._cells.cell()
+        cell[0][bisect_left(self._bounds, value)] += 1
+        cell[1] += value
+
+    def sampled(self, every: int) -> SampledTimer:
+        """Temporizador que mede uma a cada `every` chamadas."""
+        return SampledTimer(self, every)
+
+    def snapshot(self) -> Tuple[List[int], float]:
+        """Contagens cumulativas por bucket (le) e soma."""
+        counts = [0] * (len(self._bounds) + 1)
+        total = 0.0
+        for buckets, value_sum in self._cells.cells():
+            for index, count in enumerate(buckets):
+                counts[index] += count
+            total += value_sum
+        return list(itertools.accumulate(counts)), total
+
+    def quantile(self, fraction: float) -> Optional[float]:
+        """Estimativa do quantil pelo limite superior do bucket."""
+        cumulative, _ = self.snapshot()
+        if not cumulative or cumulative[-1] == 0:
+            return None
+        rank = fraction * cumulative[-1]
+        index = bisect_left(cumulative, rank)
+        return self._bounds[index] if index < len(self._bounds) else float('inf')
+
+
+class Metric:
+    """
+    Família de métricas com rótulos opcionais.
+
+    Sem rótulos, os métodos do valor único (inc, set, observe...) ficam
+    disponíveis diretamente na família.
+    """
+
+    def __init__(self, kind: str, name: str, documentation: str,
+                 labelnames: Sequence[str] = (), buckets: Sequence[float] = LATENCY_BUCKETS):
+        self.kind = kind
+        self.name = name
+        self.documentation = documentation
+        self.labelnames = tuple(labelnames)
+        self.buckets = tuple(sorted(buckets))
+        self._children: Dict[Tuple[str, ...], Any] = {}
+        self._lock = threading.Lock()
+
+        if not self.labelnames:
+            child = self.labels()
+            for attribute in ('inc', 'dec', 'set', 'set_function', 'observe',
+                              'sampled', 'value', 'snapshot', 'quantile'):
+                if hasattr(child, attribute):
+                    setattr(self, attribute, getattr(child, attribute))
+
+    def _new_child(self):
+        if self.kind == COUNTER:
+            return _CounterChild()
+        if self.kind == GAUGE:
+            return _GaugeChild()
+        return _HistogramChild(self.buckets)
+
+    def labels(self, *values: str, **named: str):
+        """
+        Retorna a série com os valores de rótulo informados.
+
+        Args:
+            *values: Valores na ordem de labelnames
+            **named: Valores por nome
+
+        Returns:
+            Série (criada na primeira chamada)
+        """
+        if named:
+            values = tuple(str(named[name]) for name in self.labelnames)
+        else:
+            values = tuple(str(value) for value in values)
+        if len(values) != len(self.labelnames):
+            raise ValueError(f"Métrica {self.name} espera rótulos {self.labelnames}")
+        child = self._children.get(values)
+        if child is None:
+            with self._lock:
+                child = self._children.setdefault(values, self._new_child())
+        return child
+
+    def samples(self) -> List[Sample]:
+        """Amostras no formato de exposição."""
+        with self._lock:
+            children = list(self._children.items())
+        samples: List[Sample] = []
+        for values, child in children:
+            labels = dict(zip(self.labelnames, values))
+            if self.kind == HISTOGRAM:
+                cumulative, total = child.snapshot()
+                for bound, count in zip(self.buckets + (float('inf'),), cumulative):
+                    samples.append((self.name + '_bucket', {**labels, 'le': _format_value(bound)}, count))
+                samples.append((self.name + '_sum', labels, total))
+                samples.append((self.name + '_count', labels, cumulative[-1]))
+            else:
+                value = child.value()
+                if value is not None:
+                    samples.append((self.name, labels, value))
+        return samples
+
+
+class MetricsRegistry:
+    """Registro de métricas e coletores."""
+
+    def __init__(self):
+        self._metrics: Dict[str, Metric] = {}
+        self._collectors: List[Tuple[Callable, Optional[weakref.ref]]] = []
+        self._lock = threading.Lock()
+
+    def _get_or_create(self, kind: str, name: str, documentation: str,
+                       labelnames: Sequence[str], **kwargs) -> Metric:
+        with self._lock:
+            metric = self._metrics.get(name)
+            if metric is None:
+                metric = Metric(kind, name, documentation, labelnames, **kwargs)
+                self._metrics[name] = metric
+            elif metric.kind != kind or metric.labelnames != tuple(labelnames):
+                raise ValueError(f"Métrica {name} já registrada com outro tipo ou rótulos")
+            return metric
+
+    def counter(self, name: str, documentation: str, labelnames: Sequence[str] = ()) -> Metric:
+        """Registra (ou retorna) um contador."""
+        return self._get_or_create(COUNTER, name, documentation, labelnames)
+
+    def gauge(self, name: str, documentation: str, labelnames: Sequence[str] = ()) -> Metric:
+        """Registra (ou retorna) um gauge."""
+        return self._get_or_create(GAUGE, name, documentation, labelnames)
+
+    def histogram(self, name: str, documentation: str, labelnames: Sequence[str] = (),
+                  buckets: Sequence[float] = LATENCY_BUCKETS) -> Metric:
+        """Registra (ou retorna) um histograma."""
+        return self._get_or_create(HISTOGRAM, name, documentation, labelnames, buckets=buckets)
+
+    def register_collector(self, collector: Callable, owner: Any = None) -> None:
+        """
+        Registra um coletor chamado a cada coleta.
+
+        O coletor retorna tuplas (nome, tipo, documentação, rótulos, valor).
+        Com owner, é chamado como collector(owner) e removido quando o
+        owner deixa de existir (referência fraca).
+
+        Args:
+            collector: Função coletora
+            owner: Objeto dono dos valores coletados
+        """
+        ref = weakref.ref(owner) if owner is not None else None
+        with self._lock:
+            self._collectors.append((collector, ref))
+
+    def collect(self) -> List[Dict[str, Any]]:
+        """
+        Coleta todas as métricas.
+
+        Séries repetidas vindas de coletores (ex.: dois decoders do mesmo
+        link) são somadas nos contadores; nos gauges vale a última.
+
+        Returns:
+            Famílias com 'name', 'type', 'help' e 'samples'
+        """
+        with self._lock:
+            metrics = list(self._metrics.values())
+            collectors = list(self._collectors)
+
+        families: Dict[str, Dict[str, Any]] = {}
+        for metric in metrics:
+            families[metric.name] = {
+                'name': metric.name, 'type': metric.kind,
+                'help': metric.documentation, 'samples': metric.samples()
+            }
+
+        collected: Dict[str, Dict[Tuple, List]] = {}
+        alive = []
+        for collector, ref in collectors:
+            if ref is not None:
+                owner = ref()
+                if owner is None:
+                    continue
+                rows = self._run_collector(collector, owner)
+            else:
+                rows = self._run_collector(collector)
+            alive.append((collector, ref))
+            for name, kind, documentation, labels, value in rows:
+                if value is None:
+                    continue
+                family = families.setdefault(name, {
+                    'name': name, 'type': kind, 'help': documentation, 'samples': []
+                })
+                series = collected.setdefault(name, {})
+                key = tuple(sorted(labels.items()))
+                if key in series and kind == COUNTER:
+                    series[key][2] += value
+                elif key in series:
+                    series[key][2] = value
+                else:
+                    series[key] = [name, dict(labels), value]
+                    family['samples'].append(series[key])
+
+        if len(alive) != len(collectors):
+            with self._lock:
+                self._collectors = [entry for entry in self._collectors
+                                    if entry[1] is None or entry[1]() is not None]
+
+        return [{**family, 'samples': [tuple(sample) for sample in family['samples']]}
+                for family in families.values()]
+
+    @staticmethod
+    def _run_collector(collector: Callable, *args) -> Iterable:
+        try:
+            return list(collector(*args))
+        except Exception as e:
+            print(f"Erro no coletor de métricas: {e}")
+            return []
+
+    def snapshot(self) -> Dict[str, Any]:
+        """
+        Valores atuais em formato JSON.
+
+        Returns:
+            {nome: [{'labels': {...}, 'value': v}, ...]}
+        """
+        return {
+            family['name']: [{'labels': labels, 'value': value}
+                             for _, labels, value in family['samples']]
+            for family in self.collect()
+        }
+
+    def render(self) -> str:
+        """
+        Exposição em formato texto do Prometheus (0.0.4).
+
+        Returns:
+            Texto com HELP, TYPE e amostras de cada família
+        """
+        lines = []
+        for family in self.collect():
+            lines.append(f"# HELP {family['name']} {_escape_help(family['help'])}")
+            lines.append(f"# TYPE {family['name']} {family['type']}")
+            for name, labels, value in family['samples']:
+                if labels:
+                    rendered = ','.join(f'{key}="{_escape_label(str(val))}"'
+                                        for key, val in labels.items())
+                    lines.append(f"{name}{{{rendered}}} {_format_value(value)}")
+                else:
+                    lines.append(f"{name} {_format_value(value)}")
+        return '\n'.join(lines) + '\n'
+
+
+def _format_value(value: float) -> str:
+    if value == float('inf'):
+        return '+Inf'
+    if isinstance(value, int) or float(value).is_integer():
+        return str(int(value))
+    return repr(float(value))
+
+
+def _escape_help(text: str) -> str:
+    return text.replace('\\', '\\\\').replace('\n', '\\n')
+
+
+def _escape_label(text: str) -> str:
+    return text.replace('\\', '\\\\').replace('\n', '\\n').replace('"', '\\"')
+
+
+def process_resident_bytes() -> Optional[float]:
+    """
+    RSS atual do processo.
+
+    Returns:
+        Bytes residentes (/proc no Linux; pico de RSS via resource nos
+        demais sistemas) ou None se indisponível
+    """
+    try:
+        with open('/proc/self/statm', 'r') as f:
+            return int(f.read().split()[1]) * os.sysconf('SC_PAGE_SIZE')
+    except (OSError, ValueError, IndexError, AttributeError):
+        pass
+    try:
+        import resource
+        peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+        return peak if sys.platform == 'darwin' else peak * 1024
+    except (ImportError, OSError):
+        return None
+
+
+# Registro global
+metrics = MetricsRegistry()
+
+metrics.gauge('process_resident_memory_bytes',
+              'Memória residente do processo (bytes)').set_function(process_resident_bytes)
+
+
+class MetricsHTTPServer:
+    """
+    Endpoint HTTP de scrape das métricas (asyncio).
+
+    GET /metrics      -> formato texto do Prometheus
+    GET /metrics.json -> snapshot JSON
+    """
+
+    CONTENT_TYPE = 'text/plain; version=0.0.4; charset=utf-8'
+
+    def __init__(self, registry: Optional[MetricsRegistry] = None,
+                 host: str = '0.0.0.0', port: int = 9108):
+        """
+        Inicializa o servidor.
+
+        Args:
+            registry: Registro exposto (padrão: global)
+            host: Endereço de escuta
+            port: Porta TCP (0 = escolhida pelo sistema)
+        """
+        self.registry = registry or metrics
+        self.host = host
+        self.port = port
+        self._server: Optional[asyncio.AbstractServer] = None
+        self.scrapes = 0
+
+    async def start(self) -> None:
+        """Inicia a escuta."""
+        self._server = await asyncio.start_server(self._handle, self.host, self.port)
+        self.port = self._server.sockets[0].getsockname()[1]
+
+    async def stop(self) -> None:
+        """Encerra o servidor."""
+        if self._server is not None:
+            self._server.close()
+            await self._server.wait_closed()
+            self._server = None
+
+    async def _handle(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter) -> None:
+        try:
+            request = await asyncio.wait_for(reader.readuntil(b'\r\n\r\n'), timeout=5)
+            method, path = request.split(b'\r\n', 1)[0].decode('latin-1').split(' ')[:2]
+            path = path.split('?', 1)[0]
+
+            if method not in ('GET', 'HEAD'):
+                status, content_type, body = '405 Method Not Allowed', 'text/plain', b'metodo nao suportado\n'
+            elif path == '/metrics':
+                self.scrapes += 1
+                status, content_type = '200 OK', self.CONTENT_TYPE
+                body = self.registry.render().encode('utf-8')
+            elif path == '/metrics.json':
+                self.scrapes += 1
+                status, content_type = '200 OK', 'application/json'
+                body = json.dumps(self.registry.snapshot()).encode('utf-8')
+            else:
+                status, content_type, body = '404 Not Found', 'text/plain', b'nao encontrado\n'
+
+            header = (f"HTTP/1.1 {status}\r\nContent-Type: {content_type}\r\n"
+                      f"Content-Length: {len(body)}\r\nConnection: close\r\n\r\n")
+            writer.write(header.encode('latin-1') + (body if method != 'HEAD' else b''))
+            await writer.drain()
+        except (asyncio.TimeoutError, asyncio.IncompleteReadError, ValueError, ConnectionError):
+            pass
+        except Exception as e:
+            print(f"Erro no endpoint de métricas: {e}")
+        finally:
+            writer.close()
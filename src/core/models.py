@@ -3,11 +3,24 @@ Modelos de dados para o sistema DAQ.
 Define as estruturas de dados utilizadas em todo o sistema.
 """
 
+from array import array
 from dataclasses import dataclass, field
 from datetime import datetime
-from typing import Optional, Dict, Any
+from typing import Optional, Dict, Any, Iterator, List, Sequence, Tuple, Union
 from enum import Enum
+import struct
 import uuid
+import zlib
+
+
+def datetime_to_us(value: datetime) -> int:
+    """Converte datetime para microssegundos desde epoch."""
+    return round(value.timestamp() * 1_000_000)
+
+
+def us_to_datetime(value: int) -> datetime:
+    """Converte microssegundos desde epoch para datetime local."""
+    return datetime.fromtimestamp(value / 1_000_000)
 
 
 class SensorStatus(Enum):
@@ -25,37 +38,87 @@ class CommunicationProtocol(Enum):
     WIFI = "wifi"
 
 
-@dataclass
 class StrainReading:
     """
     Representa uma leitura de deformação do strain gauge.
     
+    Classe com __slots__ (sem __dict__ por instância) e timestamp inteiro em
+    µs desde epoch: criar uma leitura no caminho de ingestão não formata
+    strings nem aloca datetime. O checksum é calculado sob demanda, no
+    primeiro acesso, e fica fixo a partir daí.
+    
     Attributes:
-        timestamp: Momento da leitura
+        timestamp: Momento da leitura (datetime derivado de timestamp_us)
+        timestamp_us: Momento da leitura em µs desde epoch
         strain_value: Valor da deformação em microstrains (µε)
         raw_adc_value: Valor bruto do ADC (HX711)
         sensor_id: Identificador único do sensor
         battery_level: Nível da bateria (0-100%)
         temperature: Temperatura do sensor (°C)
-        checksum: Verificação de integridade dos dados
+        checksum: Verificação de integridade dos dados (CRC32 em hexadecimal)
     """
-    timestamp: datetime
-    strain_value: float  # microstrains (µε)
-    raw_adc_value: int
-    sensor_id: str
-    battery_level: int  # 0-100%
-    temperature: float  # °C
-    checksum: Optional[str] = None
     
-    def __post_init__(self):
-        """Calcula checksum se não fornecido."""
-        if self.checksum is None:
-            self.checksum = self._calculate_checksum()
+    __slots__ = ('timestamp_us', 'strain_value', 'raw_adc_value', 'sensor_id',
+                 'battery_level', 'temperature', '_checksum')
+    
+    # Campos cobertos pelo checksum: timestamp_us, strain, ADC, bateria
+    _CHECKSUM_STRUCT = struct.Struct('<qdqq')
+    
+    def __init__(self, timestamp: Union[datetime, int], strain_value: float,
+                 raw_adc_value: int, sensor_id: str, battery_level: int,
+                 temperature: float, checksum: Optional[str] = None):
+        """
+        Inicializa a leitura.
+        
+        Args:
+            timestamp: datetime ou µs desde epoch (int)
+            strain_value: Deformação em µε
+            raw_adc_value: Valor bruto do ADC
+            sensor_id: Identificador do sensor
+            battery_level: Nível da bateria (0-100%)
+            temperature: Temperatura (°C)
+            checksum: Checksum recebido (None = calculado no primeiro acesso)
+        """
+        self.timestamp_us = timestamp if type(timestamp) is int else datetime_to_us(timestamp)
+        self.strain_value = strain_value
+        self.raw_adc_value = raw_adc_value
+        self.sensor_id = sensor_id
+        self.battery_level = battery_level
+        self.temperature = temperature
+        self._checksum = checksum
+    
+    @property
+    def timestamp(self) -> datetime:
+        """Momento da leitura como datetime local."""
+        return us_to_datetime(self.timestamp_us)
+    
+    @timestamp.setter
+    def timestamp(self, value: Union[datetime, int]) -> None:
+        self.timestamp_us = value if type(value) is int else datetime_to_us(value)
+    
+    @property
+    def checksum(self) -> str:
+        """Checksum da leitura (calculado e fixado no primeiro acesso)."""
+        if self._checksum is None:
+            self._checksum = self._calculate_checksum()
+        return self._checksum
+    
+    @checksum.setter
+    def checksum(self, value: Optional[str]) -> None:
+        self._checksum = value
     
     def _calculate_checksum(self) -> str:
-        """Calcula checksum simples para verificação de integridade."""
-        data_str = f"{self.timestamp.isoformat()}{self.strain_value}{self.raw_adc_value}{self.battery_level}"
-        return str(hash(data_str))
+        """
+        Calcula checksum determinístico para verificação de integridade.
+        
+        CRC32 sobre os campos empacotados em binário: o mesmo valor em
+        qualquer processo, ao contrário de hash(), que usa semente aleatória.
+        """
+        packed = self._CHECKSUM_STRUCT.pack(
+            self.timestamp_us, self.strain_value,
+            int(self.raw_adc_value), int(self.battery_level)
+        )
+        return f"{zlib.crc32(packed):08x}"
     
     def is_valid(self) -> bool:
         """Verifica se a leitura é válida."""
@@ -64,6 +127,223 @@ class StrainReading:
             0 <= self.battery_level <= 100 and
             -40 <= self.temperature <= 85  # Faixa operacional típica
         )
+    
+    def __eq__(self, other: object) -> bool:
+        if other.__class__ is not self.__class__:
+            return NotImplemented
+        return (
+            self.timestamp_us == other.timestamp_us and
+            self.strain_value == other.strain_value and
+            self.raw_adc_value == other.raw_adc_value and
+            self.sensor_id == other.sensor_id and
+            self.battery_level == other.battery_level and
+            self.temperature == other.temperature and
+            self.checksum == other.checksum
+        )
+    
+    __hash__ = None
+    
+    def __repr__(self) -> str:
+        return (f"StrainReading(timestamp={self.timestamp!r}, strain_value={self.strain_value!r}, "
+                f"raw_adc_value={self.raw_adc_value!r}, sensor_id={self.sensor_id!r}, "
+                f"battery_level={self.battery_level!r}, temperature={self.temperature!r})")
+    
+    def __getstate__(self) -> tuple:
+        return (self.timestamp_us, self.strain_value, self.raw_adc_value, self.sensor_id,
+                self.battery_level, self.temperature, self._checksum)
+    
+    def __setstate__(self, state: tuple) -> None:
+        (self.timestamp_us, self.strain_value, self.raw_adc_value, self.sensor_id,
+         self.battery_level, self.temperature, self._checksum) = state
+
+
+class StrainBatch:
+    """
+    Lote de leituras em colunas tipadas (struct-of-arrays).
+    
+    Formato único do caminho de ingestão: produzido pelo decoder do
+    protocolo e consumido sem conversão pelo buffer, pelo osciloscópio,
+    pela captura e pelo writer do banco, cada um com uma única aquisição
+    de lock e gravações por fatia. Também é o resultado das consultas ao
+    buffer: quando a consulta resulta em uma janela contígua as colunas
+    são memoryviews somente leitura sobre o buffer circular, caso
+    contrário são arrays copiados.
+    
+    sensor_keys indexa sensor_names; um lote de pacote tem um único sensor.
+    """
+    
+    __slots__ = ('timestamps_us', 'strain_values', 'raw_adc_values',
+                 'battery_levels', 'temperatures', 'sensor_keys', 'sensor_names')
+    
+    def __init__(self, timestamps_us, strain_values, raw_adc_values,
+                 battery_levels, temperatures, sensor_keys, sensor_names):
+        self.timestamps_us = timestamps_us
+        self.strain_values = strain_values
+        self.raw_adc_values = raw_adc_values
+        self.battery_levels = battery_levels
+        self.temperatures = temperatures
+        self.sensor_keys = sensor_keys
+        self.sensor_names = sensor_names
+    
+    def __len__(self) -> int:
+        return len(self.timestamps_us)
+    
+    def sensor_id(self, index: int) -> str:
+        """Retorna o sensor_id da leitura na posição index."""
+        return self.sensor_names[self.sensor_keys[index]]
+    
+    def timestamps_ms(self) -> array:
+        """Retorna os timestamps em ms (float), eixo de tempo dos streams."""
+        return array('d', [timestamp / 1000.0 for timestamp in self.timestamps_us])
+    
+    @classmethod
+    def for_sensor(cls, sensor_id: str, timestamps_us: Sequence[int],
+                   strain_values: Sequence[float], raw_adc_values: Sequence[int],
+                   battery_levels: Sequence[int], temperatures: Sequence[float]) -> 'StrainBatch':
+        """
+        Cria lote de um único sensor a partir das colunas (sem cópia).
+        
+        Args:
+            sensor_id: Sensor de todas as leituras
+            timestamps_us: Timestamps em µs desde epoch
+            strain_values: Deformações em µε
+            raw_adc_values: Valores brutos do ADC
+            battery_levels: Níveis de bateria
+            temperatures: Temperaturas (°C)
+            
+        Returns:
+            Lote com sensor_keys zerado
+        """
+        return cls(timestamps_us, strain_values, raw_adc_values, battery_levels,
+                   temperatures, array('H', bytes(2 * len(timestamps_us))), [sensor_id])
+    
+    @classmethod
+    def from_readings(cls, readings: List[StrainReading]) -> 'StrainBatch':
+        """
+        Converte objetos StrainReading em colunas tipadas.
+        
+        Args:
+            readings: Lista de leituras
+            
+        Returns:
+            Colunas na ordem da lista
+        """
+        names: List[str] = []
+        keys: Dict[str, int] = {}
+        sensor_keys = array('H')
+        for reading in readings:
+            key = keys.get(reading.sensor_id)
+            if key is None:
+                key = keys[reading.sensor_id] = len(names)
+                names.append(reading.sensor_id)
+            sensor_keys.append(key)
+        
+        return cls(
+            array('q', [r.timestamp_us for r in readings]),
+            array('d', [r.strain_value for r in readings]),
+            array('i', [r.raw_adc_value for r in readings]),
+            array('h', [r.battery_level for r in readings]),
+            array('d', [r.temperature for r in readings]),
+            sensor_keys,
+            names
+        )
+    
+    @classmethod
+    def concat(cls, batches: Sequence['StrainBatch']) -> 'StrainBatch':
+        """
+        Junta lotes em um único lote, na ordem recebida.
+
+        As colunas são estendidas por fatia; só lotes com vários sensores
+        têm sensor_keys remapeado leitura a leitura.
+
+        Args:
+            batches: Lotes a juntar
+
+        Returns:
+            Lote com as colunas copiadas (o próprio lote se houver só um)
+        """
+        if len(batches) == 1:
+            return batches[0]
+
+        columns = (array('q'), array('d'), array('i'), array('h'), array('d'))
+        sensor_keys = array('H')
+        names: List[str] = []
+        keys: Dict[str, int] = {}
+        for batch in batches:
+            for target, column in zip(columns, (batch.timestamps_us, batch.strain_values,
+                                                batch.raw_adc_values, batch.battery_levels,
+                                                batch.temperatures)):
+                if isinstance(column, array) and column.typecode == target.typecode:
+                    target.extend(column)
+                else:
+                    target.extend(list(column))
+
+            local = []
+            for name in batch.sensor_names:
+                key = keys.get(name)
+                if key is None:
+                    key = keys[name] = len(names)
+                    names.append(name)
+                local.append(key)
+            if len(local) == 1:
+                sensor_keys.extend(array('H', local) * len(batch))
+            else:
+                sensor_keys.extend(array('H', [local[k] for k in batch.sensor_keys]))
+
+        return cls(*columns, sensor_keys, names)
+
+    def by_sensor(self) -> Iterator[Tuple[str, 'StrainBatch']]:
+        """
+        Separa o lote por sensor, preservando a ordem dentro de cada um.
+        
+        Lotes de um único sensor são retornados sem cópia.
+        
+        Returns:
+            Iterador de (sensor_id, lote do sensor)
+        """
+        if len(self.sensor_names) == 1:
+            yield self.sensor_names[0], self
+            return
+        
+        positions: Dict[int, List[int]] = {}
+        for index, key in enumerate(self.sensor_keys):
+            positions.setdefault(key, []).append(index)
+        columns = (self.timestamps_us, self.strain_values, self.raw_adc_values,
+                   self.battery_levels, self.temperatures)
+        for key, indices in positions.items():
+            picked = [[column[i] for i in indices] for column in columns]
+            yield self.sensor_names[key], StrainBatch.for_sensor(
+                self.sensor_names[key],
+                array('q', picked[0]), array('d', picked[1]), array('i', picked[2]),
+                array('h', picked[3]), array('d', picked[4])
+            )
+    
+    def to_readings(self) -> List[StrainReading]:
+        """
+        Materializa as colunas em objetos StrainReading.
+        
+        Returns:
+            Lista de leituras na ordem das colunas
+        """
+        names = self.sensor_names
+        return [
+            StrainReading(
+                timestamp=ts,
+                strain_value=strain,
+                raw_adc_value=adc,
+                sensor_id=names[key],
+                battery_level=battery,
+                temperature=temperature
+            )
+            for ts, strain, adc, battery, temperature, key in zip(
+                self.timestamps_us,
+                self.strain_values,
+                self.raw_adc_values,
+                self.battery_levels,
+                self.temperatures,
+                self.sensor_keys
+            )
+        ]
 
 
 @dataclass 
@@ -5,6 +5,11 @@ Este módulo é responsável por:
 - Buffer em memória para dados em tempo real
 - Persistência em banco de dados SQLite
 - Exportação de dados em vários formatos
+- Captura bruta .daqcap com leitura via mmap e replay
+- Ingestão em múltiplos processos com streams em memória compartilhada
+- Snapshot das janelas do osciloscópio para partida rápida
+- Análise de fadiga em tempo real (rainflow, dano de Miner, PSD)
+- Alarmes declarativos avaliados na ingestão
 - API otimizada para visualização tipo osciloscópio
 - Streaming de dados em tempo real
 
@@ -14,15 +19,40 @@ Classes principais:
 - WebSocketStreamer: Streaming via WebSocket
 """
 
+import importlib
+
+from .ring_buffer import ColumnRing
+
 from .data_manager import (
     DataManager,
     DataBuffer,
+    ReadingColumns,
     DatabaseManager,
     DataExporter,
     OscilloscopeStreamer,
     DataStorageError
 )
 
+from .query import ReadingQuery, QueryCursor
+
+from .snapshot import SnapshotReader, SnapshotError
+
+# Submódulos opcionais (mmap, multiprocessing, análise) são importados no
+# primeiro acesso ao nome, fora do caminho de inicialização
+_LAZY_EXPORTS = {
+    'CaptureReader': '.capture',
+    'CaptureWriter': '.capture',
+    'CaptureError': '.capture',
+    'CaptureReplayer': '.replay',
+    'FatigueMonitor': '.fatigue',
+    'SNCurve': '.fatigue',
+    'AlarmEngine': '.alarms',
+    'AlarmRule': '.alarms',
+    'AlarmEvent': '.alarms',
+    'ShardedIngest': '.shards',
+    'SharedColumnRing': '.shards',
+}
+
 from .oscilloscope_api import (
     OscilloscopeAPI,
     OscilloscopeConfig,
@@ -36,12 +66,46 @@ __all__ = [
     
     # Componentes internos
     'DataBuffer',
+    'ReadingColumns',
     'DatabaseManager', 
     'DataExporter',
     'OscilloscopeStreamer',
+    'ColumnRing',
+    'ReadingQuery',
+    'QueryCursor',
+    'SnapshotReader',
+    'SnapshotError',
+    
+    # Análise de fadiga
+    'FatigueMonitor',
+    'SNCurve',
+    
+    # Alarmes
+    'AlarmEngine',
+    'AlarmRule',
+    'AlarmEvent',
+    
+    # Captura bruta (.daqcap)
+    'CaptureReader',
+    'CaptureWriter',
+    'CaptureError',
+    'CaptureReplayer',
+    
+    # Ingestão em múltiplos processos
+    'ShardedIngest',
+    'SharedColumnRing',
     
     # API de osciloscópio
     'OscilloscopeAPI',
     'OscilloscopeConfig',
     'WebSocketStreamer',
 ]
+
+
+def __getattr__(name: str):
+    module = _LAZY_EXPORTS.get(name)
+    if module is None:
+        raise AttributeError(f"module {__name__!r} has no attribute {name!r}")
+    value = getattr(importlib.import_module(module, __name__), name)
+    globals()[name] = value
+    return value
@@ -0,0 +1,408 @@
+"""
+Alarmes avaliados no caminho de ingestão.
+
+As regras são declarativas (AlarmRule, ou dicts em ALARM_CONFIG['rules']) e
+compiladas em avaliadores por sensor, criados na primeira leitura de cada
+sensor. Cada avaliador guarda seu estado (alarme ativo, amostra anterior,
+janela de ocorrências) e recebe as colunas do lote inteiro:
+
+- threshold: valor acima/abaixo/fora do limite, com histerese (o alarme
+  só é desativado quando o valor volta além do nível clear)
+- rate: o mesmo sobre a taxa de variação entre amostras (unidade/s)
+- count: pelo menos `count` amostras além do limite em `window_ms`
+
+Todas as amostras são verificadas e a latência de detecção é a do lote.
+Um lote sem nenhuma transição é descartado com max()/min() sobre a coluna
+(em C); só lotes que cruzam um limite são percorridos amostra a amostra.
+Os eventos (ativação e desativação) são entregues aos assinantes depois
+de avaliado o lote, fora do lock.
+"""
+
+import threading
+from collections import deque
+from dataclasses import dataclass
+from typing import Any, Callable, Dict, List, NamedTuple, Optional, Sequence, Tuple
+
+from ..core.config import ALARM_CONFIG
+from ..core.models import StrainBatch
+
+
+# Campo da regra -> coluna do StrainBatch
+_COLUMNS = {
+    'strain': 'strain_values',
+    'battery': 'battery_levels',
+    'temperature': 'temperatures'
+}
+
+_KINDS = ('threshold', 'rate', 'count')
+_DIRECTIONS = ('above', 'below', 'outside')
+
+
+@dataclass(frozen=True)
+class AlarmRule:
+    """
+    Regra de alarme declarativa.
+
+    Attributes:
+        name: Nome da regra (identifica o alarme junto com o sensor)
+        field: Grandeza avaliada (strain, battery ou temperature)
+        limit: Limite de ativação (na unidade do campo; unidade/s em rate)
+        kind: threshold, rate ou count
+        direction: above, below ou outside (|valor| acima do limite)
+        clear: Nível de desativação (histerese; None = o próprio limite)
+        count: Amostras além do limite necessárias na janela (count)
+        window_ms: Janela das ocorrências (count)
+        severity: Severidade informada nos eventos
+        sensors: Sensores aos quais a regra se aplica (None = todos)
+    """
+    name: str
+    field: str
+    limit: float
+    kind: str = 'threshold'
+    direction: str = 'above'
+    clear: Optional[float] = None
+    count: int = 1
+    window_ms: float = 0.0
+    severity: str = 'warning'
+    sensors: Optional[Tuple[str, ...]] = None
+
+    def __post_init__(self):
+        if self.field not in _COLUMNS:
+            raise ValueError(f"Campo de alarme inválido: {self.field}")
+        if self.kind not in _KINDS:
+            raise ValueError(f"Tipo de alarme inválido: {self.kind}")
+        if self.direction not in _DIRECTIONS:
+            raise ValueError(f"Direção de alarme inválida: {self.direction}")
+        if self.kind == 'count' and (self.count < 1 or self.window_ms <= 0):
+            raise ValueError("Alarme count requer count >= 1 e window_ms positivo")
+
+        clear = self.clear_level
+        if self.direction == 'outside' and not 0 <= clear <= self.limit:
+            raise ValueError("Histerese de outside requer 0 <= clear <= limit")
+        if self.direction == 'above' and clear > self.limit:
+            raise ValueError("Histerese de above requer clear <= limit")
+        if self.direction == 'below' and clear < self.limit:
+            raise ValueError("Histerese de below requer clear >= limit")
+        if self.sensors is not None:
+            object.__setattr__(self, 'sensors', tuple(self.sensors))
+
+    @classmethod
+    def from_dict(cls, spec: Dict[str, Any]) -> 'AlarmRule':
+        """Cria a regra a partir de um dict (ver ALARM_CONFIG['rules'])."""
+        return cls(**spec)
+
+    @property
+    def clear_level(self) -> float:
+        """Nível em que o alarme é desativado."""
+        return self.limit if self.clear is None else self.clear
+
+    def applies_to(self, sensor_id: str) -> bool:
+        """Verifica se a regra vale para o sensor."""
+        return self.sensors is None or sensor_id in self.sensors
+
+
+class AlarmEvent(NamedTuple):
+    """
+    Ativação ou desativação de um alarme.
+
+    Attributes:
+        rule: Nome da regra
+        sensor_id: Sensor
+        timestamp_us: Timestamp da amostra que causou a transição
+        value: Valor avaliado (taxa em unidade/s nas regras rate)
+        raised: True na ativação, False na desativação
+        severity: Severidade da regra
+    """
+    rule: str
+    sensor_id: str
+    timestamp_us: int
+    value: float
+    raised: bool
+    severity: str
+
+    def to_dict(self) -> Dict[str, Any]:
+        """Converte para dict (timestamp em ms, como no osciloscópio)."""
+        return {
+            'rule': self.rule,
+            'sensor_id': self.sensor_id,
+            't': self.timestamp_us / 1000.0,
+            'value': self.value,
+            'state': 'raised' if self.raised else 'cleared',
+            'severity': self.severity
+        }
+
+
+def _predicates(direction: str, limit: float, clear: float):
+    """
+    Compila os testes de uma direção.
+
+    Returns:
+        (exceeds(v), holds(v), quiet(colunas), steady(colunas)): amostra além
+        do limite, amostra que mantém o alarme ativo, lote sem nenhuma
+        amostra além do limite, lote em que todas mantêm o alarme
+    """
+    limit = float(limit)
+    clear = float(clear)
+    if direction == 'above':
+        return (limit.__lt__, clear.__le__,
+                lambda values: max(values) <= limit,
+                lambda values: min(values) >= clear)
+    if direction == 'below':
+        return (limit.__gt__, clear.__ge__,
+                lambda values: min(values) >= limit,
+                lambda values: max(values) <= clear)
+
+    def quiet(values):
+        return max(values) <= limit and min(values) >= -limit
+
+    def steady(values):
+        return min(values) >= clear or max(values) <= -clear
+
+    return (lambda v: v > limit or v < -limit,
+            lambda v: v >= clear or v <= -clear,
+            quiet, steady)
+
+
+class _Evaluator:
+    """Avaliador compilado de uma regra para um sensor."""
+
+    __slots__ = ('rule', 'active', 'since_us', 'value', '_exceeds', '_holds',
+                 '_quiet', '_steady', '_previous')
+
+    def __init__(self, rule: AlarmRule):
+        self.rule = rule
+        self.active = False
+        self.since_us = 0
+        self.value = 0.0
+        self._exceeds, self._holds, self._quiet, self._steady = _predicates(
+            rule.direction, rule.limit, rule.clear_level)
+        self._previous: Optional[Tuple[int, float]] = None
+
+    def evaluate(self, timestamps: Sequence[int],
+                 values: Sequence[float]) -> List[Tuple[int, float, bool]]:
+        """
+        Avalia as colunas de um lote do sensor.
+
+        Returns:
+            Transições (timestamp_us, valor, ativado) na ordem do lote
+        """
+        if self.rule.kind == 'rate':
+            timestamps, values = self._rates(timestamps, values)
+        transitions: List[Tuple[int, float, bool]] = []
+        self._detect(timestamps, values, transitions)
+        if transitions:
+            self.since_us, self.value, _ = transitions[-1]
+        return transitions
+
+    def _rates(self, timestamps: Sequence[int], values: Sequence[float]):
+        """Taxa de variação (unidade/s) em relação à amostra anterior."""
+        previous_t, previous_v = self._previous or (timestamps[0], values[0])
+        rates = []
+        for t, v in zip(timestamps, values):
+            dt = t - previous_t
+            rates.append((v - previous_v) * 1e6 / dt if dt > 0 else 0.0)
+            previous_t, previous_v = t, v
+        self._previous = (previous_t, previous_v)
+        return timestamps, rates
+
+    def _detect(self, timestamps, values, transitions) -> None:
+        """Limite com histerese."""
+        if self.active:
+            if self._steady(values):
+                return
+        elif self._quiet(values):
+            return
+
+        exceeds, holds = self._exceeds, self._holds
+        active = self.active
+        for t, v in zip(timestamps, values):
+            if active:
+                if not holds(v):
+                    active = False
+                    transitions.append((t, v, False))
+            elif exceeds(v):
+                active = True
+                transitions.append((t, v, True))
+        self.active = active
+
+
+class _CountEvaluator(_Evaluator):
+    """Pelo menos N amostras além do limite dentro da janela."""
+
+    __slots__ = ('_hits', '_window_us')
+
+    def __init__(self, rule: AlarmRule):
+        super().__init__(rule)
+        # Basta a N-ésima ocorrência mais recente estar dentro da janela
+        self._hits = deque(maxlen=rule.count)
+        self._window_us = int(rule.window_ms * 1000)
+
+    def _detect(self, timestamps, values, transitions) -> None:
+        if not self.active and self._quiet(values):
+            return
+
+        hits, exceeds = self._hits, self._exceeds
+        count, window_us = self.rule.count, self._window_us
+        active = self.active
+        for t, v in zip(timestamps, values):
+            if exceeds(v):
+                hits.append(t)
+            full = len(hits) == count and t - hits[0] <= window_us
+            if active:
+                if not full:
+                    active = False
+                    transitions.append((t, v, False))
+            elif full:
+                active = True
+                transitions.append((t, v, True))
+        self.active = active
+
+
+def _compile(rules: Sequence[AlarmRule], sensor_id: str):
+    """Avaliadores do sensor agrupados por coluna do lote."""
+    groups: Dict[str, List[_Evaluator]] = {}
+    for rule in rules:
+        if rule.applies_to(sensor_id):
+            evaluator = _CountEvaluator(rule) if rule.kind == 'count' else _Evaluator(rule)
+            groups.setdefault(_COLUMNS[rule.field], []).append(evaluator)
+    return list(groups.items())
+
+
+class AlarmEngine:
+    """
+    Motor de alarmes alimentado pelos lotes do caminho de ingestão.
+    """
+
+    def __init__(self, rules: Optional[Sequence[Any]] = None,
+                 history_size: Optional[int] = None):
+        """
+        Inicializa o motor.
+
+        Args:
+            rules: AlarmRule ou dicts (None = ALARM_CONFIG['rules'])
+            history_size: Eventos mantidos no histórico
+
+        Raises:
+            ValueError: Regra inválida ou nome repetido
+        """
+        if rules is None:
+            rules = ALARM_CONFIG['rules']
+        self.rules: List[AlarmRule] = [
+            rule if isinstance(rule, AlarmRule) else AlarmRule.from_dict(rule)
+            for rule in rules
+        ]
+        names = [rule.name for rule in self.rules]
+        if len(set(names)) != len(names):
+            raise ValueError("Nomes de regras de alarme devem ser únicos")
+
+        self._sensors: Dict[str, List[Tuple[str, List[_Evaluator]]]] = {}
+        self._history = deque(maxlen=history_size or ALARM_CONFIG['history_size'])
+        self._subscribers: List[Callable[[AlarmEvent], None]] = []
+        self._lock = threading.Lock()
+        self._samples = 0
+        self._events = 0
+
+    def subscribe(self, callback: Callable[[AlarmEvent], None]) -> None:
+        """Adiciona assinante chamado a cada evento (na thread de ingestão)."""
+        self._subscribers.append(callback)
+
+    def unsubscribe(self, callback: Callable[[AlarmEvent], None]) -> None:
+        """Remove assinante."""
+        if callback in self._subscribers:
+            self._subscribers.remove(callback)
+
+    def add_batch(self, batch: StrainBatch) -> List[AlarmEvent]:
+        """
+        Avalia um lote do caminho de ingestão (um ou mais sensores).
+
+        Args:
+            batch: Lote de leituras
+
+        Returns:
+            Eventos gerados pelo lote, na ordem de cada sensor
+        """
+        if not len(batch):
+            return []
+        events: List[AlarmEvent] = []
+        with self._lock:
+            for sensor_id, part in batch.by_sensor():
+                groups = self._sensors.get(sensor_id)
+                if groups is None:
+                    groups = self._sensors[sensor_id] = _compile(self.rules, sensor_id)
+                timestamps = part.timestamps_us
+                for column, evaluators in groups:
+                    values = getattr(part, column)
+                    for evaluator in evaluators:
+                        rule = evaluator.rule
+                        for t, v, raised in evaluator.evaluate(timestamps, values):
+                            events.append(AlarmEvent(rule.name, sensor_id, t, v,
+                                                     raised, rule.severity))
+                self._samples += len(part)
+            self._history.extend(events)
+            self._events += len(events)
+
+        for event in events:
+            for callback in list(self._subscribers):
+                try:
+                    callback(event)
+                except Exception as e:
+                    print(f"Erro no callback de alarme: {e}")
+        return events
+
+    def active_alarms(self, sensor_id: Optional[str] = None) -> List[Dict[str, Any]]:
+        """
+        Retorna os alarmes ativos.
+
+        Args:
+            sensor_id: ID do sensor (None = todos)
+
+        Returns:
+            Regra, sensor, severidade, instante da ativação e valor
+        """
+        with self._lock:
+            return [
+                {
+                    'rule': evaluator.rule.name,
+                    'sensor_id': sid,
+                    'severity': evaluator.rule.severity,
+                    'since': evaluator.since_us / 1000.0,
+                    'value': evaluator.value
+                }
+                for sid, groups in self._sensors.items()
+                if sensor_id is None or sid == sensor_id
+                for _, evaluators in groups
+                for evaluator in evaluators
+                if evaluator.active
+            ]
+
+    def history(self, limit: Optional[int] = None) -> List[AlarmEvent]:
+        """Eventos mais recentes, do mais antigo para o mais novo."""
+        with self._lock:
+            events = list(self._history)
+        return events[-limit:] if limit else events
+
+    def get_stats(self) -> Dict[str, Any]:
+        """Estatísticas do motor."""
+        with self._lock:
+            active = sum(
+                evaluator.active
+                for groups in self._sensors.values()
+                for _, evaluators in groups
+                for evaluator in evaluators
+            )
+            return {
+                'rules': len(self.rules),
+                'sensors': len(self._sensors),
+                'samples_evaluated': self._samples,
+                'events': self._events,
+                'active': active
+            }
+
+    def reset(self, sensor_id: Optional[str] = None) -> None:
+        """Descarta o estado dos avaliadores de um sensor (None = todos)."""
+        with self._lock:
+            if sensor_id is None:
+                self._sensors.clear()
+                self._history.clear()
+            else:
+                self._sensors.pop(sensor_id, None)
@@ -0,0 +1,544 @@
+"""
+Formato de captura bruta .daqcap para gravações longas.
+
+Arquivo somente de acréscimo (append-only) pensado para leitura via mmap:
+qualquer intervalo de tempo de um sensor é exposto como memoryviews
+tipadas sobre o arquivo mapeado, sem cópia e sem carregar a captura em
+memória.
+
+Estrutura (little-endian, blocos alinhados a 8 bytes):
+
+CABEÇALHO DO ARQUIVO (24 bytes + metadados):
+- Magic (8 bytes): b'DAQCAP01'
+- Versão (2 bytes)
+- Reservado (2 bytes)
+- Tamanho dos metadados (4 bytes)
+- Intervalo do índice (4 bytes): registros entre entradas do índice
+- Registros por segmento (4 bytes)
+- Metadados JSON: taxa de amostragem, calibração e dicionário de sensores
+
+BLOCOS (cabeçalho de 32 bytes + payload):
+- Tag (4 bytes): b'SNS1', b'SEG1' ou b'IDX1'
+- Chave do sensor (2 bytes)
+- Reservado (2 bytes)
+- Contagem (4 bytes)
+- Tamanho do payload (4 bytes)
+- Primeiro e último timestamp em µs (8 + 8 bytes)
+
+- SNS1: sensor que apareceu depois do cabeçalho (payload JSON)
+- SEG1: até `segment_records` registros de um único sensor, em colunas:
+  timestamps int64 (µs), strain float64, temperatura float64,
+  ADC int32 e bateria int16 (RECORD_SIZE bytes por registro)
+- IDX1: índice esparso gravado ao fechar, com uma entrada
+  (timestamp, offset do segmento, posição, sensor) a cada
+  `index_interval` registros de cada sensor e no início de cada segmento,
+  seguido do dicionário de sensores em JSON
+
+O arquivo termina com (offset do IDX1, b'DAQCAPIX'). Sem esse trailer
+(gravação interrompida), o leitor reconstrói o índice percorrendo os
+cabeçalhos dos blocos.
+
+Os registros de cada sensor devem chegar em ordem de timestamp, como no
+restante do sistema; dentro de um segmento eles são ordenados antes da
+gravação.
+"""
+
+import json
+import mmap
+import struct
+import threading
+from array import array
+from bisect import bisect_left, bisect_right
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional, Tuple, Union
+
+from ..core.models import SensorConfiguration, datetime_to_us
+from ..core.config import config
+from .decimation import minmax_bucket
+
+
+MAGIC = b'DAQCAP01'
+TRAILER_MAGIC = b'DAQCAPIX'
+FORMAT_VERSION = 1
+
+FILE_HEADER = struct.Struct('<8sHHIII')
+BLOCK_HEADER = struct.Struct('<4sHHIIqq')
+INDEX_ENTRY = struct.Struct('<qQII')
+TRAILER = struct.Struct('<Q8s')
+
+TAG_SENSOR = b'SNS1'
+TAG_SEGMENT = b'SEG1'
+TAG_INDEX = b'IDX1'
+
+# Colunas do segmento: (nome, typecode, bytes por registro), na ordem gravada
+COLUMNS = (
+    ('timestamps_us', 'q', 8),
+    ('strain_values', 'd', 8),
+    ('temperatures', 'd', 8),
+    ('raw_adc_values', 'i', 4),
+    ('battery_levels', 'h', 2),
+)
+RECORD_SIZE = sum(size for _, _, size in COLUMNS)
+
+Calibration = Union[SensorConfiguration, Dict[str, float]]
+
+
+class CaptureError(Exception):
+    """Erro de leitura/gravação de captura."""
+    pass
+
+
+def _padded(payload: bytes) -> bytes:
+    return payload + bytes(-len(payload) % 8)
+
+
+def _timestamp_us(value: Optional[Union[datetime, int]], default: int) -> int:
+    if value is None:
+        return default
+    if isinstance(value, datetime):
+        return datetime_to_us(value)
+    return int(value)
+
+
+class CaptureSlice:
+    """
+    Trecho contíguo de um sensor em uma captura.
+
+    As colunas são memoryviews somente leitura sobre o arquivo mapeado e
+    só permanecem válidas enquanto o CaptureReader estiver aberto.
+    """
+
+    __slots__ = ('sensor_id',) + tuple(name for name, _, _ in COLUMNS)
+
+    def __init__(self, sensor_id: str, columns: Dict[str, memoryview]):
+        self.sensor_id = sensor_id
+        for name, view in columns.items():
+            setattr(self, name, view)
+
+    def __len__(self) -> int:
+        return len(self.timestamps_us)
+
+
+class CaptureWriter:
+    """
+    Gravador de capturas .daqcap.
+
+    Leituras são acumuladas em colunas por sensor e cada segmento cheio é
+    gravado de uma vez. flush() grava também os segmentos parciais, de
+    modo que uma captura interrompida perde no máximo o que não passou
+    por flush.
+    """
+
+    def __init__(self, path: Path,
+                 sample_rate_hz: Optional[float] = None,
+                 calibration: Optional[Dict[str, Calibration]] = None,
+                 segment_records: Optional[int] = None,
+                 index_interval: Optional[int] = None,
+                 metadata: Optional[Dict[str, Any]] = None):
+        """
+        Cria o arquivo e grava o cabeçalho.
+
+        Args:
+            path: Caminho do arquivo .daqcap
+            sample_rate_hz: Taxa de amostragem nominal (padrão: DEFAULT_SAMPLING_RATE)
+            calibration: Calibração por sensor_id (SensorConfiguration ou
+                dicionário com calibration_factor e offset)
+            segment_records: Registros por segmento (padrão: CAPTURE_SEGMENT_RECORDS)
+            index_interval: Registros entre entradas do índice (padrão: CAPTURE_INDEX_INTERVAL)
+            metadata: Metadados adicionais gravados no cabeçalho
+
+        Raises:
+            CaptureError: Se não for possível criar o arquivo
+        """
+        self.path = Path(path)
+        self.segment_records = segment_records or config.CAPTURE_SEGMENT_RECORDS
+        self.index_interval = index_interval or config.CAPTURE_INDEX_INTERVAL
+        self._lock = threading.Lock()
+        self._keys: Dict[str, int] = {}
+        self._pending: Dict[int, List[array]] = {}
+        self._written: Dict[int, int] = {}
+        self._index = bytearray()
+        self._index_count = 0
+        self._sensors: Dict[str, Dict[str, Any]] = {}
+        self.records_written = 0
+        self.closed = False
+
+        for sensor_id, values in (calibration or {}).items():
+            self._sensors[sensor_id] = self._sensor_entry(sensor_id, values)
+
+        header_metadata = dict(metadata or {})
+        header_metadata.update({
+            'sample_rate_hz': sample_rate_hz or 1000.0 / config.DEFAULT_SAMPLING_RATE,
+            'created': datetime.now().isoformat(),
+            'sensors': self._sensors
+        })
+        meta = json.dumps(header_metadata, ensure_ascii=False).encode('utf-8')
+
+        try:
+            self._file = open(self.path, 'wb')
+            self._file.write(FILE_HEADER.pack(MAGIC, FORMAT_VERSION, 0, len(meta),
+                                              self.index_interval, self.segment_records))
+            self._file.write(_padded(meta))
+            self._file.flush()
+        except OSError as e:
+            raise CaptureError(f"Erro ao criar captura {self.path}: {e}")
+        self._offset = self._file.tell()
+
+    def _sensor_entry(self, sensor_id: str, values: Optional[Calibration] = None) -> Dict[str, Any]:
+        key = self._keys.setdefault(sensor_id, len(self._keys))
+        entry = {'key': key, 'calibration_factor': 1.0, 'offset': 0.0}
+        if isinstance(values, SensorConfiguration):
+            entry.update(calibration_factor=values.calibration_factor, offset=values.offset)
+        elif values:
+            entry.update({k: values[k] for k in ('calibration_factor', 'offset') if k in values})
+        return entry
+
+    def write(self, batch) -> None:
+        """
+        Acrescenta um lote de leituras (ReadingColumns) à captura.
+
+        Args:
+            batch: Colunas com timestamps_us, strain_values, raw_adc_values,
+                battery_levels, temperatures, sensor_keys e sensor_names
+        """
+        if not len(batch):
+            return
+        with self._lock:
+            if self.closed:
+                raise CaptureError("Captura já foi fechada")
+            keys = [self._key(name) for name in batch.sensor_names]
+            columns = [getattr(batch, name) for name, _, _ in COLUMNS]
+
+            if len(keys) == 1:
+                self._extend(keys[0], columns, 0, len(batch))
+                return
+
+            # Agrupa trechos consecutivos do mesmo sensor
+            sensor_keys = batch.sensor_keys
+            start = 0
+            for index in range(1, len(batch) + 1):
+                if index == len(batch) or sensor_keys[index] != sensor_keys[start]:
+                    self._extend(keys[sensor_keys[start]], columns, start, index)
+                    start = index
+
+    def _key(self, sensor_id: str) -> int:
+        """Chave do sensor, gravando bloco SNS1 se ele for novo."""
+        key = self._keys.get(sensor_id)
+        if key is None:
+            entry = self._sensor_entry(sensor_id)
+            self._sensors[sensor_id] = entry
+            payload = json.dumps({'sensor_id': sensor_id, **entry}, ensure_ascii=False).encode('utf-8')
+            self._write_block(TAG_SENSOR, entry['key'], 0, 0, 0, _padded(payload))
+            key = entry['key']
+        if key not in self._pending:
+            self._pending[key] = [array(code) for _, code, _ in COLUMNS]
+            self._written[key] = 0
+        return key
+
+    def _extend(self, key: int, columns: List, start: int, stop: int) -> None:
+        while start < stop:
+            pending = self._pending[key]
+            take = min(stop - start, self.segment_records - len(pending[0]))
+            for target, column in zip(pending, columns):
+                target.frombytes(memoryview(column)[start:start + take].cast('B'))
+            start += take
+            if len(pending[0]) >= self.segment_records:
+                self._write_segment(key)
+
+    def _write_segment(self, key: int) -> None:
+        """Grava as colunas pendentes do sensor como um segmento SEG1."""
+        pending = self._pending[key]
+        count = len(pending[0])
+        if not count:
+            return
+
+        timestamps = pending[0]
+        if any(timestamps[i] > timestamps[i + 1] for i in range(count - 1)):
+            order = sorted(range(count), key=timestamps.__getitem__)
+            pending = [array(column.typecode, [column[i] for i in order]) for column in pending]
+            timestamps = pending[0]
+
+        segment_offset = self._offset
+        payload = b''.join(column.tobytes() for column in pending)
+        self._write_block(TAG_SEGMENT, key, count, timestamps[0], timestamps[-1], _padded(payload))
+
+        # Entradas do índice: início do segmento e a cada index_interval registros
+        first_record = self._written[key]
+        interval = self.index_interval
+        position = 0
+        while position < count:
+            self._index += INDEX_ENTRY.pack(timestamps[position], segment_offset, position, key)
+            self._index_count += 1
+            position = (first_record + position) // interval * interval + interval - first_record
+
+        self._written[key] = first_record + count
+        self.records_written += count
+        self._pending[key] = [array(code) for _, code, _ in COLUMNS]
+
+    def _write_block(self, tag: bytes, key: int, count: int,
+                     first_us: int, last_us: int, payload: bytes) -> None:
+        try:
+            self._file.write(BLOCK_HEADER.pack(tag, key, 0, count, len(payload), first_us, last_us))
+            self._file.write(payload)
+            self._file.flush()
+        except OSError as e:
+            raise CaptureError(f"Erro ao gravar captura {self.path}: {e}")
+        self._offset += BLOCK_HEADER.size + len(payload)
+
+    def flush(self) -> None:
+        """Grava os segmentos parciais de todos os sensores."""
+        with self._lock:
+            if self.closed:
+                return
+            for key in self._pending:
+                self._write_segment(key)
+
+    def close(self) -> None:
+        """Grava pendências, índice e trailer e fecha o arquivo."""
+        self.flush()
+        with self._lock:
+            if self.closed:
+                return
+            index_offset = self._offset
+            sensors = json.dumps(self._sensors, ensure_ascii=False).encode('utf-8')
+            self._write_block(TAG_INDEX, 0, self._index_count, 0, 0,
+                              _padded(bytes(self._index) + sensors))
+            try:
+                self._file.write(TRAILER.pack(index_offset, TRAILER_MAGIC))
+                self._file.close()
+            except OSError as e:
+                raise CaptureError(f"Erro ao finalizar captura {self.path}: {e}")
+            self.closed = True
+
+    def __enter__(self) -> 'CaptureWriter':
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+class CaptureReader:
+    """
+    Leitor de capturas .daqcap via mmap.
+
+    read() retorna CaptureSlice com views sem cópia; decimate() reduz um
+    intervalo à largura do gráfico lendo apenas as páginas do intervalo,
+    o que permite navegar por capturas de horas sem carregá-las.
+    """
+
+    def __init__(self, path: Path):
+        """
+        Abre e mapeia a captura.
+
+        Args:
+            path: Caminho do arquivo .daqcap
+
+        Raises:
+            CaptureError: Se o arquivo não for uma captura válida
+        """
+        self.path = Path(path)
+        try:
+            with open(self.path, 'rb') as f:
+                self._mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (OSError, ValueError) as e:
+            raise CaptureError(f"Erro ao abrir captura {self.path}: {e}")
+        self._view = memoryview(self._mm)
+
+        if len(self._mm) < FILE_HEADER.size:
+            raise CaptureError(f"Captura truncada: {self.path}")
+        magic, version, _, meta_size, self.index_interval, self.segment_records = \
+            FILE_HEADER.unpack_from(self._mm, 0)
+        if magic != MAGIC or version != FORMAT_VERSION:
+            raise CaptureError(f"Arquivo não é uma captura .daqcap v{FORMAT_VERSION}: {self.path}")
+
+        start = FILE_HEADER.size
+        self.metadata: Dict[str, Any] = json.loads(bytes(self._mm[start:start + meta_size]).decode('utf-8'))
+        self._data_start = start + meta_size + (-meta_size % 8)
+        self._sensors: Dict[str, Dict[str, Any]] = dict(self.metadata.get('sensors', {}))
+
+        # Por sensor: timestamps do índice, (offset, posição) e offsets dos segmentos
+        self._entry_times: Dict[int, List[int]] = {}
+        self._entries: Dict[int, List[Tuple[int, int]]] = {}
+        self._segments: Dict[int, List[int]] = {}
+        self.complete = self._load_index()
+        if not self.complete:
+            self._scan_blocks()
+
+    @property
+    def sample_rate_hz(self) -> float:
+        return self.metadata.get('sample_rate_hz', 0.0)
+
+    @property
+    def sensors(self) -> List[str]:
+        """Sensores presentes na captura."""
+        return list(self._sensors)
+
+    def calibration(self, sensor_id: str) -> Dict[str, float]:
+        """Retorna calibration_factor e offset do sensor."""
+        entry = self._sensors[sensor_id]
+        return {'calibration_factor': entry['calibration_factor'], 'offset': entry['offset']}
+
+    def _add_entry(self, key: int, timestamp: int, offset: int, position: int) -> None:
+        self._entry_times.setdefault(key, []).append(timestamp)
+        self._entries.setdefault(key, []).append((offset, position))
+        if position == 0:
+            self._segments.setdefault(key, []).append(offset)
+
+    def _load_index(self) -> bool:
+        """Carrega o bloco IDX1 indicado pelo trailer."""
+        size = len(self._mm)
+        if size < self._data_start + TRAILER.size:
+            return False
+        index_offset, magic = TRAILER.unpack_from(self._mm, size - TRAILER.size)
+        if magic != TRAILER_MAGIC or index_offset + BLOCK_HEADER.size > size:
+            return False
+        tag, _, _, count, payload_size, _, _ = BLOCK_HEADER.unpack_from(self._mm, index_offset)
+        if tag != TAG_INDEX:
+            return False
+
+        start = index_offset + BLOCK_HEADER.size
+        for timestamp, offset, position, key in INDEX_ENTRY.iter_unpack(
+                self._mm[start:start + count * INDEX_ENTRY.size]):
+            self._add_entry(key, timestamp, offset, position)
+        sensors = bytes(self._mm[start + count * INDEX_ENTRY.size:start + payload_size])
+        self._sensors.update(json.loads(sensors.rstrip(b'\0').decode('utf-8')))
+        return True
+
+    def _scan_blocks(self) -> None:
+        """Reconstrói o índice pelos cabeçalhos (captura não finalizada)."""
+        offset, size = self._data_start, len(self._mm)
+        while offset + BLOCK_HEADER.size <= size:
+            tag, key, _, count, payload_size, first_us, _ = BLOCK_HEADER.unpack_from(self._mm, offset)
+            end = offset + BLOCK_HEADER.size + payload_size
+            if end > size or tag not in (TAG_SENSOR, TAG_SEGMENT):
+                break
+            if tag == TAG_SENSOR:
+                payload = bytes(self._mm[offset + BLOCK_HEADER.size:end]).rstrip(b'\0')
+                entry = json.loads(payload.decode('utf-8'))
+                self._sensors[entry.pop('sensor_id')] = entry
+            else:
+                self._add_entry(key, first_us, offset, 0)
+            offset = end
+
+    def _key(self, sensor_id: str) -> int:
+        entry = self._sensors.get(sensor_id)
+        if entry is None:
+            raise KeyError(f"Sensor não encontrado na captura: {sensor_id}")
+        return entry['key']
+
+    def _segment_columns(self, offset: int) -> Dict[str, memoryview]:
+        """Views das colunas de um segmento."""
+        count = BLOCK_HEADER.unpack_from(self._mm, offset)[3]
+        position = offset + BLOCK_HEADER.size
+        columns = {}
+        for name, code, size in COLUMNS:
+            columns[name] = self._view[position:position + count * size].cast(code)
+            position += count * size
+        return columns
+
+    def count(self, sensor_id: str) -> int:
+        """Número de registros do sensor."""
+        return sum(BLOCK_HEADER.unpack_from(self._mm, offset)[3]
+                   for offset in self._segments.get(self._key(sensor_id), []))
+
+    def time_range(self, sensor_id: str) -> Optional[Tuple[int, int]]:
+        """Primeiro e último timestamp (µs) do sensor, ou None se vazio."""
+        segments = self._segments.get(self._key(sensor_id))
+        if not segments:
+            return None
+        return (BLOCK_HEADER.unpack_from(self._mm, segments[0])[5],
+                BLOCK_HEADER.unpack_from(self._mm, segments[-1])[6])
+
+    def read(self, sensor_id: str,
+             start_time: Optional[Union[datetime, int]] = None,
+             end_time: Optional[Union[datetime, int]] = None) -> Iterator[CaptureSlice]:
+        """
+        Lê um intervalo de tempo do sensor sem copiar os dados.
+
+        Args:
+            sensor_id: ID do sensor
+            start_time: Início (datetime ou µs, inclusivo)
+            end_time: Fim (datetime ou µs, inclusivo)
+
+        Yields:
+            CaptureSlice por segmento, em ordem cronológica
+        """
+        key = self._key(sensor_id)
+        times = self._entry_times.get(key)
+        if not times:
+            return
+        start_us = _timestamp_us(start_time, times[0])
+        end_us = _timestamp_us(end_time, 2 ** 63 - 1)
+        entries = self._entries[key]
+        segments = self._segments[key]
+
+        # Entrada do índice imediatamente anterior ao início
+        entry = max(0, bisect_right(times, start_us) - 1)
+        offset, low = entries[entry]
+        high = entries[entry + 1][1] if entry + 1 < len(entries) and entries[entry + 1][0] == offset else None
+
+        for segment_offset in segments[bisect_left(segments, offset):]:
+            columns = self._segment_columns(segment_offset)
+            timestamps = columns['timestamps_us']
+            count = len(timestamps)
+            if segment_offset == offset:
+                low = bisect_left(timestamps, start_us, low, high or count)
+            else:
+                low = 0
+            if low < count and timestamps[low] > end_us:
+                return
+            stop = bisect_right(timestamps, end_us, low, count)
+            if stop > low:
+                yield CaptureSlice(sensor_id, {name: view[low:stop] for name, view in columns.items()})
+            if stop < count:
+                return
+
+    def decimate(self, sensor_id: str, width: int,
+                 start_time: Optional[Union[datetime, int]] = None,
+                 end_time: Optional[Union[datetime, int]] = None) -> Tuple[List[float], List[float]]:
+        """
+        Envelope min/max de um intervalo para uma largura em pixels.
+
+        Buckets não atravessam segmentos: as bordas de cada trecho
+        formam buckets menores, o que mantém os picos e acrescenta no
+        máximo dois pontos por segmento.
+
+        Args:
+            sensor_id: ID do sensor
+            width: Largura do gráfico em pixels
+            start_time: Início (datetime ou µs)
+            end_time: Fim (datetime ou µs)
+
+        Returns:
+            (tempos em ms, valores)
+        """
+        slices = list(self.read(sensor_id, start_time, end_time))
+        total = sum(len(part) for part in slices)
+        size = max(1, -(-total // max(1, int(width))))
+
+        times: List[float] = []
+        values: List[float] = []
+        for part in slices:
+            part_times = part.timestamps_us
+            strains = part.strain_values
+            for start in range(0, len(part), size):
+                for t, v in minmax_bucket(part_times, strains, start, min(start + size, len(part))):
+                    times.append(t / 1000.0)
+                    values.append(v)
+        return times, values
+
+    def close(self) -> None:
+        """Libera o mapeamento (views de read() deixam de ser válidas)."""
+        try:
+            self._view.release()
+            self._mm.close()
+        except BufferError:
+            # Ainda existem views exportadas; o mapeamento é liberado com elas
+            pass
+
+    def __enter__(self) -> 'CaptureReader':
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
@@ -6,16 +6,39 @@ Responsável por armazenamento, buffer, persistência e exportação de dados.
 import os
 import json
 import csv
+import gzip
+import heapq
 import sqlite3
 import threading
+import time
+from array import array
+from bisect import bisect_left
+from collections import deque
 from datetime import datetime, timedelta
-from typing import List, Dict, Any, Optional, Union
+from itertools import chain, islice, repeat
+from operator import itemgetter
+from typing import TYPE_CHECKING, Callable, List, Dict, Any, Iterator, Optional, Tuple, Union
 from pathlib import Path
 from dataclasses import asdict
-import pandas as pd
 
-from ..core.models import StrainReading, DataPacket, SensorInfo
-from ..core.config import get_data_file_path, config, EXPORT_CONFIG
+from ..core.models import (
+    StrainReading, StrainBatch, DataPacket, SensorInfo, datetime_to_us, us_to_datetime
+)
+from ..core.config import get_data_file_path, config, EXPORT_CONFIG, FATIGUE_CONFIG, ALARM_CONFIG
+from ..core.metrics import metrics, COUNTER, GAUGE
+from .ring_buffer import ColumnRing, search_indices, trim_indices
+from .write_behind import WriteBehindWriter
+from .partitions import PartitionRouter, READINGS_SCHEMA, DAY_MS, day_of
+from . import rollups
+from .decimation import DecimationCache, bucket_size
+from .query import ReadingQuery, QueryCursor
+from .snapshot import SnapshotReader, snapshot_path, write_snapshot
+
+# Captura, fadiga e alarmes são opcionais: importados ao serem iniciados
+if TYPE_CHECKING:
+    from .capture import CaptureWriter, Calibration
+    from .fatigue import FatigueMonitor
+    from .alarms import AlarmEngine
 
 
 class DataStorageError(Exception):
@@ -23,28 +46,129 @@ class DataStorageError(Exception):
     pass
 
 
+# Instrumentação dos caminhos quentes (temporizadores amostrados, ver core.metrics)
+_INGESTED = metrics.counter('daq_ingest_readings_total', 'Leituras recebidas pelo DataManager')
+_INGEST_TO_VISIBLE = metrics.histogram(
+    'daq_ingest_to_visible_seconds',
+    'Tempo entre a entrada em add_readings e a leitura visível no osciloscópio'
+).sampled(config.METRICS_SAMPLE_EVERY)
+_SAMPLE_AGE = metrics.histogram(
+    'daq_sample_age_seconds',
+    'Idade da leitura mais recente de um lote quando fica visível (link + ingestão)',
+    buckets=(0.01, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0, 60.0, 300.0)
+)
+_FLUSH_SECONDS = metrics.histogram('daq_buffer_flush_seconds',
+                                   'Duração do flush do buffer para o writer')
+_SQLITE_ROWS = metrics.counter('daq_sqlite_rows_total', 'Linhas gravadas nas partições SQLite')
+_SQLITE_COMMIT = metrics.histogram(
+    'daq_sqlite_commit_seconds',
+    'Duração da transação de gravação (partições, rollups e commit)'
+)
+_STREAMER_LOCK_WAIT = metrics.histogram('daq_streamer_lock_wait_seconds',
+                                        'Espera pelo lock do OscilloscopeStreamer', ['operation'])
+_LOCK_WAIT_INGEST = _STREAMER_LOCK_WAIT.labels('ingest').sampled(config.METRICS_SAMPLE_EVERY)
+_LOCK_WAIT_READ = _STREAMER_LOCK_WAIT.labels('read').sampled(config.METRICS_SAMPLE_EVERY)
+
+
+# Nome anterior do lote colunar, mantido para compatibilidade
+ReadingColumns = StrainBatch
+
+
+def _bound_us(value: Optional[Union[datetime, int]]) -> Optional[int]:
+    """Limite de consulta em µs (aceita datetime ou µs)."""
+    if value is None:
+        return None
+    return value if isinstance(value, int) else datetime_to_us(value)
+
+
+def _limit_range(low: int, high: int, max_count: Optional[int],
+                 earliest: bool) -> Tuple[int, int]:
+    """Limita [low, high) a max_count posições, no início ou no fim."""
+    if max_count and high - low > max_count:
+        if earliest:
+            return low, low + max_count
+        return high - max_count, high
+    return low, high
+
+
 class DataBuffer:
     """
     Buffer em memória para dados de sensores.
     
-    Implementa buffer circular com persistência automática
-    quando atinge limite de tamanho ou tempo.
+    Implementa buffer circular colunar pré-alocado com persistência
+    automática quando atinge limite de tamanho ou tempo. Mantém índice
+    de sensores internados e lista de posições por sensor; consultas por
+    intervalo de tempo usam busca binária enquanto os timestamps chegam
+    em ordem.
     """
     
-    def __init__(self, max_size: int = 10000, flush_interval: int = 60):
+    COLUMNS = (
+        ('timestamp_us', 'q'),
+        ('strain_value', 'd'),
+        ('raw_adc_value', 'i'),
+        ('battery_level', 'h'),
+        ('temperature', 'd'),
+        ('sensor_key', 'H')
+    )
+    
+    def __init__(self, max_size: int = 10000, flush_interval: float = 60,
+                 flush_size: Optional[int] = None):
         """
         Inicializa o buffer de dados.
         
         Args:
             max_size: Tamanho máximo do buffer
             flush_interval: Intervalo de flush em segundos
+            flush_size: Número de leituras que dispara o flush (padrão: max_size)
         """
-        self._buffer: List[StrainReading] = []
+        self._ring = ColumnRing(max_size, self.COLUMNS)
         self._max_size = max_size
+        self._flush_size = min(flush_size or max_size, max_size)
         self._flush_interval = flush_interval
         self._last_flush = datetime.now()
         self._lock = threading.Lock()
         
+        # Índice de sensores: nome -> chave e posições absolutas por chave
+        self._sensor_keys: Dict[str, int] = {}
+        self._sensor_names: List[str] = []
+        self._positions: List[array] = []
+        
+        # Ordenação temporal (global e por sensor) desde o último clear
+        self._ordered = True
+        self._sensor_ordered: List[bool] = []
+        self._last_ts = None
+        self._sensor_last_ts: List[Optional[int]] = []
+    
+    def _sensor_key(self, sensor_id: str) -> int:
+        """Interna sensor_id e retorna sua chave (chamar com lock)."""
+        key = self._sensor_keys.get(sensor_id)
+        if key is None:
+            key = len(self._sensor_names)
+            self._sensor_keys[sensor_id] = key
+            self._sensor_names.append(sensor_id)
+            self._positions.append(array('q'))
+            self._sensor_ordered.append(True)
+            self._sensor_last_ts.append(None)
+        return key
+    
+    def _track_order(self, key: int, ts: int) -> None:
+        """Atualiza flags de ordenação temporal (chamar com lock)."""
+        if self._last_ts is not None and ts < self._last_ts:
+            self._ordered = False
+        else:
+            self._last_ts = ts
+        last = self._sensor_last_ts[key]
+        if last is not None and ts < last:
+            self._sensor_ordered[key] = False
+        else:
+            self._sensor_last_ts[key] = ts
+    
+    def _compact_positions(self, key: int) -> None:
+        """Descarta posições já sobrescritas quando acumulam (chamar com lock)."""
+        positions = self._positions[key]
+        if positions and positions[0] < self._ring.first_index and len(positions) > 64:
+            trim_indices(positions, self._ring.first_index)
+    
     def add_reading(self, reading: StrainReading) -> None:
         """
         Adiciona uma leitura ao buffer.
@@ -52,12 +176,22 @@ class DataBuffer:
         Args:
             reading: Leitura a ser adicionada
         """
+        ts = reading.timestamp_us
         with self._lock:
-            self._buffer.append(reading)
+            key = self._sensor_key(reading.sensor_id)
+            self._track_order(key, ts)
             
-            # Remove dados antigos se buffer cheio
-            if len(self._buffer) > self._max_size:
-                self._buffer.pop(0)
+            # Sobrescreve a leitura mais antiga se buffer cheio
+            index = self._ring.append((
+                ts,
+                reading.strain_value,
+                reading.raw_adc_value,
+                reading.battery_level,
+                reading.temperature,
+                key
+            ))
+            self._positions[key].append(index)
+            self._compact_positions(key)
     
     def add_readings(self, readings: List[StrainReading]) -> None:
         """
@@ -66,13 +200,138 @@ class DataBuffer:
         Args:
             readings: Lista de leituras
         """
+        if readings:
+            self.add_batch(StrainBatch.from_readings(readings))
+    
+    def add_batch(self, batch: StrainBatch) -> None:
+        """
+        Adiciona um lote colunar ao buffer com uma aquisição de lock.
+        
+        As colunas são copiadas por fatia para o buffer circular; o custo
+        por leitura em Python se limita ao índice de posições quando o
+        lote mistura sensores.
+        
+        Args:
+            batch: Lote de leituras
+        """
+        count = len(batch)
+        if not count:
+            return
+        
+        timestamps = batch.timestamps_us
+        with self._lock:
+            local = [self._sensor_key(name) for name in batch.sensor_names]
+            if len(local) == 1:
+                key = local[0]
+                keys = array('H', [key]) * count
+                self._track_batch_order(key, timestamps)
+            else:
+                keys = array('H', [local[k] for k in batch.sensor_keys])
+                for key, ts in zip(keys, timestamps):
+                    self._track_order(key, ts)
+            
+            start = self._ring.extend((
+                timestamps,
+                batch.strain_values,
+                batch.raw_adc_values,
+                batch.battery_levels,
+                batch.temperatures,
+                keys
+            ))
+            
+            if len(local) == 1:
+                self._positions[key].extend(range(start, start + count))
+            else:
+                positions = self._positions
+                for offset, key in enumerate(keys):
+                    positions[key].append(start + offset)
+            for key in set(local):
+                self._compact_positions(key)
+    
+    def _track_batch_order(self, key: int, timestamps) -> None:
+        """Atualiza flags de ordenação para um lote de um sensor (chamar com lock)."""
+        values = timestamps.tolist() if isinstance(timestamps, array) else list(timestamps)
+        if values != sorted(values):
+            for ts in values:
+                self._track_order(key, ts)
+            return
+        self._track_order(key, values[0])
+        self._track_order(key, values[-1])
+    
+    def query(self, sensor_id: Optional[str] = None,
+              start_time: Optional[Union[datetime, int]] = None,
+              end_time: Optional[Union[datetime, int]] = None,
+              max_count: Optional[int] = None,
+              earliest: bool = False) -> ReadingColumns:
+        """
+        Consulta leituras do buffer retornando colunas tipadas.
+        
+        Args:
+            sensor_id: Filtrar por ID do sensor
+            start_time: Tempo inicial (datetime ou µs, inclusivo)
+            end_time: Tempo final (datetime ou µs, inclusivo)
+            max_count: Número máximo de leituras (as mais recentes)
+            earliest: Se True, max_count mantém as mais antigas
+            
+        Returns:
+            Colunas das leituras ordenadas por timestamp
+        """
+        start_us = _bound_us(start_time)
+        end_us = _bound_us(end_time)
+        
         with self._lock:
-            self._buffer.extend(readings)
+            ring = self._ring
+            names = list(self._sensor_names)
             
-            # Remove dados antigos se necessário
-            if len(self._buffer) > self._max_size:
-                excess = len(self._buffer) - self._max_size
-                self._buffer = self._buffer[excess:]
+            if sensor_id is None:
+                if self._ordered:
+                    low = ring.first_index
+                    high = ring.end_index
+                    if start_us is not None:
+                        low = ring.search('timestamp_us', start_us)
+                    if end_us is not None:
+                        high = ring.search('timestamp_us', end_us, right=True)
+                    low, high = _limit_range(low, high, max_count, earliest)
+                    return self._window(low, high, names)
+                indices = range(ring.first_index, ring.end_index)
+            else:
+                key = self._sensor_keys.get(sensor_id)
+                if key is None:
+                    return self._gather([], names)
+                positions = self._positions[key]
+                first = bisect_left(positions, ring.first_index)
+                if self._sensor_ordered[key]:
+                    low, high = first, len(positions)
+                    if start_us is not None:
+                        low = search_indices(positions, ring, 'timestamp_us', start_us, low=low)
+                    if end_us is not None:
+                        high = search_indices(positions, ring, 'timestamp_us', end_us,
+                                              right=True, low=low)
+                    low, high = _limit_range(low, high, max_count, earliest)
+                    return self._gather(positions[low:high], names)
+                indices = positions[first:]
+            
+            # Chegada fora de ordem: filtra e ordena por timestamp
+            timestamps = [ring.value('timestamp_us', i) for i in indices]
+            selected = sorted(
+                (ts, i) for ts, i in zip(timestamps, indices)
+                if (start_us is None or ts >= start_us) and (end_us is None or ts <= end_us)
+            )
+            if max_count and len(selected) > max_count:
+                selected = selected[:max_count] if earliest else selected[-max_count:]
+            return self._gather([i for _, i in selected], names)
+    
+    def _window(self, low: int, high: int, names: List[str]) -> ReadingColumns:
+        """Colunas de uma janela contígua, sem cópia (chamar com lock)."""
+        ring = self._ring
+        return ReadingColumns(*(ring.view(name, low, high) for name, _ in self.COLUMNS),
+                              sensor_names=names)
+    
+    def _gather(self, indices, names: List[str]) -> ReadingColumns:
+        """Colunas copiadas de índices arbitrários (chamar com lock)."""
+        ring = self._ring
+        return ReadingColumns(*(ring.gather(name, indices) for name, _ in self.COLUMNS),
+                              sensor_names=names)
     
     def get_readings(self, sensor_id: Optional[str] = None,
                     start_time: Optional[datetime] = None,
@@ -90,27 +349,7 @@ class DataBuffer:
         Returns:
             Lista de leituras filtradas
         """
-        with self._lock:
-            readings = self._buffer.copy()
-        
-        # Aplica filtros
-        if sensor_id:
-            readings = [r for r in readings if r.sensor_id == sensor_id]
-        
-        if start_time:
-            readings = [r for r in readings if r.timestamp >= start_time]
-        
-        if end_time:
-            readings = [r for r in readings if r.timestamp <= end_time]
-        
-        # Ordena por timestamp
-        readings.sort(key=lambda r: r.timestamp)
-        
-        # Limita quantidade se especificado
-        if max_count and len(readings) > max_count:
-            readings = readings[-max_count:]  # Pega os mais recentes
-        
-        return readings
+        return self.query(sensor_id, start_time, end_time, max_count).to_readings()
     
     def get_latest_reading(self, sensor_id: Optional[str] = None) -> Optional[StrainReading]:
         """
@@ -122,24 +361,63 @@ class DataBuffer:
         Returns:
             Leitura mais recente ou None
         """
-        readings = self.get_readings(sensor_id=sensor_id, max_count=1)
+        readings = self.query(sensor_id=sensor_id, max_count=1).to_readings()
         return readings[0] if readings else None
     
+    def drain(self) -> ReadingColumns:
+        """
+        Retira atomicamente todas as leituras do buffer.
+        
+        A cópia e a limpeza ocorrem sob o mesmo lock, de modo que nenhuma
+        leitura que chegue durante o flush é perdida. As colunas retornadas
+        são independentes do buffer, na ordem de chegada.
+        
+        Returns:
+            Colunas com as leituras retiradas
+        """
+        with self._lock:
+            ring = self._ring
+            start, end = ring.first_index, ring.end_index
+            columns = ReadingColumns(*(ring.copy(name, start, end) for name, _ in self.COLUMNS),
+                                     sensor_names=list(self._sensor_names))
+            self._clear_locked()
+            self._last_flush = datetime.now()
+            return columns
+    
     def clear(self) -> None:
         """Limpa todo o buffer."""
         with self._lock:
-            self._buffer.clear()
+            self._clear_locked()
+    
+    def _clear_locked(self) -> None:
+        """Limpa o buffer mantendo a numeração absoluta (chamar com lock)."""
+        self._ring.discard_all()
+        for positions in self._positions:
+            del positions[:]
+        self._ordered = True
+        self._last_ts = None
+        self._sensor_ordered = [True] * len(self._sensor_names)
+        self._sensor_last_ts = [None] * len(self._sensor_names)
     
     def size(self) -> int:
         """Retorna tamanho atual do buffer."""
         with self._lock:
-            return len(self._buffer)
+            return len(self._ring)
+    
+    @property
+    def capacity(self) -> int:
+        """Número máximo de leituras retidas."""
+        return self._max_size
+    
+    def memory_bytes(self) -> int:
+        """Memória alocada pelas colunas do buffer (bytes)."""
+        return self._ring.nbytes
     
     def should_flush(self) -> bool:
         """Verifica se é hora de fazer flush do buffer."""
         return (
-            len(self._buffer) >= self._max_size or
-            (datetime.now() - self._last_flush).seconds >= self._flush_interval
+            len(self._ring) >= self._flush_size or
+            (datetime.now() - self._last_flush).total_seconds() >= self._flush_interval
         )
     
     def mark_flushed(self) -> None:
@@ -153,45 +431,126 @@ class DatabaseManager:
     
     Armazena dados de forma persistente para análise posterior
     e recuperação em caso de falhas.
+    
+    Schema v3 (PRAGMA user_version = 3):
+    - banco principal: dicionário de sensores (sensor_id -> sensor_key),
+      informações/configurações de sensores e catálogo de partições
+    - um arquivo por dia (UTC) com a tabela readings WITHOUT ROWID agrupada
+      por (sensor_key, ts_ms), timestamps em milissegundos inteiros
+      (ver partitions.PartitionRouter)
+    
+    Leituras de versões anteriores (strain_readings v1, readings v2 no
+    banco principal) são migradas em lotes por um thread em segundo plano;
+    enquanto a migração não termina, as consultas também leem essas linhas.
     """
     
-    def __init__(self, db_path: Optional[Path] = None):
+    SCHEMA_VERSION = 3
+    MIGRATION_BATCH_SIZE = 20000
+    
+    # Tabelas de leituras de versões anteriores, na ordem de migração
+    LEGACY_TABLES = ('strain_readings', 'readings')
+    
+    # Rollups mantidos no banco principal (o de 1 s fica nas partições)
+    MAIN_ROLLUPS = ('1m', '1h')
+    
+    # Ajustes de conexão: WAL permite leitura concorrente com o writer
+    CONNECTION_PRAGMAS = (
+        "PRAGMA journal_mode=WAL",
+        "PRAGMA synchronous=NORMAL",
+        "PRAGMA cache_size=-16384",      # 16 MB
+        "PRAGMA temp_store=MEMORY",
+        "PRAGMA wal_autocheckpoint=4000"
+    )
+    
+    # Partições são muitas: cache menor por conexão
+    PARTITION_PRAGMAS = (
+        "PRAGMA journal_mode=WAL",
+        "PRAGMA synchronous=NORMAL",
+        "PRAGMA cache_size=-4096",       # 4 MB
+        "PRAGMA temp_store=MEMORY"
+    )
+    
+    def __init__(self, db_path: Optional[Path] = None, migrate_in_background: bool = True):
         """
         Inicializa o gerenciador de banco de dados.
         
         Args:
             db_path: Caminho para o arquivo do banco
+            migrate_in_background: Migra schemas anteriores em thread separado (False = bloqueante)
         """
         if db_path is None:
             db_path = get_data_file_path("daq_data.db")
         
-        self._db_path = db_path
-        self._connection = None
+        self._db_path = Path(db_path)
+        self._local = threading.local()
+        self._connections: List[sqlite3.Connection] = []
         self._lock = threading.Lock()
+        self._sensor_cache: Dict[str, int] = {}
+        self._sensor_names: Dict[int, str] = {}
+        
+        # Tabelas de versões anteriores ainda não migradas
+        self._legacy_tables: List[str] = []
+        self._migration_thread = None
+        self._closing = False
         
         self._init_database()
+        
+        # Leituras e rollup de 1 s ficam na partição do dia
+        self.partitions = PartitionRouter(
+            self._db_path.parent / f"{self._db_path.stem}_partitions",
+            catalog=self._get_connection,
+            pragmas=self.PARTITION_PRAGMAS,
+            schema=(READINGS_SCHEMA, rollups.rollup_schema('1s'))
+        )
+        
+        # Gravação interrompida entre partição e catálogo: refaz contagens e rollups
+        for day in self.partitions.stale_days():
+            print(f"Reconstruindo rollups da partição {self.partitions.file_name(day)}")
+            self.partitions.resync(day, self._rebuild_main_rollups)
+        
+        if self._legacy_tables:
+            if migrate_in_background:
+                self._migration_thread = threading.Thread(
+                    target=self._migrate_legacy, name="daq-schema-migration", daemon=True
+                )
+                self._migration_thread.start()
+            else:
+                self._migrate_legacy()
+    
+    @property
+    def db_path(self) -> Path:
+        """Caminho do banco principal."""
+        return self._db_path
+    
+    @property
+    def _legacy_pending(self) -> bool:
+        return bool(self._legacy_tables)
     
     def _init_database(self) -> None:
-        """Inicializa o banco de dados e cria tabelas."""
+        """Inicializa o banco de dados, verifica a versão e cria tabelas."""
         try:
             with self._get_connection() as conn:
                 cursor = conn.cursor()
                 
-                # Tabela de leituras de strain
+                version = cursor.execute("PRAGMA user_version").fetchone()[0]
+                if version > self.SCHEMA_VERSION:
+                    raise DataStorageError(
+                        f"Versão do banco ({version}) mais nova que a suportada "
+                        f"({self.SCHEMA_VERSION})"
+                    )
+                
+                # Dicionário de sensores
                 cursor.execute("""
-                    CREATE TABLE IF NOT EXISTS strain_readings (
-                        id INTEGER PRIMARY KEY AUTOINCREMENT,
-                        timestamp REAL NOT NULL,
-                        strain_value REAL NOT NULL,
-                        raw_adc_value INTEGER NOT NULL,
-                        sensor_id TEXT NOT NULL,
-                        battery_level INTEGER NOT NULL,
-                        temperature REAL NOT NULL,
-                        checksum TEXT,
-                        created_at REAL DEFAULT (datetime('now'))
+                    CREATE TABLE IF NOT EXISTS sensors (
+                        sensor_key INTEGER PRIMARY KEY,
+                        sensor_id TEXT NOT NULL UNIQUE
                     )
                 """)
                 
+                # Rollups de 1 min e 1 h (o de 1 s fica em cada partição)
+                for resolution in self.MAIN_ROLLUPS:
+                    cursor.execute(rollups.rollup_schema(resolution))
+                
                 # Tabela de informações de sensores
                 cursor.execute("""
                     CREATE TABLE IF NOT EXISTS sensor_info (
@@ -222,34 +581,72 @@ class DatabaseManager:
                     )
                 """)
                 
-                # Índices para performance
-                cursor.execute("""
-                    CREATE INDEX IF NOT EXISTS idx_readings_timestamp 
-                    ON strain_readings(timestamp)
-                """)
+                # Leituras de versões anteriores ainda não migradas
+                existing = {row[0] for row in cursor.execute(
+                    "SELECT name FROM sqlite_master WHERE type = 'table'"
+                )}
+                self._legacy_tables = [t for t in self.LEGACY_TABLES if t in existing]
                 
-                cursor.execute("""
-                    CREATE INDEX IF NOT EXISTS idx_readings_sensor 
-                    ON strain_readings(sensor_id)
-                """)
+                if not self._legacy_tables:
+                    cursor.execute(f"PRAGMA user_version = {self.SCHEMA_VERSION}")
                 
                 conn.commit()
                 
+                self._load_sensors(conn)
+                
+        except DataStorageError:
+            raise
         except Exception as e:
             raise DataStorageError(f"Erro ao inicializar banco: {e}")
     
     def _get_connection(self) -> sqlite3.Connection:
-        """Retorna conexão thread-safe com o banco."""
-        with self._lock:
-            if self._connection is None:
-                self._connection = sqlite3.connect(
-                    str(self._db_path),
-                    check_same_thread=False,
-                    timeout=30.0
-                )
-                self._connection.row_factory = sqlite3.Row
+        """Retorna conexão do thread atual (uma por thread, em modo WAL)."""
+        conn = getattr(self._local, 'connection', None)
+        if conn is None:
+            conn = sqlite3.connect(
+                str(self._db_path),
+                check_same_thread=False,
+                timeout=30.0
+            )
+            conn.row_factory = sqlite3.Row
+            for pragma in self.CONNECTION_PRAGMAS:
+                conn.execute(pragma)
+            self._local.connection = conn
+            with self._lock:
+                self._connections.append(conn)
         
-        return self._connection
+        return conn
+    
+    def _load_sensors(self, conn: sqlite3.Connection) -> None:
+        """Recarrega o dicionário de sensores do banco."""
+        rows = conn.execute("SELECT sensor_key, sensor_id FROM sensors").fetchall()
+        self._sensor_cache = {row['sensor_id']: row['sensor_key'] for row in rows}
+        self._sensor_names = {row['sensor_key']: row['sensor_id'] for row in rows}
+    
+    def _sensor_keys(self, conn: sqlite3.Connection, sensor_ids) -> Dict[str, int]:
+        """Retorna (criando se necessário) as chaves inteiras dos sensores."""
+        missing = [sid for sid in set(sensor_ids) if sid not in self._sensor_cache]
+        if missing:
+            with conn:
+                conn.executemany(
+                    "INSERT OR IGNORE INTO sensors (sensor_id) VALUES (?)",
+                    [(sid,) for sid in missing]
+                )
+            self._load_sensors(conn)
+        return self._sensor_cache
+    
+    def _sensor_name(self, conn: sqlite3.Connection, key: int) -> str:
+        """Retorna sensor_id de uma chave (recarrega se desconhecida)."""
+        name = self._sensor_names.get(key)
+        if name is None:
+            self._load_sensors(conn)
+            name = self._sensor_names.get(key, str(key))
+        return name
+    
+    @staticmethod
+    def _to_ms(value: datetime) -> int:
+        """Converte datetime para milissegundos inteiros desde epoch."""
+        return round(value.timestamp() * 1000)
     
     def store_reading(self, reading: StrainReading) -> None:
         """
@@ -259,30 +656,15 @@ class DatabaseManager:
             reading: Leitura a ser armazenada
         """
         try:
-            with self._get_connection() as conn:
-                cursor = conn.cursor()
-                cursor.execute("""
-                    INSERT INTO strain_readings 
-                    (timestamp, strain_value, raw_adc_value, sensor_id, 
-                     battery_level, temperature, checksum)
-                    VALUES (?, ?, ?, ?, ?, ?, ?)
-                """, (
-                    reading.timestamp.timestamp(),
-                    reading.strain_value,
-                    reading.raw_adc_value,
-                    reading.sensor_id,
-                    reading.battery_level,
-                    reading.temperature,
-                    reading.checksum
-                ))
-                conn.commit()
-                
-        except Exception as e:
+            self.store_readings([reading])
+        except DataStorageError as e:
             raise DataStorageError(f"Erro ao armazenar leitura: {e}")
     
     def store_readings(self, readings: List[StrainReading]) -> None:
         """
-        Armazena múltiplas leituras em lote.
+        Armazena múltiplas leituras em lote na partição de cada dia.
+        
+        Leituras do mesmo sensor no mesmo milissegundo substituem a anterior.
         
         Args:
             readings: Lista de leituras
@@ -291,34 +673,126 @@ class DatabaseManager:
             return
         
         try:
-            with self._get_connection() as conn:
-                cursor = conn.cursor()
-                
-                data = [
-                    (
-                        r.timestamp.timestamp(),
-                        r.strain_value,
-                        r.raw_adc_value,
-                        r.sensor_id,
-                        r.battery_level,
-                        r.temperature,
-                        r.checksum
-                    )
-                    for r in readings
-                ]
-                
-                cursor.executemany("""
-                    INSERT INTO strain_readings 
-                    (timestamp, strain_value, raw_adc_value, sensor_id, 
-                     battery_level, temperature, checksum)
-                    VALUES (?, ?, ?, ?, ?, ?, ?)
-                """, data)
+            keys = self._sensor_keys(self._get_connection(), (r.sensor_id for r in readings))
+            
+            self._write_rows([
+                (
+                    keys[r.sensor_id],
+                    (r.timestamp_us + 500) // 1000,
+                    r.strain_value,
+                    r.raw_adc_value,
+                    r.battery_level,
+                    r.temperature
+                )
+                for r in readings
+            ])
                 
-                conn.commit()
+        except Exception as e:
+            raise DataStorageError(f"Erro ao armazenar leituras: {e}")
+    
+    def store_batches(self, batches: List[StrainBatch]) -> None:
+        """
+        Armazena lotes colunares em uma transação, sem criar StrainReading.
+        
+        Args:
+            batches: Lotes de leituras
+        """
+        batches = [batch for batch in batches if len(batch)]
+        if not batches:
+            return
+        
+        try:
+            keys = self._sensor_keys(self._get_connection(),
+                                     {name for batch in batches for name in batch.sensor_names})
+            rows: List[tuple] = []
+            for batch in batches:
+                local = [keys[name] for name in batch.sensor_names]
+                sensor_keys = (repeat(local[0], len(batch)) if len(local) == 1
+                               else map(local.__getitem__, batch.sensor_keys))
+                rows.extend(zip(
+                    sensor_keys,
+                    [(ts + 500) // 1000 for ts in batch.timestamps_us],
+                    batch.strain_values,
+                    batch.raw_adc_values,
+                    batch.battery_levels,
+                    batch.temperatures
+                ))
+            self._write_rows(rows)
                 
         except Exception as e:
             raise DataStorageError(f"Erro ao armazenar leituras: {e}")
     
+    def _write_rows(self, rows: List[tuple], replace: bool = True) -> None:
+        """
+        Grava linhas nas partições e atualiza os rollups.
+        
+        O rollup de 1 s é atualizado na mesma transação da partição e os de
+        1 min e 1 h na mesma transação do catálogo (ver PartitionRouter).
+        No caso comum os agregados do lote são somados aos buckets; se o
+        lote substitui leituras já gravadas (replay, mesmo sensor e ms), os
+        buckets tocados são recalculados a partir das leituras (1 s) e do
+        rollup de 1 s (1 min e 1 h), sem contar a leitura antiga.
+        """
+        started = time.perf_counter()
+        deltas: Dict[int, Dict[Tuple[int, int], list]] = {}
+        
+        def update_seconds(conn, day, day_rows, replaced):
+            if replaced:
+                query = f"INSERT OR REPLACE INTO {rollups.table_name('1s')} " + \
+                        rollups.recompute_sql('readings', rollups.RESOLUTION_MS['1s'])
+                for span in rollups.key_spans(day_rows, rollups.RESOLUTION_MS['1s']):
+                    conn.execute(query, span)
+                return
+            seconds = deltas[day] = rollups.aggregate_rows(day_rows, rollups.RESOLUTION_MS['1s'])
+            conn.executemany(rollups.upsert_sql('1s'), rollups.to_rows(seconds))
+        
+        def update_main(conn, day, day_rows, replaced):
+            if replaced:
+                source = self.partitions.connection(day)
+                for resolution in self.MAIN_ROLLUPS:
+                    width = rollups.RESOLUTION_MS[resolution]
+                    query = rollups.recompute_sql(rollups.table_name('1s'), width)
+                    for span in rollups.key_spans(day_rows, width):
+                        conn.executemany(rollups.replace_sql(resolution),
+                                         [tuple(row) for row in source.execute(query, span)])
+                return
+            minutes = rollups.coarsen(deltas.pop(day), rollups.RESOLUTION_MS['1m'])
+            hours = rollups.coarsen(minutes, rollups.RESOLUTION_MS['1h'])
+            conn.executemany(rollups.upsert_sql('1m'), rollups.to_rows(minutes))
+            conn.executemany(rollups.upsert_sql('1h'), rollups.to_rows(hours))
+        
+        self.partitions.insert(rows, replace=replace, on_day=update_seconds,
+                               on_catalog=update_main)
+        
+        _SQLITE_COMMIT.observe(time.perf_counter() - started)
+        _SQLITE_ROWS.inc(len(rows))
+    
+    def _rebuild_main_rollups(self, conn: sqlite3.Connection, day: int) -> None:
+        """Recalcula os rollups de 1 min e 1 h de um dia a partir do rollup de 1 s."""
+        source = self.partitions.connection(day)
+        low, high = day * DAY_MS, (day + 1) * DAY_MS
+        for resolution in self.MAIN_ROLLUPS:
+            table = rollups.table_name(resolution)
+            query = rollups.recompute_sql(rollups.table_name('1s'),
+                                          rollups.RESOLUTION_MS[resolution], by_sensor=False)
+            conn.execute(f"DELETE FROM {table} WHERE bucket_ms >= ? AND bucket_ms < ?",
+                         (low, high))
+            conn.executemany(rollups.replace_sql(resolution),
+                             [tuple(row) for row in source.execute(query, (low, high))])
+    
+    def _key_filter(self, conn: sqlite3.Connection, sensor_id: Optional[str],
+                    column: str = "sensor_key"):
+        """Retorna cláusula e parâmetros de filtro por sensor_key."""
+        if sensor_id:
+            key = self._sensor_cache.get(sensor_id)
+            if key is None:
+                self._load_sensors(conn)
+                key = self._sensor_cache.get(sensor_id, -1)
+            return f"{column} = ?", [key]
+        # Lista explícita de chaves permite usar a chave primária por sensor
+        keys = sorted(self._sensor_names)
+        return f"{column} IN ({','.join('?' * len(keys)) or 'NULL'})", keys
+    
     def get_readings(self, sensor_id: Optional[str] = None,
                     start_time: Optional[datetime] = None,
                     end_time: Optional[datetime] = None,
@@ -326,6 +800,9 @@ class DatabaseManager:
         """
         Recupera leituras do banco com filtros.
         
+        Consulta apenas as partições que intersectam o intervalo, da mais
+        recente para a mais antiga, parando ao atingir o limite.
+        
         Args:
             sensor_id: ID do sensor
             start_time: Tempo inicial
@@ -333,53 +810,658 @@ class DatabaseManager:
             limit: Número máximo de registros
             
         Returns:
-            Lista de leituras
+            Lista de leituras (mais recentes primeiro)
         """
         try:
-            with self._get_connection() as conn:
-                cursor = conn.cursor()
+            conn = self._get_connection()
+            start_ms = self._to_ms(start_time) if start_time else None
+            end_ms = self._to_ms(end_time) if end_time else None
+            clause, key_params = self._key_filter(conn, sensor_id)
+            
+            query = f"""
+                SELECT sensor_key, ts_ms, strain_value, raw_adc_value,
+                       battery_level, temperature
+                FROM readings WHERE {clause}
+            """
+            params = list(key_params)
+            if start_ms is not None:
+                query += " AND ts_ms >= ?"
+                params.append(start_ms)
+            if end_ms is not None:
+                query += " AND ts_ms <= ?"
+                params.append(end_ms)
+            query += " ORDER BY ts_ms DESC"
+            if limit:
+                query += " LIMIT ?"
+            
+            rows = []
+            for day in self.partitions.days(start_ms, end_ms, descending=True):
+                remaining = limit - len(rows) if limit else None
+                day_params = params + [remaining] if limit else params
+                rows.extend(
+                    (row[1], self._sensor_name(conn, row[0])) + tuple(row[2:])
+                    for row in self.partitions.connection(day).execute(query, day_params)
+                )
+                if limit and len(rows) >= limit:
+                    break
+            
+            if self._legacy_tables:
+                rows = self._merge_legacy(conn, rows, sensor_id, start_ms, end_ms, limit)
+            
+            return [
+                StrainReading(
+                    timestamp=ts_ms * 1000,
+                    strain_value=strain_value,
+                    raw_adc_value=raw_adc_value,
+                    sensor_id=sid,
+                    battery_level=battery_level,
+                    temperature=temperature
+                )
+                for ts_ms, sid, strain_value, raw_adc_value, battery_level, temperature in rows
+            ]
                 
-                query = "SELECT * FROM strain_readings WHERE 1=1"
+        except Exception as e:
+            raise DataStorageError(f"Erro ao recuperar leituras: {e}")
+    
+    def _merge_legacy(self, conn: sqlite3.Connection, rows: List[tuple], sensor_id,
+                      start_ms, end_ms, limit) -> List[tuple]:
+        """Inclui linhas de versões anteriores ainda não migradas."""
+        for table in list(self._legacy_tables):
+            if table == 'strain_readings':
+                query = """
+                    SELECT CAST(round(timestamp * 1000) AS INTEGER), sensor_id, strain_value,
+                           raw_adc_value, battery_level, temperature
+                    FROM strain_readings WHERE 1=1
+                """
                 params = []
-                
                 if sensor_id:
                     query += " AND sensor_id = ?"
                     params.append(sensor_id)
+                time_column, scale = "timestamp", 1000.0
+            else:
+                clause, params = self._key_filter(conn, sensor_id)
+                query = f"""
+                    SELECT ts_ms, sensor_key, strain_value, raw_adc_value,
+                           battery_level, temperature
+                    FROM readings WHERE {clause}
+                """
+                time_column, scale = "ts_ms", 1
+            
+            if start_ms is not None:
+                query += f" AND {time_column} >= ?"
+                params.append(start_ms / scale)
+            if end_ms is not None:
+                query += f" AND {time_column} <= ?"
+                params.append(end_ms / scale)
+            query += f" ORDER BY {time_column} DESC"
+            if limit:
+                query += " LIMIT ?"
+                params.append(limit)
+            
+            try:
+                legacy_rows = conn.execute(query, params).fetchall()
+            except sqlite3.OperationalError:
+                # Tabela removida pela migração entre a verificação e a consulta
+                continue
+            
+            if table == 'readings':
+                legacy_rows = [
+                    (row[0], self._sensor_name(conn, row[1])) + tuple(row[2:])
+                    for row in legacy_rows
+                ]
+            rows.extend(tuple(row) for row in legacy_rows)
+        
+        rows.sort(key=lambda row: row[0], reverse=True)
+        return rows[:limit] if limit else rows
+
+    def iter_readings(self, sensor_id: Optional[str] = None,
+                      start_time: Optional[datetime] = None,
+                      end_time: Optional[datetime] = None,
+                      chunk_size: int = 10000) -> Iterator[ReadingColumns]:
+        """
+        Percorre leituras do banco em ordem cronológica, em blocos de colunas.
+
+        Cada partição é lida por um cursor por sensor, na ordem da chave
+        primária, e os cursores são intercalados por timestamp; assim nem o
+        SQLite (sem ORDER BY global) nem o Python materializam o intervalo
+        inteiro e a memória usada é O(chunk_size). Enquanto a migração de
+        versões anteriores não termina, as linhas das tabelas antigas são
+        intercaladas na consulta (ver iter_rows), sem esperar a migração.
+
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            start_time: Tempo inicial (inclusivo)
+            end_time: Tempo final (inclusivo)
+            chunk_size: Leituras por bloco
+
+        Yields:
+            ReadingColumns com até chunk_size leituras (sensor_keys indexa
+            sensor_names pela chave do banco)
+        """
+        if self._legacy_tables:
+            yield from self._iter_readings_with_legacy(sensor_id, start_time, end_time,
+                                                       chunk_size)
+            return
+
+        try:
+            conn = self._get_connection()
+            self._load_sensors(conn)
+            if sensor_id:
+                keys = [self._sensor_cache[sensor_id]] if sensor_id in self._sensor_cache else []
+            else:
+                keys = sorted(self._sensor_names)
+            if not keys:
+                return
+
+            names = [''] * (max(keys) + 1)
+            for key in keys:
+                names[key] = self._sensor_names[key]
+
+            start_ms = self._to_ms(start_time) if start_time else None
+            end_ms = self._to_ms(end_time) if end_time else None
+            query = """
+                SELECT sensor_key, ts_ms, strain_value, raw_adc_value,
+                       battery_level, temperature
+                FROM readings WHERE sensor_key = ?
+            """
+            params = []
+            if start_ms is not None:
+                query += " AND ts_ms >= ?"
+                params.append(start_ms)
+            if end_ms is not None:
+                query += " AND ts_ms <= ?"
+                params.append(end_ms)
+            query += " ORDER BY ts_ms"
+
+            for day in self.partitions.days(start_ms, end_ms):
+                day_conn = self.partitions.connection(day)
+                cursors = [self._cursor_rows(day_conn, query, [key] + params, chunk_size)
+                           for key in keys]
+                rows = cursors[0] if len(cursors) == 1 else heapq.merge(*cursors, key=itemgetter(1))
+
+                while True:
+                    batch = list(islice(rows, chunk_size))
+                    if not batch:
+                        break
+                    key_col, ts_col, strain_col, adc_col, battery_col, temp_col = zip(*batch)
+                    yield ReadingColumns(
+                        array('q', [ts * 1000 for ts in ts_col]),
+                        array('d', strain_col),
+                        array('i', adc_col),
+                        array('h', battery_col),
+                        array('d', temp_col),
+                        array('H', key_col),
+                        names
+                    )
+
+        except Exception as e:
+            raise DataStorageError(f"Erro ao percorrer leituras: {e}")
+
+    def _iter_readings_with_legacy(self, sensor_id: Optional[str],
+                                   start_time: Optional[datetime],
+                                   end_time: Optional[datetime],
+                                   chunk_size: int) -> Iterator[ReadingColumns]:
+        """iter_readings sobre partições e tabelas antigas (migração em andamento)."""
+        self._load_sensors(self._get_connection())
+        known = dict(self._sensor_cache)
+        rows = self.iter_rows(sensor_id,
+                              self._to_ms(start_time) if start_time else None,
+                              self._to_ms(end_time) if end_time else None,
+                              descending=False)
+        # Sensores só presentes no schema v1 ainda não têm chave: índices após as do banco
+        names = [''] * (max(self._sensor_names, default=0) + 1)
+        for key, name in self._sensor_names.items():
+            names[key] = name
+        indices: Dict[str, int] = {}
+        while True:
+            batch = list(islice(rows, chunk_size))
+            if not batch:
+                return
+            ts_col, sid_col, strain_col, adc_col, battery_col, temp_col = zip(*batch)
+            keys = array('H')
+            for sid in sid_col:
+                index = indices.get(sid)
+                if index is None:
+                    index = known.get(sid)
+                    if index is None:
+                        index = len(names)
+                        names.append(sid)
+                    indices[sid] = index
+                keys.append(index)
+            yield ReadingColumns(
+                array('q', [ts * 1000 for ts in ts_col]),
+                array('d', strain_col),
+                array('i', adc_col),
+                array('h', battery_col),
+                array('d', temp_col),
+                keys,
+                names
+            )
+
+    @staticmethod
+    def _cursor_rows(conn: sqlite3.Connection, query: str, params: list,
+                     chunk_size: int) -> Iterator[tuple]:
+        """Itera um cursor (linhas como tuplas) buscando chunk_size linhas por vez."""
+        cursor = conn.cursor()
+        cursor.row_factory = None
+        cursor.execute(query, params)
+        try:
+            while True:
+                batch = cursor.fetchmany(chunk_size)
+                if not batch:
+                    return
+                yield from batch
+        finally:
+            cursor.close()
+
+    def iter_rows(self, sensor_id: Optional[str] = None,
+                  start_ms: Optional[int] = None,
+                  end_ms: Optional[int] = None,
+                  descending: bool = True,
+                  limit: Optional[int] = None) -> Iterator[tuple]:
+        """
+        Percorre linhas ordenadas por (ts_ms, sensor_id), sob demanda.
+        
+        Cada partição é lida por um cursor por sensor na ordem da chave
+        primária, com o limite aplicado em cada cursor, e os cursores são
+        intercalados; as partições são visitadas na mesma ordem. As linhas
+        são buscadas em blocos crescentes, de modo que consumir N linhas
+        custa O(N) por sensor, independente do tamanho do intervalo.
+        
+        Enquanto a migração de versões anteriores não termina, as tabelas
+        antigas também são lidas por cursores por sensor e intercaladas com
+        as partições; uma linha que já foi copiada mas ainda não removida
+        aparece uma vez só (prevalece a da partição). Os cursores antigos
+        são abertos antes dos das partições: como a migração grava na
+        partição antes de remover da tabela antiga, nenhuma linha se perde
+        se um lote for migrado durante a consulta.
+        
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            start_ms: Tempo inicial em ms (inclusivo)
+            end_ms: Tempo final em ms (inclusivo)
+            descending: Se True, das mais recentes para as mais antigas
+            limit: Máximo de linhas por sensor consultadas em cada partição
+            
+        Yields:
+            (ts_ms, sensor_id, strain_value, raw_adc_value, battery_level,
+            temperature)
+        """
+        try:
+            conn = self._get_connection()
+            self._load_sensors(conn)
+            if sensor_id:
+                keys = [self._sensor_cache[sensor_id]] if sensor_id in self._sensor_cache else []
+            else:
+                keys = sorted(self._sensor_names)
+            
+            legacy = []
+            if self._legacy_tables:
+                legacy = self._legacy_cursors(conn, sensor_id, keys, start_ms, end_ms,
+                                              descending, limit)
+            rows = self._partition_rows(keys, start_ms, end_ms, descending, limit)
+            if legacy:
+                rows = self._unique_rows(heapq.merge(rows, *legacy, key=itemgetter(0, 1),
+                                                     reverse=descending))
+            yield from rows
+        
+        except Exception as e:
+            raise DataStorageError(f"Erro ao percorrer leituras: {e}")
+    
+    def _partition_rows(self, keys: List[int], start_ms: Optional[int],
+                        end_ms: Optional[int], descending: bool,
+                        limit: Optional[int]) -> Iterator[tuple]:
+        """Linhas das partições no formato de iter_rows (cursores abertos sob demanda)."""
+        if not keys:
+            return
+        
+        query = """
+            SELECT ts_ms, ?, strain_value, raw_adc_value, battery_level, temperature
+            FROM readings WHERE sensor_key = ?
+        """
+        params = []
+        if start_ms is not None:
+            query += " AND ts_ms >= ?"
+            params.append(start_ms)
+        if end_ms is not None:
+            query += " AND ts_ms <= ?"
+            params.append(end_ms)
+        query += " ORDER BY ts_ms DESC" if descending else " ORDER BY ts_ms"
+        if limit:
+            query += " LIMIT ?"
+            params.append(limit)
+        
+        for day in self.partitions.days(start_ms, end_ms, descending=descending):
+            day_conn = self.partitions.connection(day)
+            cursors = [self._growing_rows(day_conn, query,
+                                          [self._sensor_names[key], key] + params)
+                       for key in keys]
+            if len(cursors) == 1:
+                yield from cursors[0]
+            else:
+                yield from heapq.merge(*cursors, key=itemgetter(0, 1), reverse=descending)
+    
+    def _legacy_cursors(self, conn: sqlite3.Connection, sensor_id: Optional[str],
+                        keys: List[int], start_ms: Optional[int], end_ms: Optional[int],
+                        descending: bool, limit: Optional[int]) -> List[Iterator[tuple]]:
+        """
+        Abre cursores por sensor sobre as tabelas ainda não migradas.
+        
+        As consultas são executadas aqui (não sob demanda), antes das
+        partições; tabelas já removidas pela migração são ignoradas.
+        
+        Returns:
+            Iteradores de linhas no formato de iter_rows
+        """
+        cursors = []
+        for table in list(self._legacy_tables):
+            try:
+                if table == 'strain_readings':
+                    query = """
+                        SELECT CAST(round(timestamp * 1000) AS INTEGER), sensor_id, strain_value,
+                               raw_adc_value, battery_level, temperature
+                        FROM strain_readings WHERE sensor_id = ?
+                    """
+                    names = [sensor_id] if sensor_id else [
+                        row[0] for row in conn.execute("SELECT DISTINCT sensor_id FROM strain_readings")
+                    ]
+                    targets = [[name] for name in names]
+                    time_column, scale = "timestamp", 1000.0
+                else:
+                    query = """
+                        SELECT ts_ms, ?, strain_value, raw_adc_value, battery_level, temperature
+                        FROM readings WHERE sensor_key = ?
+                    """
+                    targets = [[self._sensor_names[key], key] for key in keys]
+                    time_column, scale = "ts_ms", 1
                 
-                if start_time:
-                    query += " AND timestamp >= ?"
-                    params.append(start_time.timestamp())
-                
-                if end_time:
-                    query += " AND timestamp <= ?"
-                    params.append(end_time.timestamp())
-                
-                query += " ORDER BY timestamp DESC"
-                
+                params = []
+                if start_ms is not None:
+                    query += f" AND {time_column} >= ?"
+                    params.append(start_ms / scale)
+                if end_ms is not None:
+                    query += f" AND {time_column} <= ?"
+                    params.append(end_ms / scale)
+                query += f" ORDER BY {time_column} DESC" if descending else f" ORDER BY {time_column}"
                 if limit:
                     query += " LIMIT ?"
                     params.append(limit)
                 
-                cursor.execute(query, params)
-                rows = cursor.fetchall()
-                
-                readings = []
-                for row in rows:
-                    reading = StrainReading(
-                        timestamp=datetime.fromtimestamp(row['timestamp']),
-                        strain_value=row['strain_value'],
-                        raw_adc_value=row['raw_adc_value'],
-                        sensor_id=row['sensor_id'],
-                        battery_level=row['battery_level'],
-                        temperature=row['temperature'],
-                        checksum=row['checksum']
-                    )
-                    readings.append(reading)
-                
-                return readings
+                for target in targets:
+                    cursor = conn.cursor()
+                    cursor.row_factory = None
+                    cursor.execute(query, target + params)
+                    cursors.append(self._fetch_rows(cursor))
+            except sqlite3.OperationalError:
+                # Tabela removida pela migração entre a verificação e a consulta
+                continue
+        return cursors
+    
+    @staticmethod
+    def _fetch_rows(cursor: sqlite3.Cursor, size: int = 1024) -> Iterator[tuple]:
+        """Itera um cursor já executado, fechando-o ao final."""
+        try:
+            while True:
+                batch = cursor.fetchmany(size)
+                if not batch:
+                    return
+                yield from batch
+        finally:
+            cursor.close()
+    
+    @staticmethod
+    def _unique_rows(rows: Iterator[tuple]) -> Iterator[tuple]:
+        """Descarta linhas repetidas (mesmo ts_ms e sensor) adjacentes."""
+        previous = None
+        for row in rows:
+            key = (row[0], row[1])
+            if key != previous:
+                previous = key
+                yield row
+    
+    @staticmethod
+    def _growing_rows(conn: sqlite3.Connection, query: str, params: list,
+                      first: int = 16, maximum: int = 4096) -> Iterator[tuple]:
+        """Itera um cursor em blocos que dobram de tamanho (de first até maximum)."""
+        cursor = conn.cursor()
+        cursor.row_factory = None
+        cursor.execute(query, params)
+        size = first
+        try:
+            while True:
+                batch = cursor.fetchmany(size)
+                if not batch:
+                    return
+                yield from batch
+                size = min(size * 2, maximum)
+        finally:
+            cursor.close()
+    
+    def _migrate_legacy(self) -> None:
+        """
+        Migra leituras de versões anteriores para as partições diárias, em lotes.
+        
+        Cada lote é gravado nas partições (ignorando chaves já existentes) e
+        depois removido da tabela antiga, de modo que a migração pode ser
+        interrompida e retomada sem duplicar dados. Ao final remove as
+        tabelas antigas e grava user_version = 3.
+        """
+        try:
+            conn = self._get_connection()
+            for table in list(self._legacy_tables):
+                while not self._closing:
+                    if table == 'strain_readings':
+                        batch = conn.execute("""
+                            SELECT id, timestamp, strain_value, raw_adc_value, sensor_id,
+                                   battery_level, temperature
+                            FROM strain_readings ORDER BY id LIMIT ?
+                        """, (self.MIGRATION_BATCH_SIZE,)).fetchall()
+                        if batch:
+                            keys = self._sensor_keys(conn, (row['sensor_id'] for row in batch))
+                            rows = [
+                                (
+                                    keys[row['sensor_id']],
+                                    round(row['timestamp'] * 1000),
+                                    row['strain_value'],
+                                    row['raw_adc_value'],
+                                    row['battery_level'],
+                                    row['temperature']
+                                )
+                                for row in batch
+                            ]
+                            delete = ("DELETE FROM strain_readings WHERE id <= ?",
+                                      (batch[-1]['id'],))
+                    else:
+                        batch = conn.execute("""
+                            SELECT sensor_key, ts_ms, strain_value, raw_adc_value,
+                                   battery_level, temperature
+                            FROM readings ORDER BY sensor_key, ts_ms LIMIT ?
+                        """, (self.MIGRATION_BATCH_SIZE,)).fetchall()
+                        if batch:
+                            rows = [tuple(row) for row in batch]
+                            last_key, last_ts = rows[-1][0], rows[-1][1]
+                            delete = ("""
+                                DELETE FROM readings
+                                WHERE sensor_key < ? OR (sensor_key = ? AND ts_ms <= ?)
+                            """, (last_key, last_key, last_ts))
+                    
+                    if not batch:
+                        with conn:
+                            if table == 'strain_readings':
+                                conn.execute("DROP INDEX IF EXISTS idx_readings_timestamp")
+                                conn.execute("DROP INDEX IF EXISTS idx_readings_sensor")
+                            conn.execute(f"DROP TABLE {table}")
+                        self._legacy_tables.remove(table)
+                        break
+                    
+                    # Dados já gravados nas partições (mais recentes) têm prioridade
+                    self._write_rows(rows, replace=False)
+                    with conn:
+                        conn.execute(*delete)
+            
+            if not self._legacy_tables:
+                conn.execute(f"PRAGMA user_version = {self.SCHEMA_VERSION}")
+                # Devolve ao sistema de arquivos o espaço das tabelas antigas
+                conn.execute("VACUUM")
                 
         except Exception as e:
-            raise DataStorageError(f"Erro ao recuperar leituras: {e}")
+            print(f"Erro na migração do banco para o schema v{self.SCHEMA_VERSION}: {e}")
+    
+    def _aggregate_query(self, conn: sqlite3.Connection, table: str, key_clause: str,
+                         key_params: list, start_ms: int, end_ms: int) -> List[tuple]:
+        """Agrega por sensor um intervalo [start_ms, end_ms) de uma tabela."""
+        if table == 'readings':
+            query = f"""
+                SELECT sensor_key, count(*), min(strain_value), max(strain_value),
+                       total(strain_value), total(strain_value * strain_value),
+                       min(battery_level), max(battery_level),
+                       min(temperature), max(temperature), max(ts_ms)
+                FROM readings
+                WHERE {key_clause} AND ts_ms >= ? AND ts_ms < ?
+                GROUP BY sensor_key
+            """
+        else:
+            query = f"""
+                SELECT sensor_key, sum(count), min(min_value), max(max_value),
+                       total(sum_value), total(sum_squares),
+                       min(battery_min), max(battery_max),
+                       min(temperature_min), max(temperature_max), max(last_ts_ms)
+                FROM {table}
+                WHERE {key_clause} AND bucket_ms >= ? AND bucket_ms < ?
+                GROUP BY sensor_key
+            """
+        return conn.execute(query, key_params + [start_ms, end_ms]).fetchall()
+    
+    def _time_bounds(self) -> Optional[Tuple[int, int]]:
+        """Retorna (menor, maior) timestamp em ms registrados no catálogo."""
+        row = self._get_connection().execute(
+            "SELECT min(min_ts_ms), max(max_ts_ms) FROM partitions"
+        ).fetchone()
+        return None if row[0] is None else (row[0], row[1])
+    
+    def get_aggregates(self, sensor_id: Optional[str] = None,
+                       start_time: Optional[datetime] = None,
+                       end_time: Optional[datetime] = None) -> Dict[str, Dict[str, Any]]:
+        """
+        Calcula estatísticas por sensor em uma janela a partir dos rollups.
+        
+        O miolo da janela é coberto por buckets de 1 h, as bordas por
+        buckets de 1 min e 1 s e apenas frações de segundo nas pontas são
+        lidas das leituras brutas, de modo que o custo é O(buckets) e não
+        O(leituras). Leituras ainda em migração de versões anteriores não
+        são incluídas.
+        
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            start_time: Tempo inicial (inclusivo)
+            end_time: Tempo final (inclusivo)
+            
+        Returns:
+            Dict sensor_id -> estatísticas (ver rollups.summarize)
+        """
+        try:
+            conn = self._get_connection()
+            bounds = self._time_bounds()
+            if bounds is None:
+                return {}
+            
+            start_ms = self._to_ms(start_time) if start_time else bounds[0]
+            end_ms = (self._to_ms(end_time) if end_time else bounds[1]) + 1
+            key_clause, key_params = self._key_filter(conn, sensor_id)
+            
+            merged: Dict[int, list] = {}
+            for resolution, low, high in rollups.split_range(start_ms, end_ms):
+                if resolution in self.MAIN_ROLLUPS:
+                    sources = [(conn, rollups.table_name(resolution))]
+                else:
+                    table = 'readings' if resolution is None else rollups.table_name(resolution)
+                    sources = [
+                        (self.partitions.connection(day), table)
+                        for day in self.partitions.days(low, high - 1)
+                    ]
+                for source, table in sources:
+                    for row in self._aggregate_query(source, table, key_clause,
+                                                     key_params, low, high):
+                        merged[row[0]] = rollups.merge(merged.get(row[0]), row[1:])
+            
+            return {
+                self._sensor_name(conn, key): rollups.summarize(agg)
+                for key, agg in merged.items()
+            }
+            
+        except Exception as e:
+            raise DataStorageError(f"Erro ao calcular agregados: {e}")
+    
+    def get_rollups(self, resolution: str = '1m',
+                    sensor_id: Optional[str] = None,
+                    start_time: Optional[datetime] = None,
+                    end_time: Optional[datetime] = None) -> List[Dict[str, Any]]:
+        """
+        Retorna a série de buckets de uma resolução.
+        
+        Args:
+            resolution: '1s', '1m' ou '1h'
+            sensor_id: ID do sensor (None = todos)
+            start_time: Tempo inicial
+            end_time: Tempo final
+            
+        Returns:
+            Lista de buckets em ordem de tempo, com sensor_id e bucket_ms
+        """
+        if resolution not in rollups.RESOLUTION_MS:
+            raise ValueError(f"Resolução não suportada: {resolution}")
+        
+        try:
+            conn = self._get_connection()
+            width = rollups.RESOLUTION_MS[resolution]
+            start_ms = self._to_ms(start_time) // width * width if start_time else -2**62
+            end_ms = self._to_ms(end_time) + 1 if end_time else 2**62
+            key_clause, key_params = self._key_filter(conn, sensor_id)
+            
+            query = f"""
+                SELECT sensor_key, bucket_ms, {', '.join(rollups.AGGREGATE_COLUMNS)}
+                FROM {rollups.table_name(resolution)}
+                WHERE {key_clause} AND bucket_ms >= ? AND bucket_ms < ?
+            """
+            params = key_params + [start_ms, end_ms]
+            
+            if resolution in self.MAIN_ROLLUPS:
+                rows = conn.execute(query, params).fetchall()
+            else:
+                bounds = self._time_bounds()
+                if bounds is None:
+                    return []
+                rows = [
+                    row
+                    for day in self.partitions.days(max(start_ms, bounds[0]),
+                                                    min(end_ms - 1, bounds[1]))
+                    for row in self.partitions.connection(day).execute(query, params)
+                ]
+            
+            series = []
+            for row in sorted(rows, key=lambda r: (r[1], r[0])):
+                bucket = rollups.summarize(row[2:])
+                bucket['sensor_id'] = self._sensor_name(conn, row[0])
+                bucket['bucket_ms'] = row[1]
+                series.append(bucket)
+            return series
+            
+        except Exception as e:
+            raise DataStorageError(f"Erro ao consultar rollups: {e}")
+    
+    def wait_migration(self, timeout: Optional[float] = None) -> bool:
+        """
+        Aguarda o término da migração em segundo plano.
+        
+        Args:
+            timeout: Tempo máximo de espera em segundos
+            
+        Returns:
+            True se não há mais dados v1 pendentes
+        """
+        if self._migration_thread is not None:
+            self._migration_thread.join(timeout)
+        return not self._legacy_pending
     
     def store_sensor_info(self, sensor_info: SensorInfo) -> None:
         """
@@ -415,6 +1497,10 @@ class DatabaseManager:
         """
         Remove dados antigos do banco.
         
+        Remove partições diárias inteiras (arquivos), em tempo proporcional
+        ao número de partições e não ao volume de leituras. A retenção tem
+        granularidade de um dia.
+        
         Args:
             days: Número de dias para manter
             
@@ -423,249 +1509,876 @@ class DatabaseManager:
         """
         try:
             cutoff_time = datetime.now() - timedelta(days=days)
+            cutoff_ms = self._to_ms(cutoff_time)
+            deleted_count = self.partitions.drop_before(cutoff_ms)
             
+            # Rollups acompanham a retenção das partições (dias inteiros)
             with self._get_connection() as conn:
-                cursor = conn.cursor()
-                cursor.execute("""
-                    DELETE FROM strain_readings 
-                    WHERE timestamp < ?
-                """, (cutoff_time.timestamp(),))
-                
-                deleted_count = cursor.rowcount
-                conn.commit()
-                
-                return deleted_count
+                key_clause, key_params = self._key_filter(conn, None)
+                for resolution in self.MAIN_ROLLUPS:
+                    conn.execute(f"""
+                        DELETE FROM {rollups.table_name(resolution)}
+                        WHERE {key_clause} AND bucket_ms < ?
+                    """, key_params + [day_of(cutoff_ms) * DAY_MS])
+            
+            if 'strain_readings' in self._legacy_tables:
+                try:
+                    with self._get_connection() as conn:
+                        cursor = conn.execute("""
+                            DELETE FROM strain_readings 
+                            WHERE timestamp < ?
+                        """, (cutoff_time.timestamp(),))
+                        deleted_count += cursor.rowcount
+                except sqlite3.OperationalError:
+                    pass
+            
+            return deleted_count
                 
         except Exception as e:
             raise DataStorageError(f"Erro na limpeza: {e}")
     
     def close(self) -> None:
-        """Fecha conexão com o banco."""
+        """Fecha conexões com o banco e partições."""
+        self._closing = True
+        if self._migration_thread is not None:
+            self._migration_thread.join()
+        
+        self.partitions.close()
         with self._lock:
-            if self._connection:
-                self._connection.close()
-                self._connection = None
+            for conn in self._connections:
+                conn.close()
+            self._connections.clear()
+        self._local = threading.local()
 
 
 class DataExporter:
     """
     Exportador de dados para diferentes formatos.
     
-    Suporta exportação para CSV, JSON e Excel para análise externa.
+    Suporta exportação para CSV, JSON, JSON Lines e Excel para análise
+    externa e para Parquet/Arrow, que pandas e Polars carregam sem
+    reinterpretar texto. Os métodos aceitam uma lista de StrainReading ou
+    um iterável de blocos ReadingColumns (ver DatabaseManager.iter_readings)
+    e escrevem bloco a bloco, com memória constante. Saídas de texto são
+    comprimidas com gzip quando compression='gzip' ou o caminho termina
+    em '.gz'.
     """
     
+    CSV_HEADER = [
+        'timestamp',
+        'strain_value_microstrains',
+        'raw_adc_value',
+        'sensor_id',
+        'battery_level_percent',
+        'temperature_celsius',
+        'checksum'
+    ]
+    
+    EXCEL_HEADER = [
+        'Timestamp', 'Strain (µε)', 'Raw ADC', 'Sensor ID',
+        'Battery (%)', 'Temperature (°C)', 'Checksum'
+    ]
+    
+    # Linhas de dados por planilha do Excel (limite do formato menos o cabeçalho)
+    EXCEL_MAX_ROWS = 1_048_575
+    
+    SYSTEM_NAME = 'Sistema DAQ CNH Industrial'
+    
+    @staticmethod
+    def _iter_readings(source) -> Iterator[StrainReading]:
+        """Percorre leituras de uma lista ou de blocos ReadingColumns."""
+        for item in source:
+            if isinstance(item, ReadingColumns):
+                yield from item.to_readings()
+            else:
+                yield item
+    
+    @staticmethod
+    def _iter_columns(source, chunk_size: int = 10000) -> Iterator[ReadingColumns]:
+        """Percorre blocos de colunas de uma lista ou de blocos ReadingColumns."""
+        pending: List[StrainReading] = []
+        for item in source:
+            if isinstance(item, ReadingColumns):
+                if pending:
+                    yield ReadingColumns.from_readings(pending)
+                    pending = []
+                if len(item):
+                    yield item
+                continue
+            pending.append(item)
+            if len(pending) >= chunk_size:
+                yield ReadingColumns.from_readings(pending)
+                pending = []
+        if pending:
+            yield ReadingColumns.from_readings(pending)
+    
+    @staticmethod
+    def _summary(source, summary: Optional[Dict[str, Any]]) -> Dict[str, Any]:
+        """Retorna total e período das leituras (calculado se source é lista)."""
+        if summary is not None:
+            return summary
+        if isinstance(source, list) and (not source or isinstance(source[0], StrainReading)):
+            if not source:
+                return {'total_readings': 0}
+            return {
+                'total_readings': len(source),
+                'start': source[0].timestamp,
+                'end': source[-1].timestamp
+            }
+        return {}
+    
     @staticmethod
-    def export_to_csv(readings: List[StrainReading], 
+    def _open_text(output_path: Path, compression: Optional[str]):
+        """Abre arquivo de texto para escrita, com gzip se solicitado."""
+        if compression is None and str(output_path).endswith('.gz'):
+            compression = 'gzip'
+        if compression == 'gzip':
+            return gzip.open(output_path, 'wt', encoding='utf-8', newline='')
+        if compression is not None:
+            raise ValueError(f"Compressão não suportada: {compression}")
+        return open(output_path, 'w', encoding='utf-8', newline='')
+    
+    @staticmethod
+    def _reading_dict(reading: StrainReading) -> Dict[str, Any]:
+        """Representação JSON de uma leitura."""
+        return {
+            'timestamp': reading.timestamp.isoformat(),
+            'strain_value': reading.strain_value,
+            'raw_adc_value': reading.raw_adc_value,
+            'sensor_id': reading.sensor_id,
+            'battery_level': reading.battery_level,
+            'temperature': reading.temperature,
+            'checksum': reading.checksum
+        }
+    
+    @staticmethod
+    def export_to_csv(readings, 
                      output_path: Path,
-                     include_metadata: bool = True) -> None:
+                     include_metadata: bool = True,
+                     summary: Optional[Dict[str, Any]] = None,
+                     compression: Optional[str] = None) -> None:
         """
         Exporta leituras para arquivo CSV.
         
         Args:
-            readings: Lista de leituras
+            readings: Lista de leituras ou iterável de ReadingColumns
             output_path: Caminho do arquivo de saída
             include_metadata: Se incluir metadados no cabeçalho
+            summary: Total e período ('total_readings', 'start', 'end'); calculado se lista
+            compression: 'gzip' ou None (automático pela extensão .gz)
         """
         try:
-            with open(output_path, 'w', newline='', encoding='utf-8') as csvfile:
+            info = DataExporter._summary(readings, summary)
+            date_format = EXPORT_CONFIG['csv']['date_format']
+            
+            with DataExporter._open_text(output_path, compression) as csvfile:
                 writer = csv.writer(csvfile)
                 
                 # Cabeçalho com metadados
                 if include_metadata:
                     writer.writerow(['# Sistema DAQ - Dados de Deformação'])
                     writer.writerow([f'# Exportado em: {datetime.now().isoformat()}'])
-                    writer.writerow([f'# Total de leituras: {len(readings)}'])
-                    if readings:
-                        writer.writerow([f'# Período: {readings[0].timestamp} a {readings[-1].timestamp}'])
+                    if 'total_readings' in info:
+                        writer.writerow([f'# Total de leituras: {info["total_readings"]}'])
+                    if info.get('start') is not None:
+                        writer.writerow([f'# Período: {info["start"]} a {info["end"]}'])
                     writer.writerow(['#'])
                 
                 # Cabeçalho das colunas
-                writer.writerow([
-                    'timestamp',
-                    'strain_value_microstrains',
-                    'raw_adc_value',
-                    'sensor_id',
-                    'battery_level_percent',
-                    'temperature_celsius',
-                    'checksum'
-                ])
+                writer.writerow(DataExporter.CSV_HEADER)
                 
                 # Dados
-                for reading in readings:
-                    writer.writerow([
-                        reading.timestamp.strftime(EXPORT_CONFIG['csv']['date_format']),
+                writer.writerows(
+                    (
+                        reading.timestamp.strftime(date_format),
                         reading.strain_value,
                         reading.raw_adc_value,
                         reading.sensor_id,
                         reading.battery_level,
                         reading.temperature,
                         reading.checksum
-                    ])
+                    )
+                    for reading in DataExporter._iter_readings(readings)
+                )
                     
         except Exception as e:
             raise DataStorageError(f"Erro ao exportar CSV: {e}")
     
     @staticmethod
-    def export_to_json(readings: List[StrainReading], output_path: Path) -> None:
+    def export_to_json(readings, output_path: Path,
+                       summary: Optional[Dict[str, Any]] = None,
+                       compression: Optional[str] = None) -> None:
         """
         Exporta leituras para arquivo JSON.
         
+        O documento ({'metadata', 'readings'}) é escrito leitura a leitura,
+        sem montar a lista completa em memória.
+        
         Args:
-            readings: Lista de leituras
+            readings: Lista de leituras ou iterável de ReadingColumns
             output_path: Caminho do arquivo de saída
+            summary: Total e período; calculado se lista
+            compression: 'gzip' ou None (automático pela extensão .gz)
         """
         try:
-            data = {
-                'metadata': {
-                    'exported_at': datetime.now().isoformat(),
-                    'total_readings': len(readings),
-                    'system': 'Sistema DAQ CNH Industrial'
-                },
-                'readings': [
-                    {
-                        'timestamp': reading.timestamp.isoformat(),
-                        'strain_value': reading.strain_value,
-                        'raw_adc_value': reading.raw_adc_value,
-                        'sensor_id': reading.sensor_id,
-                        'battery_level': reading.battery_level,
-                        'temperature': reading.temperature,
-                        'checksum': reading.checksum
-                    }
-                    for reading in readings
-                ]
+            info = DataExporter._summary(readings, summary)
+            metadata = {
+                'exported_at': datetime.now().isoformat(),
+                'total_readings': info.get('total_readings'),
+                'system': DataExporter.SYSTEM_NAME
             }
+            options = dict(EXPORT_CONFIG['json'])
+            indent = options.pop('indent', None) or 0
+            pad = ' ' * indent
+            
+            with DataExporter._open_text(output_path, compression) as jsonfile:
+                jsonfile.write('{\n' + pad + '"metadata": ' +
+                               json.dumps(metadata, **options) + ',\n' +
+                               pad + '"readings": [')
+                separator = '\n' + pad * 2
+                for reading in DataExporter._iter_readings(readings):
+                    jsonfile.write(separator)
+                    jsonfile.write(json.dumps(DataExporter._reading_dict(reading), **options))
+                    separator = ',\n' + pad * 2
+                jsonfile.write('\n' + pad + ']\n}\n')
+                
+        except Exception as e:
+            raise DataStorageError(f"Erro ao exportar JSON: {e}")
+    
+    @staticmethod
+    def export_to_jsonl(readings, output_path: Path,
+                        compression: Optional[str] = None) -> None:
+        """
+        Exporta leituras para JSON Lines (um objeto por linha).
+        
+        Args:
+            readings: Lista de leituras ou iterável de ReadingColumns
+            output_path: Caminho do arquivo de saída
+            compression: 'gzip' ou None (automático pela extensão .gz)
+        """
+        try:
+            ensure_ascii = EXPORT_CONFIG['json'].get('ensure_ascii', True)
+            with DataExporter._open_text(output_path, compression) as jsonfile:
+                jsonfile.writelines(
+                    json.dumps(DataExporter._reading_dict(reading), ensure_ascii=ensure_ascii) + '\n'
+                    for reading in DataExporter._iter_readings(readings)
+                )
+                
+        except Exception as e:
+            raise DataStorageError(f"Erro ao exportar JSON Lines: {e}")
+    
+    @staticmethod
+    def export_to_excel(readings, output_path: Path,
+                        summary: Optional[Dict[str, Any]] = None) -> None:
+        """
+        Exporta leituras para arquivo Excel.
+        
+        Usa o modo write_only do openpyxl, que grava as linhas em disco à
+        medida que são adicionadas. Acima do limite de linhas do Excel os
+        dados continuam em planilhas 'Strain Data 2', 'Strain Data 3', ...
+        
+        Args:
+            readings: Lista de leituras ou iterável de ReadingColumns
+            output_path: Caminho do arquivo de saída
+            summary: Total e período; calculado se lista
+        """
+        try:
+            from openpyxl import Workbook
+            
+            workbook = Workbook(write_only=True)
+            sheet = None
+            sheets = 0
+            rows_in_sheet = DataExporter.EXCEL_MAX_ROWS
+            total = 0
+            
+            for reading in DataExporter._iter_readings(readings):
+                if rows_in_sheet >= DataExporter.EXCEL_MAX_ROWS:
+                    sheets += 1
+                    sheet = workbook.create_sheet(
+                        'Strain Data' if sheets == 1 else f'Strain Data {sheets}'
+                    )
+                    sheet.append(DataExporter.EXCEL_HEADER)
+                    rows_in_sheet = 0
+                sheet.append([
+                    reading.timestamp,
+                    reading.strain_value,
+                    reading.raw_adc_value,
+                    reading.sensor_id,
+                    reading.battery_level,
+                    reading.temperature,
+                    reading.checksum
+                ])
+                rows_in_sheet += 1
+                total += 1
+            
+            if sheet is None:
+                workbook.create_sheet('Strain Data').append(DataExporter.EXCEL_HEADER)
+            
+            # Metadados em uma aba separada
+            info = DataExporter._summary(readings, summary)
+            metadata = workbook.create_sheet('Metadata')
+            metadata.append(['Property', 'Value'])
+            metadata.append(['Export Date', datetime.now().isoformat()])
+            metadata.append(['Total Readings', info.get('total_readings', total)])
+            metadata.append(['System', DataExporter.SYSTEM_NAME])
+            
+            workbook.save(output_path)
+                
+        except Exception as e:
+            raise DataStorageError(f"Erro ao exportar Excel: {e}")
+    
+    @staticmethod
+    def _arrow_schema(pa, dictionary: bool, metadata: Dict[str, Any]):
+        """Schema Arrow das leituras (sensor_id como dicionário ou texto)."""
+        sensor_type = pa.dictionary(pa.int32(), pa.string()) if dictionary else pa.string()
+        return pa.schema([
+            ('timestamp', pa.timestamp('us', tz='UTC')),
+            ('sensor_id', sensor_type),
+            ('strain_value', pa.float64()),
+            ('raw_adc_value', pa.int32()),
+            ('battery_level', pa.int16()),
+            ('temperature', pa.float64())
+        ], metadata={key: str(value) for key, value in metadata.items()})
+    
+    @staticmethod
+    def _arrow_batch(pa, schema, columns: ReadingColumns):
+        """
+        Converte um bloco de colunas em RecordBatch.
+        
+        As colunas numéricas são arrays nativos e viram buffers Arrow sem
+        cópia; sensor_id usa os índices sensor_keys sobre sensor_names.
+        """
+        count = len(columns)
+        
+        def buffer_array(values, arrow_type):
+            return pa.Array.from_buffers(arrow_type, count, [None, pa.py_buffer(values)])
+        
+        sensor_ids = pa.DictionaryArray.from_arrays(
+            buffer_array(columns.sensor_keys, pa.uint16()).cast(pa.int32()),
+            pa.array(columns.sensor_names, type=pa.string())
+        )
+        if not pa.types.is_dictionary(schema.field('sensor_id').type):
+            sensor_ids = sensor_ids.dictionary_decode()
+        
+        return pa.RecordBatch.from_arrays([
+            buffer_array(columns.timestamps_us, pa.timestamp('us', tz='UTC')),
+            sensor_ids,
+            buffer_array(columns.strain_values, pa.float64()),
+            buffer_array(columns.raw_adc_values, pa.int32()),
+            buffer_array(columns.battery_levels, pa.int16()),
+            buffer_array(columns.temperatures, pa.float64())
+        ], schema=schema)
+    
+    @staticmethod
+    def _arrow_metadata(info: Dict[str, Any]) -> Dict[str, Any]:
+        """Metadados gravados no schema Arrow/Parquet."""
+        metadata = {
+            'exported_at': datetime.now().isoformat(),
+            'system': DataExporter.SYSTEM_NAME
+        }
+        if 'total_readings' in info:
+            metadata['total_readings'] = info['total_readings']
+        return metadata
+    
+    @staticmethod
+    def export_to_parquet(readings, output_path: Path,
+                          summary: Optional[Dict[str, Any]] = None) -> None:
+        """
+        Exporta leituras para Parquet (requer pyarrow).
+        
+        Blocos são acumulados até EXPORT_CONFIG['parquet']['row_group_size']
+        leituras e gravados como row groups com estatísticas (mín./máx.)
+        por coluna, que pandas/Polars usam para pular row groups em filtros.
+        
+        Args:
+            readings: Lista de leituras ou iterável de ReadingColumns
+            output_path: Caminho do arquivo de saída
+            summary: Total e período; calculado se lista
+        """
+        try:
+            import pyarrow as pa
+            import pyarrow.parquet as pq
+            
+            options = EXPORT_CONFIG['parquet']
+            schema = DataExporter._arrow_schema(
+                pa, True, DataExporter._arrow_metadata(DataExporter._summary(readings, summary))
+            )
+            
+            with pq.ParquetWriter(str(output_path), schema,
+                                  compression=options['compression'],
+                                  write_statistics=True) as writer:
+                pending = []
+                pending_rows = 0
+                for columns in DataExporter._iter_columns(readings):
+                    pending.append(DataExporter._arrow_batch(pa, schema, columns))
+                    pending_rows += len(columns)
+                    if pending_rows >= options['row_group_size']:
+                        writer.write_table(pa.Table.from_batches(pending),
+                                           row_group_size=options['row_group_size'])
+                        pending = []
+                        pending_rows = 0
+                if pending:
+                    writer.write_table(pa.Table.from_batches(pending),
+                                       row_group_size=options['row_group_size'])
+                    
+        except Exception as e:
+            raise DataStorageError(f"Erro ao exportar Parquet: {e}")
+    
+    @staticmethod
+    def export_to_arrow(readings, output_path: Path,
+                        summary: Optional[Dict[str, Any]] = None) -> None:
+        """
+        Exporta leituras para arquivo Arrow IPC/Feather v2 (requer pyarrow).
+        
+        O arquivo não é comprimido, de modo que pode ser mapeado em memória
+        (pyarrow.memory_map, polars.read_ipc) sem cópia.
+        
+        Args:
+            readings: Lista de leituras ou iterável de ReadingColumns
+            output_path: Caminho do arquivo de saída
+            summary: Total e período; calculado se lista
+        """
+        try:
+            import pyarrow as pa
+            
+            # Formato de arquivo IPC não aceita troca de dicionário entre blocos
+            schema = DataExporter._arrow_schema(
+                pa, False, DataExporter._arrow_metadata(DataExporter._summary(readings, summary))
+            )
+            
+            with pa.OSFile(str(output_path), 'wb') as sink:
+                with pa.ipc.new_file(sink, schema) as writer:
+                    for columns in DataExporter._iter_columns(readings):
+                        writer.write_batch(DataExporter._arrow_batch(pa, schema, columns))
+                    
+        except Exception as e:
+            raise DataStorageError(f"Erro ao exportar Arrow: {e}")
+
+
+class StreamWindow:
+    """
+    Janela somente leitura sobre o stream de um sensor.
+    
+    As colunas (times, values, raw_values, battery_levels, temperatures)
+    são memoryviews sobre o buffer circular, sem cópia. Para compatibilidade,
+    indexar a janela retorna o ponto no formato {'t', 'v', 'r', 'b', 'temp'}
+    e fatiar retorna outra janela.
+    
+    A janela reflete o buffer no momento da consulta e continua válida até
+    que o stream receba `max_points - len(janela)` novos pontos.
+    """
+    
+    __slots__ = ('times', 'values', 'raw_values', 'battery_levels', 'temperatures')
+    
+    FIELDS = ('t', 'v', 'r', 'b', 'temp')
+    
+    def __init__(self, times, values, raw_values, battery_levels, temperatures):
+        self.times = times
+        self.values = values
+        self.raw_values = raw_values
+        self.battery_levels = battery_levels
+        self.temperatures = temperatures
+    
+    def _columns(self) -> tuple:
+        return (self.times, self.values, self.raw_values,
+                self.battery_levels, self.temperatures)
+    
+    def __len__(self) -> int:
+        return len(self.times)
+    
+    def __getitem__(self, index):
+        if isinstance(index, slice):
+            return StreamWindow(*(column[index] for column in self._columns()))
+        return dict(zip(self.FIELDS, (column[index] for column in self._columns())))
+    
+    def __iter__(self):
+        fields = self.FIELDS
+        for point in zip(*self._columns()):
+            yield dict(zip(fields, point))
+    
+    def to_points(self) -> List[Dict]:
+        """Materializa a janela em lista de pontos (dicionários)."""
+        return list(self)
+
+
+class _SensorStream:
+    """
+    Stream numérico de um sensor com estatísticas móveis.
+    
+    Mínimo e máximo da janela são mantidos por deques monotônicos de
+    índices absolutos e a média por soma acumulada, recalculada a cada
+    `capacity` pontos para limitar o erro de ponto flutuante. Traços
+    decimados são mantidos incrementalmente por (modo, tamanho do bucket,
+    janela).
+    """
+    
+    COLUMNS = (('t', 'd'), ('v', 'd'), ('r', 'i'), ('b', 'h'), ('temp', 'd'))
+    
+    # Bytes por ponto nas colunas do buffer circular
+    BYTES_PER_POINT = sum(array(code).itemsize for _, code in COLUMNS)
+    
+    # Caches de decimação mantidos por stream (larguras distintas em uso)
+    MAX_DECIMATION_CACHES = 4
+    
+    def __init__(self, capacity: int, ring: Optional[ColumnRing] = None):
+        self.ring = ColumnRing(capacity, self.COLUMNS) if ring is None else ring
+        self._min = deque()
+        self._max = deque()
+        self._sum = 0.0
+        self._since_recompute = 0
+        self._decimation: Dict[Tuple[str, int, Optional[int]],
+                               Tuple[DecimationCache, threading.Lock]] = {}
+    
+    def append(self, time_ms: float, reading: StrainReading) -> None:
+        ring = self.ring
+        value = reading.strain_value
+        if len(ring) == ring.capacity:
+            self._sum -= ring.value('v', ring.first_index)
+        
+        index = ring.append((time_ms, value, reading.raw_adc_value,
+                             reading.battery_level, reading.temperature))
+        self._sum += value
+        
+        first = ring.first_index
+        minimum, maximum = self._min, self._max
+        while minimum and minimum[-1][1] >= value:
+            minimum.pop()
+        minimum.append((index, value))
+        while minimum[0][0] < first:
+            minimum.popleft()
+        while maximum and maximum[-1][1] <= value:
+            maximum.pop()
+        maximum.append((index, value))
+        while maximum[0][0] < first:
+            maximum.popleft()
+        
+        self._since_recompute += 1
+        if self._since_recompute >= ring.capacity:
+            self._sum = sum(ring.view('v', first, ring.end_index))
+            self._since_recompute = 0
+    
+    def extend(self, times_ms, batch: StrainBatch) -> None:
+        """Grava um lote do sensor por fatias, com estatísticas atualizadas por lote."""
+        self._extend(times_ms, batch.strain_values, batch.raw_adc_values,
+                     batch.battery_levels, batch.temperatures)
+    
+    def load(self, window: StreamWindow) -> None:
+        """Grava as colunas de uma janela (ex: restaurada de um snapshot)."""
+        self._extend(*window._columns())
+    
+    def _extend(self, times_ms, values, raw_values, battery_levels, temperatures) -> None:
+        ring = self.ring
+        count = len(values)
+        if not count:
+            return
+        
+        overflow = len(ring) + count - ring.capacity
+        if 0 < overflow < len(ring):
+            self._sum -= sum(ring.view('v', ring.first_index, ring.first_index + overflow))
+        elif overflow >= len(ring):
+            self._sum = 0.0
+        
+        start = ring.extend((times_ms, values, raw_values, battery_levels, temperatures))
+        first, end = ring.first_index, ring.end_index
+        kept = ring.view('v', max(start, first), end)
+        self._sum += sum(kept)
+        
+        # Sobrevivem nos deques os valores antigos menores (maiores) que todo
+        # o lote e os mínimos (máximos) de sufixo do próprio lote
+        minimum, maximum = self._min, self._max
+        low, high = min(kept), max(kept)
+        while minimum and minimum[-1][1] >= low:
+            minimum.pop()
+        while maximum and maximum[-1][1] <= high:
+            maximum.pop()
+        suffix_min, suffix_max = [], []
+        run_min, run_max = float('inf'), float('-inf')
+        index = end
+        for value in reversed(kept):
+            index -= 1
+            if value < run_min:
+                run_min = value
+                suffix_min.append((index, value))
+            if value > run_max:
+                run_max = value
+                suffix_max.append((index, value))
+        minimum.extend(reversed(suffix_min))
+        maximum.extend(reversed(suffix_max))
+        while minimum[0][0] < first:
+            minimum.popleft()
+        while maximum[0][0] < first:
+            maximum.popleft()
+        
+        self._since_recompute += count
+        if self._since_recompute >= ring.capacity:
+            self._sum = sum(ring.view('v', first, end))
+            self._since_recompute = 0
+    
+    def window(self, last_n: Optional[int] = None) -> StreamWindow:
+        ring = self.ring
+        end = ring.end_index
+        start = ring.first_index if last_n is None else max(ring.first_index, end - last_n)
+        return StreamWindow(*(ring.view(name, start, end) for name, _ in self.COLUMNS))
+    
+    def since(self, seq: Optional[int],
+              max_points: Optional[int] = None) -> Tuple[StreamWindow, int, int]:
+        ring = self.ring
+        first, end = ring.first_index, ring.end_index
+        # Cursor à frente do stream: stream recriado, recomeça do início
+        start = first if seq is None or seq > end else max(seq, first)
+        stop = end if max_points is None else min(end, start + max_points)
+        return (StreamWindow(*(ring.view(name, start, stop) for name, _ in self.COLUMNS)),
+                start, stop)
+    
+    def decimation(self, width: int, mode: str,
+                   last_n: Optional[int] = None) -> Callable[[], Tuple[List[float], List[float]]]:
+        """
+        Copia a janela e retorna a decimação dela, a executar fora do lock.
+        
+        Só a cópia das colunas (memória contígua) ocorre sob o lock do
+        streamer; a decimação roda depois, sob o lock do próprio cache.
+        """
+        ring = self.ring
+        end = ring.end_index
+        start = ring.first_index if last_n is None else max(ring.first_index, end - last_n)
+        
+        # Bucket calculado sobre o tamanho nominal da janela, estável enquanto o buffer enche.
+        # Janelas distintas (last_n) têm caches próprios: o cache só avança a borda antiga
+        nominal = ring.capacity if last_n is None else min(last_n, ring.capacity)
+        key = (mode, bucket_size(nominal, width, mode), last_n)
+        entry = self._decimation.get(key)
+        if entry is None:
+            if len(self._decimation) >= self.MAX_DECIMATION_CACHES:
+                del self._decimation[next(iter(self._decimation))]
+            entry = self._decimation[key] = (DecimationCache(mode, key[1]), threading.Lock())
+        cache, lock = entry
+        times, values = ring.copy('t', start, end), ring.copy('v', start, end)
+        
+        def run() -> Tuple[List[float], List[float]]:
+            with lock:
+                return cache.update(times, values, start, end)
+        return run
+    
+    def decimate(self, width: int, mode: str,
+                 last_n: Optional[int] = None) -> Tuple[List[float], List[float]]:
+        return self.decimation(width, mode, last_n)()
+    
+    def latest(self) -> Dict:
+        index = self.ring.end_index - 1
+        return {name: self.ring.value(name, index) for name, _ in self.COLUMNS}
+    
+    def stats(self) -> Dict[str, Any]:
+        count = len(self.ring)
+        return {
+            'points': count,
+            'latest_time': self.ring.value('t', self.ring.end_index - 1),
+            'min_value': self._min[0][1],
+            'max_value': self._max[0][1],
+            'avg_value': self._sum / count
+        }
+    
+    def clear(self) -> None:
+        self.ring.discard_all()
+        self._min.clear()
+        self._max.clear()
+        self._sum = 0.0
+        self._since_recompute = 0
+        self._decimation.clear()
+
+
+class OscilloscopeStreamer:
+    """
+    Streamer de dados otimizado para visualização tipo osciloscópio.
+    
+    Fornece dados em formato otimizado para gráficos em tempo real.
+    Cada sensor tem um buffer circular numérico com estatísticas móveis,
+    de modo que snapshots custam O(sensores) e não O(pontos).
+    """
+    
+    def __init__(self, max_points: int = 1000):
+        """
+        Inicializa o streamer de osciloscópio.
+        
+        Args:
+            max_points: Número máximo de pontos a manter na janela
+        """
+        self._data_streams: Dict[str, _SensorStream] = {}
+        self._max_points = max_points
+        self._lock = threading.Lock()
+        
+    def add_reading(self, reading: StrainReading) -> None:
+        """
+        Adiciona leitura ao stream de osciloscópio.
+        
+        Args:
+            reading: Leitura do sensor
+        """
+        # Converte timestamp para valor numérico (ms desde epoch)
+        time_ms = reading.timestamp_us / 1000
+        
+        started = _LOCK_WAIT_INGEST.start()
+        with self._lock:
+            _LOCK_WAIT_INGEST.stop(started)
+            self._stream(reading.sensor_id).append(time_ms, reading)
+    
+    def add_readings(self, readings: List[StrainReading]) -> None:
+        """
+        Adiciona múltiplas leituras adquirindo o lock uma única vez.
+        
+        Args:
+            readings: Lista de leituras
+        """
+        if readings:
+            self.add_batch(StrainBatch.from_readings(readings))
+    
+    def add_batch(self, batch: StrainBatch) -> None:
+        """
+        Adiciona um lote colunar aos streams com uma aquisição de lock.
+        
+        Args:
+            batch: Lote de leituras (um ou mais sensores)
+        """
+        if not len(batch):
+            return
+        parts = [(sensor_id, part, part.timestamps_ms())
+                 for sensor_id, part in batch.by_sensor()]
+        
+        started = _LOCK_WAIT_INGEST.start()
+        with self._lock:
+            _LOCK_WAIT_INGEST.stop(started)
+            for sensor_id, part, times_ms in parts:
+                self._stream(sensor_id).extend(times_ms, part)
+    
+    def attach_stream(self, sensor_id: str, stream: _SensorStream) -> None:
+        """
+        Registra um stream mantido fora do streamer (ex: ring em memória
+        compartilhada gravado por um worker de ingestão, ver data.shards).
+        
+        As consultas passam a ler o stream anexado; o sensor não deve
+        receber leituras por add_batch neste processo.
+        
+        Args:
+            sensor_id: ID do sensor
+            stream: Stream do sensor
+        """
+        with self._lock:
+            self._data_streams[sensor_id] = stream
+    
+    def detach_stream(self, sensor_id: str) -> Optional[_SensorStream]:
+        """
+        Remove um stream anexado por attach_stream.
+        
+        Args:
+            sensor_id: ID do sensor
             
-            with open(output_path, 'w', encoding='utf-8') as jsonfile:
-                json.dump(data, jsonfile, **EXPORT_CONFIG['json'])
-                
-        except Exception as e:
-            raise DataStorageError(f"Erro ao exportar JSON: {e}")
+        Returns:
+            Stream removido (None se não existia)
+        """
+        with self._lock:
+            return self._data_streams.pop(sensor_id, None)
     
-    @staticmethod
-    def export_to_excel(readings: List[StrainReading], output_path: Path) -> None:
+    def load_window(self, sensor_id: str, window: StreamWindow) -> None:
         """
-        Exporta leituras para arquivo Excel.
+        Recarrega pontos de um sensor a partir de uma janela (ex: snapshot
+        da partida rápida), copiando as colunas para o buffer circular.
         
         Args:
-            readings: Lista de leituras
-            output_path: Caminho do arquivo de saída
+            sensor_id: ID do sensor
+            window: Pontos em ordem de tempo (tempos em ms)
         """
-        try:
-            # Converte para DataFrame do pandas
-            data = []
-            for reading in readings:
-                data.append({
-                    'Timestamp': reading.timestamp,
-                    'Strain (µε)': reading.strain_value,
-                    'Raw ADC': reading.raw_adc_value,
-                    'Sensor ID': reading.sensor_id,
-                    'Battery (%)': reading.battery_level,
-                    'Temperature (°C)': reading.temperature,
-                    'Checksum': reading.checksum
-                })
-            
-            df = pd.DataFrame(data)
-            
-            # Exporta para Excel com formatação
-            with pd.ExcelWriter(output_path, engine='openpyxl') as writer:
-                df.to_excel(writer, sheet_name='Strain Data', index=False)
-                
-                # Adiciona metadados em uma segunda aba
-                metadata_df = pd.DataFrame({
-                    'Property': ['Export Date', 'Total Readings', 'System'],
-                    'Value': [
-                        datetime.now().isoformat(),
-                        len(readings),
-                        'Sistema DAQ CNH Industrial'
-                    ]
-                })
-                metadata_df.to_excel(writer, sheet_name='Metadata', index=False)
-                
-        except Exception as e:
-            raise DataStorageError(f"Erro ao exportar Excel: {e}")
-
-
-class OscilloscopeStreamer:
-    """
-    Streamer de dados otimizado para visualização tipo osciloscópio.
+        if not len(window):
+            return
+        with self._lock:
+            self._stream(sensor_id).load(window)
     
-    Fornece dados em formato otimizado para gráficos em tempo real.
-    """
+    def _stream(self, sensor_id: str) -> _SensorStream:
+        """Retorna stream do sensor, criando se necessário (chamar com lock)."""
+        stream = self._data_streams.get(sensor_id)
+        if stream is None:
+            stream = _SensorStream(self._max_points)
+            self._data_streams[sensor_id] = stream
+        return stream
     
-    def __init__(self, max_points: int = 1000):
+    def get_stream_data(self, sensor_id: str, last_n: Optional[int] = None) -> StreamWindow:
         """
-        Inicializa o streamer de osciloscópio.
+        Retorna dados do stream para um sensor.
         
         Args:
-            max_points: Número máximo de pontos a manter na janela
+            sensor_id: ID do sensor
+            last_n: Número de pontos mais recentes (None = todos)
+            
+        Returns:
+            Janela somente leitura com os pontos (vazia se sensor desconhecido)
         """
-        self._data_streams: Dict[str, List[Dict]] = {}
-        self._max_points = max_points
-        self._lock = threading.Lock()
-        
-    def add_reading(self, reading: StrainReading) -> None:
+        started = _LOCK_WAIT_READ.start()
+        with self._lock:
+            _LOCK_WAIT_READ.stop(started)
+            stream = self._data_streams.get(sensor_id)
+            if stream is None:
+                return _EMPTY_WINDOW
+            return stream.window(last_n)
+    
+    def get_since(self, sensor_id: str, seq: Optional[int] = None,
+                  max_points: Optional[int] = None) -> Tuple[StreamWindow, int, int]:
         """
-        Adiciona leitura ao stream de osciloscópio.
+        Retorna pontos do sensor a partir de um número de sequência.
+        
+        O número de sequência de cada ponto é seu índice absoluto no
+        buffer circular, atribuído na ingestão e crescente por sensor;
+        localizar o cursor é O(1) e o custo depende apenas dos pontos
+        novos. Pontos com o mesmo timestamp nunca são perdidos ou repetidos.
         
         Args:
-            reading: Leitura do sensor
+            sensor_id: ID do sensor
+            seq: Próximo número de sequência esperado (None = janela inteira)
+            max_points: Número máximo de pontos retornados (a partir do cursor)
+            
+        Returns:
+            (janela, seq do primeiro ponto, próximo seq). Se o primeiro seq
+            for maior que o solicitado, os pontos intermediários já saíram
+            da janela.
         """
         with self._lock:
-            # Inicializa stream do sensor se não existir
-            if reading.sensor_id not in self._data_streams:
-                self._data_streams[reading.sensor_id] = []
-            
-            # Converte timestamp para valor numérico (ms desde epoch)
-            time_ms = reading.timestamp.timestamp() * 1000
-            
-            # Formato otimizado para gráficos
-            data_point = {
-                't': time_ms,                    # Timestamp em ms
-                'v': reading.strain_value,       # Valor principal
-                'r': reading.raw_adc_value,      # Valor ADC bruto
-                'b': reading.battery_level,      # Bateria
-                'temp': reading.temperature      # Temperatura
-            }
-            
-            stream = self._data_streams[reading.sensor_id]
-            stream.append(data_point)
-            
-            # Mantém apenas os últimos N pontos
-            if len(stream) > self._max_points:
-                stream.pop(0)
+            stream = self._data_streams.get(sensor_id)
+            if stream is None:
+                return _EMPTY_WINDOW, 0, 0
+            return stream.since(seq, max_points)
     
-    def get_stream_data(self, sensor_id: str, last_n: Optional[int] = None) -> List[Dict]:
+    def get_decimated(self, sensor_id: str, width: int, mode: str = 'minmax',
+                      last_n: Optional[int] = None) -> Tuple[List[float], List[float]]:
         """
-        Retorna dados do stream para um sensor.
+        Retorna o traço do sensor decimado para uma largura em pixels.
+        
+        O resultado tem tamanho proporcional a width, independente do
+        tamanho da janela, e é mantido incrementalmente entre chamadas
+        (ver decimation.DecimationCache).
         
         Args:
             sensor_id: ID do sensor
+            width: Largura do gráfico em pixels
+            mode: 'minmax' (envelope, até 2 pontos por pixel) ou 'lttb'
             last_n: Número de pontos mais recentes (None = todos)
             
         Returns:
-            Lista de pontos de dados
+            (tempos em ms, valores) decimados
         """
         with self._lock:
-            if sensor_id not in self._data_streams:
-                return []
-            
-            stream = self._data_streams[sensor_id]
-            
-            if last_n is not None:
-                return stream[-last_n:]
-            
-            return stream.copy()
+            stream = self._data_streams.get(sensor_id)
+            if stream is None:
+                return [], []
+            decimation = stream.decimation(width, mode, last_n)
+        return decimation()
     
-    def get_all_streams(self) -> Dict[str, List[Dict]]:
+    def get_all_streams(self) -> Dict[str, StreamWindow]:
         """
         Retorna todos os streams ativos.
         
         Returns:
-            Dict com sensor_id como chave e lista de pontos como valor
+            Dict com sensor_id como chave e janela de pontos como valor
         """
         with self._lock:
             return {
-                sensor_id: stream.copy() 
+                sensor_id: stream.window()
                 for sensor_id, stream in self._data_streams.items()
             }
     
@@ -677,11 +2390,11 @@ class OscilloscopeStreamer:
             Dict com valores mais recentes por sensor
         """
         with self._lock:
-            latest = {}
-            for sensor_id, stream in self._data_streams.items():
-                if stream:
-                    latest[sensor_id] = stream[-1]
-            return latest
+            return {
+                sensor_id: stream.latest()
+                for sensor_id, stream in self._data_streams.items()
+                if len(stream.ring)
+            }
     
     def clear_stream(self, sensor_id: str) -> None:
         """
@@ -699,6 +2412,11 @@ class OscilloscopeStreamer:
         with self._lock:
             self._data_streams.clear()
     
+    def memory_bytes(self) -> int:
+        """Memória alocada pelos buffers circulares dos streams (bytes)."""
+        with self._lock:
+            return sum(stream.ring.nbytes for stream in self._data_streams.values())
+    
     def get_stream_stats(self) -> Dict[str, Any]:
         """
         Retorna estatísticas dos streams ativos.
@@ -709,24 +2427,22 @@ class OscilloscopeStreamer:
         with self._lock:
             stats = {
                 'active_sensors': len(self._data_streams),
-                'total_points': sum(len(stream) for stream in self._data_streams.values()),
+                'total_points': sum(len(stream.ring) for stream in self._data_streams.values()),
+                'bytes_per_point': _SensorStream.BYTES_PER_POINT,
+                'allocated_bytes': len(self._data_streams) * self._max_points * _SensorStream.BYTES_PER_POINT,
                 'sensors': {}
             }
             
             for sensor_id, stream in self._data_streams.items():
-                if stream:
-                    values = [point['v'] for point in stream]
-                    stats['sensors'][sensor_id] = {
-                        'points': len(stream),
-                        'latest_time': stream[-1]['t'],
-                        'min_value': min(values),
-                        'max_value': max(values),
-                        'avg_value': sum(values) / len(values)
-                    }
+                if len(stream.ring):
+                    stats['sensors'][sensor_id] = stream.stats()
             
             return stats
 
 
+_EMPTY_WINDOW = _SensorStream(1).window()
+
+
 class DataManager:
     """
     Gerenciador principal de dados do sistema DAQ.
@@ -734,20 +2450,180 @@ class DataManager:
     Coordena buffer em memória, persistência em banco, exportação e streaming.
     """
     
-    def __init__(self):
-        """Inicializa o gerenciador de dados."""
+    def __init__(self, db_path: Optional[Path] = None, warm_start: Optional[bool] = None):
+        """
+        Inicializa o gerenciador de dados.
+        
+        Com warm_start, as janelas do osciloscópio são restauradas do
+        snapshot gravado no último close() (via mmap, antes de abrir o
+        banco) ou, sem snapshot, da cauda de cada sensor no banco. Os
+        lotes não gravados de um snapshot são persistidos em qualquer caso.
+        
+        Args:
+            db_path: Caminho para o arquivo do banco (padrão: data/daq_data.db)
+            warm_start: Restaura o estado anterior (padrão: config.WARM_START)
+        """
+        if db_path is None:
+            db_path = get_data_file_path("daq_data.db")
+        self._warm_start = config.WARM_START if warm_start is None else warm_start
+        self._snapshot_path = snapshot_path(db_path)
+        self.warm_start_info: Dict[str, Any] = {'source': None, 'sensors': 0, 'points': 0,
+                                                'seconds': 0.0}
+        
         self.buffer = DataBuffer(
             max_size=config.MAX_BUFFER_SIZE,
-            flush_interval=config.BUFFER_FLUSH_INTERVAL
+            flush_interval=config.PERSIST_MAX_LATENCY,
+            flush_size=config.PERSIST_BATCH_SIZE
         )
-        self.database = DatabaseManager()
+        self.oscilloscope_streamer = OscilloscopeStreamer(config.OSCILLOSCOPE_MAX_POINTS)
+        started = time.perf_counter()
+        self._recovered: List[ReadingColumns] = []
+        restored = self._restore_snapshot()
+        self.warm_start_info['seconds'] = time.perf_counter() - started
+        
+        self.database = DatabaseManager(db_path)
         self.exporter = DataExporter()
-        self.oscilloscope_streamer = OscilloscopeStreamer()
+        if self._warm_start and not restored:
+            started = time.perf_counter()
+            self._restore_from_database()
+            self.warm_start_info['seconds'] = time.perf_counter() - started
+        
+        # Captura bruta opcional, gravada em paralelo ao banco
+        self.capture: Optional['CaptureWriter'] = None
+        self._drain_lock = threading.Lock()
+        
+        # Persistência em segundo plano: ingestão não espera o SQLite
+        self.writer = WriteBehindWriter(
+            store=self._store_batches,
+            batch_size=config.PERSIST_BATCH_SIZE,
+            max_latency=config.PERSIST_MAX_LATENCY,
+            queue_size=config.PERSIST_QUEUE_SIZE,
+            policy=config.PERSIST_BACKPRESSURE,
+            spill_dir=get_data_file_path(config.PERSIST_SPILL_DIR),
+            source=self._drain_buffer,
+            batch_factory=ReadingColumns
+        )
+        self._replay_recovered()
+        
+        # Consultas intercaladas sobre buffer, writer e banco
+        self.query = ReadingQuery(self.buffer, self.writer, self.database)
+        
+        # Análise de fadiga opcional, alimentada pelos mesmos lotes
+        self.fatigue: Optional['FatigueMonitor'] = None
+        if FATIGUE_CONFIG['enabled']:
+            self.start_fatigue()
+        
+        # Alarmes opcionais, avaliados em cada lote recebido
+        self.alarms: Optional['AlarmEngine'] = None
+        if ALARM_CONFIG['enabled']:
+            self.start_alarms()
+        
+        # Ocupação, fila e memória lidas apenas no scrape das métricas
+        metrics.register_collector(DataManager._collect_metrics, owner=self)
         
-        # Controle de flush automático
-        self._auto_flush_enabled = True
-        self._flush_thread = None
+    def _restore_snapshot(self) -> bool:
+        """
+        Lê o snapshot do último close(): janelas do osciloscópio e lotes não gravados.
+        
+        Os lotes não gravados são sempre copiados para _recovered, mesmo sem
+        partida rápida ou com snapshot antigo; idade e colunas decidem apenas
+        se as janelas são restauradas. O arquivo só é removido por
+        _replay_recovered(), depois que os lotes chegam ao banco, e um
+        snapshot ilegível é renomeado em vez de apagado.
+        
+        Returns:
+            True se as janelas foram restauradas do snapshot
+        """
+        path = self._snapshot_path
+        if not path.exists():
+            return False
+        restored = False
+        try:
+            with SnapshotReader(path) as reader:
+                if (self._warm_start
+                        and reader.stream_columns == _SensorStream.COLUMNS
+                        and reader.age_seconds <= config.WARM_START_MAX_AGE):
+                    for sensor_id, columns in reader.streams():
+                        self.oscilloscope_streamer.load_window(sensor_id, StreamWindow(*columns))
+                        self.warm_start_info['sensors'] += 1
+                        self.warm_start_info['points'] += len(columns[0])
+                    self.warm_start_info['source'] = 'snapshot'
+                    restored = True
+                self._recovered = list(reader.pending(copy=True))
+        except Exception as e:
+            print(f"Erro ao restaurar snapshot: {e}")
+            self._recovered = []
+            self._set_aside_snapshot()
+        return restored
+    
+    def _set_aside_snapshot(self) -> None:
+        """Renomeia um snapshot ilegível para que o próximo close() não o sobrescreva."""
+        path = self._snapshot_path
+        target = path.with_name(f"{path.name}.{time.time_ns()}.failed")
+        try:
+            path.replace(target)
+            print(f"Snapshot preservado em {target}")
+        except OSError as e:
+            print(f"Erro ao preservar snapshot: {e}")
+    
+    def _replay_recovered(self) -> None:
+        """Grava os lotes recuperados do snapshot e só então remove o arquivo."""
+        batches, self._recovered = self._recovered, []
+        if not self._snapshot_path.exists():
+            return
+        dropped = self.writer.readings_dropped
+        for batch in batches:
+            self.writer.submit(batch)
+        if not self.writer.flush() or self.writer.readings_dropped != dropped:
+            print("Erro ao gravar lotes do snapshot: arquivo mantido para a próxima inicialização")
+            return
+        try:
+            self._snapshot_path.unlink()
+        except OSError:
+            pass
+    
+    def _restore_from_database(self) -> None:
+        """Preenche as janelas com a cauda de cada sensor (consulta pela chave primária)."""
+        # Não espera a migração de schemas anteriores na inicialização
+        if self.database._legacy_pending:
+            return
+        capacity = config.OSCILLOSCOPE_MAX_POINTS
+        start_ms = int((time.time() - config.WARM_START_MAX_AGE) * 1000)
+        tails: Dict[str, List[tuple]] = {}
+        try:
+            for row in self.database.iter_rows(start_ms=start_ms, descending=True,
+                                               limit=capacity):
+                tail = tails.setdefault(row[1], [])
+                if len(tail) < capacity:
+                    tail.append(row)
+        except DataStorageError as e:
+            print(f"Erro ao restaurar janelas do banco: {e}")
+            return
         
+        for sensor_id, rows in tails.items():
+            rows.reverse()
+            times, _, strain, adc, battery, temperature = zip(*rows)
+            self.oscilloscope_streamer.load_window(sensor_id, StreamWindow(
+                array('d', times), array('d', strain), array('i', adc),
+                array('h', battery), array('d', temperature)
+            ))
+            self.warm_start_info['sensors'] += 1
+            self.warm_start_info['points'] += len(rows)
+        if tails:
+            self.warm_start_info['source'] = 'database'
+    
+    def _write_snapshot(self, batches: List[ReadingColumns]) -> None:
+        """Grava o snapshot das janelas e dos lotes não persistidos."""
+        streams = {
+            sensor_id: window._columns()
+            for sensor_id, window in self.oscilloscope_streamer.get_all_streams().items()
+        }
+        try:
+            write_snapshot(self._snapshot_path, _SensorStream.COLUMNS, streams,
+                           batches, config.OSCILLOSCOPE_MAX_POINTS)
+        except Exception as e:
+            print(f"Erro ao gravar snapshot: {e}")
+    
     def add_reading(self, reading: StrainReading) -> None:
         """
         Adiciona uma leitura ao sistema.
@@ -755,12 +2631,25 @@ class DataManager:
         Args:
             reading: Leitura a ser adicionada
         """
+        started = _INGEST_TO_VISIBLE.start()
+        
         # Adiciona ao buffer
         self.buffer.add_reading(reading)
         
         # Adiciona ao streamer de osciloscópio
         self.oscilloscope_streamer.add_reading(reading)
         
+        if self.fatigue is not None or self.alarms is not None:
+            batch = StrainBatch.from_readings([reading])
+            if self.fatigue is not None:
+                self.fatigue.add_batch(batch)
+            if self.alarms is not None:
+                self.alarms.add_batch(batch)
+        
+        _INGESTED.inc()
+        if started is not None:
+            self._observe_visible(started, reading.timestamp_us)
+        
         # Verifica se precisa fazer flush
         if self.buffer.should_flush():
             self._flush_buffer()
@@ -772,105 +2661,355 @@ class DataManager:
         Args:
             readings: Lista de leituras
         """
-        self.buffer.add_readings(readings)
+        if readings:
+            self.add_batch(StrainBatch.from_readings(readings))
+    
+    def add_batch(self, batch: StrainBatch, stream: bool = True) -> None:
+        """
+        Adiciona um lote colunar ao sistema (caminho principal de ingestão).
+        
+        O mesmo lote alimenta o buffer e o osciloscópio, sem materializar
+        StrainReading; o custo fixo é por lote, não por leitura.
+        
+        Args:
+            batch: Lote de leituras
+            stream: Se False, o osciloscópio não recebe o lote (já gravado
+                no ring compartilhado por um worker, ver data.shards)
+        """
+        count = len(batch)
+        if not count:
+            return
+        started = _INGEST_TO_VISIBLE.start()
         
-        # Adiciona ao streamer também
-        for reading in readings:
-            self.oscilloscope_streamer.add_reading(reading)
+        self.buffer.add_batch(batch)
+        if stream:
+            self.oscilloscope_streamer.add_batch(batch)
+        if self.fatigue is not None:
+            self.fatigue.add_batch(batch)
+        if self.alarms is not None:
+            self.alarms.add_batch(batch)
+        
+        _INGESTED.inc(count)
+        if started is not None:
+            self._observe_visible(started, batch.timestamps_us[-1])
         
         if self.buffer.should_flush():
             self._flush_buffer()
     
+    @staticmethod
+    def _observe_visible(started: float, newest_us: int) -> None:
+        """Registra latência até a visibilidade e idade da leitura (chamada amostrada)."""
+        _INGEST_TO_VISIBLE.stop(started)
+        _SAMPLE_AGE.observe(max(0.0, time.time() - newest_us / 1e6))
+    
+    def _drain_buffer(self, take: Callable[[Callable[[], ReadingColumns]], Any]
+                      ) -> Optional[ReadingColumns]:
+        """
+        Retira o conteúdo do buffer por meio de take e o grava na captura.
+        
+        Único caminho de saída do buffer: usado pelo flush da ingestão e
+        como fonte do writer, de modo que a captura recebe todos os lotes
+        que chegam ao banco, na ordem em que saíram do buffer. take recebe
+        a retirada em memória (buffer.drain) e a executa sob o lock do
+        writer; a gravação da captura ocorre depois, fora dele.
+        
+        Args:
+            take: Executa a retirada e retorna o lote (ou None)
+        
+        Returns:
+            Colunas retiradas do buffer, ou None
+        """
+        with self._drain_lock:
+            batch = take(self.buffer.drain)
+            if self.capture is not None and batch is not None and len(batch):
+                try:
+                    self.capture.write(batch)
+                except Exception as e:
+                    print(f"Erro ao gravar captura: {e}")
+        return batch
+    
     def _flush_buffer(self) -> None:
-        """Persiste dados do buffer no banco."""
+        """Entrega o conteúdo do buffer ao writer (não bloqueia no SQLite)."""
+        started = time.perf_counter()
         try:
-            readings = self.buffer.get_readings()
-            if readings:
-                self.database.store_readings(readings)
-                self.buffer.clear()
-                self.buffer.mark_flushed()
+            # Visível em pending() desde a retirada até entrar na fila
+            batch = self._drain_buffer(self.writer.stage)
+            if batch is not None:
+                self.writer.submit(batch)
                 
         except Exception as e:
             print(f"Erro no flush do buffer: {e}")
+        _FLUSH_SECONDS.observe(time.perf_counter() - started)
+    
+    def _store_batches(self, batches: List[ReadingColumns]) -> None:
+        """Grava lotes no banco em uma transação (thread do writer)."""
+        self.database.store_batches(batches)
+    
+    def flush(self, timeout: Optional[float] = None) -> bool:
+        """
+        Persiste todas as leituras recebidas até agora e aguarda a gravação.
+        
+        Args:
+            timeout: Tempo máximo de espera em segundos
+            
+        Returns:
+            True se tudo foi gravado dentro do prazo
+        """
+        self._flush_buffer()
+        if self.capture is not None:
+            self.capture.flush()
+        return self.writer.flush(timeout)
+    
+    def start_capture(self, path: Path, sample_rate_hz: Optional[float] = None,
+                      calibration: Optional[Dict[str, 'Calibration']] = None) -> 'CaptureWriter':
+        """
+        Inicia gravação das leituras recebidas em uma captura .daqcap.
+        
+        A captura recebe os mesmos lotes entregues ao banco, sem passar
+        pela fila de persistência.
+        
+        Args:
+            path: Caminho do arquivo .daqcap
+            sample_rate_hz: Taxa de amostragem nominal
+            calibration: Calibração por sensor_id
+            
+        Returns:
+            Gravador da captura
+        """
+        from .capture import CaptureWriter
+        
+        self.stop_capture()
+        self._flush_buffer()
+        capture = CaptureWriter(path, sample_rate_hz, calibration)
+        with self._drain_lock:
+            self.capture = capture
+        return capture
+    
+    def stop_capture(self) -> None:
+        """Finaliza a captura em andamento (grava índice e trailer)."""
+        if self.capture is None:
+            return
+        self._flush_buffer()
+        with self._drain_lock:
+            capture, self.capture = self.capture, None
+        try:
+            capture.close()
+        except Exception as e:
+            print(f"Erro ao finalizar captura: {e}")
+    
+    def start_fatigue(self, **options) -> 'FatigueMonitor':
+        """
+        Inicia a análise de fadiga (rainflow, dano, PSD) de todos os sensores.
+        
+        As leituras recebidas a partir daqui alimentam o monitor no
+        caminho de ingestão, com custo O(1) amortizado por leitura.
+        
+        Args:
+            **options: Parâmetros de FatigueAnalyzer (curve, modulus_mpa,
+                gate, range_bin, psd_segment, psd_overlap, psd_averages)
+            
+        Returns:
+            Monitor de fadiga
+        """
+        from .fatigue import FatigueMonitor
+        
+        self.fatigue = FatigueMonitor(**options)
+        return self.fatigue
+    
+    def stop_fatigue(self) -> None:
+        """Interrompe a análise de fadiga e descarta seus resultados."""
+        self.fatigue = None
+    
+    def get_fatigue(self, sensor_id: str) -> Optional[Dict[str, Any]]:
+        """
+        Retorna ciclos rainflow e dano acumulado de um sensor.
+        
+        Args:
+            sensor_id: ID do sensor
+            
+        Returns:
+            Resumo de fadiga (None se a análise não está ativa ou sem dados)
+        """
+        return self.fatigue.fatigue(sensor_id) if self.fatigue is not None else None
+    
+    def get_spectrum(self, sensor_id: str) -> Optional[Dict[str, Any]]:
+        """
+        Retorna a PSD (Welch) de um sensor.
+        
+        Args:
+            sensor_id: ID do sensor
+            
+        Returns:
+            Espectro (None se a análise não está ativa ou sem dados)
+        """
+        return self.fatigue.spectrum(sensor_id) if self.fatigue is not None else None
+    
+    def start_alarms(self, rules: Optional[List[Any]] = None,
+                     history_size: Optional[int] = None) -> 'AlarmEngine':
+        """
+        Inicia o motor de alarmes (limites, taxa, histerese, N em T).
+        
+        Cada lote recebido a partir daqui é avaliado integralmente antes de
+        add_batch retornar; os eventos vão para os assinantes do motor
+        (AlarmEngine.subscribe).
+        
+        Args:
+            rules: AlarmRule ou dicts (None = ALARM_CONFIG['rules'])
+            history_size: Eventos mantidos no histórico
+            
+        Returns:
+            Motor de alarmes
+        """
+        from .alarms import AlarmEngine
+        
+        self.alarms = AlarmEngine(rules, history_size)
+        return self.alarms
+    
+    def stop_alarms(self) -> None:
+        """Interrompe a avaliação de alarmes e descarta seu estado."""
+        self.alarms = None
+    
+    def get_active_alarms(self, sensor_id: Optional[str] = None) -> List[Dict[str, Any]]:
+        """
+        Retorna os alarmes ativos.
+        
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            
+        Returns:
+            Alarmes ativos (vazio se o motor não está ativo)
+        """
+        return self.alarms.active_alarms(sensor_id) if self.alarms is not None else []
     
     def get_recent_readings(self, sensor_id: Optional[str] = None,
                           minutes: int = 60,
                           max_count: Optional[int] = None) -> List[StrainReading]:
         """
-        Retorna leituras recentes (buffer + banco).
+        Retorna leituras recentes (buffer + writer + banco).
+        
+        Com max_count, as fontes são lidas da mais recente para a mais
+        antiga e a consulta para ao atingir o limite (ver ReadingQuery).
         
         Args:
             sensor_id: ID do sensor
             minutes: Minutos para trás
-            max_count: Número máximo de leituras
+            max_count: Número máximo de leituras (as mais recentes)
             
         Returns:
             Lista de leituras ordenadas por timestamp
         """
         start_time = datetime.now() - timedelta(minutes=minutes)
+        if not max_count:
+            return list(self.query.readings(sensor_id, start_time, descending=False))
         
-        # Busca no buffer
-        buffer_readings = self.buffer.get_readings(
-            sensor_id=sensor_id,
-            start_time=start_time
-        )
-        
-        # Busca no banco
-        db_readings = self.database.get_readings(
-            sensor_id=sensor_id,
-            start_time=start_time,
-            limit=max_count
-        )
-        
-        # Combina e ordena
-        all_readings = buffer_readings + db_readings
-        all_readings.sort(key=lambda r: r.timestamp)
-        
-        # Remove duplicatas (baseado em timestamp e sensor_id)
-        unique_readings = []
-        seen = set()
-        for reading in all_readings:
-            key = (reading.timestamp, reading.sensor_id)
-            if key not in seen:
-                seen.add(key)
-                unique_readings.append(reading)
+        readings = list(self.query.readings(sensor_id, start_time, limit=max_count))
+        readings.reverse()
+        return readings
+    
+    def query_readings(self, sensor_id: Optional[str] = None,
+                       start_time: Optional[datetime] = None,
+                       end_time: Optional[datetime] = None,
+                       limit: Optional[int] = None,
+                       descending: bool = True) -> Iterator[StrainReading]:
+        """
+        Itera leituras do buffer, do writer e do banco sob demanda.
         
-        # Limita se necessário
-        if max_count and len(unique_readings) > max_count:
-            unique_readings = unique_readings[-max_count:]
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            start_time: Tempo inicial (inclusivo)
+            end_time: Tempo final (inclusivo)
+            limit: Número máximo de leituras
+            descending: Se True, das mais recentes para as mais antigas
+            
+        Returns:
+            Iterador de leituras sem duplicatas (sensor, ms)
+        """
+        return self.query.readings(sensor_id, start_time, end_time, limit, descending)
+    
+    def page_readings(self, sensor_id: Optional[str] = None,
+                      start_time: Optional[datetime] = None,
+                      end_time: Optional[datetime] = None,
+                      page_size: int = 1000,
+                      cursor: Optional[QueryCursor] = None,
+                      descending: bool = True) -> Tuple[List[StrainReading], Optional[QueryCursor]]:
+        """
+        Retorna uma página de leituras para navegação por cursor.
         
-        return unique_readings
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            start_time: Tempo inicial
+            end_time: Tempo final
+            page_size: Leituras por página
+            cursor: Cursor da página anterior (None = primeira página)
+            descending: Ordem da primeira página
+            
+        Returns:
+            (leituras, cursor da próxima página ou None se acabou)
+        """
+        return self.query.page(sensor_id, start_time, end_time, page_size, descending, cursor)
     
     def export_data(self, format_type: str, output_path: Path,
                    sensor_id: Optional[str] = None,
                    start_time: Optional[datetime] = None,
-                   end_time: Optional[datetime] = None) -> None:
+                   end_time: Optional[datetime] = None,
+                   compression: Optional[str] = None,
+                   chunk_size: int = 10000) -> None:
         """
         Exporta dados em formato específico.
         
+        Leituras pendentes são persistidas antes; em seguida o banco é lido
+        em blocos (DatabaseManager.iter_readings) e escrito em ordem
+        cronológica à medida que é lido, com memória independente do
+        tamanho do intervalo. Total e período do cabeçalho vêm dos rollups.
+        
         Args:
-            format_type: Formato ('csv', 'json', 'excel')
+            format_type: Formato ('csv', 'json', 'jsonl', 'excel', 'parquet', 'arrow')
             output_path: Caminho do arquivo de saída
             sensor_id: ID do sensor (opcional)
             start_time: Tempo inicial (opcional)
             end_time: Tempo final (opcional)
+            compression: 'gzip' para formatos de texto (ou extensão .gz)
+            chunk_size: Leituras lidas do banco por bloco
         """
-        # Busca dados
-        readings = self.database.get_readings(
-            sensor_id=sensor_id,
-            start_time=start_time,
-            end_time=end_time
-        )
+        format_type = format_type.lower()
+        if format_type not in ('csv', 'json', 'jsonl', 'excel', 'parquet', 'arrow'):
+            raise ValueError(f"Formato não suportado: {format_type}")
+        
+        self.flush()
+        # O resumo vem dos rollups, que só cobrem linhas já migradas
+        self.database.wait_migration()
+        
+        # Total e período a partir dos rollups, sem percorrer as leituras
+        aggregates = [
+            stats for stats in self.database.get_aggregates(sensor_id, start_time, end_time).values()
+            if stats['count']
+        ]
+        summary: Dict[str, Any] = {'total_readings': sum(stats['count'] for stats in aggregates)}
+        
+        chunks = self.database.iter_readings(sensor_id, start_time, end_time, chunk_size)
+        first = next(chunks, None)
+        if first is not None:
+            chunks = chain([first], chunks)
+            summary['start'] = us_to_datetime(first.timestamps_us[0])
+            summary['end'] = datetime.fromtimestamp(
+                max(stats['last_ts_ms'] for stats in aggregates) / 1000
+            ) if aggregates else summary['start']
         
         # Exporta no formato solicitado
-        if format_type.lower() == 'csv':
-            self.exporter.export_to_csv(readings, output_path)
-        elif format_type.lower() == 'json':
-            self.exporter.export_to_json(readings, output_path)
-        elif format_type.lower() == 'excel':
-            self.exporter.export_to_excel(readings, output_path)
+        if format_type == 'csv':
+            self.exporter.export_to_csv(chunks, output_path, summary=summary,
+                                        compression=compression)
+        elif format_type == 'json':
+            self.exporter.export_to_json(chunks, output_path, summary=summary,
+                                         compression=compression)
+        elif format_type == 'jsonl':
+            self.exporter.export_to_jsonl(chunks, output_path, compression=compression)
+        elif format_type == 'excel':
+            self.exporter.export_to_excel(chunks, output_path, summary=summary)
+        elif format_type == 'parquet':
+            self.exporter.export_to_parquet(chunks, output_path, summary=summary)
         else:
-            raise ValueError(f"Formato não suportado: {format_type}")
+            self.exporter.export_to_arrow(chunks, output_path, summary=summary)
     
     def cleanup_old_data(self, days: int = None) -> int:
         """
@@ -888,7 +3027,7 @@ class DataManager:
         return self.database.cleanup_old_data(days)
     
     def get_oscilloscope_data(self, sensor_id: Optional[str] = None, 
-                             last_n: Optional[int] = None) -> Union[List[Dict], Dict[str, List[Dict]]]:
+                             last_n: Optional[int] = None) -> Union[StreamWindow, Dict[str, StreamWindow]]:
         """
         Retorna dados formatados para visualização em osciloscópio.
         
@@ -904,6 +3043,37 @@ class DataManager:
         else:
             return self.oscilloscope_streamer.get_all_streams()
     
+    def get_oscilloscope_since(self, sensor_id: str, seq: Optional[int] = None,
+                               max_points: Optional[int] = None) -> Tuple[StreamWindow, int, int]:
+        """
+        Retorna pontos de osciloscópio a partir de um número de sequência.
+        
+        Args:
+            sensor_id: ID do sensor
+            seq: Próximo número de sequência esperado (None = janela inteira)
+            max_points: Número máximo de pontos retornados
+            
+        Returns:
+            (janela, seq do primeiro ponto, próximo seq)
+        """
+        return self.oscilloscope_streamer.get_since(sensor_id, seq, max_points)
+    
+    def get_decimated_trace(self, sensor_id: str, width: int, mode: str = 'minmax',
+                            last_n: Optional[int] = None) -> Tuple[List[float], List[float]]:
+        """
+        Retorna o traço de osciloscópio decimado para uma largura em pixels.
+        
+        Args:
+            sensor_id: ID do sensor
+            width: Largura do gráfico em pixels
+            mode: 'minmax' ou 'lttb'
+            last_n: Número de pontos mais recentes (None = todos)
+            
+        Returns:
+            (tempos em ms, valores) decimados
+        """
+        return self.oscilloscope_streamer.get_decimated(sensor_id, width, mode, last_n)
+    
     def get_realtime_values(self) -> Dict[str, Dict]:
         """
         Retorna valores em tempo real de todos os sensores.
@@ -922,6 +3092,54 @@ class DataManager:
         """
         return self.oscilloscope_streamer.get_stream_stats()
     
+    def get_ingest_metrics(self) -> Dict[str, Any]:
+        """
+        Resumo da instrumentação de ingestão (ver core.metrics).
+        
+        Returns:
+            Total de leituras ingeridas e p99 (ms, limite do bucket) da
+            latência até a visibilidade, da idade das leituras e da espera
+            pelo lock do streamer
+        """
+        def p99_ms(histogram) -> Optional[float]:
+            value = histogram.quantile(0.99)
+            return value * 1000 if value is not None else None
+        
+        return {
+            'readings_total': int(_INGESTED.value()),
+            'ingest_to_visible_p99_ms': p99_ms(_INGEST_TO_VISIBLE.histogram),
+            'sample_age_p99_ms': p99_ms(_SAMPLE_AGE),
+            'lock_wait_p99_ms': p99_ms(_LOCK_WAIT_INGEST.histogram),
+            'memory_bytes': {
+                'buffer': self.buffer.memory_bytes(),
+                'streamer': self.oscilloscope_streamer.memory_bytes()
+            }
+        }
+    
+    def _collect_metrics(self) -> List[tuple]:
+        """Coletor de métricas: ocupação, fila de persistência e memória."""
+        writer = self.writer
+        rows = [
+            ('daq_buffer_readings', GAUGE, 'Leituras no buffer em memória', {}, self.buffer.size()),
+            ('daq_buffer_capacity', GAUGE, 'Capacidade do buffer em memória', {}, self.buffer.capacity),
+            ('daq_writer_queue_depth', GAUGE, 'Lotes aguardando o writer', {}, writer.queue_depth),
+            ('daq_writer_readings_written_total', COUNTER, 'Leituras gravadas pelo writer', {},
+             writer.readings_written),
+            ('daq_writer_readings_dropped_total', COUNTER, 'Leituras descartadas por contrapressão', {},
+             writer.readings_dropped),
+            ('daq_writer_readings_spilled_total', COUNTER, 'Leituras gravadas em spill', {},
+             writer.readings_spilled),
+            ('daq_writer_errors_total', COUNTER, 'Falhas de gravação do writer', {},
+             writer.write_errors),
+            ('daq_streamer_sensors', GAUGE, 'Sensores com stream ativo', {},
+             len(self.oscilloscope_streamer._data_streams))
+        ]
+        for structure, size in (('buffer', self.buffer.memory_bytes()),
+                                ('streamer', self.oscilloscope_streamer.memory_bytes())):
+            rows.append(('daq_memory_bytes', GAUGE, 'Memória alocada por estrutura (bytes)',
+                         {'structure': structure}, size))
+        return rows
+    
     def get_statistics(self, sensor_id: Optional[str] = None) -> Dict[str, Any]:
         """
         Retorna estatísticas dos dados.
@@ -932,38 +3150,88 @@ class DataManager:
         Returns:
             Dicionário com estatísticas
         """
-        recent_readings = self.get_recent_readings(sensor_id=sensor_id, minutes=1440)  # 24h
+        start_time = datetime.now() - timedelta(minutes=1440)  # 24h
+        
+        # Banco, buffer e writer lidos sem gravação ou retirada entre eles:
+        # cada leitura é contada uma vez
+        aggregates, buffered, pending = self.writer.read_consistent(
+            lambda: self.database.get_aggregates(sensor_id, start_time),
+            lambda: self.buffer.query(sensor_id=sensor_id, start_time=start_time))
+        
+        # Persistido: rollups do banco (O(buckets))
+        per_sensor: Dict[str, list] = {}
+        for sid, stats in aggregates.items():
+            agg = rollups.from_summary(stats)
+            if agg is not None:
+                per_sensor[sid] = agg
         
-        if not recent_readings:
+        # Em memória: buffer e lotes ainda não gravados, no ms arredondado do banco
+        start_us = datetime_to_us(start_time)
+        for columns in [buffered] + pending:
+            names = columns.sensor_names
+            rows = (
+                (names[key], (ts + 500) // 1000, strain, 0, battery, temperature)
+                for ts, strain, battery, temperature, key in zip(
+                    columns.timestamps_us, columns.strain_values, columns.battery_levels,
+                    columns.temperatures, columns.sensor_keys)
+                if ts >= start_us and (sensor_id is None or names[key] == sensor_id)
+            )
+            for (sid, _), agg in rollups.aggregate_rows(rows, 2**62).items():
+                per_sensor[sid] = rollups.merge(per_sensor.get(sid), agg)
+        
+        if not per_sensor:
             return {
                 'total_readings': 0,
                 'sensors_count': 0,
                 'latest_reading': None
             }
         
-        # Calcula estatísticas
-        strain_values = [r.strain_value for r in recent_readings]
-        sensors = set(r.sensor_id for r in recent_readings)
+        total = None
+        for agg in per_sensor.values():
+            total = rollups.merge(total, agg)
         
         return {
-            'total_readings': len(recent_readings),
-            'sensors_count': len(sensors),
-            'latest_reading': recent_readings[-1].timestamp.isoformat(),
+            'total_readings': total[0],
+            'sensors_count': len(per_sensor),
+            'latest_reading': datetime.fromtimestamp(total[9] / 1000).isoformat(),
             'strain_stats': {
-                'min': min(strain_values),
-                'max': max(strain_values),
-                'avg': sum(strain_values) / len(strain_values)
+                'min': total[1],
+                'max': total[2],
+                'avg': total[3] / total[0]
             },
-            'buffer_size': self.buffer.size()
+            'buffer_size': self.buffer.size(),
+            'persistence': self.writer.get_stats()
         }
     
-    def close(self) -> None:
-        """Encerra o gerenciador de dados."""
-        # Flush final do buffer
+    def close(self, timeout: Optional[float] = None) -> None:
+        """
+        Encerra o gerenciador de dados.
+        
+        Com a partida rápida ativa, grava o snapshot das janelas do
+        osciloscópio. Se o writer não termina dentro do prazo, os lotes que
+        ele ainda não começou a gravar são retirados dele (detach_pending)
+        e vão para o snapshot, sendo persistidos na próxima inicialização;
+        o grupo em gravação fica com o writer, e o banco não é fechado
+        enquanto ele estiver ativo.
+        
+        Args:
+            timeout: Tempo máximo de espera pela gravação no banco (segundos)
+        """
+        # Flush final do buffer e drenagem da fila de persistência
         self._flush_buffer()
+        self.stop_capture()
+        stopped = self.writer.close(timeout)
+        unwritten = [] if stopped else self.writer.detach_pending()
+        
+        if self._warm_start:
+            self._write_snapshot(unwritten)
+        elif unwritten:
+            print(f"Erro ao encerrar: {sum(len(b) for b in unwritten)} leituras não gravadas "
+                  f"no prazo de {timeout}s")
         
         # Limpa streams
         self.oscilloscope_streamer.clear_all_streams()
         
-        # Fecha banco de dados
-        self.database.close()
+        # Fecha banco de dados (conexões do writer ainda em uso se ele não terminou)
+        if stopped:
+            self.database.close()
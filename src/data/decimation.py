@@ -0,0 +1,244 @@
+"""
+Decimação de traços para visualização.
+
+Reduz uma janela do stream a um número de pontos proporcional à largura
+do gráfico em pixels, preservando picos:
+- minmax: envelope com o mínimo e o máximo de cada bucket (até 2 pontos por pixel)
+- lttb: Largest-Triangle-Three-Buckets (1 ponto por pixel)
+
+Os buckets são alinhados aos índices absolutos do buffer circular (ver
+ring_buffer), de modo que um bucket completo não muda quando a janela
+avança. DecimationCache guarda o resultado desses buckets, e cada
+redesenho processa apenas a cauda nova e o bucket parcial da borda
+antiga. As reduções por bucket rodam sobre fatias das colunas
+(memoryview) com min/max/index nativos.
+"""
+
+import math
+from collections import deque
+from typing import List, Sequence, Tuple
+
+
+MINMAX = 'minmax'
+LTTB = 'lttb'
+
+MODES = (MINMAX, LTTB)
+
+Point = Tuple[float, float]
+
+
+def bucket_size(window_points: int, width: int, mode: str) -> int:
+    """
+    Calcula pontos de entrada por bucket para uma largura em pixels.
+
+    Args:
+        window_points: Tamanho nominal da janela (pontos)
+        width: Largura do gráfico em pixels
+        mode: Modo de decimação (MODES)
+
+    Returns:
+        Pontos por bucket (>= 1)
+    """
+    if mode not in MODES:
+        raise ValueError(f"Modo de decimação não suportado: {mode}")
+    width = max(1, int(width))
+    if mode == LTTB:
+        # Primeiro e último pontos são sempre mantidos
+        return max(1, math.ceil(max(window_points - 2, 0) / max(width - 2, 1)))
+    return max(1, math.ceil(window_points / width))
+
+
+def minmax_bucket(times: Sequence[float], values: Sequence[float],
+                  start: int, end: int) -> Tuple[Point, ...]:
+    """
+    Extremos de values[start:end] na ordem temporal.
+
+    Args:
+        times: Coluna de tempos
+        values: Coluna de valores
+        start: Posição inicial
+        end: Posição final (exclusiva)
+
+    Returns:
+        Um ou dois pontos (t, v): mínimo e máximo do bucket
+    """
+    chunk = values[start:end].tolist()
+    low, high = min(chunk), max(chunk)
+    low_at, high_at = chunk.index(low), chunk.index(high)
+    if low_at == high_at:
+        return ((times[start + low_at], low),)
+    first, second = sorted((low_at, high_at))
+    return ((times[start + first], chunk[first]), (times[start + second], chunk[second]))
+
+
+def bucket_mean(times: Sequence[float], values: Sequence[float],
+                start: int, end: int) -> Point:
+    """Ponto médio (t, v) de um bucket."""
+    count = end - start
+    return (sum(times[start:end]) / count, sum(values[start:end]) / count)
+
+
+def lttb_select(times: Sequence[float], values: Sequence[float], start: int, end: int,
+                anchor: Point, following: Point) -> Point:
+    """
+    Escolhe o ponto do bucket que forma o maior triângulo com os vizinhos.
+
+    Args:
+        times: Coluna de tempos
+        values: Coluna de valores
+        start: Posição inicial do bucket
+        end: Posição final (exclusiva)
+        anchor: Ponto escolhido no bucket anterior
+        following: Média do bucket seguinte
+
+    Returns:
+        Ponto (t, v) selecionado
+    """
+    ax, ay = anchor
+    dx, dy = ax - following[0], following[1] - ay
+    chunk_times = times[start:end].tolist()
+    chunk_values = values[start:end].tolist()
+    areas = [abs(dx * (y - ay) - (ax - x) * dy) for x, y in zip(chunk_times, chunk_values)]
+    best = areas.index(max(areas))
+    return (chunk_times[best], chunk_values[best])
+
+
+class DecimationCache:
+    """
+    Decimação incremental de um stream para um modo e tamanho de bucket.
+
+    O bucket b cobre os índices absolutos [b * size, (b + 1) * size).
+    Buckets completos ficam em cache e são descartados quando saem da
+    janela; buckets parciais (bordas) são recalculados a cada chamada.
+
+    No modo lttb a seleção de um bucket só entra no cache quando o
+    bucket seguinte está completo (sua média é final). A âncora de cada
+    seleção é o ponto escolhido no bucket anterior no momento do cálculo,
+    portanto o resultado pode diferir do LTTB recalculado do zero após a
+    janela avançar, mas cada ponto emitido continua sendo um ponto real
+    do seu bucket.
+    """
+
+    def __init__(self, mode: str, size: int):
+        """
+        Inicializa o cache.
+
+        Args:
+            mode: Modo de decimação (MODES)
+            size: Pontos de entrada por bucket
+        """
+        if mode not in MODES:
+            raise ValueError(f"Modo de decimação não suportado: {mode}")
+        self.mode = mode
+        self.size = max(1, size)
+        self._buckets: deque = deque()  # (número do bucket, pontos)
+
+    def clear(self) -> None:
+        """Descarta buckets em cache."""
+        self._buckets.clear()
+
+    def update(self, times: Sequence[float], values: Sequence[float],
+               first: int, end: int) -> Tuple[List[float], List[float]]:
+        """
+        Decima a janela [first, end) do stream.
+
+        Args:
+            times: Coluna de tempos da janela (posição 0 = índice absoluto first)
+            values: Coluna de valores da janela
+            first: Índice absoluto do primeiro ponto
+            end: Índice absoluto final (exclusivo)
+
+        Returns:
+            (tempos, valores) decimados, em ordem temporal
+        """
+        if end <= first:
+            self._buckets.clear()
+            return [], []
+
+        size = self.size
+        first_full = -(-first // size)
+        last_full = end // size
+        buckets = self._buckets
+
+        # Descarta buckets fora da janela ou de um stream reiniciado
+        while buckets and buckets[0][0] < first_full:
+            buckets.popleft()
+        if buckets and buckets[-1][0] >= last_full:
+            buckets.clear()
+
+        if self.mode == LTTB:
+            points = self._lttb(times, values, first, end, first_full, last_full)
+        else:
+            points = self._minmax(times, values, first, end, first_full, last_full)
+        return [point[0] for point in points], [point[1] for point in points]
+
+    def _minmax(self, times, values, first: int, end: int,
+                first_full: int, last_full: int) -> List[Point]:
+        size = self.size
+        buckets = self._buckets
+        if first_full >= last_full:
+            return list(minmax_bucket(times, values, 0, end - first))
+
+        next_bucket = buckets[-1][0] + 1 if buckets else first_full
+        for bucket in range(next_bucket, last_full):
+            start = bucket * size - first
+            buckets.append((bucket, minmax_bucket(times, values, start, start + size)))
+
+        points: List[Point] = []
+        head_end = first_full * size - first
+        if head_end > 0:
+            points.extend(minmax_bucket(times, values, 0, head_end))
+        for _, bucket_points in buckets:
+            points.extend(bucket_points)
+        tail_start = last_full * size - first
+        if tail_start < end - first:
+            points.extend(minmax_bucket(times, values, tail_start, end - first))
+        return points
+
+    def _lttb(self, times, values, first: int, end: int,
+              first_full: int, last_full: int) -> List[Point]:
+        size = self.size
+        buckets = self._buckets
+        count = end - first
+        head: Point = (times[0], values[0])
+        last: Point = (times[count - 1], values[count - 1])
+        if count <= 2:
+            return [head, last] if count == 2 else [head]
+
+        def segment(bucket: int) -> Tuple[int, int]:
+            """Posições internas (sem primeiro e último pontos) do bucket."""
+            return max(1, bucket * size - first), min(count - 1, (bucket + 1) * size - first)
+
+        # Bucket b entra no cache quando b + 1 está inteiro no interior da janela
+        cache_until = (end - 1) // size - 1
+        next_bucket = buckets[-1][0] + 1 if buckets else first_full
+        anchor = buckets[-1][1] if buckets else head
+        for bucket in range(next_bucket, cache_until):
+            start, stop = segment(bucket)
+            anchor = lttb_select(times, values, start, stop, anchor,
+                                 bucket_mean(times, values, *segment(bucket + 1)))
+            buckets.append((bucket, anchor))
+
+        # Borda antiga (bucket parcial) e buckets ainda abertos: recalculados a cada chamada
+        first_open = buckets[-1][0] + 1 if buckets else first_full
+        open_segments = [segment(bucket) for bucket in range(first_open, (end - 2) // size + 1)]
+        open_segments = [(start, stop) for start, stop in open_segments if start < stop]
+
+        points: List[Point] = [head]
+        head_stop = min(count - 1, first_full * size - first)
+        if head_stop > 1:
+            following_segment = segment(first_full)
+            following = (bucket_mean(times, values, *following_segment)
+                         if following_segment[0] < following_segment[1] else last)
+            points.append(lttb_select(times, values, 1, head_stop, head, following))
+        points.extend(point for _, point in buckets)
+
+        anchor = points[-1]
+        for index, (start, stop) in enumerate(open_segments):
+            following = (bucket_mean(times, values, *open_segments[index + 1])
+                         if index + 1 < len(open_segments) else last)
+            anchor = lttb_select(times, values, start, stop, anchor, following)
+            points.append(anchor)
+
+        points.append(last)
+        return points
@@ -0,0 +1,628 @@
+"""
+Análise de fadiga em tempo real: rainflow, dano de Miner e PSD.
+
+Cada sensor tem um FatigueAnalyzer que processa as leituras à medida que
+chegam, com custo O(1) amortizado por amostra:
+
+- RainflowCounter: contagem de ciclos pelo método de três pontos da ASTM
+  E1049 (seção 5.4.4), incremental. As reversões são extraídas com uma
+  histerese (gate) contra ruído e empilhadas; cada reversão entra e sai
+  da pilha uma única vez. O que sobra na pilha (resíduo) são meios ciclos
+  ainda abertos.
+- MinerDamage: dano acumulado pela regra de Palmgren-Miner, D = Σ n/N(S),
+  com curva S-N bilinear (inclinação m até o joelho, m2 depois, sem dano
+  abaixo do corte). A faixa de deformação (µε) vira faixa de tensão pelo
+  módulo de elasticidade.
+- WelchPSD: densidade espectral de potência pelo método de Welch:
+  segmentos sobrepostos com janela de Hann, FFT de cada segmento e média
+  dos espectros. Com numpy os segmentos completados por um lote são
+  transformados juntos (rfft em 2D); sem numpy é usada uma FFT radix-2
+  em Python puro.
+
+FatigueMonitor reúne os analisadores de todos os sensores e recebe os
+mesmos lotes do caminho de ingestão do DataManager (add_batch).
+"""
+
+import cmath
+import math
+import threading
+from collections import deque
+from dataclasses import dataclass
+from functools import cached_property
+from typing import Any, Callable, Dict, List, Optional, Sequence, Tuple
+
+from ..core.config import FATIGUE_CONFIG
+from ..core.models import StrainBatch
+
+
+@dataclass(frozen=True)
+class SNCurve:
+    """
+    Curva S-N bilinear (faixa de tensão em MPa).
+
+    Attributes:
+        reference_range: Faixa de tensão resistente em reference_cycles (ex: FAT 90)
+        m: Inclinação até o joelho
+        reference_cycles: Ciclos de referência da classe (2e6)
+        knee_cycles: Ciclos no joelho (None = inclinação única)
+        m2: Inclinação após o joelho
+        cutoff_cycles: Ciclos no limite de corte (faixas menores não causam dano)
+    """
+    reference_range: float
+    m: float = 3.0
+    reference_cycles: float = 2e6
+    knee_cycles: Optional[float] = None
+    m2: Optional[float] = None
+    cutoff_cycles: Optional[float] = None
+
+    def __post_init__(self):
+        if self.reference_range <= 0 or self.m <= 0:
+            raise ValueError("Curva S-N requer faixa de referência e inclinação positivas")
+
+    @classmethod
+    def from_config(cls, name: Optional[str] = None) -> 'SNCurve':
+        """
+        Cria a curva a partir de FATIGUE_CONFIG['sn_curves'].
+
+        Args:
+            name: Nome da curva (None = FATIGUE_CONFIG['sn_curve'])
+
+        Returns:
+            Curva S-N
+        """
+        name = name or FATIGUE_CONFIG['sn_curve']
+        try:
+            return cls(**FATIGUE_CONFIG['sn_curves'][name])
+        except KeyError:
+            raise ValueError(f"Curva S-N não configurada: {name}")
+
+    def _range_at(self, cycles: float, slope: float,
+                  origin_range: float, origin_cycles: float) -> float:
+        return origin_range * (origin_cycles / cycles) ** (1.0 / slope)
+
+    @cached_property
+    def knee_range(self) -> Optional[float]:
+        """Faixa de tensão no joelho."""
+        if self.knee_cycles is None:
+            return None
+        return self._range_at(self.knee_cycles, self.m, self.reference_range,
+                              self.reference_cycles)
+
+    @cached_property
+    def cutoff_range(self) -> float:
+        """Faixa de tensão abaixo da qual não há dano."""
+        if self.cutoff_cycles is None:
+            return 0.0
+        knee = self.knee_range
+        if knee is None:
+            return self._range_at(self.cutoff_cycles, self.m, self.reference_range,
+                                  self.reference_cycles)
+        return self._range_at(self.cutoff_cycles, self.m2 or self.m, knee, self.knee_cycles)
+
+    def cycles_to_failure(self, stress_range: float) -> float:
+        """
+        Ciclos até a falha para uma faixa de tensão.
+
+        Args:
+            stress_range: Faixa de tensão (MPa)
+
+        Returns:
+            Ciclos (inf abaixo do corte)
+        """
+        if stress_range <= 0 or stress_range < self.cutoff_range:
+            return math.inf
+        knee = self.knee_range
+        if knee is not None and stress_range < knee:
+            return self.knee_cycles * (knee / stress_range) ** (self.m2 or self.m)
+        return self.reference_cycles * (self.reference_range / stress_range) ** self.m
+
+
+class RainflowCounter:
+    """
+    Contagem rainflow incremental (ASTM E1049, três pontos).
+    """
+
+    def __init__(self, gate: float = 0.0, range_bin: float = 10.0,
+                 on_cycle: Optional[Callable[[float, float, float], None]] = None):
+        """
+        Inicializa o contador.
+
+        Args:
+            gate: Histerese para aceitar uma reversão (mesma unidade dos valores)
+            range_bin: Largura das classes de faixa e média do histograma
+            on_cycle: Chamado com (faixa, média, contagem) a cada ciclo fechado
+                (contagem 1.0) ou meio ciclo do ponto inicial (0.5)
+        """
+        if range_bin <= 0:
+            raise ValueError("Largura de classe deve ser positiva")
+        self.gate = gate
+        self.range_bin = range_bin
+        self.on_cycle = on_cycle
+        self.reset()
+
+    def reset(self) -> None:
+        """Descarta ciclos, resíduo e estado de reversão."""
+        self._stack: List[float] = []
+        self._extreme: Optional[float] = None  # extremo provisório após a última reversão
+        self._direction = 0
+        self.matrix: Dict[Tuple[int, int], float] = {}
+        self.cycles = 0.0
+        self.max_range = 0.0
+        self.samples = 0
+        self.reversals = 0
+
+    def update(self, values: Sequence[float]) -> None:
+        """
+        Processa amostras em ordem temporal.
+
+        Args:
+            values: Valores (µε)
+        """
+        if not len(values):
+            return
+        self.samples += len(values)
+        gate = self.gate
+        extreme = self._extreme
+        direction = self._direction
+        push = self._push
+
+        iterator = iter(values)
+        if extreme is None:
+            extreme = next(iterator)
+            push(extreme)
+
+        for value in iterator:
+            if direction > 0:
+                if value > extreme:
+                    extreme = value
+                elif extreme - value > gate:
+                    push(extreme)
+                    direction, extreme = -1, value
+            elif direction < 0:
+                if value < extreme:
+                    extreme = value
+                elif value - extreme > gate:
+                    push(extreme)
+                    direction, extreme = 1, value
+            else:
+                # Antes da primeira reversão: direção definida a partir da origem
+                origin = self._stack[0]
+                if value - origin > gate:
+                    direction, extreme = 1, value
+                elif origin - value > gate:
+                    direction, extreme = -1, value
+
+        self._extreme = extreme
+        self._direction = direction
+
+    def _push(self, point: float) -> None:
+        """Empilha uma reversão e extrai os ciclos que ela fecha."""
+        stack = self._stack
+        stack.append(point)
+        self.reversals += 1
+        while len(stack) >= 3:
+            x = abs(stack[-1] - stack[-2])
+            y = abs(stack[-2] - stack[-3])
+            if x < y:
+                break
+            mean = (stack[-2] + stack[-3]) / 2
+            if len(stack) == 3:
+                # Y contém o ponto inicial: meio ciclo, descarta o ponto inicial
+                self._count(y, mean, 0.5)
+                del stack[0]
+            else:
+                self._count(y, mean, 1.0)
+                del stack[-3:-1]
+
+    def _count(self, cycle_range: float, mean: float, count: float) -> None:
+        key = (int(cycle_range // self.range_bin), int(mean // self.range_bin))
+        self.matrix[key] = self.matrix.get(key, 0.0) + count
+        self.cycles += count
+        if cycle_range > self.max_range:
+            self.max_range = cycle_range
+        if self.on_cycle is not None:
+            self.on_cycle(cycle_range, mean, count)
+
+    def residue(self) -> List[float]:
+        """
+        Reversões ainda abertas, incluindo o extremo provisório.
+
+        Returns:
+            Pontos do resíduo em ordem temporal
+        """
+        residue = list(self._stack)
+        if self._direction and self._extreme is not None:
+            residue.append(self._extreme)
+        return residue
+
+    def residue_cycles(self) -> List[Tuple[float, float]]:
+        """
+        Meios ciclos do resíduo (ASTM: contados como 0,5 ao final).
+
+        Returns:
+            Lista de (faixa, média)
+        """
+        residue = self.residue()
+        return [(abs(b - a), (a + b) / 2) for a, b in zip(residue, residue[1:])]
+
+    def range_histogram(self) -> Tuple[List[float], List[float]]:
+        """
+        Ciclos fechados por classe de faixa.
+
+        Returns:
+            (limite inferior de cada classe, ciclos na classe), em ordem crescente
+        """
+        counts: Dict[int, float] = {}
+        for (range_bin, _), count in self.matrix.items():
+            counts[range_bin] = counts.get(range_bin, 0.0) + count
+        bins = sorted(counts)
+        return [b * self.range_bin for b in bins], [counts[b] for b in bins]
+
+
+class MinerDamage:
+    """
+    Dano acumulado pela regra de Palmgren-Miner.
+    """
+
+    def __init__(self, curve: SNCurve, modulus_mpa: float = 210000.0,
+                 strain_scale: float = 1e-6):
+        """
+        Inicializa o acumulador.
+
+        Args:
+            curve: Curva S-N do detalhe monitorado
+            modulus_mpa: Módulo de elasticidade (MPa)
+            strain_scale: Fator da unidade dos valores para deformação (µε = 1e-6)
+        """
+        self.curve = curve
+        self.stress_per_unit = modulus_mpa * strain_scale
+        self.damage = 0.0
+
+    def stress_range(self, strain_range: float) -> float:
+        """Faixa de tensão (MPa) de uma faixa de deformação."""
+        return strain_range * self.stress_per_unit
+
+    def cycle_damage(self, strain_range: float, count: float = 1.0) -> float:
+        """Dano de `count` ciclos de uma faixa de deformação."""
+        cycles = self.curve.cycles_to_failure(self.stress_range(strain_range))
+        return 0.0 if math.isinf(cycles) else count / cycles
+
+    def add_cycle(self, strain_range: float, mean: float = 0.0, count: float = 1.0) -> None:
+        """Acumula um ciclo (assinatura compatível com RainflowCounter.on_cycle)."""
+        self.damage += self.cycle_damage(strain_range, count)
+
+    def with_residue(self, residue_cycles: Sequence[Tuple[float, float]]) -> float:
+        """Dano incluindo os meios ciclos do resíduo."""
+        return self.damage + sum(self.cycle_damage(r, 0.5) for r, _ in residue_cycles)
+
+
+_NUMPY: List[Any] = []
+
+
+def _numpy():
+    """numpy importado na primeira PSD (None se indisponível)."""
+    if not _NUMPY:
+        try:
+            import numpy
+        except ImportError:
+            numpy = None
+        _NUMPY.append(numpy)
+    return _NUMPY[0]
+
+
+_FFT_TWIDDLES: Dict[int, List[complex]] = {}
+
+
+def _fft(values: List[complex]) -> List[complex]:
+    """FFT radix-2 iterativa (tamanho potência de 2)."""
+    size = len(values)
+    data = list(values)
+    j = 0
+    for i in range(1, size):
+        bit = size >> 1
+        while j & bit:
+            j ^= bit
+            bit >>= 1
+        j |= bit
+        if i < j:
+            data[i], data[j] = data[j], data[i]
+
+    twiddles = _FFT_TWIDDLES.get(size)
+    if twiddles is None:
+        twiddles = _FFT_TWIDDLES[size] = [cmath.exp(-2j * math.pi * k / size)
+                                          for k in range(size // 2)]
+    length = 2
+    while length <= size:
+        half = length // 2
+        step = size // length
+        for start in range(0, size, length):
+            k = 0
+            for i in range(start, start + half):
+                t = twiddles[k] * data[i + half]
+                data[i + half] = data[i] - t
+                data[i] += t
+                k += step
+        length *= 2
+    return data
+
+
+class WelchPSD:
+    """
+    PSD incremental pelo método de Welch (Hann, segmentos sobrepostos).
+    """
+
+    def __init__(self, segment: int = 256, overlap: float = 0.5, averages: int = 0):
+        """
+        Inicializa o estimador.
+
+        Args:
+            segment: Amostras por segmento (potência de 2)
+            overlap: Fração de sobreposição entre segmentos [0, 1)
+            averages: Segmentos da média exponencial (0 = média acumulada)
+        """
+        if segment < 8 or segment & (segment - 1):
+            raise ValueError("Segmento deve ser potência de 2 (>= 8)")
+        if not 0 <= overlap < 1:
+            raise ValueError("Sobreposição deve estar em [0, 1)")
+        self.segment = segment
+        self.hop = max(1, int(round(segment * (1 - overlap))))
+        self.averages = averages
+        self.window = [0.5 - 0.5 * math.cos(2 * math.pi * n / segment) for n in range(segment)]
+        self._window_power = sum(w * w for w in self.window)
+        self.reset()
+
+    def reset(self) -> None:
+        """Descarta amostras e espectro acumulado."""
+        self._values: deque = deque(maxlen=self.segment)
+        self._times: deque = deque(maxlen=self.segment)
+        self._since = 0  # amostras desde o último segmento
+        self._power: Optional[List[float]] = None  # |X|² médio (sem escala)
+        self.segments = 0
+        self.sample_rate_hz = 0.0
+
+    def update(self, times_ms: Sequence[float], values: Sequence[float]) -> None:
+        """
+        Acrescenta amostras e processa os segmentos completados.
+
+        Args:
+            times_ms: Timestamps em ms (para a taxa de amostragem)
+            values: Valores
+        """
+        segments: List[List[float]] = []
+        rates: List[float] = []
+        hop, size = self.hop, self.segment
+        history, clock = self._values, self._times
+        position = 0
+        count = len(values)
+        while position < count:
+            # Avança até completar o próximo segmento: o primeiro quando o
+            # histórico enche, os demais a cada `hop` amostras
+            filling = len(history) < size
+            needed = size - len(history) if filling else hop - self._since
+            take = min(needed, count - position)
+            history.extend(values[position:position + take])
+            clock.extend(times_ms[position:position + take])
+            position += take
+            if not filling:
+                self._since += take
+            if take < needed:
+                break
+            self._since = 0
+            segments.append(list(history))
+            span = clock[-1] - clock[0]
+            rates.append((size - 1) * 1000.0 / span if span > 0 else 0.0)
+        if segments:
+            self._accumulate(segments, rates)
+
+    def _accumulate(self, segments: List[List[float]], rates: List[float]) -> None:
+        """Transforma os segmentos (juntos com numpy) e atualiza a média."""
+        window = self.window
+        np = _numpy()
+        if np is not None:
+            data = np.asarray(segments, dtype=float)
+            data -= data.mean(axis=1, keepdims=True)
+            spectra = np.abs(np.fft.rfft(data * np.asarray(window), axis=1)) ** 2
+            powers = spectra.tolist()
+        else:
+            powers = []
+            half = self.segment // 2 + 1
+            for segment in segments:
+                mean = sum(segment) / len(segment)
+                spectrum = _fft([(v - mean) * w for v, w in zip(segment, window)])
+                powers.append([abs(x) ** 2 for x in spectrum[:half]])
+
+        for power, rate in zip(powers, rates):
+            self.segments += 1
+            # Média acumulada até `averages` segmentos, exponencial depois
+            weight = 1.0 / (min(self.segments, self.averages) if self.averages
+                            else self.segments)
+            if self._power is None:
+                self._power = power
+            else:
+                self._power = [p + (q - p) * weight for p, q in zip(self._power, power)]
+            if rate:
+                self.sample_rate_hz += (rate - self.sample_rate_hz) * weight
+
+    def spectrum(self) -> Tuple[List[float], List[float]]:
+        """
+        PSD unilateral atual.
+
+        Returns:
+            (frequências em Hz, densidade em unidade²/Hz); vazias antes do
+            primeiro segmento
+        """
+        if self._power is None or self.sample_rate_hz <= 0:
+            return [], []
+        rate = self.sample_rate_hz
+        scale = 1.0 / (rate * self._window_power)
+        last = len(self._power) - 1
+        psd = [p * scale * (1.0 if k in (0, last) else 2.0) for k, p in enumerate(self._power)]
+        frequencies = [k * rate / self.segment for k in range(len(psd))]
+        return frequencies, psd
+
+
+class FatigueAnalyzer:
+    """
+    Rainflow, dano e PSD de um sensor.
+    """
+
+    def __init__(self, curve: Optional[SNCurve] = None,
+                 modulus_mpa: Optional[float] = None,
+                 gate: Optional[float] = None,
+                 range_bin: Optional[float] = None,
+                 psd_segment: Optional[int] = None,
+                 psd_overlap: Optional[float] = None,
+                 psd_averages: Optional[int] = None):
+        """
+        Inicializa o analisador (padrões de FATIGUE_CONFIG).
+
+        Args:
+            curve: Curva S-N
+            modulus_mpa: Módulo de elasticidade (MPa)
+            gate: Histerese do rainflow (µε)
+            range_bin: Classe do histograma rainflow (µε)
+            psd_segment: Amostras por segmento da PSD
+            psd_overlap: Sobreposição entre segmentos
+            psd_averages: Segmentos da média exponencial (0 = acumulada)
+        """
+        def option(value, key):
+            return FATIGUE_CONFIG[key] if value is None else value
+
+        self.damage = MinerDamage(curve or SNCurve.from_config(),
+                                  option(modulus_mpa, 'modulus_mpa'))
+        self.rainflow = RainflowCounter(option(gate, 'rainflow_gate'),
+                                        option(range_bin, 'range_bin'),
+                                        on_cycle=self.damage.add_cycle)
+        self.psd = WelchPSD(option(psd_segment, 'psd_segment'),
+                            option(psd_overlap, 'psd_overlap'),
+                            option(psd_averages, 'psd_averages'))
+        self.first_time_ms: Optional[float] = None
+        self.last_time_ms: Optional[float] = None
+
+    def update(self, times_ms: Sequence[float], values: Sequence[float]) -> None:
+        """
+        Processa um trecho do sensor em ordem temporal.
+
+        Args:
+            times_ms: Timestamps em ms
+            values: Deformação (µε)
+        """
+        if not len(values):
+            return
+        if self.first_time_ms is None:
+            self.first_time_ms = times_ms[0]
+        self.last_time_ms = times_ms[-1]
+        self.rainflow.update(values)
+        self.psd.update(times_ms, values)
+
+    def fatigue(self) -> Dict[str, Any]:
+        """
+        Resumo de ciclos e dano.
+
+        Returns:
+            Ciclos, dano (fechado e com resíduo), taxa de dano por hora,
+            vida estimada, maior faixa, histograma e resíduo
+        """
+        rainflow, damage = self.rainflow, self.damage
+        residue_cycles = rainflow.residue_cycles()
+        total = damage.with_residue(residue_cycles)
+        hours = 0.0
+        if self.first_time_ms is not None and self.last_time_ms > self.first_time_ms:
+            hours = (self.last_time_ms - self.first_time_ms) / 3.6e6
+        rate = total / hours if hours > 0 else 0.0
+        ranges, counts = rainflow.range_histogram()
+        return {
+            'samples': rainflow.samples,
+            'cycles': rainflow.cycles,
+            'residue_half_cycles': len(residue_cycles),
+            'max_range': max([rainflow.max_range] + [r for r, _ in residue_cycles]),
+            'damage': damage.damage,
+            'damage_with_residue': total,
+            'damage_per_hour': rate,
+            'life_hours': (1.0 - total) / rate if rate > 0 else None,
+            'histogram': {'range_bin': rainflow.range_bin, 'ranges': ranges, 'cycles': counts},
+            'residue': rainflow.residue()
+        }
+
+    def spectrum(self) -> Dict[str, Any]:
+        """
+        PSD e grandezas derivadas.
+
+        Returns:
+            Frequências, PSD, frequência dominante, RMS, segmentos e taxa
+        """
+        frequencies, psd = self.psd.spectrum()
+        dominant = None
+        rms = 0.0
+        if psd:
+            peak = max(range(1, len(psd)), key=psd.__getitem__, default=0)
+            dominant = frequencies[peak]
+            rms = math.sqrt(sum(psd) * (frequencies[1] - frequencies[0]))
+        return {
+            'frequencies': frequencies,
+            'psd': psd,
+            'dominant_frequency': dominant,
+            'rms': rms,
+            'segments': self.psd.segments,
+            'sample_rate_hz': self.psd.sample_rate_hz
+        }
+
+
+class FatigueMonitor:
+    """
+    Analisadores de fadiga de todos os sensores, alimentados pela ingestão.
+    """
+
+    def __init__(self, **options):
+        """
+        Inicializa o monitor.
+
+        Args:
+            **options: Parâmetros de FatigueAnalyzer aplicados a cada novo sensor
+        """
+        self._options = options
+        self._analyzers: Dict[str, FatigueAnalyzer] = {}
+        self._lock = threading.Lock()
+
+    def add_batch(self, batch: StrainBatch) -> None:
+        """
+        Processa um lote do caminho de ingestão (um ou mais sensores).
+
+        Args:
+            batch: Lote de leituras
+        """
+        if not len(batch):
+            return
+        with self._lock:
+            for sensor_id, part in batch.by_sensor():
+                analyzer = self._analyzers.get(sensor_id)
+                if analyzer is None:
+                    analyzer = self._analyzers[sensor_id] = FatigueAnalyzer(**self._options)
+                analyzer.update(part.timestamps_ms(),
+                                part.strain_values)
+
+    @property
+    def sensors(self) -> List[str]:
+        """Sensores analisados."""
+        with self._lock:
+            return list(self._analyzers)
+
+    def fatigue(self, sensor_id: str) -> Optional[Dict[str, Any]]:
+        """Resumo de fadiga do sensor (None se sem dados)."""
+        with self._lock:
+            analyzer = self._analyzers.get(sensor_id)
+            return analyzer.fatigue() if analyzer else None
+
+    def spectrum(self, sensor_id: str) -> Optional[Dict[str, Any]]:
+        """PSD do sensor (None se sem dados)."""
+        with self._lock:
+            analyzer = self._analyzers.get(sensor_id)
+            return analyzer.spectrum() if analyzer else None
+
+    def reset(self, sensor_id: Optional[str] = None) -> None:
+        """Descarta a análise de um sensor (None = todos)."""
+        with self._lock:
+            if sensor_id is None:
+                self._analyzers.clear()
+            else:
+                self._analyzers.pop(sensor_id, None)
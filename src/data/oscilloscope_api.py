@@ -7,13 +7,18 @@ em tempo real formatados especificamente para gráficos tipo osciloscópio.
 
 import json
 import time
-from typing import Dict, List, Optional, Any, Union
+from array import array
+from bisect import bisect_right
+from typing import TYPE_CHECKING, Dict, List, Optional, Any, Union
 from datetime import datetime, timedelta
 from dataclasses import dataclass
 
 from .data_manager import DataManager
 from ..core.models import StrainReading
 
+if TYPE_CHECKING:
+    from .capture import CaptureReader
+
 
 @dataclass
 class OscilloscopeConfig:
@@ -43,19 +48,38 @@ class OscilloscopeAPI:
         self.data_manager = data_manager
         self.config = OscilloscopeConfig()
         self._last_update_time = 0
+        self._last_ingest_sample: Optional[tuple] = None
         
     def get_trace_data(self, sensor_id: str, 
-                      decimation_factor: int = 1) -> Dict[str, Any]:
+                      decimation_factor: int = 1,
+                      width: Optional[int] = None,
+                      mode: str = 'minmax') -> Dict[str, Any]:
         """
         Retorna dados de traço para um sensor específico.
         
+        Com width, todo o stream do sensor é reduzido a um número de pontos
+        proporcional à largura do gráfico, preservando picos ('minmax':
+        envelope mínimo/máximo por pixel; 'lttb': Largest-Triangle-Three-
+        Buckets). O resultado é mantido incrementalmente entre redesenhos.
+        Sem width, mantém a subamostragem por decimation_factor.
+        
         Args:
             sensor_id: ID do sensor
-            decimation_factor: Fator de decimação para reduzir pontos
+            decimation_factor: Fator de decimação para reduzir pontos (sem width)
+            width: Largura do gráfico em pixels
+            mode: Modo de decimação com width ('minmax' ou 'lttb')
             
         Returns:
             Dados do traço formatados para gráfico
         """
+        if width is not None:
+            times, values = self.data_manager.get_decimated_trace(sensor_id, width, mode)
+            if not times:
+                return self._empty_trace()
+            trace = self._build_trace(sensor_id, times, values)
+            trace['decimation'] = mode
+            return trace
+        
         # Busca dados do stream
         stream_data = self.data_manager.get_oscilloscope_data(
             sensor_id=sensor_id,
@@ -69,10 +93,13 @@ class OscilloscopeAPI:
         if decimation_factor > 1:
             stream_data = stream_data[::decimation_factor]
         
-        # Extrai arrays para plotagem rápida
-        times = [point['t'] for point in stream_data]
-        values = [point['v'] for point in stream_data]
-        
+        # Extrai colunas para plotagem rápida (direto das views do stream)
+        return self._build_trace(sensor_id, stream_data.times.tolist(),
+                                 stream_data.values.tolist())
+    
+    def _build_trace(self, sensor_id: str, times: List[float],
+                     values: List[float]) -> Dict[str, Any]:
+        """Monta a estrutura de traço a partir das colunas."""
         # Calcula estatísticas
         if values:
             y_min = min(values)
@@ -86,13 +113,41 @@ class OscilloscopeAPI:
             'times': times,
             'values': values,
             'point_count': len(times),
-            'time_span': (max(times) - min(times)) / 1000.0 if len(times) > 1 else 0,
+            'time_span': (times[-1] - times[0]) / 1000.0 if len(times) > 1 else 0,
             'y_min': y_min,
             'y_max': y_max,
             'y_range': y_range,
             'last_update': time.time() * 1000
         }
     
+    def get_capture_trace(self, reader: 'CaptureReader', sensor_id: str,
+                          start_time: Optional[datetime] = None,
+                          end_time: Optional[datetime] = None,
+                          width: Optional[int] = None) -> Dict[str, Any]:
+        """
+        Retorna traço de um intervalo de uma captura .daqcap.
+        
+        Lê apenas as páginas do intervalo no arquivo mapeado, permitindo
+        navegar por gravações longas sem carregá-las.
+        
+        Args:
+            reader: Captura aberta
+            sensor_id: ID do sensor
+            start_time: Início do intervalo
+            end_time: Fim do intervalo
+            width: Largura do gráfico em pixels (padrão: max_points)
+            
+        Returns:
+            Dados do traço formatados para gráfico
+        """
+        times, values = reader.decimate(sensor_id, width or self.config.max_points,
+                                        start_time, end_time)
+        if not times:
+            return self._empty_trace()
+        trace = self._build_trace(sensor_id, times, values)
+        trace['decimation'] = 'minmax'
+        return trace
+    
     def get_multi_trace_data(self, sensor_ids: List[str]) -> Dict[str, Dict[str, Any]]:
         """
         Retorna dados de múltiplos traços.
@@ -160,12 +215,10 @@ class OscilloscopeAPI:
         if not stream_data:
             return self._empty_streaming_data()
         
-        # Filtra dados novos
+        # Filtra dados novos (pontos do stream estão em ordem temporal)
         if since_timestamp is not None:
-            stream_data = [
-                point for point in stream_data 
-                if point['t'] > since_timestamp
-            ]
+            stream_data = stream_data[bisect_right(stream_data.times, since_timestamp):]
+        stream_data = stream_data.to_points()
         
         return {
             'sensor_id': sensor_id,
@@ -175,6 +228,123 @@ class OscilloscopeAPI:
             'has_more': len(stream_data) > 0
         }
     
+    def get_since(self, sensor_id: str, seq: Optional[int] = None,
+                  max_points: Optional[int] = None) -> Dict[str, Any]:
+        """
+        Retorna pontos novos a partir de um cursor (número de sequência).
+        
+        Cada ponto recebe na ingestão um número de sequência crescente por
+        sensor; o cliente guarda 'next_seq' e o envia na próxima consulta.
+        O custo é proporcional aos pontos novos, não ao tamanho da janela.
+        
+        Args:
+            sensor_id: ID do sensor
+            seq: Cursor retornado na consulta anterior (None = janela inteira)
+            max_points: Número máximo de pontos por resposta
+            
+        Returns:
+            Dados incrementais com 'seq' (primeiro ponto), 'next_seq' e
+            'missed' (pontos que saíram da janela antes de serem lidos)
+        """
+        window, first_seq, next_seq = self.data_manager.get_oscilloscope_since(
+            sensor_id, seq, max_points
+        )
+        points = window.to_points()
+        
+        return {
+            'sensor_id': sensor_id,
+            'new_points': len(points),
+            'data': points,
+            'latest_timestamp': points[-1]['t'] if points else None,
+            'has_more': len(points) > 0,
+            'seq': first_seq,
+            'next_seq': next_seq,
+            'missed': max(0, first_seq - seq) if seq is not None else 0
+        }
+    
+    def get_fatigue_data(self, sensor_id: str) -> Dict[str, Any]:
+        """
+        Retorna contagem rainflow e dano acumulado (Miner) de um sensor.
+        
+        Requer DataManager.start_fatigue (ou FATIGUE_CONFIG['enabled']).
+        
+        Args:
+            sensor_id: ID do sensor
+            
+        Returns:
+            Ciclos, dano, taxa de dano, vida estimada, histograma de faixas
+            e resíduo ('active' False se a análise não está ativa)
+        """
+        fatigue = self.data_manager.get_fatigue(sensor_id)
+        if fatigue is None:
+            return {
+                'sensor_id': sensor_id,
+                'active': self.data_manager.fatigue is not None,
+                'samples': 0,
+                'cycles': 0.0,
+                'damage': 0.0,
+                'damage_with_residue': 0.0,
+                'histogram': {'ranges': [], 'cycles': []}
+            }
+        return {'sensor_id': sensor_id, 'active': True, **fatigue}
+    
+    def get_spectrum_data(self, sensor_id: str,
+                          max_frequency: Optional[float] = None) -> Dict[str, Any]:
+        """
+        Retorna a PSD (Welch) de um sensor para gráfico de espectro.
+        
+        Args:
+            sensor_id: ID do sensor
+            max_frequency: Limita as frequências retornadas (Hz)
+            
+        Returns:
+            Frequências, PSD, frequência dominante e RMS
+        """
+        spectrum = self.data_manager.get_spectrum(sensor_id)
+        if spectrum is None:
+            return {
+                'sensor_id': sensor_id,
+                'active': self.data_manager.fatigue is not None,
+                'frequencies': [],
+                'psd': [],
+                'dominant_frequency': None,
+                'rms': 0.0
+            }
+        if max_frequency is not None:
+            count = bisect_right(spectrum['frequencies'], max_frequency)
+            spectrum['frequencies'] = spectrum['frequencies'][:count]
+            spectrum['psd'] = spectrum['psd'][:count]
+        return {'sensor_id': sensor_id, 'active': True, **spectrum}
+    
+    def get_alarm_data(self, sensor_id: Optional[str] = None,
+                       recent: int = 50) -> Dict[str, Any]:
+        """
+        Retorna alarmes ativos e eventos recentes.
+        
+        Requer DataManager.start_alarms (ou ALARM_CONFIG['enabled']); os
+        alarmes são avaliados na ingestão, não nesta chamada.
+        
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            recent: Número máximo de eventos recentes
+        
+        Returns:
+            Alarmes ativos, eventos recentes e estatísticas do motor
+        """
+        alarms = self.data_manager.alarms
+        if alarms is None:
+            return {'active': False, 'alarms': [], 'events': [], 'stats': {}}
+        events = [
+            event.to_dict() for event in alarms.history()
+            if sensor_id is None or event.sensor_id == sensor_id
+        ]
+        return {
+            'active': True,
+            'alarms': alarms.active_alarms(sensor_id),
+            'events': events[-recent:] if recent else events,
+            'stats': alarms.get_stats()
+        }
+    
     def get_performance_metrics(self) -> Dict[str, Any]:
         """
         Retorna métricas de performance do sistema.
@@ -184,12 +354,19 @@ class OscilloscopeAPI:
         """
         stats = self.data_manager.get_stream_statistics()
         buffer_stats = self.data_manager.get_statistics()
+        ingest = self.data_manager.get_ingest_metrics()
         
         return {
             'stream_stats': stats,
             'buffer_stats': buffer_stats,
             'api_update_rate': self._calculate_update_rate(),
-            'memory_usage': self._estimate_memory_usage(),
+            'ingest_rate': self._calculate_ingest_rate(ingest['readings_total']),
+            'latency': {
+                'ingest_to_visible_p99_ms': ingest['ingest_to_visible_p99_ms'],
+                'sample_age_p99_ms': ingest['sample_age_p99_ms'],
+                'lock_wait_p99_ms': ingest['lock_wait_p99_ms']
+            },
+            'memory_usage': self._estimate_memory_usage(ingest['memory_bytes']),
             'config': {
                 'time_window': self.config.time_window_seconds,
                 'max_points': self.config.max_points,
@@ -232,12 +409,11 @@ class OscilloscopeAPI:
             return '\n'.join(lines)
         
         elif format_type == 'binary':
-            # Formato binário simples: float64 para cada valor
-            import struct
-            data = b''
-            for t, v in zip(trace_data['times'], trace_data['values']):
-                data += struct.pack('dd', t, v)  # 2 doubles por ponto
-            return data
+            # Formato binário simples: pares (t, v) em float64
+            points = array('d', bytes(16 * len(trace_data['times'])))
+            points[0::2] = array('d', trace_data['times'])
+            points[1::2] = array('d', trace_data['values'])
+            return points.tobytes()
         
         else:
             raise ValueError(f"Formato não suportado: {format_type}")
@@ -277,17 +453,31 @@ class OscilloscopeAPI:
         self._last_update_time = current_time
         return rate
     
-    def _estimate_memory_usage(self) -> Dict[str, int]:
+    def _calculate_ingest_rate(self, readings_total: int) -> float:
+        """Leituras/s ingeridas desde a chamada anterior (contador de ingestão)."""
+        now = time.monotonic()
+        rate = 0.0
+        if self._last_ingest_sample is not None:
+            last_time, last_total = self._last_ingest_sample
+            if now > last_time:
+                rate = (readings_total - last_total) / (now - last_time)
+        self._last_ingest_sample = (now, readings_total)
+        return rate
+    
+    def _estimate_memory_usage(self, measured: Optional[Dict[str, int]] = None) -> Dict[str, int]:
         """Estima uso de memória do sistema."""
         stats = self.data_manager.get_stream_statistics()
         
-        # Estimativas aproximadas
+        # Colunas numéricas do buffer circular (ver _SensorStream.COLUMNS);
+        # os buffers são pré-alocados com a capacidade da janela
         points_per_sensor = stats.get('total_points', 0) / max(stats.get('active_sensors', 1), 1)
-        bytes_per_point = 32  # Estimativa baseada na estrutura dos dados
+        bytes_per_point = stats.get('bytes_per_point', 0)
         
         return {
             'total_points': stats.get('total_points', 0),
             'estimated_bytes': stats.get('total_points', 0) * bytes_per_point,
+            'allocated_bytes': stats.get('allocated_bytes', 0),
+            'measured_bytes': measured or {},
             'points_per_sensor': int(points_per_sensor),
             'active_sensors': stats.get('active_sensors', 0)
         }
@@ -308,16 +498,16 @@ class WebSocketStreamer:
             oscilloscope_api: API do osciloscópio
         """
         self.api = oscilloscope_api
-        self._clients = set()
+        self._clients: Dict[str, Dict[str, int]] = {}  # client_id -> sensor_id -> next_seq
         self._is_streaming = False
         
     def add_client(self, client_id: str) -> None:
         """Adiciona cliente ao streaming."""
-        self._clients.add(client_id)
+        self._clients.setdefault(client_id, {})
         
     def remove_client(self, client_id: str) -> None:
-        """Remove cliente do streaming."""
-        self._clients.discard(client_id)
+        """Remove cliente do streaming (e seus cursores)."""
+        self._clients.pop(client_id, None)
         
     def broadcast_snapshot(self) -> Dict[str, Any]:
         """
@@ -333,18 +523,31 @@ class WebSocketStreamer:
         }
     
     def get_trace_update(self, sensor_id: str, 
-                        since_timestamp: float) -> Dict[str, Any]:
+                        since_timestamp: Optional[float] = None,
+                        client_id: Optional[str] = None,
+                        max_points: Optional[int] = None) -> Dict[str, Any]:
         """
         Gera atualização de traço para WebSocket.
         
+        Com client_id, o streamer mantém o cursor (número de sequência) do
+        cliente por sensor e retorna apenas os pontos que ele ainda não
+        recebeu; since_timestamp é ignorado nesse caso.
+        
         Args:
             sensor_id: ID do sensor
-            since_timestamp: Timestamp da última atualização
+            since_timestamp: Timestamp da última atualização (sem client_id)
+            client_id: ID do cliente
+            max_points: Número máximo de pontos por atualização (com client_id)
             
         Returns:
             Dados de atualização
         """
-        streaming_data = self.api.get_streaming_data(sensor_id, since_timestamp)
+        if client_id is not None:
+            cursors = self._clients.setdefault(client_id, {})
+            streaming_data = self.api.get_since(sensor_id, cursors.get(sensor_id), max_points)
+            cursors[sensor_id] = streaming_data['next_seq']
+        else:
+            streaming_data = self.api.get_streaming_data(sensor_id, since_timestamp)
         
         return {
             'type': 'trace_update',
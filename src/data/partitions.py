@@ -0,0 +1,453 @@
+"""
+Particionamento temporal das leituras em arquivos SQLite diários.
+
+Cada dia (UTC) de leituras fica em um arquivo próprio com a tabela
+readings do schema v2. Um catálogo no banco principal registra as
+partições e suas faixas de tempo; inserções vão para a partição do dia,
+consultas abrem apenas as partições que intersectam o intervalo e a
+retenção apaga arquivos inteiros em vez de executar DELETE.
+
+Os arquivos são abertos por conexões próprias (uma por thread), e não
+com ATTACH, que é limitado a 10 bancos por conexão. Cada conexão só é
+fechada pelo thread que a abriu: ao remover uma partição, os demais
+threads são avisados e fecham as suas na próxima chamada a connection().
+
+Como partição e catálogo são arquivos distintos, uma gravação tem duas
+transações. Cada partição guarda um contador de versão incrementado na
+mesma transação das leituras, e o catálogo registra a versão da última
+gravação que concluiu a segunda transação. Partições com versões
+diferentes (interrupção entre as duas) são listadas por stale_days() e
+reconstruídas com resync().
+"""
+
+import sqlite3
+import threading
+from datetime import datetime, timezone
+from pathlib import Path
+from typing import Callable, Dict, Iterable, List, Optional, Sequence, Set, Tuple
+
+
+DAY_MS = 86_400_000
+
+READINGS_SCHEMA = """
+    CREATE TABLE IF NOT EXISTS readings (
+        sensor_key INTEGER NOT NULL,
+        ts_ms INTEGER NOT NULL,
+        strain_value REAL NOT NULL,
+        raw_adc_value INTEGER NOT NULL,
+        battery_level INTEGER NOT NULL,
+        temperature REAL NOT NULL,
+        PRIMARY KEY (sensor_key, ts_ms)
+    ) WITHOUT ROWID
+"""
+
+CATALOG_SCHEMA = """
+    CREATE TABLE IF NOT EXISTS partitions (
+        day INTEGER PRIMARY KEY,
+        file_name TEXT NOT NULL,
+        row_count INTEGER NOT NULL DEFAULT 0,
+        min_ts_ms INTEGER,
+        max_ts_ms INTEGER,
+        version INTEGER NOT NULL DEFAULT 0
+    )
+"""
+
+# Versão da partição, incrementada a cada gravação (ver stale_days)
+META_SCHEMA = (
+    """
+    CREATE TABLE IF NOT EXISTS partition_meta (
+        id INTEGER PRIMARY KEY CHECK (id = 0),
+        version INTEGER NOT NULL
+    )
+    """,
+    "INSERT OR IGNORE INTO partition_meta (id, version) VALUES (0, 0)"
+)
+
+# Callback de gravação: (conexão, dia, linhas gravadas, linhas substituídas)
+WriteCallback = Callable[[sqlite3.Connection, int, List[Tuple], List[Tuple]], None]
+
+
+def day_of(ts_ms: int) -> int:
+    """Retorna o dia UTC (dias desde epoch) de um timestamp em ms."""
+    return ts_ms // DAY_MS
+
+
+class PartitionRouter:
+    """
+    Roteador de leituras para partições diárias.
+
+    Linhas seguem o layout da tabela readings:
+    (sensor_key, ts_ms, strain_value, raw_adc_value, battery_level, temperature).
+    """
+
+    def __init__(self, directory: Path,
+                 catalog: Callable[[], sqlite3.Connection],
+                 pragmas: Sequence[str] = (),
+                 schema: Sequence[str] = (READINGS_SCHEMA,)):
+        """
+        Inicializa o roteador.
+
+        Args:
+            directory: Diretório dos arquivos de partição
+            catalog: Função que retorna a conexão do banco principal (thread atual)
+            pragmas: PRAGMAs aplicados a cada conexão de partição
+            schema: Comandos DDL executados ao criar/abrir cada partição
+        """
+        self._directory = Path(directory)
+        self._directory.mkdir(parents=True, exist_ok=True)
+        self._catalog = catalog
+        self._pragmas = tuple(pragmas)
+        self._schema = tuple(schema) + META_SCHEMA
+
+        self._local = threading.local()
+        self._lock = threading.Lock()
+        # Conexões por thread dono (dia -> conexão) e dias que cada um deve fechar
+        self._threads: Dict[threading.Thread, Dict[int, sqlite3.Connection]] = {}
+        self._retired: Dict[threading.Thread, Set[int]] = {}
+        self._known_days = set()
+        self._epoch = 0  # incrementado quando partições são removidas
+        # Arquivos removidos ainda abertos por outro thread (Windows)
+        self._unlink_pending: Dict[int, Path] = {}
+
+        with self._catalog() as conn:
+            conn.execute(CATALOG_SCHEMA)
+            columns = {row[1] for row in conn.execute("PRAGMA table_info(partitions)")}
+            if 'version' not in columns:
+                conn.execute(
+                    "ALTER TABLE partitions ADD COLUMN version INTEGER NOT NULL DEFAULT 0"
+                )
+            self._known_days.update(row[0] for row in conn.execute("SELECT day FROM partitions"))
+
+    @staticmethod
+    def file_name(day: int) -> str:
+        """Nome do arquivo da partição de um dia."""
+        date = datetime.fromtimestamp(day * DAY_MS / 1000, tz=timezone.utc)
+        return f"readings_{date:%Y%m%d}.db"
+
+    def path(self, day: int) -> Path:
+        """Caminho do arquivo da partição de um dia."""
+        return self._directory / self.file_name(day)
+
+    def connection(self, day: int) -> sqlite3.Connection:
+        """
+        Retorna a conexão do thread atual com a partição (criando se necessário).
+
+        Args:
+            day: Dia UTC da partição
+
+        Returns:
+            Conexão SQLite com a partição
+        """
+        connections = getattr(self._local, 'connections', None)
+        if connections is None:
+            connections = self._local.connections = {}
+            with self._lock:
+                self._local.epoch = self._epoch
+                self._threads[threading.current_thread()] = connections
+                # Conexões de threads encerrados não têm mais dono para fechá-las
+                finished = [thread for thread in self._threads if not thread.is_alive()]
+                orphans = [conn for thread in finished
+                           for conn in self._threads.pop(thread).values()]
+                for thread in finished:
+                    self._retired.pop(thread, None)
+            for conn in orphans:
+                conn.close()
+        elif self._local.epoch != self._epoch:
+            # Partições removidas por outro thread: fecha as próprias conexões com elas
+            self._close_retired()
+
+        conn = connections.get(day)
+        if conn is None:
+            conn = sqlite3.connect(str(self.path(day)), check_same_thread=False, timeout=30.0)
+            conn.row_factory = sqlite3.Row
+            for pragma in self._pragmas:
+                conn.execute(pragma)
+            for statement in self._schema:
+                conn.execute(statement)
+            conn.commit()
+            with self._lock:
+                connections[day] = conn
+
+        if day not in self._known_days:
+            self._register(day)
+        return conn
+
+    def _register(self, day: int) -> None:
+        """Registra a partição no catálogo antes de receber dados."""
+        with self._catalog() as conn:
+            conn.execute(
+                "INSERT OR IGNORE INTO partitions (day, file_name) VALUES (?, ?)",
+                (day, self.file_name(day))
+            )
+        self._known_days.add(day)
+
+    def insert(self, rows: Iterable[Tuple], replace: bool = True,
+               on_day: Optional[WriteCallback] = None,
+               on_catalog: Optional[WriteCallback] = None) -> Dict[int, List[Tuple]]:
+        """
+        Grava linhas nas partições dos respectivos dias.
+
+        Linhas repetidas no lote (mesmo sensor e ms) são reduzidas a uma:
+        a última com replace, a primeira sem. Sem replace, linhas cuja
+        chave já existe na partição não são gravadas nem repassadas aos
+        callbacks; com replace, as linhas antigas substituídas são
+        repassadas, para que os agregados não as contem duas vezes.
+
+        Args:
+            rows: Linhas no layout da tabela readings
+            replace: Substitui leituras com mesma chave (False = ignora)
+            on_day: Chamado na mesma transação da partição, após a gravação
+                (ex.: agregados da partição)
+            on_catalog: Chamado na mesma transação do catálogo (ex.:
+                agregados do banco principal)
+
+        Returns:
+            Linhas efetivamente gravadas agrupadas por dia
+        """
+        by_day: Dict[int, List[Tuple]] = {}
+        for row in rows:
+            by_day.setdefault(row[1] // DAY_MS, []).append(row)
+
+        verb = "INSERT OR REPLACE" if replace else "INSERT OR IGNORE"
+        written: Dict[int, List[Tuple]] = {}
+        for day, day_rows in by_day.items():
+            with self.connection(day) as conn:
+                day_rows, replaced = self._resolve(conn, day_rows, replace)
+                if not day_rows:
+                    continue
+                conn.executemany(f"""
+                    {verb} INTO readings
+                    (sensor_key, ts_ms, strain_value, raw_adc_value,
+                     battery_level, temperature)
+                    VALUES (?, ?, ?, ?, ?, ?)
+                """, day_rows)
+                conn.execute("UPDATE partition_meta SET version = version + 1")
+                version = conn.execute("SELECT version FROM partition_meta").fetchone()[0]
+                if on_day is not None:
+                    on_day(conn, day, day_rows, replaced)
+
+            timestamps = [row[1] for row in day_rows]
+            with self._catalog() as conn:
+                conn.execute("""
+                    UPDATE partitions SET
+                        row_count = row_count + ?,
+                        min_ts_ms = min(coalesce(min_ts_ms, ?), ?),
+                        max_ts_ms = max(coalesce(max_ts_ms, ?), ?),
+                        version = ?
+                    WHERE day = ?
+                """, (len(day_rows) - len(replaced), min(timestamps), min(timestamps),
+                      max(timestamps), max(timestamps), version, day))
+                if on_catalog is not None:
+                    on_catalog(conn, day, day_rows, replaced)
+            written[day] = day_rows
+        return written
+
+    @staticmethod
+    def _resolve(conn: sqlite3.Connection, rows: List[Tuple],
+                 replace: bool) -> Tuple[List[Tuple], List[Tuple]]:
+        """Remove repetições do lote e separa as chaves que já existem na partição."""
+        unique: Dict[Tuple[int, int], Tuple] = {}
+        if replace:
+            for row in rows:
+                unique[(row[0], row[1])] = row
+        else:
+            for row in rows:
+                unique.setdefault((row[0], row[1]), row)
+        if len(unique) != len(rows):
+            rows = list(unique.values())
+
+        # Um intervalo por sensor: sem sobreposição (caso comum) a busca é vazia
+        bounds: Dict[int, List[int]] = {}
+        for key, ts in unique:
+            span = bounds.get(key)
+            if span is None:
+                bounds[key] = [ts, ts]
+            elif ts < span[0]:
+                span[0] = ts
+            elif ts > span[1]:
+                span[1] = ts
+        existing = []
+        for key, (low, high) in bounds.items():
+            for row in conn.execute("""
+                SELECT sensor_key, ts_ms, strain_value, raw_adc_value,
+                       battery_level, temperature
+                FROM readings WHERE sensor_key = ? AND ts_ms BETWEEN ? AND ?
+            """, (key, low, high)):
+                if (row[0], row[1]) in unique:
+                    existing.append(tuple(row))
+
+        if not existing:
+            return rows, []
+        if replace:
+            return rows, existing
+        taken = {(row[0], row[1]) for row in existing}
+        return [row for row in rows if (row[0], row[1]) not in taken], []
+
+    def stale_days(self) -> List[int]:
+        """
+        Lista partições cuja última gravação não chegou ao catálogo.
+
+        Returns:
+            Dias UTC com versão da partição diferente da do catálogo
+        """
+        stale = []
+        for day, version in self._catalog().execute(
+                "SELECT day, version FROM partitions ORDER BY day").fetchall():
+            path = self.path(day)
+            if not path.exists():
+                continue
+            conn = sqlite3.connect(str(path), timeout=30.0)
+            try:
+                current = conn.execute("SELECT version FROM partition_meta").fetchone()
+            except sqlite3.OperationalError:
+                current = None  # Partição anterior ao contador de versão
+            finally:
+                conn.close()
+            if (current[0] if current else 0) != version:
+                stale.append(day)
+        return stale
+
+    def resync(self, day: int,
+               on_catalog: Optional[Callable[[sqlite3.Connection, int], None]] = None) -> None:
+        """
+        Reconstrói a entrada do catálogo de uma partição a partir dos dados.
+
+        Args:
+            day: Dia UTC da partição
+            on_catalog: Chamado como on_catalog(conexão, dia) na mesma
+                transação do catálogo (ex.: reconstrução de agregados)
+        """
+        conn = self.connection(day)
+        count, low, high = conn.execute(
+            "SELECT count(*), min(ts_ms), max(ts_ms) FROM readings"
+        ).fetchone()
+        version = conn.execute("SELECT version FROM partition_meta").fetchone()[0]
+        with self._catalog() as catalog:
+            catalog.execute("""
+                UPDATE partitions SET row_count = ?, min_ts_ms = ?, max_ts_ms = ?, version = ?
+                WHERE day = ?
+            """, (count, low, high, version, day))
+            if on_catalog is not None:
+                on_catalog(catalog, day)
+
+    def days(self, start_ms: Optional[int] = None, end_ms: Optional[int] = None,
+             descending: bool = False) -> List[int]:
+        """
+        Lista partições que intersectam o intervalo [start_ms, end_ms].
+
+        Args:
+            start_ms: Início do intervalo (None = sem limite)
+            end_ms: Fim do intervalo (None = sem limite)
+            descending: Ordem do mais recente para o mais antigo
+
+        Returns:
+            Dias UTC das partições
+        """
+        low = day_of(start_ms) if start_ms is not None else -2**62
+        high = day_of(end_ms) if end_ms is not None else 2**62
+        order = "DESC" if descending else "ASC"
+        rows = self._catalog().execute(
+            f"SELECT day FROM partitions WHERE day BETWEEN ? AND ? ORDER BY day {order}",
+            (low, high)
+        ).fetchall()
+        return [row[0] for row in rows]
+
+    def row_count(self) -> int:
+        """Total de leituras registrado no catálogo."""
+        return self._catalog().execute(
+            "SELECT coalesce(sum(row_count), 0) FROM partitions"
+        ).fetchone()[0]
+
+    def drop_before(self, cutoff_ms: int) -> int:
+        """
+        Remove partições cujo dia termina antes de cutoff_ms.
+
+        O custo depende apenas do número de partições removidas, não do
+        volume de dados. A granularidade é de um dia: leituras anteriores
+        ao corte que pertencem ao dia do corte permanecem até o dia expirar.
+
+        Args:
+            cutoff_ms: Timestamp (ms) mais antigo a ser mantido
+
+        Returns:
+            Número de leituras removidas (segundo o catálogo)
+        """
+        limit_day = day_of(cutoff_ms)
+        with self._catalog() as conn:
+            rows = conn.execute(
+                "SELECT day, row_count FROM partitions WHERE day < ?", (limit_day,)
+            ).fetchall()
+            conn.execute("DELETE FROM partitions WHERE day < ?", (limit_day,))
+
+        removed = 0
+        for day, row_count in rows:
+            self._known_days.discard(day)
+            self._close_day(day)
+            self._unlink(day, self.path(day))
+            removed += row_count
+        return removed
+
+    def _close_day(self, day: int) -> None:
+        """
+        Fecha as conexões com uma partição removida.
+
+        Fecha aqui a conexão do thread atual e as de threads já encerrados;
+        os demais threads fecham as suas em _close_retired().
+        """
+        current = threading.current_thread()
+        closing = []
+        with self._lock:
+            self._epoch += 1
+            for thread, connections in list(self._threads.items()):
+                if day not in connections:
+                    continue
+                if thread is current or not thread.is_alive():
+                    closing.append(connections.pop(day))
+                    if not connections and thread is not current:
+                        del self._threads[thread]
+                else:
+                    self._retired.setdefault(thread, set()).add(day)
+        for conn in closing:
+            conn.close()
+
+    def _close_retired(self) -> None:
+        """Fecha as conexões do thread atual com partições removidas."""
+        thread = threading.current_thread()
+        connections = self._local.connections
+        with self._lock:
+            self._local.epoch = self._epoch
+            days = self._retired.pop(thread, ())
+            closing = [connections.pop(day) for day in days if day in connections]
+        for conn in closing:
+            conn.close()
+        if closing and self._unlink_pending:
+            self._retry_unlink()
+
+    def _unlink(self, day: int, path: Path) -> None:
+        """Apaga o arquivo de uma partição (adia se ainda estiver aberto)."""
+        try:
+            for suffix in ('', '-wal', '-shm'):
+                Path(str(path) + suffix).unlink(missing_ok=True)
+        except OSError:
+            # Outro thread ainda não fechou sua conexão (arquivo travado)
+            self._unlink_pending[day] = path
+
+    def _retry_unlink(self) -> None:
+        """Tenta de novo apagar arquivos de partições removidas."""
+        for day, path in list(self._unlink_pending.items()):
+            del self._unlink_pending[day]
+            if day not in self._known_days:
+                self._unlink(day, path)
+
+    def close(self) -> None:
+        """Fecha todas as conexões com partições (encerramento)."""
+        with self._lock:
+            connections = [conn for thread_conns in self._threads.values()
+                           for conn in thread_conns.values()]
+            self._threads.clear()
+            self._retired.clear()
+            self._epoch += 1
+        for conn in connections:
+            conn.close()
+        self._local = threading.local()
+        self._retry_unlink()
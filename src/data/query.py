@@ -0,0 +1,243 @@
+"""
+Consultas de leituras sobre buffer, writer e banco como um único fluxo.
+
+Uma consulta é uma intercalação k-way (heapq.merge) de três fontes já
+ordenadas por (ts_ms, sensor_id):
+- o buffer circular em memória (DataBuffer), copiado de uma vez na
+  abertura, com busca binária e limite aplicados no próprio buffer
+- os lotes retirados do buffer e ainda não gravados (WriteBehindWriter)
+- as partições do banco, com um cursor por sensor na ordem da chave
+  primária e LIMIT no SQL (DatabaseManager.iter_rows)
+
+Filtros de sensor e intervalo, ordem e limite são aplicados em cada fonte,
+e o resultado é um iterador consumido sob demanda. Pedir as N leituras
+mais recentes custa O(N) por fonte, não O(tamanho do intervalo); com
+cursor, o buffer (limitado a MAX_BUFFER_SIZE) é copiado sem limite. Leituras
+do mesmo sensor no mesmo milissegundo (resolução do banco) aparecem uma
+vez, com preferência para a fonte mais recente (buffer, depois writer).
+
+As fontes são abertas nessa ordem: uma leitura que passa do buffer para
+o writer, ou do writer para o banco, durante a abertura aparece em duas
+fontes e é deduplicada, mas nunca falta.
+"""
+
+from datetime import datetime
+from operator import itemgetter
+from typing import Iterator, List, NamedTuple, Optional, Tuple, Union
+import heapq
+
+from ..core.models import StrainReading, datetime_to_us
+
+
+# (ts_ms, sensor_id, timestamp_us, strain, adc, bateria, temperatura)
+Row = Tuple[int, str, int, float, int, int, float]
+
+_KEY = itemgetter(0, 1)
+
+
+def _us_to_ms(timestamp_us: int) -> int:
+    """µs -> ms com o arredondamento usado na gravação do banco."""
+    return (timestamp_us + 500) // 1000
+
+
+class QueryCursor(NamedTuple):
+    """
+    Posição de continuação de uma consulta paginada.
+
+    Attributes:
+        ts_ms: Timestamp (ms) da última leitura entregue
+        sensor_id: Sensor da última leitura entregue
+        descending: Ordem da consulta que gerou o cursor
+    """
+    ts_ms: int
+    sensor_id: str
+    descending: bool = True
+
+
+class ReadingQuery:
+    """
+    Motor de consultas intercaladas sobre buffer, writer e banco.
+    """
+
+    def __init__(self, buffer, writer, database):
+        """
+        Inicializa o motor.
+
+        Args:
+            buffer: DataBuffer com as leituras ainda não entregues ao writer
+            writer: WriteBehindWriter (pending() retorna lotes em trânsito)
+            database: DatabaseManager
+        """
+        self.buffer = buffer
+        self.writer = writer
+        self.database = database
+
+    def rows(self, sensor_id: Optional[str] = None,
+             start_time: Optional[Union[datetime, int]] = None,
+             end_time: Optional[Union[datetime, int]] = None,
+             limit: Optional[int] = None,
+             descending: bool = True,
+             cursor: Optional[QueryCursor] = None) -> Iterator[Row]:
+        """
+        Itera linhas ordenadas por (ts_ms, sensor_id).
+
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            start_time: Tempo inicial (datetime ou µs, inclusivo)
+            end_time: Tempo final (datetime ou µs, inclusivo)
+            limit: Número máximo de linhas
+            descending: Se True, das mais recentes para as mais antigas
+            cursor: Continua após a posição indicada (define a ordem)
+
+        Yields:
+            Linhas (ts_ms, sensor_id, timestamp_us, strain_value,
+            raw_adc_value, battery_level, temperature)
+        """
+        start_us = self._to_us(start_time)
+        end_us = self._to_us(end_time)
+        if cursor is not None:
+            descending = cursor.descending
+            # Milissegundo do cursor inteiro: as já entregues são puladas abaixo
+            if descending:
+                bound = cursor.ts_ms * 1000 + 499
+                end_us = bound if end_us is None else min(end_us, bound)
+            else:
+                bound = cursor.ts_ms * 1000 - 500
+                start_us = bound if start_us is None else max(start_us, bound)
+
+        sources = [
+            # Com cursor, as linhas já entregues no ms do cursor não contam no limite
+            self._buffer_rows(sensor_id, start_us, end_us, descending,
+                              None if cursor is not None else limit),
+            self._pending_rows(sensor_id, start_us, end_us, descending),
+            self._database_rows(sensor_id, start_us, end_us, descending, limit,
+                                cursor is not None)
+        ]
+        merged = heapq.merge(*sources, key=_KEY, reverse=descending)
+
+        after = None if cursor is None else (cursor.ts_ms, cursor.sensor_id)
+        previous = None
+        emitted = 0
+        for row in merged:
+            key = _KEY(row)
+            if key == previous:
+                continue
+            previous = key
+            if after is not None:
+                if (key >= after) if descending else (key <= after):
+                    continue
+                after = None
+            yield row
+            emitted += 1
+            if limit and emitted >= limit:
+                return
+
+    def readings(self, sensor_id: Optional[str] = None,
+                 start_time: Optional[Union[datetime, int]] = None,
+                 end_time: Optional[Union[datetime, int]] = None,
+                 limit: Optional[int] = None,
+                 descending: bool = True,
+                 cursor: Optional[QueryCursor] = None) -> Iterator[StrainReading]:
+        """
+        Itera leituras ordenadas por timestamp (ver rows).
+
+        Yields:
+            StrainReading, criadas à medida que são consumidas
+        """
+        for _, sid, timestamp_us, strain, adc, battery, temperature in self.rows(
+                sensor_id, start_time, end_time, limit, descending, cursor):
+            yield StrainReading(
+                timestamp=timestamp_us,
+                strain_value=strain,
+                raw_adc_value=adc,
+                sensor_id=sid,
+                battery_level=battery,
+                temperature=temperature
+            )
+
+    def page(self, sensor_id: Optional[str] = None,
+             start_time: Optional[Union[datetime, int]] = None,
+             end_time: Optional[Union[datetime, int]] = None,
+             page_size: int = 1000,
+             descending: bool = True,
+             cursor: Optional[QueryCursor] = None) -> Tuple[List[StrainReading], Optional[QueryCursor]]:
+        """
+        Retorna uma página de leituras e o cursor da próxima.
+
+        Args:
+            sensor_id: ID do sensor (None = todos)
+            start_time: Tempo inicial (datetime ou µs)
+            end_time: Tempo final (datetime ou µs)
+            page_size: Leituras por página
+            descending: Ordem da primeira página (as seguintes seguem o cursor)
+            cursor: Cursor retornado pela página anterior
+
+        Returns:
+            (leituras, cursor da próxima página ou None se acabou)
+        """
+        if page_size <= 0:
+            raise ValueError("Tamanho de página deve ser positivo")
+        if cursor is not None:
+            descending = cursor.descending
+        readings = list(self.readings(sensor_id, start_time, end_time, page_size + 1,
+                                      descending, cursor))
+        if len(readings) <= page_size:
+            return readings, None
+        del readings[page_size:]
+        last = readings[-1]
+        return readings, QueryCursor(_us_to_ms(last.timestamp_us), last.sensor_id, descending)
+
+    @staticmethod
+    def _to_us(value: Optional[Union[datetime, int]]) -> Optional[int]:
+        if value is None:
+            return None
+        return value if isinstance(value, int) else datetime_to_us(value)
+
+    @staticmethod
+    def _column_rows(columns) -> List[Row]:
+        names = columns.sensor_names
+        return [
+            (_us_to_ms(ts), names[key], ts, strain, adc, battery, temperature)
+            for ts, strain, adc, battery, temperature, key in zip(
+                columns.timestamps_us, columns.strain_values, columns.raw_adc_values,
+                columns.battery_levels, columns.temperatures, columns.sensor_keys)
+        ]
+
+    def _buffer_rows(self, sensor_id: Optional[str], start_us: Optional[int],
+                     end_us: Optional[int], descending: bool,
+                     limit: Optional[int]) -> Iterator[Row]:
+        """Buffer copiado de uma vez a partir da ponta pedida, com busca binária."""
+        # Uma única leitura, antes de writer.pending(): um bloco lido depois
+        # perderia as leituras entregues ao writer nesse intervalo
+        rows = self._column_rows(self.buffer.query(sensor_id, start_us, end_us,
+                                                   max_count=limit or None,
+                                                   earliest=not descending))
+        rows.sort(key=_KEY, reverse=descending)
+        yield from rows
+
+    def _pending_rows(self, sensor_id: Optional[str], start_us: Optional[int],
+                      end_us: Optional[int], descending: bool) -> Iterator[Row]:
+        """Lotes em trânsito no writer (limitados pela fila do writer)."""
+        rows = [
+            row
+            for batch in self.writer.pending()
+            for row in self._column_rows(batch)
+            if (sensor_id is None or row[1] == sensor_id)
+            and (start_us is None or row[2] >= start_us)
+            and (end_us is None or row[2] <= end_us)
+        ]
+        rows.sort(key=_KEY, reverse=descending)
+        yield from rows
+
+    def _database_rows(self, sensor_id: Optional[str], start_us: Optional[int],
+                       end_us: Optional[int], descending: bool,
+                       limit: Optional[int], cursor: bool = False) -> Iterator[Row]:
+        """Partições do banco, com ordem e limite aplicados no SQL."""
+        start_ms = None if start_us is None else _us_to_ms(start_us)
+        end_ms = None if end_us is None else _us_to_ms(end_us)
+        # Com cursor, a linha de cada sensor no ms do cursor é pulada depois
+        if limit and cursor:
+            limit += 1
+        for ts_ms, sid, strain, adc, battery, temperature in self.database.iter_rows(
+                sensor_id, start_ms, end_ms, descending, limit):
+            yield ts_ms, sid, ts_ms * 1000, strain, adc, battery, temperature
@@ -0,0 +1,237 @@
+"""
+Reprodução de capturas .daqcap pelo caminho real de ingestão.
+
+Cada trecho da captura é reempacotado como o nó sensor envia no campo:
+DataPacket colunar de até `packet_size` leituras, enquadrado por
+MessageProtocol (DATA_BATCH). Os bytes passam por FrameDecoder e o pacote
+decodificado entra como StrainBatch em DataManager.add_batch, alimentando o
+OscilloscopeStreamer e a persistência como uma leitura ao vivo.
+
+Modos de velocidade:
+- speed=1.0: tempo real (cada pacote é entregue quando sua última
+  leitura foi amostrada na gravação original)
+- speed=N: N vezes mais rápido
+- speed=None: o mais rápido possível, para medir a taxa máxima de
+  ingestão sustentada
+
+Com vários sensores os pacotes são intercalados pelo timestamp da
+última leitura (instante de envio), como chegariam de nós independentes.
+"""
+
+import asyncio
+import heapq
+import time
+from datetime import datetime
+from typing import Any, Dict, Iterator, List, Optional, Tuple, Union
+
+from ..core.config import COMMUNICATION_CONFIG
+from ..communication.columnar import ColumnarCodec
+from ..communication.protocol import (
+    MessageProtocol,
+    MessageType,
+    CompressionType,
+    PayloadEncoding,
+    FrameDecoder,
+    ProtocolError
+)
+from .capture import CaptureReader, _timestamp_us
+
+
+# Pacote pronto para entrega: (timestamp da primeira leitura, da última, mensagem)
+_Packet = Tuple[int, int, bytes]
+
+
+class CaptureReplayer:
+    """
+    Motor de replay de capturas para análise offline e testes de carga.
+    """
+
+    def __init__(self, reader: CaptureReader, data_manager,
+                 speed: Optional[float] = 1.0,
+                 sensors: Optional[List[str]] = None,
+                 start_time: Optional[Union[datetime, int]] = None,
+                 end_time: Optional[Union[datetime, int]] = None,
+                 packet_size: Optional[int] = None,
+                 rebase_time: bool = False):
+        """
+        Inicializa o replay.
+
+        Args:
+            reader: Captura aberta
+            data_manager: DataManager que recebe as leituras
+            speed: Fator de velocidade (1.0 = tempo real, None = máximo)
+            sensors: Sensores reproduzidos (None = todos)
+            start_time: Início do trecho (datetime ou µs)
+            end_time: Fim do trecho (datetime ou µs)
+            packet_size: Leituras por pacote (padrão: o que cabe em
+                COMMUNICATION_CONFIG['max_packet_size'])
+            rebase_time: Desloca os timestamps para que o replay comece agora
+        """
+        if speed is not None and speed <= 0:
+            raise ValueError("Velocidade deve ser positiva (ou None para máxima)")
+
+        self.reader = reader
+        self.data_manager = data_manager
+        self.speed = speed
+        self.sensors = list(sensors) if sensors else reader.sensors
+        self.start_time = start_time
+        self.end_time = end_time
+        limit = COMMUNICATION_CONFIG['max_packet_size']
+        self.packet_size = packet_size or max(1, min(
+            (ColumnarCodec.max_readings(limit, 'replay_00000000', sensor_id)
+             for sensor_id in self.sensors), default=1
+        ))
+        self.rebase_time = rebase_time
+
+        self.decoder = FrameDecoder(link='replay')
+        self._running = False
+        self._reset_stats()
+
+    def _reset_stats(self) -> None:
+        self.stats: Dict[str, Any] = {
+            'readings': 0,
+            'packets': 0,
+            'bytes': 0,
+            'errors': 0,
+            'ingest_seconds': 0.0,
+            'elapsed_seconds': 0.0,
+            'max_lag_ms': 0.0
+        }
+
+    def stop(self) -> None:
+        """Interrompe o replay após o pacote atual."""
+        self._running = False
+
+    def run(self) -> Dict[str, Any]:
+        """
+        Reproduz a captura (bloqueante).
+
+        Returns:
+            Estatísticas do replay (ver get_stats)
+        """
+        started = self._begin()
+        for due, message in self._schedule(started):
+            if not self._running:
+                break
+            if due is not None:
+                delay = due - time.perf_counter()
+                if delay > 0:
+                    time.sleep(delay)
+            self._deliver(message, due)
+        return self._finish(started)
+
+    async def run_async(self) -> Dict[str, Any]:
+        """
+        Reproduz a captura sem bloquear o loop asyncio.
+
+        No modo máximo o controle é devolvido ao loop a cada pacote.
+
+        Returns:
+            Estatísticas do replay (ver get_stats)
+        """
+        started = self._begin()
+        for due, message in self._schedule(started):
+            if not self._running:
+                break
+            delay = 0.0 if due is None else due - time.perf_counter()
+            await asyncio.sleep(max(0.0, delay))
+            self._deliver(message, due)
+        return self._finish(started)
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Retorna estatísticas do replay.
+
+        Returns:
+            Leituras, pacotes, bytes, erros, tempos e taxas. ingest_rate
+            considera só o caminho de ingestão e sustained_rate inclui a
+            gravação final no banco (flush).
+        """
+        stats = dict(self.stats)
+        stats['ingest_rate'] = (stats['readings'] / stats['ingest_seconds']
+                                if stats['ingest_seconds'] > 0 else 0.0)
+        stats['sustained_rate'] = (stats['readings'] / stats['elapsed_seconds']
+                                   if stats['elapsed_seconds'] > 0 else 0.0)
+        return stats
+
+    def _begin(self) -> float:
+        self._reset_stats()
+        self.decoder.reset()
+        self._running = True
+        return time.perf_counter()
+
+    def _finish(self, started: float) -> Dict[str, Any]:
+        self._running = False
+        self.data_manager.flush()
+        self.stats['elapsed_seconds'] = time.perf_counter() - started
+        return self.get_stats()
+
+    def _schedule(self, started: float) -> Iterator[Tuple[Optional[float], bytes]]:
+        """Pacotes com o instante de entrega (perf_counter) ou None."""
+        origin: Optional[int] = None
+        for first_us, last_us, message in self._packets():
+            if self.speed is None:
+                yield None, message
+                continue
+            if origin is None:
+                origin = first_us
+            yield started + (last_us - origin) / 1e6 / self.speed, message
+
+    def _packets(self) -> Iterator[_Packet]:
+        """Intercala os pacotes de todos os sensores por timestamp."""
+        ranges = [self.reader.time_range(sensor_id) for sensor_id in self.sensors]
+        starts = [r[0] for r in ranges if r is not None]
+        if not starts:
+            return
+        shift = 0
+        if self.rebase_time:
+            origin = _timestamp_us(self.start_time, min(starts))
+            shift = int(time.time() * 1e6) - origin
+
+        streams = [self._sensor_packets(sensor_id, shift) for sensor_id in self.sensors]
+        yield from heapq.merge(*streams, key=lambda packet: packet[1])
+
+    def _sensor_packets(self, sensor_id: str, shift: int) -> Iterator[_Packet]:
+        """Pacotes colunares enquadrados de um sensor, em ordem."""
+        sequence = 0
+        for part in self.reader.read(sensor_id, self.start_time, self.end_time):
+            for start in range(0, len(part), self.packet_size):
+                stop = min(start + self.packet_size, len(part))
+                timestamps = part.timestamps_us[start:stop]
+                if shift:
+                    timestamps = [t + shift for t in timestamps]
+                first_us, last_us = timestamps[0], timestamps[-1]
+                payload = ColumnarCodec.encode_columns(
+                    packet_id=f"replay_{sequence:08d}",
+                    sensor_id=sensor_id,
+                    packet_timestamp_us=last_us,
+                    timestamps_us=timestamps,
+                    strain_values=part.strain_values[start:stop],
+                    raw_adc_values=part.raw_adc_values[start:stop],
+                    temperatures=part.temperatures[start:stop],
+                    battery_levels=part.battery_levels[start:stop],
+                    sequence_number=sequence & 0xFFFF
+                )
+                sequence += 1
+                yield first_us, last_us, MessageProtocol.create_message(
+                    MessageType.DATA_BATCH, payload,
+                    CompressionType.NONE, PayloadEncoding.COLUMNAR
+                )
+
+    def _deliver(self, message: bytes, due: Optional[float]) -> None:
+        """Entrega a mensagem ao caminho de ingestão."""
+        now = time.perf_counter()
+        if due is not None:
+            self.stats['max_lag_ms'] = max(self.stats['max_lag_ms'], (now - due) * 1000)
+
+        self.stats['packets'] += 1
+        self.stats['bytes'] += len(message)
+        try:
+            for frame in self.decoder.feed(message):
+                batch = frame.to_batch()
+                self.data_manager.add_batch(batch)
+                self.stats['readings'] += len(batch)
+        except (ProtocolError, ValueError) as e:
+            self.stats['errors'] += 1
+            print(f"Erro no replay do pacote {self.stats['packets']}: {e}")
+        self.stats['ingest_seconds'] += time.perf_counter() - now
@@ -0,0 +1,281 @@
+"""
+Buffers circulares colunares pré-alocados.
+
+Cada coluna é um array tipado de tamanho fixo, espelhado (2x capacidade):
+a amostra de índice absoluto k é gravada nas posições k % cap e
+k % cap + cap. Assim qualquer janela de até `capacity` amostras
+consecutivas é contígua na memória e pode ser exposta como memoryview
+somente leitura, sem cópia.
+
+Uma view continua válida até que `capacity - len(view)` novas amostras
+sejam gravadas; quem precisar reter os dados por mais tempo deve copiá-los.
+"""
+
+import sys
+from array import array
+from typing import Dict, List, Sequence, Tuple
+
+
+class ColumnRing:
+    """
+    Buffer circular de colunas tipadas com índices absolutos.
+
+    Índices absolutos crescem monotonicamente desde a criação (ou reset)
+    e identificam cada amostra de forma estável, mesmo após o descarte
+    das amostras mais antigas.
+    """
+
+    def __init__(self, capacity: int, columns: Sequence[Tuple[str, str]]):
+        """
+        Inicializa o buffer.
+
+        Args:
+            capacity: Número máximo de amostras retidas
+            columns: Pares (nome, typecode do array) das colunas
+        """
+        if capacity <= 0:
+            raise ValueError("Capacidade deve ser positiva")
+
+        self.capacity = capacity
+        self.names = tuple(name for name, _ in columns)
+        self._typecodes: Dict[str, str] = dict(columns)
+        self._columns: Dict[str, array] = {
+            name: array(typecode, bytes(array(typecode).itemsize * 2 * capacity))
+            for name, typecode in columns
+        }
+        self._arrays = tuple(self._columns[name] for name in self.names)
+        self._codes = tuple(self._typecodes[name] for name in self.names)
+        self._first = 0  # índice absoluto da amostra mais antiga
+        self._end = 0    # próximo índice absoluto a ser gravado
+
+    def __len__(self) -> int:
+        return self._end - self._first
+
+    @property
+    def nbytes(self) -> int:
+        """Memória alocada pelas colunas (bytes, incluindo o espelho)."""
+        return sum(sys.getsizeof(column) for column in self._arrays)
+
+    @property
+    def first_index(self) -> int:
+        """Índice absoluto da amostra mais antiga retida."""
+        return self._first
+
+    @property
+    def end_index(self) -> int:
+        """Índice absoluto da próxima amostra (uma após a mais recente)."""
+        return self._end
+
+    def append(self, values: Sequence) -> int:
+        """
+        Grava uma amostra (valores na ordem das colunas).
+
+        Args:
+            values: Valores da amostra
+
+        Returns:
+            Índice absoluto da amostra
+        """
+        index = self._end
+        slot = index % self.capacity
+        mirror = slot + self.capacity
+        for column, value in zip(self._arrays, values):
+            column[slot] = value
+            column[mirror] = value
+
+        self._end = index + 1
+        if self._end - self._first > self.capacity:
+            self._first = self._end - self.capacity
+        return index
+
+    def extend(self, columns: Sequence[Sequence]) -> int:
+        """
+        Grava várias amostras de uma vez (uma sequência por coluna).
+
+        Usa atribuição por fatias, sem laço Python por amostra.
+
+        Args:
+            columns: Sequências na ordem das colunas, todas do mesmo tamanho
+
+        Returns:
+            Índice absoluto da primeira amostra gravada
+        """
+        count = len(columns[0])
+        start = self._end
+        if count == 0:
+            return start
+
+        # Só as últimas `capacity` amostras sobrevivem
+        skip = max(0, count - self.capacity)
+        for column, typecode, values in zip(self._arrays, self._codes, columns):
+            if len(values) != count:
+                raise ValueError("Colunas com tamanhos diferentes")
+            if (isinstance(values, memoryview) and values.format == typecode
+                    and values.c_contiguous):
+                # Views tipadas (ex: arquivo mapeado) são copiadas como bytes
+                raw, values = values, array(typecode)
+                values.frombytes(raw.cast('B'))
+            elif not isinstance(values, array) or values.typecode != typecode:
+                values = array(typecode, values)
+            self._write(column, (start + skip) % self.capacity, values[skip:])
+
+        self._end = start + count
+        if self._end - self._first > self.capacity:
+            self._first = self._end - self.capacity
+        return start
+
+    def _write(self, column, slot: int, values: array) -> None:
+        """Grava valores a partir de slot, com espelho e quebra de borda."""
+        capacity = self.capacity
+        head = min(len(values), capacity - slot)
+        column[slot:slot + head] = values[:head]
+        column[slot + capacity:slot + capacity + head] = values[:head]
+        tail = len(values) - head
+        if tail:
+            column[0:tail] = values[head:]
+            column[capacity:capacity + tail] = values[head:]
+
+    def value(self, name: str, index: int):
+        """Retorna valor de uma coluna no índice absoluto."""
+        if not self._first <= index < self._end:
+            raise IndexError(f"Índice fora do buffer: {index}")
+        return self._columns[name][index % self.capacity]
+
+    def view(self, name: str, start: int, end: int) -> memoryview:
+        """
+        Retorna view somente leitura de [start, end) em índices absolutos.
+
+        Args:
+            name: Nome da coluna
+            start: Índice absoluto inicial (limitado ao mais antigo)
+            end: Índice absoluto final exclusivo (limitado ao mais recente)
+
+        Returns:
+            memoryview contígua, sem cópia
+        """
+        start = max(start, self._first)
+        end = min(end, self._end)
+        if end <= start:
+            return memoryview(self._columns[name])[0:0].toreadonly()
+        slot = start % self.capacity
+        return memoryview(self._columns[name])[slot:slot + end - start].toreadonly()
+
+    def copy(self, name: str, start: int, end: int) -> array:
+        """
+        Copia [start, end) em índices absolutos para um novo array.
+
+        Args:
+            name: Nome da coluna
+            start: Índice absoluto inicial
+            end: Índice absoluto final exclusivo
+
+        Returns:
+            Array independente do buffer (cópia de memória contígua)
+        """
+        values = array(self._typecodes[name])
+        values.frombytes(self.view(name, start, end).cast('B'))
+        return values
+
+    def gather(self, name: str, indices: Sequence[int]) -> array:
+        """
+        Copia valores de índices absolutos arbitrários para um array.
+
+        Args:
+            name: Nome da coluna
+            indices: Índices absolutos (devem estar retidos)
+
+        Returns:
+            Array com os valores na ordem dos índices
+        """
+        column = self._columns[name]
+        capacity = self.capacity
+        return array(self._typecodes[name], [column[i % capacity] for i in indices])
+
+    def search(self, name: str, target, start: int = None, end: int = None,
+               right: bool = False) -> int:
+        """
+        Busca binária em coluna ordenada (ordem crescente).
+
+        Args:
+            name: Nome da coluna
+            target: Valor procurado
+            start: Limite inferior (índice absoluto)
+            end: Limite superior exclusivo (índice absoluto)
+            right: Se True, retorna posição após valores iguais
+
+        Returns:
+            Índice absoluto de inserção
+        """
+        column = self._columns[name]
+        capacity = self.capacity
+        low = self._first if start is None else max(start, self._first)
+        high = self._end if end is None else min(end, self._end)
+        while low < high:
+            middle = (low + high) // 2
+            value = column[middle % capacity]
+            if value < target or (right and value == target):
+                low = middle + 1
+            else:
+                high = middle
+        return low
+
+    def discard_all(self) -> None:
+        """Descarta todas as amostras mantendo a numeração absoluta."""
+        self._first = self._end
+
+    def reset(self) -> None:
+        """Descarta tudo e reinicia a numeração absoluta."""
+        self._first = 0
+        self._end = 0
+
+
+def search_indices(indices: Sequence[int], ring: ColumnRing, name: str,
+                   target, right: bool = False, low: int = 0) -> int:
+    """
+    Busca binária em uma lista de índices absolutos ordenada por coluna.
+
+    Args:
+        indices: Índices absolutos em ordem crescente de valor
+        ring: Buffer dono dos índices
+        name: Coluna usada como chave
+        target: Valor procurado
+        right: Se True, retorna posição após valores iguais
+        low: Posição inicial da busca em indices
+
+    Returns:
+        Posição de inserção em indices
+    """
+    column = ring._columns[name]
+    capacity = ring.capacity
+    high = len(indices)
+    while low < high:
+        middle = (low + high) // 2
+        value = column[indices[middle] % capacity]
+        if value < target or (right and value == target):
+            low = middle + 1
+        else:
+            high = middle
+    return low
+
+
+def trim_indices(indices: List[int], first_index: int) -> int:
+    """
+    Remove de uma lista ordenada os índices absolutos já descartados.
+
+    Args:
+        indices: Índices absolutos em ordem crescente
+        first_index: Índice absoluto mais antigo ainda retido
+
+    Returns:
+        Número de índices removidos
+    """
+    low, high = 0, len(indices)
+    while low < high:
+        middle = (low + high) // 2
+        if indices[middle] < first_index:
+            low = middle + 1
+        else:
+            high = middle
+    if low:
+        del indices[:low]
+    return low
@@ -0,0 +1,287 @@
+"""
+Agregados (rollups) de leituras em múltiplas resoluções.
+
+Cada bucket guarda, por sensor: contagem, mínimo, máximo, soma e soma dos
+quadrados do strain, extremos de bateria e temperatura e o timestamp da
+última leitura. Agregados são combináveis, de modo que estatísticas de
+qualquer janela podem ser calculadas a partir de buckets em vez de
+leituras individuais.
+"""
+
+import math
+from typing import Dict, Iterable, List, Optional, Sequence, Tuple
+
+
+# Resoluções disponíveis (nome -> largura do bucket em ms), da mais grossa para a mais fina
+RESOLUTIONS = (
+    ('1h', 3_600_000),
+    ('1m', 60_000),
+    ('1s', 1_000),
+)
+
+RESOLUTION_MS = dict(RESOLUTIONS)
+
+# Ordem das colunas de agregado (após sensor_key e bucket)
+AGGREGATE_COLUMNS = ('count', 'min_value', 'max_value', 'sum_value', 'sum_squares',
+                     'battery_min', 'battery_max', 'temperature_min', 'temperature_max',
+                     'last_ts_ms')
+
+
+def table_name(resolution: str) -> str:
+    """Nome da tabela de rollup de uma resolução."""
+    return f"rollup_{resolution}"
+
+
+def rollup_schema(resolution: str) -> str:
+    """DDL da tabela de rollup de uma resolução."""
+    return f"""
+        CREATE TABLE IF NOT EXISTS {table_name(resolution)} (
+            sensor_key INTEGER NOT NULL,
+            bucket_ms INTEGER NOT NULL,
+            count INTEGER NOT NULL,
+            min_value REAL NOT NULL,
+            max_value REAL NOT NULL,
+            sum_value REAL NOT NULL,
+            sum_squares REAL NOT NULL,
+            battery_min INTEGER NOT NULL,
+            battery_max INTEGER NOT NULL,
+            temperature_min REAL NOT NULL,
+            temperature_max REAL NOT NULL,
+            last_ts_ms INTEGER NOT NULL,
+            PRIMARY KEY (sensor_key, bucket_ms)
+        ) WITHOUT ROWID
+    """
+
+
+def upsert_sql(resolution: str) -> str:
+    """UPSERT que combina um agregado parcial com o bucket existente."""
+    return f"""
+        INSERT INTO {table_name(resolution)}
+        (sensor_key, bucket_ms, count, min_value, max_value, sum_value, sum_squares,
+         battery_min, battery_max, temperature_min, temperature_max, last_ts_ms)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+        ON CONFLICT (sensor_key, bucket_ms) DO UPDATE SET
+            count = count + excluded.count,
+            min_value = min(min_value, excluded.min_value),
+            max_value = max(max_value, excluded.max_value),
+            sum_value = sum_value + excluded.sum_value,
+            sum_squares = sum_squares + excluded.sum_squares,
+            battery_min = min(battery_min, excluded.battery_min),
+            battery_max = max(battery_max, excluded.battery_max),
+            temperature_min = min(temperature_min, excluded.temperature_min),
+            temperature_max = max(temperature_max, excluded.temperature_max),
+            last_ts_ms = max(last_ts_ms, excluded.last_ts_ms)
+    """
+
+
+def replace_sql(resolution: str) -> str:
+    """INSERT que substitui o bucket por um agregado recalculado (valor absoluto)."""
+    return f"""
+        INSERT OR REPLACE INTO {table_name(resolution)}
+        (sensor_key, bucket_ms, {', '.join(AGGREGATE_COLUMNS)})
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    """
+
+
+def recompute_sql(source: str, bucket_ms: int, by_sensor: bool = True) -> str:
+    """
+    SELECT que recalcula agregados por (sensor_key, bucket) a partir da fonte.
+
+    Args:
+        source: 'readings' ou a tabela de um rollup mais fino
+        bucket_ms: Largura do bucket de saída em ms
+        by_sensor: Se True, parâmetros (sensor_key, início, fim);
+            senão (início, fim) para todos os sensores
+
+    Returns:
+        SQL com colunas (sensor_key, bucket_ms, AGGREGATE_COLUMNS...)
+    """
+    if source == 'readings':
+        time_column = 'ts_ms'
+        columns = """count(*), min(strain_value), max(strain_value),
+               total(strain_value), total(strain_value * strain_value),
+               min(battery_level), max(battery_level),
+               min(temperature), max(temperature), max(ts_ms)"""
+    else:
+        time_column = 'bucket_ms'
+        columns = """sum(count), min(min_value), max(max_value),
+               total(sum_value), total(sum_squares),
+               min(battery_min), max(battery_max),
+               min(temperature_min), max(temperature_max), max(last_ts_ms)"""
+    sensor = "sensor_key = ? AND " if by_sensor else ""
+    bucket = f"{time_column} - {time_column} % {bucket_ms}"
+    return f"""
+        SELECT sensor_key, {bucket}, {columns}
+        FROM {source}
+        WHERE {sensor}{time_column} >= ? AND {time_column} < ?
+        GROUP BY sensor_key, {bucket}
+    """
+
+
+def key_spans(rows: Iterable[Sequence], bucket_ms: int) -> List[Tuple[int, int, int]]:
+    """
+    Intervalos alinhados a bucket_ms cobertos pelas linhas de cada sensor.
+
+    Args:
+        rows: Linhas no layout readings
+        bucket_ms: Largura do bucket em ms
+
+    Returns:
+        Lista de (sensor_key, início inclusivo, fim exclusivo)
+    """
+    bounds: Dict[int, List[int]] = {}
+    for row in rows:
+        key, ts = row[0], row[1]
+        span = bounds.get(key)
+        if span is None:
+            bounds[key] = [ts, ts]
+        elif ts < span[0]:
+            span[0] = ts
+        elif ts > span[1]:
+            span[1] = ts
+    return [(key, low - low % bucket_ms, high - high % bucket_ms + bucket_ms)
+            for key, (low, high) in bounds.items()]
+
+
+def aggregate_rows(rows: Iterable[Sequence], bucket_ms: int) -> Dict[Tuple[int, int], list]:
+    """
+    Agrega linhas no layout readings por (sensor_key, bucket).
+
+    Args:
+        rows: Linhas (sensor_key, ts_ms, strain, adc, battery, temperature)
+        bucket_ms: Largura do bucket em ms
+
+    Returns:
+        Dicionário (sensor_key, bucket_ms) -> agregado (ordem AGGREGATE_COLUMNS)
+    """
+    buckets: Dict[Tuple[int, int], list] = {}
+    for key, ts, strain, _adc, battery, temperature in rows:
+        bucket = (key, ts - ts % bucket_ms)
+        agg = buckets.get(bucket)
+        if agg is None:
+            buckets[bucket] = [1, strain, strain, strain, strain * strain,
+                               battery, battery, temperature, temperature, ts]
+            continue
+        agg[0] += 1
+        if strain < agg[1]:
+            agg[1] = strain
+        if strain > agg[2]:
+            agg[2] = strain
+        agg[3] += strain
+        agg[4] += strain * strain
+        if battery < agg[5]:
+            agg[5] = battery
+        if battery > agg[6]:
+            agg[6] = battery
+        if temperature < agg[7]:
+            agg[7] = temperature
+        if temperature > agg[8]:
+            agg[8] = temperature
+        if ts > agg[9]:
+            agg[9] = ts
+    return buckets
+
+
+def merge(target: Optional[list], other: Sequence) -> list:
+    """Combina dois agregados (ordem AGGREGATE_COLUMNS)."""
+    if target is None:
+        return list(other)
+    target[0] += other[0]
+    target[1] = min(target[1], other[1])
+    target[2] = max(target[2], other[2])
+    target[3] += other[3]
+    target[4] += other[4]
+    target[5] = min(target[5], other[5])
+    target[6] = max(target[6], other[6])
+    target[7] = min(target[7], other[7])
+    target[8] = max(target[8], other[8])
+    target[9] = max(target[9], other[9])
+    return target
+
+
+def coarsen(buckets: Dict[Tuple[int, int], list], bucket_ms: int) -> Dict[Tuple[int, int], list]:
+    """Reagrupa agregados de uma resolução fina em buckets mais largos."""
+    coarse: Dict[Tuple[int, int], list] = {}
+    for (key, bucket), agg in buckets.items():
+        target = (key, bucket - bucket % bucket_ms)
+        coarse[target] = merge(coarse.get(target), agg)
+    return coarse
+
+
+def to_rows(buckets: Dict[Tuple[int, int], list]) -> List[tuple]:
+    """Converte agregados em linhas para upsert_sql."""
+    return [(key, bucket, *agg) for (key, bucket), agg in buckets.items()]
+
+
+def split_range(start_ms: int, end_ms: int,
+                levels: Sequence[Tuple[str, int]] = RESOLUTIONS) -> List[Tuple[Optional[str], int, int]]:
+    """
+    Decompõe [start_ms, end_ms) em segmentos cobertos por buckets inteiros.
+
+    Usa a resolução mais grossa no miolo do intervalo e resoluções mais
+    finas nas bordas; o que sobra abaixo da resolução mais fina é
+    marcado com resolução None (leituras brutas).
+
+    Args:
+        start_ms: Início (inclusivo)
+        end_ms: Fim (exclusivo)
+        levels: Resoluções (nome, largura ms) da mais grossa para a mais fina
+
+    Returns:
+        Lista de (resolução ou None, início, fim exclusivo)
+    """
+    if start_ms >= end_ms:
+        return []
+    if not levels:
+        return [(None, start_ms, end_ms)]
+
+    name, width = levels[0]
+    low = -(-start_ms // width) * width
+    high = end_ms // width * width
+    if low >= high:
+        return split_range(start_ms, end_ms, levels[1:])
+
+    return (split_range(start_ms, low, levels[1:]) +
+            [(name, low, high)] +
+            split_range(high, end_ms, levels[1:]))
+
+
+def summarize(agg: Optional[Sequence]) -> Dict[str, object]:
+    """
+    Converte um agregado em estatísticas legíveis.
+
+    Args:
+        agg: Agregado (ordem AGGREGATE_COLUMNS) ou None
+
+    Returns:
+        Dicionário com count, min, max, avg, std e extremos de bateria/temperatura
+    """
+    if not agg or not agg[0]:
+        return {'count': 0}
+    count = agg[0]
+    mean = agg[3] / count
+    variance = max(0.0, agg[4] / count - mean * mean)
+    return {
+        'count': count,
+        'min': agg[1],
+        'max': agg[2],
+        'avg': mean,
+        'std': math.sqrt(variance),
+        'battery_min': agg[5],
+        'battery_max': agg[6],
+        'temperature_min': agg[7],
+        'temperature_max': agg[8],
+        'last_ts_ms': agg[9]
+    }
+
+
+def from_summary(stats: Dict[str, object]) -> Optional[list]:
+    """Reconstrói o agregado combinável a partir de summarize()."""
+    count = stats.get('count', 0)
+    if not count:
+        return None
+    mean, std = stats['avg'], stats['std']
+    return [count, stats['min'], stats['max'], mean * count,
+            (std * std + mean * mean) * count,
+            stats['battery_min'], stats['battery_max'],
+            stats['temperature_min'], stats['temperature_max'], stats['last_ts_ms']]
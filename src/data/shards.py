@@ -0,0 +1,670 @@
+"""
+Ingestão em múltiplos processos com streams em memória compartilhada.
+
+Os sensores são distribuídos entre N processos worker por hash estável do
+ID (CRC32, independente do salt de hash() por processo). Cada worker
+decodifica os bytes recebidos dos seus links com FrameDecoder e grava cada
+sensor em um SharedColumnRing: o mesmo layout espelhado de ColumnRing
+usado pelo OscilloscopeStreamer, mas alocado em
+multiprocessing.shared_memory.
+
+O processo principal anexa os rings anunciados pelos workers ao seu
+OscilloscopeStreamer (attach_stream). OscilloscopeAPI, DataManager e GUI
+continuam lendo memoryviews das colunas, agora sobre a memória escrita
+pelo worker: nada é copiado nem serializado no caminho de leitura. O
+mínimo, o máximo e a média da janela são publicados pelo worker no
+cabeçalho do ring a cada lote.
+
+Os workers não abrem o banco. Com um DataManager, os lotes decodificados
+voltam ao processo principal pela fila de resultados (agrupados em até
+PERSIST_BATCH_SIZE leituras ou PERSIST_MAX_LATENCY segundos) e entram em
+DataManager.add_batch sem o osciloscópio, que já os recebeu pelo ring.
+Buffer, writer único, captura, fadiga e alarmes veem assim as mesmas
+leituras que a ingestão no processo principal.
+
+Layout do segmento (little-endian nativo, alinhado a 8 bytes):
+- [0, 32): int64 magic, capacity, first, end
+- [32, 56): float64 min, max, média da janela
+- [56, 64): int64 contador de sequência das estatísticas (seqlock)
+- [64, ...): colunas na ordem de _SensorStream.COLUMNS, 2x capacidade
+
+O worker avança `first` antes de sobrescrever qualquer slot e só avança
+`end` depois de gravar as colunas, de modo que [first, end) nunca contém
+um slot em gravação. copy() e value() no leitor conferem `first` depois
+de ler e repetem a leitura se o intervalo foi alcançado pelo worker no
+meio da cópia. Como no ColumnRing, uma view sem cópia continua válida até
+que `capacity - len(view)` novas amostras sejam gravadas.
+
+As três estatísticas são publicadas sob um seqlock: o contador fica
+ímpar durante a gravação e o leitor repete a leitura até obter o mesmo
+valor par antes e depois.
+"""
+
+import queue
+import threading
+import time
+import multiprocessing
+import zlib
+from array import array
+from multiprocessing import shared_memory
+from typing import Any, Dict, List, Optional, Sequence, Tuple, Union
+
+from ..core.config import config
+from ..core.models import StrainBatch
+from ..communication.protocol import FrameDecoder, MessageType
+from .ring_buffer import ColumnRing
+from .data_manager import (
+    DataManager,
+    DataStorageError,
+    OscilloscopeStreamer,
+    _SensorStream
+)
+
+
+_MAGIC = 0x44515352  # 'DQSR'
+_HEADER_SIZE = 64
+_DATA_TYPES = (MessageType.DATA_BATCH, MessageType.DATA_BUFFER)
+
+
+_BATCH_CODES = ('q', 'd', 'i', 'h', 'd')
+
+
+def _portable_batch(batches: List[StrainBatch]) -> StrainBatch:
+    """Junta lotes em colunas array, serializáveis na fila entre processos."""
+    batch = StrainBatch.concat(batches)
+    columns = [
+        column if isinstance(column, array) and column.typecode == code else array(code, column)
+        for column, code in zip((batch.timestamps_us, batch.strain_values, batch.raw_adc_values,
+                                 batch.battery_levels, batch.temperatures), _BATCH_CODES)
+    ]
+    return StrainBatch(*columns, array('H', batch.sensor_keys), list(batch.sensor_names))
+
+
+def _column_layout(capacity: int,
+                   columns: Sequence[Tuple[str, str]]) -> Tuple[List[Tuple[str, str, int, int]], int]:
+    """Deslocamentos (nome, typecode, início, bytes) das colunas e tamanho total."""
+    layout = []
+    offset = _HEADER_SIZE
+    for name, typecode in columns:
+        size = array(typecode).itemsize * 2 * capacity
+        layout.append((name, typecode, offset, size))
+        offset += (size + 7) & ~7
+    return layout, offset
+
+
+class SharedColumnRing(ColumnRing):
+    """
+    ColumnRing cujas colunas e índices vivem em memória compartilhada.
+
+    Um único processo grava (o dono, que cria o segmento); os demais
+    anexam pelo nome e apenas leem.
+    """
+
+    def __init__(self, capacity: Optional[int], columns: Sequence[Tuple[str, str]],
+                 name: Optional[str] = None, create: bool = True):
+        """
+        Cria ou anexa o segmento compartilhado.
+
+        Args:
+            capacity: Número máximo de amostras (None ao anexar: lido do cabeçalho)
+            columns: Pares (nome, typecode do array) das colunas
+            name: Nome do segmento (None ao criar = nome gerado)
+            create: Se True cria o segmento, senão anexa a um existente
+
+        Raises:
+            ValueError: Se o segmento não tem o layout esperado
+        """
+        if create:
+            if not capacity or capacity <= 0:
+                raise ValueError("Capacidade deve ser positiva")
+            _, size = _column_layout(capacity, columns)
+            self._shm = shared_memory.SharedMemory(name=name, create=True, size=size)
+        else:
+            self._shm = shared_memory.SharedMemory(name=name)
+
+        buffer = self._shm.buf
+        self._ints = buffer[0:32].cast('q')
+        self._floats = buffer[32:56].cast('d')
+        self._sequence = buffer[56:64].cast('q')
+        if create:
+            self._ints[0] = _MAGIC
+            self._ints[1] = capacity
+            self._ints[2] = 0
+            self._ints[3] = 0
+            self._sequence[0] = 0
+        else:
+            if self._ints[0] != _MAGIC:
+                self.close()
+                raise ValueError(f"Segmento não é um SharedColumnRing: {name}")
+            capacity = self._ints[1]
+
+        layout, size = _column_layout(capacity, columns)
+        if len(buffer) < size:
+            self.close()
+            raise ValueError(f"Segmento menor que o layout esperado: {name}")
+
+        self.capacity = capacity
+        self.names = tuple(name for name, _ in columns)
+        self._typecodes: Dict[str, str] = dict(columns)
+        self._columns = {
+            column: buffer[start:start + length].cast(typecode)
+            for column, typecode, start, length in layout
+        }
+        self._arrays = tuple(self._columns[column] for column in self.names)
+        self._codes = tuple(self._typecodes[column] for column in self.names)
+        self._owner = create
+
+    @classmethod
+    def attach(cls, name: str, columns: Sequence[Tuple[str, str]]) -> 'SharedColumnRing':
+        """
+        Anexa (somente leitura) a um ring criado por outro processo.
+
+        Args:
+            name: Nome do segmento
+            columns: Colunas usadas na criação
+
+        Returns:
+            Ring anexado
+        """
+        return cls(None, columns, name=name, create=False)
+
+    # Índices no cabeçalho compartilhado, lidos a cada acesso
+
+    @property
+    def _first(self) -> int:
+        first, end = self._ints[2], self._ints[3]
+        # Lido no meio de um extend maior que a janela: first > end antigo
+        return min(max(first, end - self.capacity), end)
+
+    @_first.setter
+    def _first(self, value: int) -> None:
+        self._ints[2] = value
+
+    @property
+    def _end(self) -> int:
+        return self._ints[3]
+
+    @_end.setter
+    def _end(self, value: int) -> None:
+        self._ints[3] = value
+
+    @property
+    def name(self) -> str:
+        """Nome do segmento compartilhado."""
+        return self._shm.name
+
+    @property
+    def nbytes(self) -> int:
+        """Tamanho do segmento compartilhado (bytes, incluindo cabeçalho)."""
+        return self._shm.size
+
+    def _release_slots(self, count: int) -> None:
+        """Avança first sobre os slots que as próximas `count` amostras sobrescrevem."""
+        end = self._ints[3]
+        first = max(self._ints[2], end + count - self.capacity)
+        # Um extend maior que a janela sobrescreve tudo: janela vazia até o fim
+        self._ints[2] = min(first, end)
+
+    def append(self, values: Sequence) -> int:
+        self._release_slots(1)
+        return super().append(values)
+
+    def extend(self, columns: Sequence[Sequence]) -> int:
+        self._release_slots(len(columns[0]))
+        return super().extend(columns)
+
+    def value(self, name: str, index: int):
+        value = super().value(name, index)
+        if index < self._first:
+            raise IndexError(f"Índice sobrescrito durante a leitura: {index}")
+        return value
+
+    def copy(self, name: str, start: int, end: int) -> array:
+        """
+        Copia [start, end) conferindo se o dono não sobrescreveu o trecho.
+
+        Se `first` passou de start durante a cópia, a cópia é refeita a
+        partir do novo `first` (as amostras anteriores já foram descartadas).
+        """
+        while True:
+            low = max(start, self._first)
+            values = super().copy(name, low, end)
+            if self._first <= low:
+                return values
+
+    def publish_stats(self, minimum: float, maximum: float, average: float) -> None:
+        """Publica as estatísticas da janela no cabeçalho (processo dono)."""
+        sequence, floats = self._sequence, self._floats
+        sequence[0] += 1  # ímpar: gravação em andamento
+        floats[0] = minimum
+        floats[1] = maximum
+        floats[2] = average
+        sequence[0] += 1
+
+    def read_stats(self) -> Tuple[float, float, float]:
+        """Lê (mínimo, máximo, média) publicados pelo dono, sem mistura de lotes."""
+        sequence, floats = self._sequence, self._floats
+        while True:
+            before = sequence[0]
+            if before & 1:
+                time.sleep(0)
+                continue
+            stats = floats[0], floats[1], floats[2]
+            if sequence[0] == before:
+                return stats
+
+    def close(self) -> None:
+        """
+        Libera as views deste processo sobre o segmento.
+
+        Se ainda houver views entregues a consumidores, o mapeamento é
+        mantido até que elas sejam coletadas.
+        """
+        views = [self._ints, self._floats, self._sequence, *getattr(self, '_arrays', ())]
+        for view in views:
+            view.release()
+        self._arrays = ()
+        self._columns = {}
+        try:
+            self._shm.close()
+        except BufferError:
+            pass
+
+    def unlink(self) -> None:
+        """Remove o segmento do sistema (processo dono, após close)."""
+        try:
+            self._shm.unlink()
+        except FileNotFoundError:
+            pass
+
+
+class _PublishingStream(_SensorStream):
+    """Stream do worker: grava no ring compartilhado e publica estatísticas."""
+
+    def _publish(self) -> None:
+        self.ring.publish_stats(self._min[0][1], self._max[0][1],
+                                self._sum / len(self.ring))
+
+    def append(self, time_ms: float, reading) -> None:
+        super().append(time_ms, reading)
+        self._publish()
+
+    def extend(self, times_ms, batch) -> None:
+        super().extend(times_ms, batch)
+        if len(self.ring):
+            self._publish()
+
+
+class _AttachedStream(_SensorStream):
+    """Stream do processo leitor sobre um ring gravado por um worker."""
+
+    def append(self, time_ms: float, reading) -> None:
+        raise DataStorageError("Stream compartilhado é somente leitura")
+
+    def extend(self, times_ms, batch) -> None:
+        raise DataStorageError("Stream compartilhado é somente leitura")
+
+    def stats(self) -> Dict[str, Any]:
+        ring = self.ring
+        minimum, maximum, average = ring.read_stats()
+        return {
+            'points': len(ring),
+            'latest_time': ring.value('t', ring.end_index - 1),
+            'min_value': minimum,
+            'max_value': maximum,
+            'avg_value': average
+        }
+
+    def clear(self) -> None:
+        # Os dados pertencem ao worker; só os caches locais são descartados
+        self._decimation.clear()
+
+
+def _worker_main(shard: int, inbox, results, capacity: int, prefix: str,
+                 forward: bool, batch_size: int, max_latency: float) -> None:
+    """
+    Laço de um worker de ingestão.
+
+    Mensagens da inbox:
+    - ('data', [(chave do link, bytes), ...]): blocos recebidos dos links
+    - ('sync', token): responde ('synced', shard, token, stats) após
+      processar tudo o que chegou antes
+    - None: encaminha o pendente, responde ('stopped', shard, stats) e
+      remove os segmentos
+
+    Cada sensor novo é anunciado com ('sensor', shard, sensor_id, nome do
+    segmento) antes de receber leituras. Com forward, os lotes
+    decodificados são enviados como ('batch', shard, lote), sempre antes
+    da resposta ao 'sync' que os segue.
+    """
+    decoders: Dict[Any, FrameDecoder] = {}
+    streams: Dict[str, _PublishingStream] = {}
+    pending: List[StrainBatch] = []
+    pending_count = 0
+    stats = {'chunks': 0, 'bytes': 0, 'frames': 0, 'readings': 0,
+             'errors': 0, 'forwarded': 0, 'sensors': 0}
+
+    def persist() -> None:
+        nonlocal pending, pending_count
+        if not pending:
+            return
+        results.put(('batch', shard, _portable_batch(pending)))
+        stats['forwarded'] += pending_count
+        pending, pending_count = [], 0
+
+    def stream_for(sensor_id: str) -> _PublishingStream:
+        stream = streams.get(sensor_id)
+        if stream is None:
+            ring = SharedColumnRing(capacity, _SensorStream.COLUMNS,
+                                    name=f"{prefix}_{shard}_{len(streams)}")
+            stream = streams[sensor_id] = _PublishingStream(capacity, ring)
+            stats['sensors'] += 1
+            results.put(('sensor', shard, sensor_id, ring.name))
+        return stream
+
+    try:
+        while True:
+            try:
+                message = inbox.get(timeout=max_latency)
+            except queue.Empty:
+                persist()
+                continue
+            if message is None:
+                break
+
+            kind = message[0]
+            if kind == 'sync':
+                persist()
+                results.put(('synced', shard, message[1], dict(stats)))
+                continue
+
+            for key, data in message[1]:
+                decoder = decoders.get(key)
+                if decoder is None:
+                    decoder = decoders[key] = FrameDecoder()
+                stats['chunks'] += 1
+                stats['bytes'] += len(data)
+                for frame in decoder.feed(data):
+                    if frame.message_type not in _DATA_TYPES:
+                        continue
+                    stats['frames'] += 1
+                    try:
+                        batch = frame.to_batch()
+                    except Exception as e:
+                        stats['errors'] += 1
+                        print(f"Erro ao decodificar lote no worker {shard}: {e}")
+                        continue
+                    for sensor_id, part in batch.by_sensor():
+                        stream_for(sensor_id).extend(
+                            part.timestamps_ms(), part)
+                    stats['readings'] += len(batch)
+                    if forward:
+                        pending.append(batch)
+                        pending_count += len(batch)
+                        if pending_count >= batch_size:
+                            persist()
+    finally:
+        persist()
+        results.put(('stopped', shard, dict(stats)))
+        for stream in streams.values():
+            stream.ring.close()
+            stream.ring.unlink()
+
+
+class ShardedIngest:
+    """
+    Roteador de ingestão para N processos worker.
+
+    submit() acumula os blocos de cada worker e os envia em lotes de
+    `send_chunks`, amortizando o custo da fila entre processos. Os
+    streams anunciados pelos workers são anexados ao OscilloscopeStreamer
+    informado, onde ficam visíveis para OscilloscopeAPI e GUI.
+
+    Com data_manager, os lotes decodificados voltam dos workers e a thread
+    de resultados os entrega a data_manager.add_batch(stream=False): um
+    único writer grava o banco, e captura, fadiga e alarmes continuam
+    valendo para os sensores distribuídos.
+    """
+
+    def __init__(self, streamer: Optional[OscilloscopeStreamer] = None,
+                 shards: Optional[int] = None, capacity: Optional[int] = None,
+                 data_manager: Optional[DataManager] = None,
+                 start_method: str = 'spawn', send_chunks: Optional[int] = None):
+        """
+        Inicializa o roteador (workers iniciados em start()).
+
+        Args:
+            streamer: Streamer que recebe os streams compartilhados
+                (padrão: o de data_manager ou um OscilloscopeStreamer próprio)
+            shards: Número de workers (padrão: config.INGEST_SHARDS ou
+                o número de CPUs)
+            capacity: Pontos por sensor (padrão: config.OSCILLOSCOPE_MAX_POINTS)
+            data_manager: Destino dos lotes decodificados (None = só streams)
+            start_method: Método de início do multiprocessing
+            send_chunks: Blocos acumulados por envio (padrão: config.SHARD_SEND_CHUNKS)
+        """
+        self.shards = shards or config.INGEST_SHARDS or multiprocessing.cpu_count()
+        if self.shards <= 0:
+            raise ValueError("Número de shards deve ser positivo")
+        if streamer is None:
+            streamer = (data_manager.oscilloscope_streamer if data_manager is not None
+                        else OscilloscopeStreamer(config.OSCILLOSCOPE_MAX_POINTS))
+        self.streamer = streamer
+        self.capacity = capacity or config.OSCILLOSCOPE_MAX_POINTS
+        self.data_manager = data_manager
+        self.send_chunks = max(1, send_chunks or config.SHARD_SEND_CHUNKS)
+
+        self._context = multiprocessing.get_context(start_method)
+        self._prefix = f"daq{multiprocessing.current_process().pid}_{id(self) & 0xFFFFFF:x}"
+        self._inboxes: List = []
+        self._processes: List = []
+        self._results = None
+        self._listener: Optional[threading.Thread] = None
+        self._outgoing: List[List[Tuple[Any, bytes]]] = []
+        self._rings: Dict[str, SharedColumnRing] = {}
+        self._condition = threading.Condition()
+        self._synced: Dict[int, Dict[int, Dict[str, Any]]] = {}
+        self._worker_stats: Dict[int, Dict[str, Any]] = {}
+        self._sync_token = 0
+        self._submitted = 0
+        self._running = False
+
+    def __enter__(self) -> 'ShardedIngest':
+        self.start()
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.stop()
+
+    @property
+    def is_running(self) -> bool:
+        """Indica se os workers estão ativos."""
+        return self._running
+
+    def start(self) -> None:
+        """Inicia os workers e a thread que anexa os streams anunciados."""
+        if self._running:
+            return
+        self._results = self._context.Queue()
+        self._outgoing = [[] for _ in range(self.shards)]
+        for shard in range(self.shards):
+            inbox = self._context.Queue()
+            process = self._context.Process(
+                target=_worker_main,
+                args=(shard, inbox, self._results, self.capacity, self._prefix,
+                      self.data_manager is not None, config.PERSIST_BATCH_SIZE, config.PERSIST_MAX_LATENCY),
+                name=f"daq-ingest-{shard}",
+                daemon=True
+            )
+            process.start()
+            self._inboxes.append(inbox)
+            self._processes.append(process)
+
+        self._running = True
+        self._listener = threading.Thread(target=self._listen, name="daq-ingest-results",
+                                          daemon=True)
+        self._listener.start()
+
+    def shard_for(self, key) -> int:
+        """
+        Retorna o worker responsável por um sensor/link.
+
+        Args:
+            key: ID do sensor (ou do link)
+
+        Returns:
+            Índice do worker, estável entre execuções
+        """
+        return zlib.crc32(str(key).encode('utf-8')) % self.shards
+
+    def submit(self, key, data: Union[bytes, bytearray, memoryview]) -> None:
+        """
+        Encaminha um bloco recebido de um link ao worker do sensor.
+
+        Args:
+            key: ID do sensor (ou do link) que originou o bloco
+            data: Bytes recebidos
+        """
+        if not self._running:
+            raise RuntimeError("ShardedIngest não iniciado")
+        shard = self.shard_for(key)
+        outgoing = self._outgoing[shard]
+        outgoing.append((key, bytes(data)))
+        self._submitted += 1
+        if len(outgoing) >= self.send_chunks:
+            self._send(shard)
+
+    def dispatch(self) -> None:
+        """Envia os blocos acumulados a todos os workers."""
+        for shard in range(len(self._outgoing)):
+            self._send(shard)
+
+    def _send(self, shard: int) -> None:
+        outgoing = self._outgoing[shard]
+        if outgoing:
+            self._inboxes[shard].put(('data', outgoing))
+            self._outgoing[shard] = []
+
+    def sync(self, timeout: Optional[float] = None) -> bool:
+        """
+        Aguarda os workers processarem tudo o que foi enviado.
+
+        Com data_manager, os lotes já foram entregues a add_batch ao
+        retornar; use data_manager.flush() para aguardar a gravação.
+
+        Args:
+            timeout: Tempo máximo de espera em segundos
+
+        Returns:
+            True se todos os workers confirmaram dentro do prazo
+        """
+        if not self._running:
+            return False
+        self.dispatch()
+        self._sync_token += 1
+        token = self._sync_token
+        for inbox in self._inboxes:
+            inbox.put(('sync', token))
+
+        deadline = None if timeout is None else time.monotonic() + timeout
+        with self._condition:
+            while len(self._synced.get(token, ())) < self.shards:
+                remaining = None if deadline is None else deadline - time.monotonic()
+                if remaining is not None and remaining <= 0:
+                    return False
+                self._condition.wait(remaining)
+            self._synced.pop(token)
+        return True
+
+    def stop(self, timeout: float = 10.0) -> None:
+        """
+        Encerra os workers após processarem o pendente.
+
+        Os streams compartilhados são removidos do streamer.
+
+        Args:
+            timeout: Tempo máximo de espera por worker
+        """
+        if not self._running:
+            return
+        self.dispatch()
+        for inbox in self._inboxes:
+            inbox.put(None)
+        for process in self._processes:
+            process.join(timeout)
+            if process.is_alive():
+                process.terminate()
+                process.join()
+        self._running = False
+
+        # Workers encerrados: nenhum anúncio novo chega depois do sentinel
+        self._results.put(None)
+        self._listener.join(timeout)
+
+        with self._condition:
+            for sensor_id, ring in self._rings.items():
+                self.streamer.detach_stream(sensor_id)
+                ring.close()
+            self._rings.clear()
+        for inbox in self._inboxes:
+            inbox.close()
+        self._results.close()
+        self._inboxes, self._processes = [], []
+
+    def _listen(self) -> None:
+        """Thread que processa anúncios e confirmações dos workers."""
+        while True:
+            message = self._results.get()
+            if message is None:
+                return
+            kind, shard = message[0], message[1]
+            if kind == 'batch':
+                # Fora do lock: add_batch pode esperar pelo writer
+                try:
+                    self.data_manager.add_batch(message[2], stream=False)
+                except Exception as e:
+                    print(f"Erro ao entregar lote do worker {shard}: {e}")
+                continue
+            with self._condition:
+                if kind == 'sensor':
+                    sensor_id, name = message[2], message[3]
+                    try:
+                        ring = SharedColumnRing.attach(name, _SensorStream.COLUMNS)
+                    except (OSError, ValueError) as e:
+                        print(f"Erro ao anexar stream de {sensor_id}: {e}")
+                        continue
+                    self._rings[sensor_id] = ring
+                    self.streamer.attach_stream(sensor_id, _AttachedStream(ring.capacity, ring))
+                elif kind == 'synced':
+                    self._synced.setdefault(message[2], {})[shard] = message[3]
+                    self._worker_stats[shard] = message[3]
+                elif kind == 'stopped':
+                    self._worker_stats[shard] = message[2]
+                self._condition.notify_all()
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Retorna estatísticas da ingestão distribuída.
+
+        Returns:
+            Shards, blocos submetidos, sensores anexados, memória
+            compartilhada e os contadores agregados dos workers (da última
+            confirmação de cada um)
+        """
+        with self._condition:
+            workers = dict(self._worker_stats)
+            shared_bytes = sum(ring.nbytes for ring in self._rings.values())
+            sensors = len(self._rings)
+        totals: Dict[str, int] = {}
+        for worker in workers.values():
+            for name, value in worker.items():
+                totals[name] = totals.get(name, 0) + value
+        return {
+            'shards': self.shards,
+            'running': self._running,
+            'submitted_chunks': self._submitted,
+            'attached_sensors': sensors,
+            'shared_bytes': shared_bytes,
+            'workers': workers,
+            **totals
+        }
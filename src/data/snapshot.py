@@ -0,0 +1,259 @@
+"""
+Snapshot binário para partida rápida do DataManager (.daqsnap).
+
+Gravado em DataManager.close() com as janelas do osciloscópio e os lotes
+que ainda não chegaram ao banco; lido na inicialização via mmap, antes de
+abrir o SQLite. As colunas são copiadas do arquivo mapeado direto para os
+buffers circulares (uma cópia de bytes por coluna), de modo que restaurar
+custa O(pontos) sem conversão por amostra.
+
+Estrutura (little-endian, colunas alinhadas a 8 bytes):
+
+CABEÇALHO (24 bytes + índice):
+- Magic (8 bytes): b'DAQSNP01'
+- Versão (2 bytes)
+- Reservado (2 bytes)
+- Tamanho do índice (4 bytes)
+- Instante da gravação em µs (8 bytes)
+- Índice JSON: colunas do stream, janela do osciloscópio e, por bloco,
+  sensor(es), contagem e offset
+
+BLOCOS:
+- stream: uma janela do osciloscópio, com as colunas de _SensorStream
+  (tempos em ms, strain, ADC, bateria, temperatura)
+- pending: um lote não persistido, nas colunas do StrainBatch
+  (timestamps em µs, strain, ADC, bateria, temperatura, sensor_keys)
+
+O arquivo é gravado em um temporário e renomeado, e só é removido depois
+que os lotes pendentes foram entregues ao banco; reaplicá-los após uma
+falha é inofensivo, pois a gravação é idempotente por (sensor, timestamp).
+"""
+
+import json
+import mmap
+import os
+import struct
+import time
+from array import array
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Sequence, Tuple
+
+from ..core.models import StrainBatch
+
+
+MAGIC = b'DAQSNP01'
+FORMAT_VERSION = 1
+SUFFIX = '.daqsnap'
+
+HEADER = struct.Struct('<8sHHIq')
+
+# Colunas de um lote pendente, na ordem gravada
+PENDING_COLUMNS = (
+    ('timestamps_us', 'q'),
+    ('strain_values', 'd'),
+    ('raw_adc_values', 'i'),
+    ('battery_levels', 'h'),
+    ('temperatures', 'd'),
+    ('sensor_keys', 'H'),
+)
+
+
+class SnapshotError(Exception):
+    """Erro de leitura/gravação de snapshot."""
+    pass
+
+
+def snapshot_path(db_path: Path) -> Path:
+    """Caminho do snapshot associado a um banco."""
+    return Path(db_path).with_suffix(SUFFIX)
+
+
+def _bytes(column) -> memoryview:
+    view = column if isinstance(column, memoryview) else memoryview(column)
+    return view.cast('B') if view.c_contiguous else memoryview(view.tobytes())
+
+
+def write_snapshot(path: Path, stream_columns: Sequence[Tuple[str, str]],
+                   streams: Dict[str, Sequence], pending: Sequence[StrainBatch] = (),
+                   max_points: int = 0) -> int:
+    """
+    Grava um snapshot.
+
+    Args:
+        path: Caminho do arquivo .daqsnap
+        stream_columns: (nome, typecode) das colunas das janelas
+        streams: sensor_id -> colunas da janela (na ordem de stream_columns)
+        pending: Lotes ainda não persistidos
+        max_points: Capacidade das janelas no momento da gravação
+
+    Returns:
+        Tamanho do arquivo em bytes
+    """
+    blocks: List[List[memoryview]] = []
+    entries: Dict[str, List[Dict[str, Any]]] = {'streams': [], 'pending': []}
+    for sensor_id, columns in streams.items():
+        if len(columns[0]):
+            entries['streams'].append({'sensor_id': sensor_id, 'count': len(columns[0])})
+            blocks.append([_bytes(column) for column in columns])
+    for batch in pending:
+        if len(batch):
+            entries['pending'].append({'sensor_names': list(batch.sensor_names),
+                                       'count': len(batch)})
+            blocks.append([_bytes(getattr(batch, name)) for name, _ in PENDING_COLUMNS])
+
+    # Offsets relativos ao início dos blocos (logo após o índice)
+    offset = 0
+    for entry, columns in zip(entries['streams'] + entries['pending'], blocks):
+        entry['offset'] = offset
+        offset += sum(len(column) + (-len(column) % 8) for column in columns)
+    payload = json.dumps({
+        'max_points': max_points,
+        'stream_columns': [list(column) for column in stream_columns],
+        **entries
+    }).encode('utf-8')
+    index_size = len(payload) + (-(HEADER.size + len(payload)) % 8)
+
+    path = Path(path)
+    temporary = path.with_suffix(path.suffix + '.tmp')
+    with open(temporary, 'wb') as f:
+        f.write(HEADER.pack(MAGIC, FORMAT_VERSION, 0, index_size, int(time.time() * 1e6)))
+        f.write(payload.ljust(index_size, b' '))
+        for columns in blocks:
+            for column in columns:
+                f.write(column)
+                f.write(bytes(-len(column) % 8))
+        size = f.tell()
+    os.replace(temporary, path)
+    return size
+
+
+def _copy_column(code: str, view: memoryview) -> array:
+    values = array(code)
+    values.frombytes(view.cast('B'))
+    return values
+
+
+class SnapshotReader:
+    """
+    Leitura de snapshot via mmap.
+
+    As colunas retornadas são memoryviews sobre o arquivo mapeado e só
+    permanecem válidas enquanto o leitor estiver aberto.
+    """
+
+    def __init__(self, path: Path):
+        """
+        Abre e valida o snapshot.
+
+        Args:
+            path: Caminho do arquivo .daqsnap
+
+        Raises:
+            SnapshotError: Arquivo inválido ou de versão não suportada
+        """
+        self.path = Path(path)
+        self._file = open(self.path, 'rb')
+        self._views: List[memoryview] = []
+        try:
+            self._map = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        except ValueError:
+            self._file.close()
+            raise SnapshotError("Snapshot vazio")
+
+        try:
+            if len(self._map) < HEADER.size:
+                raise SnapshotError("Snapshot truncado")
+            magic, version, _, index_size, self.created_us = HEADER.unpack_from(self._map)
+            if magic != MAGIC:
+                raise SnapshotError("Arquivo não é um snapshot .daqsnap")
+            if version > FORMAT_VERSION:
+                raise SnapshotError(f"Versão de snapshot não suportada: {version}")
+            self._index = json.loads(bytes(self._map[HEADER.size:HEADER.size + index_size]))
+            self._data_start = HEADER.size + index_size
+        except SnapshotError:
+            self.close()
+            raise
+        except ValueError as e:
+            self.close()
+            raise SnapshotError(f"Índice do snapshot inválido: {e}")
+
+    @property
+    def max_points(self) -> int:
+        """Capacidade das janelas quando o snapshot foi gravado."""
+        return self._index['max_points']
+
+    @property
+    def stream_columns(self) -> Tuple[Tuple[str, str], ...]:
+        """(nome, typecode) das colunas das janelas."""
+        return tuple(tuple(column) for column in self._index['stream_columns'])
+
+    @property
+    def age_seconds(self) -> float:
+        """Tempo desde a gravação do snapshot."""
+        return max(0.0, time.time() - self.created_us / 1e6)
+
+    def _columns(self, offset: int, count: int,
+                 codes: Sequence[str]) -> List[memoryview]:
+        columns = []
+        offset += self._data_start
+        for code in codes:
+            size = count * struct.calcsize(code)
+            if offset + size > len(self._map):
+                raise SnapshotError("Snapshot truncado")
+            view = memoryview(self._map)[offset:offset + size].cast(code)
+            self._views.append(view)
+            columns.append(view)
+            offset += size + (-size % 8)
+        return columns
+
+    def streams(self) -> Iterator[Tuple[str, List[memoryview]]]:
+        """
+        Itera as janelas do osciloscópio.
+
+        Yields:
+            (sensor_id, colunas na ordem de stream_columns)
+        """
+        codes = [code for _, code in self._index['stream_columns']]
+        for entry in self._index['streams']:
+            yield entry['sensor_id'], self._columns(entry['offset'], entry['count'], codes)
+
+    def pending(self, copy: bool = False) -> Iterator[StrainBatch]:
+        """
+        Itera os lotes não persistidos.
+
+        Args:
+            copy: Copia as colunas para arrays independentes do arquivo,
+                válidos depois de close()
+
+        Yields:
+            Lotes com colunas sobre o arquivo mapeado (ou cópias)
+        """
+        codes = [code for _, code in PENDING_COLUMNS]
+        for entry in self._index['pending']:
+            columns = self._columns(entry['offset'], entry['count'], codes)
+            if copy:
+                columns = [_copy_column(code, view) for code, view in zip(codes, columns)]
+            yield StrainBatch(*columns, list(entry['sensor_names']))
+
+    def close(self) -> None:
+        """Libera o mapeamento e fecha o arquivo."""
+        for view in self._views:
+            try:
+                view.release()
+            except BufferError:
+                pass
+        self._views.clear()
+        if getattr(self, '_map', None) is not None:
+            try:
+                self._map.close()
+            except BufferError:
+                # Colunas ainda referenciadas: o mapeamento é liberado com elas
+                pass
+            self._map = None
+        self._file.close()
+
+    def __enter__(self) -> 'SnapshotReader':
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb) -> None:
+        self.close()
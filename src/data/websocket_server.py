@@ -0,0 +1,606 @@
+"""
+Servidor WebSocket (RFC 6455) para distribuição de dados de osciloscópio.
+
+A cada tick (OSCILLOSCOPE_UPDATE_RATE) o servidor lê uma única vez os
+pontos novos de cada sensor pelo cursor de sequência (ver
+OscilloscopeAPI.get_since), codifica cada delta em um quadro binário e
+entrega os mesmos bytes a todos os assinantes. O snapshot em tempo real
+(JSON) é calculado uma vez por intervalo e compartilhado da mesma forma.
+
+Cada cliente tem uma fila de envio limitada e uma tarefa de envio
+própria, de modo que um navegador lento não atrasa os demais nem faz a
+memória crescer:
+- snapshots são coalescidos (só o mais recente fica na fila)
+- com a fila cheia, o quadro mais antigo é descartado; se era um delta,
+  o cliente recebe em seguida um quadro completo da janela do sensor
+
+Formato binário do traço (little-endian, offsets alinhados a 4 bytes):
+
+CABEÇALHO (24 bytes):
+- Versão (1 byte): versão do formato (1)
+- Tipo (1 byte): 0 = delta, 1 = janela completa
+- Tamanho do sensor_id (1 byte)
+- Reservado (1 byte)
+- Contagem (4 bytes): número de pontos N
+- Sequência (8 bytes): número de sequência do primeiro ponto
+- t0 (8 bytes, float64): timestamp do primeiro ponto em ms
+
+CORPO:
+- sensor_id (UTF-8, completado com zeros até múltiplo de 4)
+- Tempos (N x float32): ms relativos a t0
+- Valores (N x float32): strain em µε
+
+O ponto i tem número de sequência seq + i; clientes descartam pontos com
+sequência já recebida (um quadro completo pode se sobrepor a deltas).
+"""
+
+import asyncio
+import base64
+import hashlib
+import json
+import struct
+import sys
+import time
+from array import array
+from collections import deque
+from typing import Any, Deque, Dict, Iterable, List, Optional, Sequence, Set, Tuple
+
+from ..core.config import config, STREAMING_CONFIG
+from .oscilloscope_api import WebSocketStreamer
+
+
+TRACE_VERSION = 1
+TRACE_DELTA = 0
+TRACE_FULL = 1
+
+_TRACE_HEADER = struct.Struct('<BBBxIQd')
+
+_GUID = b"258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+# Opcodes RFC 6455
+OP_CONTINUATION = 0x0
+OP_TEXT = 0x1
+OP_BINARY = 0x2
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+# Tipos de quadro na fila de envio
+_SNAPSHOT = 'snapshot'
+_DELTA = 'delta'
+_CONTROL = 'control'
+
+_LITTLE_ENDIAN = sys.byteorder == 'little'
+
+
+class WebSocketProtocolError(Exception):
+    """Erro de protocolo WebSocket."""
+    pass
+
+
+def encode_trace(sensor_id: str, kind: int, first_seq: int,
+                 times: Sequence[float], values: Sequence[float]) -> bytes:
+    """
+    Codifica pontos de um sensor no formato binário de traço.
+
+    Args:
+        sensor_id: ID do sensor
+        kind: TRACE_DELTA ou TRACE_FULL
+        first_seq: Número de sequência do primeiro ponto
+        times: Timestamps em ms
+        values: Valores de strain
+
+    Returns:
+        Payload binário
+    """
+    count = len(times)
+    t0 = times[0] if count else 0.0
+    offsets = array('f', [t - t0 for t in times])
+    strains = array('f', values)
+    if not _LITTLE_ENDIAN:
+        offsets.byteswap()
+        strains.byteswap()
+
+    name = sensor_id.encode('utf-8')
+    if len(name) > 255:
+        raise ValueError(f"sensor_id muito longo para o formato de traço: {sensor_id!r}")
+    return b''.join((
+        _TRACE_HEADER.pack(TRACE_VERSION, kind, len(name), count, first_seq, t0),
+        name, bytes(-len(name) % 4),
+        offsets.tobytes(),
+        strains.tobytes()
+    ))
+
+
+def decode_trace(data: bytes) -> Dict[str, Any]:
+    """
+    Decodifica um payload binário de traço.
+
+    Args:
+        data: Payload produzido por encode_trace
+
+    Returns:
+        Dicionário com sensor_id, kind, seq, times e values
+
+    Raises:
+        ValueError: Se payload inválido
+    """
+    if len(data) < _TRACE_HEADER.size:
+        raise ValueError("Quadro de traço truncado")
+    version, kind, name_size, count, first_seq, t0 = _TRACE_HEADER.unpack_from(data, 0)
+    if version != TRACE_VERSION:
+        raise ValueError(f"Versão do formato de traço não suportada: {version}")
+
+    offset = _TRACE_HEADER.size
+    sensor_id = bytes(data[offset:offset + name_size]).decode('utf-8')
+    offset += name_size + (-name_size % 4)
+    if len(data) - offset != count * 8:
+        raise ValueError("Tamanho do quadro de traço não confere com a contagem")
+
+    offsets = array('f')
+    offsets.frombytes(data[offset:offset + count * 4])
+    strains = array('f')
+    strains.frombytes(data[offset + count * 4:])
+    if not _LITTLE_ENDIAN:
+        offsets.byteswap()
+        strains.byteswap()
+
+    return {
+        'sensor_id': sensor_id,
+        'kind': kind,
+        'seq': first_seq,
+        'times': [t0 + t for t in offsets],
+        'values': strains.tolist()
+    }
+
+
+def encode_frame(opcode: int, payload: bytes = b'') -> bytes:
+    """Monta um quadro WebSocket servidor -> cliente (sem máscara, FIN=1)."""
+    first = 0x80 | opcode
+    size = len(payload)
+    if size < 126:
+        header = struct.pack('!BB', first, size)
+    elif size < 1 << 16:
+        header = struct.pack('!BBH', first, 126, size)
+    else:
+        header = struct.pack('!BBQ', first, 127, size)
+    return header + payload
+
+
+def _unmask(payload: bytes, mask: bytes) -> bytes:
+    """Aplica a máscara do cliente (XOR com chave de 4 bytes)."""
+    size = len(payload)
+    key = (mask * (size // 4 + 1))[:size]
+    return (int.from_bytes(payload, 'little') ^ int.from_bytes(key, 'little')).to_bytes(size, 'little')
+
+
+async def read_frame(reader: asyncio.StreamReader,
+                     max_size: int = 1 << 16) -> Tuple[int, bool, bytes]:
+    """
+    Lê um quadro WebSocket.
+
+    Args:
+        reader: Stream de entrada
+        max_size: Tamanho máximo aceito do payload
+
+    Returns:
+        (opcode, fin, payload sem máscara)
+
+    Raises:
+        WebSocketProtocolError: Se quadro inválido ou grande demais
+    """
+    first, second = await reader.readexactly(2)
+    opcode = first & 0x0F
+    size = second & 0x7F
+    if size == 126:
+        size = struct.unpack('!H', await reader.readexactly(2))[0]
+    elif size == 127:
+        size = struct.unpack('!Q', await reader.readexactly(8))[0]
+    if size > max_size:
+        raise WebSocketProtocolError(f"Quadro grande demais: {size} bytes")
+
+    mask = await reader.readexactly(4) if second & 0x80 else None
+    payload = await reader.readexactly(size)
+    if mask is not None:
+        payload = _unmask(payload, mask)
+    return opcode, bool(first & 0x80), payload
+
+
+def _http_status(status: str) -> bytes:
+    """Resposta HTTP sem corpo que encerra a conexão."""
+    return f"HTTP/1.1 {status}\r\nContent-Length: 0\r\nConnection: close\r\n\r\n".encode('ascii')
+
+
+def accept_key(key: str) -> str:
+    """Calcula Sec-WebSocket-Accept para a chave do cliente."""
+    return base64.b64encode(hashlib.sha1(key.encode('ascii') + _GUID).digest()).decode('ascii')
+
+
+class _Client:
+    """Estado de um cliente conectado."""
+
+    __slots__ = ('client_id', 'writer', 'sensors', 'queue', 'resync', 'wakeup',
+                 'last_seen', 'frames_sent', 'frames_dropped', 'closed')
+
+    def __init__(self, client_id: str, writer: asyncio.StreamWriter):
+        self.client_id = client_id
+        self.writer = writer
+        self.sensors: Optional[Set[str]] = None  # None = todos os sensores
+        self.queue: Deque[Tuple[str, Optional[str], bytes]] = deque()
+        self.resync: Set[str] = set()
+        self.wakeup = asyncio.Event()
+        self.last_seen = time.monotonic()
+        self.frames_sent = 0
+        self.frames_dropped = 0
+        self.closed = False
+
+    def wants(self, sensor_id: str) -> bool:
+        return self.sensors is None or sensor_id in self.sensors
+
+
+class OscilloscopeWebSocketServer:
+    """
+    Servidor asyncio de streaming do osciloscópio via WebSocket.
+
+    Clientes conectam em ws://host:porta/oscilloscope e recebem, ao
+    conectar, a janela completa de cada sensor e depois deltas binários a
+    cada tick e snapshots JSON ({'type': 'realtime_snapshot', ...}). A
+    mensagem de texto {"type": "subscribe", "sensors": [...]} restringe os
+    sensores (lista vazia ou ausente = todos).
+    """
+
+    def __init__(self, streamer: WebSocketStreamer,
+                 host: str = '0.0.0.0',
+                 port: Optional[int] = None,
+                 path: str = '/oscilloscope',
+                 update_rate: Optional[float] = None,
+                 heartbeat: Optional[float] = None,
+                 queue_size: Optional[int] = None,
+                 max_clients: Optional[int] = None,
+                 snapshot_interval: float = 1.0,
+                 handshake_timeout: Optional[float] = None):
+        """
+        Inicializa o servidor.
+
+        Args:
+            streamer: Streamer WebSocket (registro de clientes e API)
+            host: Endereço de escuta
+            port: Porta (usa config.WEBSOCKET_PORT se None; 0 = porta livre)
+            path: Caminho aceito no handshake
+            update_rate: Ticks por segundo (usa config.OSCILLOSCOPE_UPDATE_RATE)
+            heartbeat: Intervalo de ping em segundos (usa config.WEBSOCKET_HEARTBEAT)
+            queue_size: Quadros na fila de cada cliente (usa STREAMING_CONFIG)
+            max_clients: Máximo de clientes simultâneos, contando conexões
+                em handshake (usa STREAMING_CONFIG)
+            snapshot_interval: Intervalo entre snapshots JSON em segundos
+            handshake_timeout: Prazo do upgrade HTTP em segundos (usa STREAMING_CONFIG)
+        """
+        websocket_config = STREAMING_CONFIG['websocket']
+        self.streamer = streamer
+        self.api = streamer.api
+        self.host = host
+        self.port = config.WEBSOCKET_PORT if port is None else port
+        self.path = path
+        self.update_interval = 1.0 / (update_rate or config.OSCILLOSCOPE_UPDATE_RATE)
+        self.heartbeat = heartbeat or config.WEBSOCKET_HEARTBEAT
+        self.queue_size = queue_size or websocket_config['buffer_size']
+        self.max_clients = max_clients or websocket_config['max_clients']
+        self.snapshot_interval = snapshot_interval
+        self.handshake_timeout = handshake_timeout or websocket_config['handshake_timeout']
+
+        self._clients: Dict[str, _Client] = {}
+        self._cursors: Dict[str, int] = {}
+        self._server: Optional[asyncio.AbstractServer] = None
+        self._tick_task: Optional[asyncio.Task] = None
+        self._tasks: Set[asyncio.Task] = set()
+        self._client_sequence = 0
+        self._handshaking = 0
+
+        # Estatísticas
+        self.ticks = 0
+        self.frames_built = 0
+        self.bytes_built = 0
+        self.rejected_clients = 0
+        self.handshake_timeouts = 0
+        self.last_tick_ms = 0.0
+
+    async def start(self) -> None:
+        """Abre o socket de escuta e inicia o laço de ticks."""
+        self._server = await asyncio.start_server(self._handle_connection, self.host, self.port)
+        self.port = self._server.sockets[0].getsockname()[1]
+        self._tick_task = asyncio.create_task(self._tick_loop())
+
+    async def stop(self) -> None:
+        """Encerra o servidor e desconecta todos os clientes."""
+        if self._tick_task is not None:
+            self._tick_task.cancel()
+            await asyncio.gather(self._tick_task, return_exceptions=True)
+            self._tick_task = None
+        if self._server is not None:
+            self._server.close()
+            await self._server.wait_closed()
+            self._server = None
+        for client in list(self._clients.values()):
+            self._close_client(client, code=1001)
+        tasks = list(self._tasks)
+        for task in tasks:
+            task.cancel()
+        await asyncio.gather(*tasks, return_exceptions=True)
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Retorna estatísticas do servidor.
+
+        Returns:
+            Dicionário com clientes, quadros e tempo de tick
+        """
+        return {
+            'clients': len(self._clients),
+            'handshaking': self._handshaking,
+            'ticks': self.ticks,
+            'frames_built': self.frames_built,
+            'bytes_built': self.bytes_built,
+            'frames_sent': sum(c.frames_sent for c in self._clients.values()),
+            'frames_dropped': sum(c.frames_dropped for c in self._clients.values()),
+            'max_queue_depth': max((len(c.queue) for c in self._clients.values()), default=0),
+            'rejected_clients': self.rejected_clients,
+            'handshake_timeouts': self.handshake_timeouts,
+            'last_tick_ms': self.last_tick_ms
+        }
+
+    # Laço de ticks
+
+    async def _tick_loop(self) -> None:
+        """Calcula deltas e snapshots uma vez por tick e distribui a todos."""
+        loop = asyncio.get_running_loop()
+        next_snapshot = loop.time()
+        next_heartbeat = loop.time() + self.heartbeat
+        while True:
+            started = loop.time()
+            try:
+                self._broadcast_deltas()
+
+                if started >= next_snapshot:
+                    next_snapshot = started + self.snapshot_interval
+                    if self._clients:
+                        snapshot = json.dumps(self.streamer.broadcast_snapshot()).encode('utf-8')
+                        self._broadcast(_SNAPSHOT, None, self._build(OP_TEXT, snapshot))
+
+                if started >= next_heartbeat:
+                    next_heartbeat = started + self.heartbeat
+                    self._check_heartbeat()
+            except Exception as e:
+                print(f"Erro no tick do servidor WebSocket: {e}")
+
+            self.ticks += 1
+            elapsed = loop.time() - started
+            self.last_tick_ms = elapsed * 1000
+            await asyncio.sleep(max(0.0, self.update_interval - elapsed))
+
+    def _broadcast_deltas(self) -> None:
+        """Lê pontos novos de cada sensor pelo cursor compartilhado."""
+        data_manager = self.api.data_manager
+        for sensor_id in data_manager.get_realtime_values():
+            window, first_seq, next_seq = data_manager.get_oscilloscope_since(
+                sensor_id, self._cursors.get(sensor_id)
+            )
+            self._cursors[sensor_id] = next_seq
+            if not len(window) or not any(c.wants(sensor_id) for c in self._clients.values()):
+                continue
+            payload = encode_trace(sensor_id, TRACE_DELTA, first_seq, window.times, window.values)
+            self._broadcast(_DELTA, sensor_id, self._build(OP_BINARY, payload))
+
+    def _build(self, opcode: int, payload: bytes) -> bytes:
+        """Serializa um quadro compartilhado por todos os clientes."""
+        frame = encode_frame(opcode, payload)
+        self.frames_built += 1
+        self.bytes_built += len(frame)
+        return frame
+
+    def _broadcast(self, kind: str, sensor_id: Optional[str], frame: bytes) -> None:
+        for client in self._clients.values():
+            if sensor_id is None or client.wants(sensor_id):
+                self._enqueue(client, kind, sensor_id, frame)
+
+    def _enqueue(self, client: _Client, kind: str, sensor_id: Optional[str], frame: bytes) -> None:
+        """Enfileira quadro aplicando coalescência e descarte do mais antigo."""
+        queue = client.queue
+        if kind == _SNAPSHOT and any(entry[0] == _SNAPSHOT for entry in queue):
+            client.queue = queue = deque(entry for entry in queue if entry[0] != _SNAPSHOT)
+            client.frames_dropped += 1
+        while len(queue) >= self.queue_size:
+            dropped_kind, dropped_sensor, _ = queue.popleft()
+            client.frames_dropped += 1
+            if dropped_kind == _DELTA:
+                client.resync.add(dropped_sensor)
+        queue.append((kind, sensor_id, frame))
+        client.wakeup.set()
+
+    def _full_frame(self, sensor_id: str) -> Optional[bytes]:
+        """Quadro com a janela do sensor até o cursor compartilhado (por cliente)."""
+        window, first_seq, next_seq = self.api.data_manager.get_oscilloscope_since(sensor_id)
+        cursor = self._cursors.get(sensor_id)
+        if cursor is not None and cursor < next_seq:
+            window = window[:max(0, cursor - first_seq)]
+        if not len(window):
+            return None
+        payload = encode_trace(sensor_id, TRACE_FULL, first_seq, window.times, window.values)
+        return encode_frame(OP_BINARY, payload)
+
+    def _check_heartbeat(self) -> None:
+        """Envia ping e desconecta clientes sem resposta por dois intervalos."""
+        now = time.monotonic()
+        ping = encode_frame(OP_PING)
+        for client in list(self._clients.values()):
+            if now - client.last_seen > 2 * self.heartbeat:
+                self._close_client(client, code=1001)
+            else:
+                self._enqueue(client, _CONTROL, None, ping)
+
+    # Conexões
+
+    async def _handle_connection(self, reader: asyncio.StreamReader,
+                                 writer: asyncio.StreamWriter) -> None:
+        # Conexões em handshake ocupam vaga: cabeçalhos lentos não se acumulam
+        if len(self._clients) + self._handshaking >= self.max_clients:
+            self.rejected_clients += 1
+            writer.write(_http_status("503 Service Unavailable"))
+            writer.close()
+            return
+
+        self._handshaking += 1
+        try:
+            accepted = await asyncio.wait_for(self._handshake(reader, writer),
+                                              self.handshake_timeout)
+        except asyncio.TimeoutError:
+            self.handshake_timeouts += 1
+            accepted = False
+        except (asyncio.IncompleteReadError, asyncio.LimitOverrunError, ConnectionError, ValueError):
+            accepted = False
+        finally:
+            self._handshaking -= 1
+        if not accepted:
+            writer.close()
+            return
+
+        self._client_sequence += 1
+        peer = writer.get_extra_info('peername')
+        client_id = f"{peer[0]}:{peer[1]}#{self._client_sequence}" if peer else f"ws#{self._client_sequence}"
+        client = _Client(client_id, writer)
+        self._clients[client_id] = client
+        self.streamer.add_client(client_id)
+        self._queue_full_windows(client, self._cursors)
+
+        sender = asyncio.create_task(self._send_loop(client))
+        self._tasks.add(sender)
+        sender.add_done_callback(self._tasks.discard)
+        try:
+            await self._receive_loop(reader, client)
+        except (asyncio.IncompleteReadError, ConnectionError, WebSocketProtocolError):
+            pass
+        finally:
+            self._close_client(client)
+            sender.cancel()
+
+    async def _handshake(self, reader: asyncio.StreamReader,
+                         writer: asyncio.StreamWriter) -> bool:
+        """Valida o upgrade HTTP e responde 101 (ou erro)."""
+        request = (await reader.readuntil(b'\r\n\r\n')).decode('latin-1')
+        lines = request.split('\r\n')
+        method, target, _ = (lines[0].split(' ') + ['', '', ''])[:3]
+        headers = {}
+        for line in lines[1:]:
+            if ':' in line:
+                name, value = line.split(':', 1)
+                headers[name.strip().lower()] = value.strip()
+
+        status = None
+        if method != 'GET' or target.split('?')[0] != self.path:
+            status = "404 Not Found"
+        elif (headers.get('upgrade', '').lower() != 'websocket' or
+              'sec-websocket-key' not in headers):
+            status = "400 Bad Request"
+        if status is not None:
+            writer.write(_http_status(status))
+            await writer.drain()
+            return False
+
+        writer.write((
+            "HTTP/1.1 101 Switching Protocols\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            f"Sec-WebSocket-Accept: {accept_key(headers['sec-websocket-key'])}\r\n\r\n"
+        ).encode('ascii'))
+        await writer.drain()
+        return True
+
+    def _queue_full_windows(self, client: _Client, sensor_ids: Iterable[str]) -> None:
+        """Enfileira a janela completa dos sensores assinados pelo cliente."""
+        for sensor_id in list(sensor_ids):
+            if client.wants(sensor_id):
+                frame = self._full_frame(sensor_id)
+                if frame is not None:
+                    self._enqueue(client, _DELTA, sensor_id, frame)
+
+    async def _receive_loop(self, reader: asyncio.StreamReader, client: _Client) -> None:
+        """Processa mensagens do cliente (assinatura, ping/pong, close)."""
+        fragments: List[bytes] = []
+        while not client.closed:
+            opcode, fin, payload = await read_frame(reader)
+            client.last_seen = time.monotonic()
+
+            if opcode == OP_CLOSE:
+                self._close_client(client, code=1000)
+                return
+            if opcode == OP_PING:
+                self._enqueue(client, _CONTROL, None, encode_frame(OP_PONG, payload))
+                continue
+            if opcode == OP_PONG:
+                continue
+
+            fragments.append(payload)
+            if not fin:
+                continue
+            message, fragments = b''.join(fragments), []
+            if opcode in (OP_TEXT, OP_CONTINUATION):
+                self._handle_message(client, message)
+
+    def _handle_message(self, client: _Client, message: bytes) -> None:
+        try:
+            request = json.loads(message.decode('utf-8'))
+        except (UnicodeDecodeError, ValueError):
+            return
+        if not isinstance(request, dict) or request.get('type') != 'subscribe':
+            return
+
+        sensors = request.get('sensors') or None
+        previous = client.sensors
+        client.sensors = set(sensors) if sensors else None
+        if previous is not None:
+            self._queue_full_windows(client, [s for s in self._cursors if s not in previous])
+
+    async def _send_loop(self, client: _Client) -> None:
+        """Envia a fila do cliente; só esta tarefa espera o socket dele."""
+        writer = client.writer
+        try:
+            while not client.closed:
+                await client.wakeup.wait()
+                client.wakeup.clear()
+
+                while client.queue or client.resync:
+                    if client.resync:
+                        # Deltas na fila já estão cobertos pela janela completa
+                        sensors, client.resync = client.resync, set()
+                        client.queue = deque(entry for entry in client.queue
+                                             if not (entry[0] == _DELTA and entry[1] in sensors))
+                        frames = [self._full_frame(sensor_id) for sensor_id in sensors]
+                        for frame in frames:
+                            if frame is not None:
+                                writer.write(frame)
+                                client.frames_sent += 1
+                        await writer.drain()
+                        continue
+
+                    _, _, frame = client.queue.popleft()
+                    writer.write(frame)
+                    client.frames_sent += 1
+                    await writer.drain()
+        except (ConnectionError, asyncio.CancelledError):
+            pass
+        finally:
+            self._close_client(client)
+
+    def _close_client(self, client: _Client, code: Optional[int] = None) -> None:
+        """Remove o cliente e fecha o socket (enviando close se code)."""
+        if client.closed:
+            return
+        client.closed = True
+        client.wakeup.set()
+        self._clients.pop(client.client_id, None)
+        self.streamer.remove_client(client.client_id)
+        try:
+            if code is not None and not client.writer.is_closing():
+                client.writer.write(encode_frame(OP_CLOSE, struct.pack('!H', code)))
+            client.writer.close()
+        except Exception:
+            pass
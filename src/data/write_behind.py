@@ -0,0 +1,556 @@
+"""
+Persistência write-behind para o sistema DAQ.
+
+Um thread dedicado recebe lotes de leituras (colunas retiradas do
+DataBuffer) por uma fila limitada e os grava no banco, mantendo a
+ingestão e a interface livres da latência do SQLite.
+
+Políticas de contrapressão quando a fila está cheia:
+- block: o produtor espera espaço na fila
+- drop_oldest: descarta o lote mais antigo da fila
+- spill: grava o lote em disco; o writer o reprocessa quando houver folga
+"""
+
+import json
+import queue
+import struct
+import threading
+import time
+from array import array
+from pathlib import Path
+from typing import Callable, Dict, Any, List, Optional, Tuple
+
+
+class BackpressurePolicy:
+    """Políticas de contrapressão da fila de persistência."""
+    BLOCK = "block"
+    DROP_OLDEST = "drop_oldest"
+    SPILL = "spill"
+
+    ALL = (BLOCK, DROP_OLDEST, SPILL)
+
+
+# Cabeçalho dos arquivos de spill: magic, versão, contagem, tamanho dos nomes
+_SPILL_HEADER = struct.Struct('<4sBxHI')
+_SPILL_MAGIC = b'DQSP'
+_SPILL_VERSION = 1
+
+# Atributos de ReadingColumns gravados no spill, na ordem
+_SPILL_COLUMNS = ('timestamps_us', 'strain_values', 'raw_adc_values',
+                  'battery_levels', 'temperatures', 'sensor_keys')
+
+_STOP = object()
+
+
+def _write_spill(path: Path, batch) -> None:
+    """Grava lote de colunas em arquivo de spill (binário nativo)."""
+    names = json.dumps(batch.sensor_names).encode('utf-8')
+    with open(path, 'wb') as f:
+        f.write(_SPILL_HEADER.pack(_SPILL_MAGIC, _SPILL_VERSION, 0, len(names)))
+        f.write(names)
+        for attribute in _SPILL_COLUMNS:
+            column = getattr(batch, attribute)
+            f.write(struct.pack('<cI', column.typecode.encode('ascii'), len(column)))
+            column.tofile(f)
+
+
+def _read_spill(path: Path, factory: Callable):
+    """Lê arquivo de spill e reconstrói o lote com factory(*colunas, sensor_names)."""
+    with open(path, 'rb') as f:
+        magic, version, _, names_size = _SPILL_HEADER.unpack(f.read(_SPILL_HEADER.size))
+        if magic != _SPILL_MAGIC or version != _SPILL_VERSION:
+            raise ValueError(f"Arquivo de spill inválido: {path}")
+        names = json.loads(f.read(names_size).decode('utf-8'))
+        columns = []
+        for _ in _SPILL_COLUMNS:
+            typecode, count = struct.unpack('<cI', f.read(5))
+            column = array(typecode.decode('ascii'))
+            column.fromfile(f, count)
+            columns.append(column)
+    return factory(*columns, sensor_names=names)
+
+
+class WriteBehindWriter:
+    """
+    Thread de persistência alimentado por fila limitada de lotes.
+
+    O produtor entrega lotes com submit(); o writer acumula lotes até
+    batch_size leituras (ou max_latency segundos) e grava cada grupo em
+    uma única transação. Se configurado com source, o writer também
+    retira do buffer, a cada max_latency, leituras que não atingiram o
+    limite de flush, garantindo a latência máxima de persistência.
+
+    O source recebe take(drain): take executa drain (retirada em memória)
+    sob o lock do writer e já marca o lote como em gravação; o que o
+    source fizer depois (ex.: gravar a captura) fica fora desse lock.
+    """
+
+    def __init__(self, store: Callable[[List], None],
+                 batch_size: int = 1000,
+                 max_latency: float = 1.0,
+                 queue_size: int = 16,
+                 policy: str = BackpressurePolicy.BLOCK,
+                 spill_dir: Optional[Path] = None,
+                 source: Optional[Callable[[], Any]] = None,
+                 batch_factory: Optional[Callable] = None):
+        """
+        Inicializa o writer.
+
+        Args:
+            store: Função que grava uma lista de lotes (na thread do writer)
+            batch_size: Leituras por transação
+            max_latency: Tempo máximo (s) entre chegada e gravação
+            queue_size: Número máximo de lotes na fila
+            policy: Política de contrapressão (BackpressurePolicy)
+            spill_dir: Diretório de spill (obrigatório para 'spill')
+            source: Função source(take) que retira leituras pendentes do
+                buffer por meio de take(drain)
+            batch_factory: Construtor dos lotes lidos do spill
+        """
+        if policy not in BackpressurePolicy.ALL:
+            raise ValueError(f"Política de contrapressão inválida: {policy}")
+        if policy == BackpressurePolicy.SPILL and (spill_dir is None or batch_factory is None):
+            raise ValueError("Política 'spill' requer spill_dir e batch_factory")
+
+        self._store = store
+        self._batch_size = batch_size
+        self._max_latency = max_latency
+        self._policy = policy
+        self._spill_dir = Path(spill_dir) if spill_dir is not None else None
+        self._source = source
+        self._batch_factory = batch_factory
+
+        self._queue: queue.Queue = queue.Queue(maxsize=queue_size)
+        self._submit_lock = threading.Lock()
+        self._idle = threading.Condition()
+        self._in_flight: List = []
+        # Gravação de um grupo e limpeza de _in_flight, atômicas para leitores
+        self._store_lock = threading.Lock()
+        # Lotes retirados com stage() e ainda não colocados na fila
+        self._staged: List = []
+        self._spill_lock = threading.Lock()
+        self._spill_sequence = 0
+        self._closed = False
+        # Entrega dos lotes não iniciados após um close() com timeout
+        self._detached = False
+        self._taking = False
+        self._handoff: List = []
+
+        # Estatísticas
+        self.batches_written = 0
+        self.readings_written = 0
+        self.readings_dropped = 0
+        self.readings_spilled = 0
+        self.write_errors = 0
+        self.last_write_ms = 0.0
+
+        if self._spill_dir is not None:
+            self._spill_dir.mkdir(parents=True, exist_ok=True)
+            self._spill_sequence = len(self._spill_files())
+
+        self._thread = threading.Thread(target=self._run, name="daq-write-behind", daemon=True)
+        self._thread.start()
+
+    def stage(self, drain: Callable[[], Any]):
+        """
+        Retira um lote com drain e o torna visível em pending() no mesmo passo.
+
+        Usado por quem retira leituras do buffer e as entrega com submit():
+        drain (retirada em memória) roda sob o lock do writer, e o lote
+        permanece em pending() até submit() colocá-lo na fila, sem intervalo
+        em que as leituras não estejam nem no buffer nem no writer.
+
+        Args:
+            drain: Função que retira e retorna o lote (ou None)
+
+        Returns:
+            Lote não vazio, a ser entregue com submit(), ou None
+        """
+        with self._idle:
+            batch = drain()
+            if batch is None or not len(batch):
+                return None
+            self._staged.append(batch)
+        return batch
+
+    def submit(self, batch) -> None:
+        """
+        Entrega um lote para persistência.
+
+        Args:
+            batch: Colunas de leituras (ReadingColumns)
+        """
+        try:
+            self._enqueue(batch)
+        finally:
+            if self._staged:
+                with self._idle:
+                    self._staged = [staged for staged in self._staged if staged is not batch]
+
+    def _enqueue(self, batch) -> None:
+        """Coloca o lote na fila conforme a política de contrapressão."""
+        if not len(batch):
+            return
+        if self._closed:
+            raise RuntimeError("Writer encerrado")
+
+        with self._submit_lock:
+            if self._policy == BackpressurePolicy.BLOCK:
+                self._queue.put(batch)
+                return
+
+            try:
+                self._queue.put_nowait(batch)
+                return
+            except queue.Full:
+                pass
+
+            if self._policy == BackpressurePolicy.SPILL:
+                self._spill(batch)
+                return
+
+            # drop_oldest: abre espaço descartando o lote mais antigo
+            while True:
+                try:
+                    dropped = self._queue.get_nowait()
+                    self._queue.task_done()
+                    self.readings_dropped += len(dropped)
+                except queue.Empty:
+                    pass
+                try:
+                    self._queue.put_nowait(batch)
+                    return
+                except queue.Full:
+                    continue
+
+    def pending(self) -> List:
+        """
+        Retorna lotes ainda não gravados (preparados + fila + gravação em curso).
+
+        Cada conjunto é lido antes daquele para onde seus lotes seguem, de
+        modo que um lote em movimento aparece ao menos uma vez (e só uma:
+        duplicatas são removidas). Lotes em spill não são incluídos até
+        serem reprocessados.
+
+        Returns:
+            Lista de lotes
+        """
+        with self._idle:
+            staged = list(self._staged)
+        with self._queue.mutex:
+            queued = list(self._queue.queue)
+        with self._idle:
+            in_flight = list(self._in_flight)
+        seen = set()
+        batches = []
+        for batch in in_flight + queued + staged:
+            if batch is not _STOP and id(batch) not in seen:
+                seen.add(id(batch))
+                batches.append(batch)
+        return batches
+
+    def read_consistent(self, persisted: Callable[[], Any],
+                        buffered: Callable[[], Any]) -> Tuple[Any, Any, List]:
+        """
+        Lê banco, buffer e lotes não gravados sem contar um lote duas vezes.
+
+        persisted roda sem gravação de grupo em curso (um grupo sai de
+        pending() no mesmo passo em que chega ao banco), e buffered roda
+        sob o lock das retiradas do source e de stage(), de modo que uma
+        leitura está em exatamente uma das três fontes (exceto spill).
+
+        Args:
+            persisted: Leitura do banco (ex.: rollups)
+            buffered: Leitura do buffer
+
+        Returns:
+            (persisted(), buffered(), pending())
+        """
+        with self._store_lock:
+            stored = persisted()
+            with self._idle:
+                return stored, buffered(), self.pending()
+
+    def flush(self, timeout: Optional[float] = None) -> bool:
+        """
+        Aguarda a gravação de todos os lotes entregues até agora.
+
+        Args:
+            timeout: Tempo máximo de espera em segundos
+
+        Returns:
+            True se a fila foi esvaziada
+        """
+        deadline = None if timeout is None else time.monotonic() + timeout
+        with self._idle:
+            while self._queue.unfinished_tasks or self._in_flight:
+                remaining = None if deadline is None else deadline - time.monotonic()
+                if remaining is not None and remaining <= 0:
+                    return False
+                self._idle.wait(remaining if remaining is not None else 0.1)
+        return True
+
+    def close(self, timeout: Optional[float] = None) -> bool:
+        """
+        Encerra o writer gravando lotes pendentes e arquivos de spill.
+
+        Args:
+            timeout: Tempo máximo de espera em segundos
+
+        Returns:
+            True se o thread terminou; False se ainda está gravando (ver
+            detach_pending)
+        """
+        if not self._closed:
+            self._closed = True
+            self._queue.put(_STOP)
+        self._thread.join(timeout)
+        return not self._thread.is_alive()
+
+    def detach_pending(self) -> List:
+        """
+        Retira do writer os lotes que ele ainda não começou a gravar.
+
+        Usado após um close() que expirou: o thread conclui apenas o grupo
+        em gravação e não pega mais lotes da fila nem do source, de modo
+        que os lotes retornados nunca são gravados por ele e podem ser
+        persistidos por outro caminho (ex.: snapshot) sem duplicação.
+
+        Returns:
+            Lotes não gravados, na ordem de chegada
+        """
+        with self._idle:
+            self._detached = True
+        batches = []
+        while True:
+            try:
+                batch = self._queue.get_nowait()
+            except queue.Empty:
+                break
+            self._queue.task_done()
+            if batch is not _STOP:
+                batches.append(batch)
+        with self._idle:
+            # Lote retirado da fila pelo thread antes de ver a marca
+            while self._taking and self._thread.is_alive():
+                self._idle.wait(0.05)
+            handoff, self._handoff = self._handoff, []
+        return handoff + batches
+
+    @property
+    def queue_depth(self) -> int:
+        """Lotes aguardando gravação na fila."""
+        return self._queue.qsize()
+
+    def get_stats(self) -> Dict[str, Any]:
+        """
+        Retorna estatísticas do writer.
+
+        Returns:
+            Dicionário com contadores da persistência
+        """
+        return {
+            'policy': self._policy,
+            'queue_depth': self.queue_depth,
+            'batches_written': self.batches_written,
+            'readings_written': self.readings_written,
+            'readings_dropped': self.readings_dropped,
+            'readings_spilled': self.readings_spilled,
+            'spill_files': len(self._spill_files()) if self._spill_dir else 0,
+            'write_errors': self.write_errors,
+            'last_write_ms': self.last_write_ms
+        }
+
+    def _run(self) -> None:
+        """Laço principal do thread de persistência."""
+        stopping = False
+        backlog = bool(self._spill_dir) and bool(self._spill_files())
+        while not stopping:
+            group = []
+            count = 0
+            deadline = time.monotonic() + self._max_latency
+
+            # Acumula lotes até batch_size leituras ou max_latency; com spill
+            # pendente, só o que já está na fila, sem esperar
+            while count < self._batch_size:
+                remaining = deadline - time.monotonic()
+                if remaining <= 0 and not backlog:
+                    break
+                batch = self._take(None if backlog else remaining)
+                if batch is None:
+                    break
+                if batch is _STOP:
+                    stopping = True
+                    break
+                group.append(batch)
+                count += len(batch)
+
+            queued = len(group)
+            if self._source is not None and not stopping:
+                batch = self._take_source()
+                if batch is not None:
+                    group.append(batch)
+
+            self._write(group, queued=queued)
+            if self._detached:
+                return
+
+            backlog = False
+            if not stopping and self._queue.empty():
+                backlog = self._replay_spill(budget=self._max_latency)
+            if stopping:
+                self._drain_remaining()
+
+    def _take(self, timeout: Optional[float]):
+        """
+        Retira o próximo lote da fila e o marca como em gravação.
+
+        Returns:
+            Lote, _STOP, ou None (timeout, fila vazia ou writer desanexado)
+        """
+        with self._idle:
+            if self._detached:
+                return None
+            self._taking = True
+        batch = None
+        try:
+            batch = (self._queue.get(timeout=timeout) if timeout is not None
+                     else self._queue.get_nowait())
+        except queue.Empty:
+            pass
+        finally:
+            with self._idle:
+                self._taking = False
+                if batch is _STOP:
+                    self._queue.task_done()
+                elif batch is not None:
+                    if self._detached:
+                        # detach_pending já passou pela fila: o lote é entregue a ele
+                        self._queue.task_done()
+                        self._handoff.append(batch)
+                        batch = None
+                    else:
+                        self._in_flight.append(batch)
+                self._idle.notify_all()
+        return batch
+
+    def _take_source(self):
+        """
+        Retira as leituras pendentes do source e as marca como em gravação.
+
+        A retirada (drain) e a inclusão em _in_flight ocorrem sob o mesmo
+        lock, de modo que pending() nunca vê o lote fora do buffer e fora
+        do writer; o restante do source roda sem o lock.
+
+        Returns:
+            Lote não vazio, ou None (source vazio ou writer desanexado)
+        """
+        taken = []
+
+        def take(drain: Callable[[], Any]):
+            with self._idle:
+                if self._detached:
+                    return None
+                batch = drain()
+                if batch is None or not len(batch):
+                    return None
+                self._in_flight.append(batch)
+            taken.append(batch)
+            return batch
+
+        self._source(take)
+        return taken[0] if taken else None
+
+    def _write(self, group: List, queued: int) -> None:
+        """Grava um grupo de lotes; queued lotes vieram da fila."""
+        with self._store_lock:
+            if group:
+                with self._idle:
+                    self._in_flight = group
+
+                started = time.perf_counter()
+                try:
+                    self._store(group)
+                    self.batches_written += len(group)
+                    self.readings_written += sum(len(batch) for batch in group)
+                except Exception as e:
+                    self.write_errors += 1
+                    print(f"Erro na persistência em segundo plano: {e}")
+                    if self._spill_dir is not None:
+                        for batch in group:
+                            self._spill(batch)
+                    else:
+                        self.readings_dropped += sum(len(batch) for batch in group)
+                self.last_write_ms = (time.perf_counter() - started) * 1000
+
+            with self._idle:
+                self._in_flight = []
+                for _ in range(queued):
+                    self._queue.task_done()
+                self._idle.notify_all()
+
+    def _drain_remaining(self) -> None:
+        """Grava tudo que restou na fila e no spill (encerramento)."""
+        while True:
+            batch = self._take(None)
+            if batch is None:
+                if self._detached:
+                    return
+                break
+            if batch is _STOP:
+                continue
+            self._write([batch], queued=1)
+        if self._source is not None:
+            batch = self._take_source()
+            if batch is not None:
+                self._write([batch], queued=0)
+        self._replay_spill()
+
+    def _spill_files(self) -> List[Path]:
+        return sorted(self._spill_dir.glob('*.spill'))
+
+    def _spill(self, batch) -> None:
+        """Grava lote em disco (política spill ou falha de gravação)."""
+        # Chamado pelo produtor (submit) e pelo thread do writer (falha de gravação)
+        with self._spill_lock:
+            self._spill_sequence += 1
+            sequence = self._spill_sequence
+        try:
+            path = self._spill_dir / f"{time.time_ns():020d}_{sequence:06d}.spill"
+            _write_spill(path, batch)
+            with self._spill_lock:
+                self.readings_spilled += len(batch)
+        except Exception as e:
+            with self._spill_lock:
+                self.readings_dropped += len(batch)
+            print(f"Erro ao gravar spill: {e}")
+
+    def _replay_spill(self, budget: Optional[float] = None) -> bool:
+        """
+        Reprocessa arquivos de spill, do mais antigo ao mais novo.
+
+        Args:
+            budget: Tempo máximo (s); com budget, para também quando chegam
+                lotes novos na fila (None = todos os arquivos)
+
+        Returns:
+            True se o tempo acabou ou a fila recebeu lotes com arquivos restantes
+        """
+        if self._spill_dir is None:
+            return False
+        deadline = None if budget is None else time.monotonic() + budget
+        for path in self._spill_files():
+            if deadline is not None and (time.monotonic() >= deadline
+                                         or not self._queue.empty()):
+                return True
+            try:
+                batch = _read_spill(path, self._batch_factory)
+                self._store([batch])
+                path.unlink()
+                self.batches_written += 1
+                self.readings_written += len(batch)
+            except Exception as e:
+                self.write_errors += 1
+                print(f"Erro ao reprocessar spill {path.name}: {e}")
+                break
+        return False
@@ -0,0 +1,1804 @@
+"""
+Testes unitários para o gerenciamento de dados.
+Valida o buffer circular colunar e as consultas por intervalo de tempo.
+"""
+
+import asyncio
+import gzip
+import json
+import math
+import os
+import pytest
+import sqlite3
+import struct
+import threading
+import time
+from array import array
+from datetime import datetime, timedelta
+import sys
+from pathlib import Path
+
+# Adiciona diretório pai ao path para importações
+sys.path.append(str(Path(__file__).parent.parent))
+
+from src.core.models import DataPacket, StrainBatch, StrainReading
+from src.core.config import config
+from src.core.metrics import MetricsHTTPServer, MetricsRegistry, metrics
+from src.communication.protocol import (
+    DataPacketEncoder,
+    FrameDecoder,
+    MessageProtocol,
+    MessageType
+)
+from src.data.ring_buffer import ColumnRing
+from src.data.data_manager import (
+    DataBuffer,
+    DatabaseManager,
+    DataExporter,
+    DataManager,
+    OscilloscopeStreamer,
+    ReadingColumns,
+    _SensorStream
+)
+from src.data.oscilloscope_api import OscilloscopeAPI, WebSocketStreamer
+from src.data.websocket_server import (
+    OP_BINARY,
+    OP_TEXT,
+    TRACE_DELTA,
+    TRACE_FULL,
+    OscilloscopeWebSocketServer,
+    _Client,
+    decode_trace,
+    encode_frame,
+    read_frame
+)
+from src.data.alarms import AlarmEngine, AlarmRule
+from src.data.capture import CaptureReader, CaptureWriter
+from src.data.fatigue import MinerDamage, RainflowCounter, SNCurve, WelchPSD
+from src.data.query import QueryCursor, ReadingQuery
+from src.data.replay import CaptureReplayer
+from src.data.shards import ShardedIngest, SharedColumnRing
+from src.data.snapshot import SnapshotReader, snapshot_path, write_snapshot
+from src.data.write_behind import WriteBehindWriter, BackpressurePolicy
+from src.data import rollups
+
+
+START = datetime(2024, 1, 15, 10, 30, 0)
+
+
+def _reading(i: int, sensor_id: str = "HX711_001") -> StrainReading:
+    """Cria leitura i com timestamp a 10 Hz."""
+    return StrainReading(
+        timestamp=START + timedelta(milliseconds=100 * i),
+        strain_value=float(i),
+        raw_adc_value=1000 + i,
+        sensor_id=sensor_id,
+        battery_level=150 if i % 2 else 80,
+        temperature=25.0
+    )
+
+
+class TestColumnRing:
+    """Testes para o buffer circular espelhado."""
+    
+    def test_wraparound_view_is_contiguous(self):
+        """Testa view contígua após a quebra de borda."""
+        ring = ColumnRing(4, [('v', 'i')])
+        ring.extend([list(range(6))])
+        
+        view = ring.view('v', ring.first_index, ring.end_index)
+        
+        assert ring.first_index == 2
+        assert list(view) == [2, 3, 4, 5]
+        assert view.readonly
+    
+    def test_extend_larger_than_capacity(self):
+        """Testa extend com mais amostras que a capacidade."""
+        ring = ColumnRing(3, [('v', 'q')])
+        ring.append((-1,))
+        
+        start = ring.extend([list(range(10))])
+        
+        assert start == 1
+        assert len(ring) == 3
+        assert [ring.value('v', i) for i in range(8, 11)] == [7, 8, 9]
+        with pytest.raises(IndexError):
+            ring.value('v', 7)
+    
+    def test_search(self):
+        """Testa busca binária em coluna ordenada."""
+        ring = ColumnRing(8, [('v', 'q')])
+        ring.extend([[0, 10, 10, 20, 30]])
+        
+        assert ring.search('v', 10) == 1
+        assert ring.search('v', 10, right=True) == 3
+        assert ring.search('v', 99) == 5
+
+
+class TestDataBuffer:
+    """Testes para o buffer de leituras."""
+    
+    def test_time_range_query(self):
+        """Testa consulta por intervalo de tempo."""
+        buffer = DataBuffer(max_size=100)
+        buffer.add_readings([_reading(i) for i in range(50)])
+        
+        readings = buffer.get_readings(
+            start_time=START + timedelta(seconds=1),
+            end_time=START + timedelta(seconds=2)
+        )
+        
+        assert [r.strain_value for r in readings] == [float(i) for i in range(10, 21)]
+        assert readings[0].timestamp == START + timedelta(seconds=1)
+        assert readings[1].battery_level == 150
+    
+    def test_overwrite_oldest(self):
+        """Testa descarte das leituras mais antigas quando cheio."""
+        buffer = DataBuffer(max_size=10)
+        for i in range(25):
+            buffer.add_reading(_reading(i))
+        
+        readings = buffer.get_readings()
+        
+        assert buffer.size() == 10
+        assert [r.strain_value for r in readings] == [float(i) for i in range(15, 25)]
+    
+    def test_query_returns_views(self):
+        """Testa que consultas sem filtro de sensor não copiam dados."""
+        buffer = DataBuffer(max_size=20)
+        buffer.add_readings([_reading(i) for i in range(30)])
+        
+        columns = buffer.query(max_count=5)
+        
+        assert isinstance(columns.strain_values, memoryview)
+        assert list(columns.strain_values) == [25.0, 26.0, 27.0, 28.0, 29.0]
+        assert columns.sensor_id(0) == "HX711_001"
+    
+    def test_sensor_filter(self):
+        """Testa filtro por sensor com leituras intercaladas."""
+        buffer = DataBuffer(max_size=100)
+        for i in range(40):
+            buffer.add_reading(_reading(i, "HX711_00" + str(i % 3)))
+        
+        readings = buffer.get_readings(sensor_id="HX711_001", max_count=3)
+        latest = buffer.get_latest_reading("HX711_002")
+        
+        assert [r.strain_value for r in readings] == [31.0, 34.0, 37.0]
+        assert latest.strain_value == 38.0
+        assert buffer.get_latest_reading("INEXISTENTE") is None
+    
+    def test_out_of_order_arrival(self):
+        """Testa leituras fora de ordem temporal."""
+        buffer = DataBuffer(max_size=100)
+        order = [3, 1, 4, 0, 2, 5]
+        buffer.add_readings([_reading(i) for i in order])
+        
+        readings = buffer.get_readings(
+            sensor_id="HX711_001",
+            end_time=START + timedelta(milliseconds=300)
+        )
+        
+        assert [r.strain_value for r in readings] == [0.0, 1.0, 2.0, 3.0]
+        assert [r.strain_value for r in buffer.get_readings()][-1] == 5.0
+    
+    def test_add_batch_mixed_sensors(self):
+        """Testa lote colunar com sensores intercalados e fora de ordem."""
+        buffer = DataBuffer(max_size=100)
+        buffer.add_batch(ReadingColumns.from_readings(
+            [_reading(i, "HX711_001" if i % 2 else "HX711_002") for i in (1, 0, 3, 2, 5, 4)]
+        ))
+        buffer.add_batch(ReadingColumns.from_readings([_reading(i) for i in (7, 9)]))
+        
+        assert [r.strain_value for r in buffer.get_readings(sensor_id="HX711_001")] == [1.0, 3.0, 5.0, 7.0, 9.0]
+        assert [r.strain_value for r in buffer.get_readings(sensor_id="HX711_002")] == [0.0, 2.0, 4.0]
+        window = buffer.get_readings(end_time=START + timedelta(milliseconds=250))
+        assert [r.strain_value for r in window] == [0.0, 1.0, 2.0]
+    
+    def test_clear(self):
+        """Testa limpeza do buffer e reutilização."""
+        buffer = DataBuffer(max_size=10)
+        buffer.add_readings([_reading(i) for i in range(5)])
+        buffer.clear()
+        
+        assert buffer.size() == 0
+        assert buffer.get_latest_reading() is None
+        
+        buffer.add_reading(_reading(0))
+        assert len(buffer.get_readings(sensor_id="HX711_001")) == 1
+
+
+class TestOscilloscopeStreamer:
+    """Testes para o streamer de osciloscópio."""
+    
+    def test_rolling_stats_match_window(self):
+        """Testa min/max/média móveis contra recálculo da janela."""
+        streamer = OscilloscopeStreamer(max_points=7)
+        values = [5, -3, 8, 8, 1, 12, -7, 4, 4, 9, 0, 2, 15, -1, 3, 6, 6, -2, 7, 1]
+        
+        for i, value in enumerate(values):
+            reading = _reading(i)
+            reading.strain_value = float(value)
+            streamer.add_reading(reading)
+            
+            window = values[max(0, i - 6):i + 1]
+            stats = streamer.get_stream_stats()['sensors']["HX711_001"]
+            assert stats['points'] == len(window)
+            assert stats['min_value'] == min(window)
+            assert stats['max_value'] == max(window)
+            assert stats['avg_value'] == pytest.approx(sum(window) / len(window))
+    
+    def test_batch_stats_match_per_reading_path(self):
+        """Testa estatísticas do add_batch contra o caminho leitura a leitura."""
+        values = [5, -3, 8, 8, 1, 12, -7, 4, 4, 9, 0, 2, 15, -1, 3, 6, 6, -2, 7, 1]
+        readings = []
+        for i, value in enumerate(values):
+            readings.append(_reading(i))
+            readings[-1].strain_value = float(value)
+        
+        single, batched = OscilloscopeStreamer(max_points=7), OscilloscopeStreamer(max_points=7)
+        position = 0
+        for size in (3, 1, 5, 2, 9):
+            part = readings[position:position + size]
+            position += size
+            for reading in part:
+                single.add_reading(reading)
+            batched.add_batch(ReadingColumns.from_readings(part))
+            expected = single.get_stream_stats()['sensors']["HX711_001"]
+            stats = batched.get_stream_stats()['sensors']["HX711_001"]
+            for name, value in expected.items():
+                assert stats[name] == pytest.approx(value)
+        
+        assert list(batched.get_stream_data("HX711_001").values) == values[-7:]
+        assert batched.get_decimated("HX711_001", 2) == single.get_decimated("HX711_001", 2)
+    
+    def test_stream_data_is_readonly_view(self):
+        """Testa que get_stream_data retorna janela sem cópia."""
+        streamer = OscilloscopeStreamer(max_points=5)
+        streamer.add_readings([_reading(i) for i in range(8)])
+        
+        window = streamer.get_stream_data("HX711_001", last_n=3)
+        
+        assert isinstance(window.values, memoryview)
+        assert window.values.readonly
+        assert list(window.values) == [5.0, 6.0, 7.0]
+        assert window[-1]['r'] == 1007
+        assert len(window[::2]) == 2
+        assert len(streamer.get_stream_data("INEXISTENTE")) == 0
+    
+    def test_latest_values_and_clear(self):
+        """Testa valores mais recentes e limpeza do stream."""
+        streamer = OscilloscopeStreamer(max_points=5)
+        streamer.add_readings([_reading(i, "A") for i in range(3)])
+        streamer.add_reading(_reading(9, "B"))
+        
+        latest = streamer.get_latest_values()
+        assert latest["A"]['v'] == 2.0
+        assert latest["B"]['t'] == (START + timedelta(milliseconds=900)).timestamp() * 1000
+        
+        streamer.clear_stream("A")
+        assert "A" not in streamer.get_latest_values()
+        assert "A" not in streamer.get_stream_stats()['sensors']
+    
+    def test_sequence_cursor(self):
+        """Testa cursor por número de sequência com timestamps repetidos."""
+        streamer = OscilloscopeStreamer(max_points=10)
+        readings = [_reading(i) for i in range(6)]
+        for reading in readings:
+            reading.timestamp = START  # mesmo timestamp em todas
+        streamer.add_readings(readings[:4])
+        
+        window, first, next_seq = streamer.get_since("HX711_001")
+        streamer.add_readings(readings[4:])
+        new, new_first, new_next = streamer.get_since("HX711_001", next_seq)
+        
+        assert (first, next_seq) == (0, 4)
+        assert list(new.values) == [4.0, 5.0] and (new_first, new_next) == (4, 6)
+        assert len(streamer.get_since("HX711_001", new_next)[0]) == 0
+        
+        streamer.add_readings([_reading(i) for i in range(20)])
+        late, late_first, _ = streamer.get_since("HX711_001", new_next, max_points=3)
+        assert late_first == 16 and list(late.values) == [10.0, 11.0, 12.0]
+    
+    def test_websocket_client_cursors(self, tmp_path):
+        """Testa cursores independentes por cliente no WebSocketStreamer."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        streamer = WebSocketStreamer(OscilloscopeAPI(manager))
+        manager.oscilloscope_streamer.add_readings([_reading(i) for i in range(5)])
+        
+        first = streamer.get_trace_update("HX711_001", client_id="a")['data']
+        manager.oscilloscope_streamer.add_readings([_reading(i) for i in range(5, 8)])
+        second = streamer.get_trace_update("HX711_001", client_id="a")['data']
+        other = streamer.get_trace_update("HX711_001", client_id="b")['data']
+        
+        assert first['new_points'] == 5 and second['new_points'] == 3
+        assert [p['v'] for p in second['data']] == [5.0, 6.0, 7.0]
+        assert other['new_points'] == 8 and other['next_seq'] == 8
+        assert streamer.get_trace_update("HX711_001", client_id="a")['data']['new_points'] == 0
+        manager.close()
+    
+    def test_minmax_decimation_keeps_peaks(self):
+        """Testa envelope min/max incremental contra recálculo e picos isolados."""
+        streamer = OscilloscopeStreamer(max_points=1000)
+        readings = [_reading(i) for i in range(2600)]
+        for reading in readings:
+            reading.strain_value = 500.0 if reading.raw_adc_value % 331 == 0 else float(reading.raw_adc_value % 7)
+        
+        streamer.add_readings(readings[:1500])
+        streamer.get_decimated("HX711_001", width=64)
+        streamer.add_readings(readings[1500:])
+        times, values = streamer.get_decimated("HX711_001", width=64)
+        
+        window = readings[-1000:]
+        fresh = OscilloscopeStreamer(max_points=1000)
+        fresh.add_readings(readings)
+        assert (times, values) == fresh.get_decimated("HX711_001", width=64)
+        assert len(times) <= 2 * 64 + 2
+        assert times == sorted(times)
+        assert values.count(500.0) == sum(1 for r in window if r.strain_value == 500.0)
+        assert min(values) == min(r.strain_value for r in window)
+    
+    def test_decimation_cache_per_window(self):
+        """Testa que janelas com o mesmo bucket não compartilham cache."""
+        streamer = OscilloscopeStreamer(max_points=1000)
+        streamer.add_readings([_reading(i) for i in range(1000)])
+        
+        # last_n=500 com width=50 e a janela inteira com width=100: bucket de 10 pontos
+        recent = streamer.get_decimated("HX711_001", width=50, last_n=500)
+        times, values = streamer.get_decimated("HX711_001", width=100)
+        
+        fresh = OscilloscopeStreamer(max_points=1000)
+        fresh.add_readings([_reading(i) for i in range(1000)])
+        assert (times, values) == fresh.get_decimated("HX711_001", width=100)
+        assert values[0] == 0.0
+        assert recent == fresh.get_decimated("HX711_001", width=50, last_n=500)
+    
+    def test_lttb_decimation(self):
+        """Testa LTTB com tamanho constante e extremos da janela."""
+        streamer = OscilloscopeStreamer(max_points=400)
+        streamer.add_readings([_reading(i) for i in range(1000)])
+        
+        times, values = streamer.get_decimated("HX711_001", width=50, mode='lttb')
+        
+        assert 45 <= len(times) <= 52
+        assert values[0] == 600.0 and values[-1] == 999.0
+        assert times == sorted(times)
+        assert streamer.get_decimated("INEXISTENTE", width=50) == ([], [])
+
+
+class TestFatigue:
+    """Testes para rainflow, dano de Miner e PSD incrementais."""
+    
+    # Exemplo de contagem rainflow da ASTM E1049 (figura 6)
+    ASTM_HISTORY = [-2, 1, -3, 5, -1, 3, -4, 4, -2]
+    
+    def test_rainflow_matches_astm_example_incrementally(self):
+        """Testa contagem da norma com o resíduo, amostra a amostra e em lote."""
+        whole = RainflowCounter(range_bin=1)
+        whole.update(self.ASTM_HISTORY)
+        streamed = RainflowCounter(range_bin=1)
+        for value in self.ASTM_HISTORY:
+            streamed.update([value])
+        
+        counts = {}
+        for (range_bin, _), count in whole.matrix.items():
+            counts[range_bin] = counts.get(range_bin, 0) + count
+        for cycle_range, _ in whole.residue_cycles():
+            counts[cycle_range] = counts.get(cycle_range, 0) + 0.5
+        
+        assert counts == {3: 0.5, 4: 1.5, 6: 0.5, 8: 1.0, 9: 0.5}
+        assert streamed.matrix == whole.matrix and streamed.residue() == whole.residue()
+        assert whole.residue() == [5, -4, 4, -2]
+    
+    def test_rainflow_gate_and_miner_damage(self):
+        """Testa histerese contra ruído e dano de amplitude constante."""
+        curve = SNCurve(reference_range=90.0, m=3.0, reference_cycles=2e6)
+        # 1000 ciclos de 500 µε (105 MPa) com ruído de 1 µε sobreposto
+        values = [250 * math.sin(2 * math.pi * i / 40) + (1 if i % 3 else -1)
+                  for i in range(40 * 1000 + 1)]
+        damage = MinerDamage(curve, modulus_mpa=210000.0)
+        counter = RainflowCounter(gate=5.0, range_bin=50.0, on_cycle=damage.add_cycle)
+        counter.update(values)
+        
+        expected = 1 / curve.cycles_to_failure(105.0)
+        assert counter.cycles == pytest.approx(999.5, abs=1)
+        assert counter.max_range == pytest.approx(500, abs=3)
+        assert damage.damage == pytest.approx(999.5 * expected, rel=0.03)
+        
+        knee = SNCurve(reference_range=90.0, knee_cycles=5e6, m2=5.0, cutoff_cycles=1e8)
+        assert knee.cycles_to_failure(knee.knee_range) == pytest.approx(5e6)
+        assert math.isinf(knee.cycles_to_failure(knee.cutoff_range * 0.99))
+    
+    def test_welch_psd_of_sine(self):
+        """Testa frequência dominante e RMS de um seno entregue em lotes irregulares."""
+        psd = WelchPSD(segment=256, overlap=0.5)
+        times = [10.0 * i for i in range(4096)]
+        values = [100 * math.sin(2 * math.pi * 12.5 * i / 100) for i in range(4096)]
+        for start in range(0, 4096, 37):
+            psd.update(times[start:start + 37], values[start:start + 37])
+        
+        frequencies, density = psd.spectrum()
+        peak = max(range(len(density)), key=density.__getitem__)
+        rms = math.sqrt(sum(density) * (frequencies[1] - frequencies[0]))
+        
+        assert psd.segments == (4096 - 256) // 128 + 1
+        assert psd.sample_rate_hz == pytest.approx(100.0)
+        assert frequencies[peak] == pytest.approx(12.5)
+        assert rms == pytest.approx(100 / math.sqrt(2), rel=0.01)
+    
+    def test_data_manager_fatigue_through_api(self, tmp_path):
+        """Testa análise alimentada pela ingestão e exposta pelo OscilloscopeAPI."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        api = OscilloscopeAPI(manager)
+        assert api.get_fatigue_data("HX711_001")['active'] is False
+        
+        manager.start_fatigue(psd_segment=64)
+        readings = [_reading(i) for i in range(2000)]
+        for i, reading in enumerate(readings):
+            reading.strain_value = 300 * math.sin(2 * math.pi * i / 20)
+        manager.add_readings(readings)
+        
+        fatigue = api.get_fatigue_data("HX711_001")
+        spectrum = api.get_spectrum_data("HX711_001", max_frequency=2.0)
+        
+        assert fatigue['active'] and fatigue['samples'] == 2000
+        assert fatigue['cycles'] == pytest.approx(99.5, abs=1)
+        assert fatigue['damage'] > 0 and fatigue['life_hours'] > 0
+        assert spectrum['dominant_frequency'] == pytest.approx(0.5, abs=0.1)
+        assert max(spectrum['frequencies']) <= 2.0
+        manager.close()
+
+
+class TestAlarms:
+    """Testes para o motor de alarmes avaliado na ingestão."""
+    
+    @staticmethod
+    def _batch(values, sensor_id="HX711_001", start=0, step_us=10000, battery=80):
+        return StrainBatch.for_sensor(
+            sensor_id,
+            array('q', [(start + i) * step_us for i in range(len(values))]),
+            array('d', values),
+            array('i', [0] * len(values)),
+            array('h', [battery] * len(values)),
+            array('d', [25.0] * len(values))
+        )
+    
+    def test_threshold_hysteresis_catches_single_sample_spike(self):
+        """Testa pico de uma amostra no meio do lote e desativação só abaixo de clear."""
+        engine = AlarmEngine([AlarmRule('overload', 'strain', 1000.0, direction='outside',
+                                        clear=800.0, severity='critical')])
+        received = []
+        engine.subscribe(received.append)
+        
+        values = [0.0] * 100
+        values[37] = -1200.0
+        events = engine.add_batch(self._batch(values))
+        assert [(e.timestamp_us, e.value, e.raised) for e in events] == [
+            (370000, -1200.0, True), (380000, 0.0, False)]
+        assert received == events and received[0].severity == 'critical'
+        
+        # Entre clear e limit o alarme permanece ativo
+        events = engine.add_batch(self._batch([1500.0, 900.0, 850.0], start=100))
+        assert [e.raised for e in events] == [True]
+        assert engine.active_alarms()[0]['rule'] == 'overload'
+        assert engine.add_batch(self._batch([900.0] * 50, start=103)) == []
+        events = engine.add_batch(self._batch([900.0, 700.0], start=153))
+        assert [(e.timestamp_us, e.raised) for e in events] == [(1540000, False)]
+        assert engine.active_alarms() == []
+        assert engine.get_stats()['samples_evaluated'] == 155
+    
+    def test_rate_and_count_window_across_batches(self):
+        """Testa taxa de variação e N ocorrências em T com estado entre lotes."""
+        engine = AlarmEngine([
+            AlarmRule('impact', 'strain', 50000.0, kind='rate', direction='outside'),
+            AlarmRule('peaks', 'strain', 100.0, kind='count', count=3, window_ms=100.0),
+            {'name': 'battery', 'field': 'battery', 'limit': 10, 'direction': 'below',
+             'clear': 15, 'sensors': ['HX711_002']}
+        ])
+        # Salto de 600 µε em 10 ms (60000 µε/s) na fronteira entre lotes
+        engine.add_batch(self._batch([0.0] * 10))
+        events = engine.add_batch(self._batch([600.0] + [0.0] * 20, start=10))
+        impact = [e for e in events if e.rule == 'impact']
+        assert [(e.timestamp_us, e.raised) for e in impact] == [(100000, True), (120000, False)]
+        assert impact[0].value == pytest.approx(60000.0)
+        
+        # Picos a cada 40 ms: 3 em 100 ms ativam; espaçados a cada 60 ms, não
+        sparse = ([200.0] + [0.0] * 5) * 4
+        assert not [e for e in engine.add_batch(self._batch(sparse, start=100))
+                    if e.rule == 'peaks']
+        dense = ([200.0] + [0.0] * 3) * 3 + [0.0] * 20
+        peaks = [e for e in engine.add_batch(self._batch(dense, start=200))
+                 if e.rule == 'peaks']
+        assert [(e.timestamp_us, e.raised) for e in peaks] == [(2080000, True), (2110000, False)]
+        
+        # Regra restrita a um sensor
+        engine.add_batch(self._batch([0.0] * 5, sensor_id="HX711_001", battery=5))
+        engine.add_batch(self._batch([0.0] * 5, sensor_id="HX711_002", battery=5))
+        assert [a['sensor_id'] for a in engine.active_alarms() if a['rule'] == 'battery'] == [
+            "HX711_002"]
+        with pytest.raises(ValueError):
+            AlarmRule('bad', 'strain', 100.0, direction='above', clear=200.0)
+    
+    def test_data_manager_alarms_through_api(self, tmp_path):
+        """Testa alarmes avaliados em add_readings e expostos pelo OscilloscopeAPI."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        api = OscilloscopeAPI(manager)
+        assert api.get_alarm_data()['active'] is False
+        
+        engine = manager.start_alarms([AlarmRule('high', 'strain', 150.0)])
+        received = []
+        engine.subscribe(received.append)
+        readings = [_reading(i) for i in range(200)]
+        readings[170].strain_value = 0.0
+        manager.add_readings(readings)
+        manager.add_reading(_reading(200, sensor_id="HX711_002"))
+        
+        data = api.get_alarm_data("HX711_001")
+        assert [(e.raised, e.value) for e in received] == [
+            (True, 151.0), (False, 0.0), (True, 171.0), (True, 200.0)]
+        assert [alarm['sensor_id'] for alarm in manager.get_active_alarms()] == [
+            "HX711_001", "HX711_002"]
+        assert data['active'] and len(data['alarms']) == 1
+        assert [event['state'] for event in data['events']] == ['raised', 'cleared', 'raised']
+        assert data['stats']['samples_evaluated'] == 201
+        manager.close()
+
+
+class TestWriteBehindWriter:
+    """Testes para a persistência em segundo plano."""
+    
+    def _batch(self, start: int, count: int) -> ReadingColumns:
+        buffer = DataBuffer(max_size=count)
+        buffer.add_readings([_reading(i) for i in range(start, start + count)])
+        return buffer.drain()
+    
+    def test_drain_is_atomic(self):
+        """Testa que drain retira tudo e o buffer continua utilizável."""
+        buffer = DataBuffer(max_size=10)
+        buffer.add_readings([_reading(i) for i in range(4)])
+        
+        batch = buffer.drain()
+        buffer.add_reading(_reading(4))
+        
+        assert list(batch.strain_values) == [0.0, 1.0, 2.0, 3.0]
+        assert buffer.size() == 1
+        assert buffer.get_latest_reading().strain_value == 4.0
+    
+    def test_submit_does_not_wait_for_store(self):
+        """Testa que o produtor não espera a gravação lenta."""
+        release = threading.Event()
+        stored = []
+        writer = WriteBehindWriter(
+            store=lambda batches: (release.wait(), stored.extend(batches)),
+            max_latency=0.01
+        )
+        
+        started = time.perf_counter()
+        for i in range(5):
+            writer.submit(self._batch(i * 10, 10))
+        elapsed = time.perf_counter() - started
+        
+        assert elapsed < 0.5
+        assert writer.flush(timeout=0.05) is False
+        assert sum(len(b) for b in writer.pending()) == 50
+        
+        release.set()
+        assert writer.flush(timeout=5)
+        writer.close()
+        assert sum(len(b) for b in stored) == 50
+    
+    def test_staged_batch_visible_until_queued(self):
+        """Testa lote de stage() em pending() enquanto submit espera espaço na fila."""
+        release = threading.Event()
+        stored = []
+        writer = WriteBehindWriter(
+            store=lambda batches: (release.wait(), stored.extend(batches)),
+            batch_size=10,
+            max_latency=0.01,
+            queue_size=1
+        )
+        writer.submit(self._batch(0, 10))
+        time.sleep(0.1)  # writer ocupado com o primeiro lote
+        writer.submit(self._batch(10, 10))
+        
+        staged = writer.stage(lambda: self._batch(20, 10))
+        producer = threading.Thread(target=writer.submit, args=(staged,))
+        producer.start()
+        time.sleep(0.05)  # fila cheia: submit bloqueado
+        assert producer.is_alive()
+        assert [b.strain_values[0] for b in writer.pending()] == [0.0, 10.0, 20.0]
+        
+        release.set()
+        producer.join(5)
+        assert writer.flush(timeout=5)
+        assert writer.pending() == []
+        writer.close()
+        assert [b.strain_values[0] for b in stored] == [0.0, 10.0, 20.0]
+    
+    def test_detach_after_close_timeout_hands_off_unstarted_batches(self):
+        """Testa que lotes entregues por detach_pending nunca são gravados pelo writer."""
+        release = threading.Event()
+        stored = []
+        writer = WriteBehindWriter(
+            store=lambda batches: (release.wait(), stored.extend(batches)),
+            batch_size=10,
+            max_latency=0.01
+        )
+        
+        for i in range(3):
+            writer.submit(self._batch(i * 10, 10))
+        time.sleep(0.1)  # writer ocupado com o primeiro lote
+        
+        assert writer.close(timeout=0.05) is False
+        detached = writer.detach_pending()
+        release.set()
+        assert writer.close(timeout=5) is True
+        
+        assert [b.strain_values[0] for b in detached] == [10.0, 20.0]
+        assert [b.strain_values[0] for b in stored] == [0.0]
+    
+    def test_source_batch_visible_in_pending_once_drained(self):
+        """Testa que o lote retirado do source entra em pending() no mesmo passo."""
+        drained = self._batch(0, 5)
+        sources = [drained]
+        seen = []
+        readers = []
+        
+        def drain():
+            # Leitor concorrente que consulta pending() durante a retirada
+            reader = threading.Thread(target=lambda: seen.append(writer.pending()))
+            reader.start()
+            readers.append(reader)
+            return sources.pop() if sources else None
+        
+        def source(take):
+            take(drain)
+        
+        def store(batches):
+            readers[0].join()
+        
+        writer = WriteBehindWriter(store=store, max_latency=0.01, source=source)
+        time.sleep(0.1)
+        writer.close(timeout=5)
+        for reader in readers:
+            reader.join()
+        
+        assert any(batch is drained for batch in seen[0])
+    
+    def test_source_work_after_take_does_not_block_pending(self):
+        """Testa pending() livre enquanto o source grava em disco após a retirada."""
+        drained = self._batch(0, 5)
+        sources = [drained]
+        release = threading.Event()
+        
+        def source(take):
+            if take(lambda: sources.pop() if sources else None) is not None:
+                release.wait()  # gravação da captura
+        
+        writer = WriteBehindWriter(store=lambda batches: None, max_latency=0.01,
+                                   source=source)
+        time.sleep(0.1)
+        started = time.monotonic()
+        seen = writer.pending()
+        elapsed = time.monotonic() - started
+        release.set()
+        writer.close(timeout=5)
+        
+        assert [batch is drained for batch in seen] == [True]
+        assert elapsed < 0.05
+    
+    def test_drop_oldest_policy(self):
+        """Testa descarte do lote mais antigo com fila cheia."""
+        release = threading.Event()
+        writer = WriteBehindWriter(
+            store=lambda batches: release.wait(),
+            batch_size=10,
+            max_latency=0.01,
+            queue_size=2,
+            policy=BackpressurePolicy.DROP_OLDEST
+        )
+        
+        writer.submit(self._batch(0, 10))
+        time.sleep(0.1)  # writer ocupado com o primeiro lote
+        for i in range(1, 5):
+            writer.submit(self._batch(i * 10, 10))
+        
+        assert writer.readings_dropped == 20
+        release.set()
+        writer.close(timeout=5)
+        assert writer.readings_written == 30
+    
+    def test_spill_policy_replays_on_close(self, tmp_path):
+        """Testa spill em disco e reprocessamento no encerramento."""
+        release = threading.Event()
+        stored = []
+        writer = WriteBehindWriter(
+            store=lambda batches: (release.wait(), stored.extend(batches)),
+            batch_size=10,
+            max_latency=0.01,
+            queue_size=1,
+            policy=BackpressurePolicy.SPILL,
+            spill_dir=tmp_path,
+            batch_factory=ReadingColumns
+        )
+        
+        writer.submit(self._batch(0, 10))
+        time.sleep(0.1)
+        for i in range(1, 4):
+            writer.submit(self._batch(i * 10, 10))
+        
+        assert writer.readings_spilled >= 10
+        release.set()
+        writer.close(timeout=5)
+        
+        values = sorted(v for batch in stored for v in batch.strain_values)
+        assert values == [float(i) for i in range(40)]
+        assert stored[-1].sensor_id(0) == "HX711_001"
+        assert list(tmp_path.glob('*.spill')) == []
+    
+    def test_spill_backlog_replayed_while_queue_is_idle(self, tmp_path):
+        """Testa reprocessamento do spill sem esperar max_latency por arquivo."""
+        release = threading.Event()
+        stored = []
+        writer = WriteBehindWriter(
+            store=lambda batches: (release.wait(), stored.extend(batches)),
+            batch_size=10,
+            max_latency=0.2,
+            queue_size=1,
+            policy=BackpressurePolicy.SPILL,
+            spill_dir=tmp_path,
+            batch_factory=ReadingColumns
+        )
+        writer.submit(self._batch(0, 10))
+        time.sleep(0.1)
+        for i in range(1, 21):
+            writer.submit(self._batch(i * 10, 10))
+        assert len(list(tmp_path.glob('*.spill'))) >= 18
+        
+        release.set()
+        deadline = time.monotonic() + 1.0
+        while list(tmp_path.glob('*.spill')) and time.monotonic() < deadline:
+            time.sleep(0.01)
+        
+        assert list(tmp_path.glob('*.spill')) == []
+        assert sum(len(batch) for batch in stored) == 210
+        writer.close(timeout=5)
+
+
+def _create_v1_database(path: Path, count: int) -> None:
+    """Cria banco com o schema v1 (strain_readings) e leituras intercaladas."""
+    conn = sqlite3.connect(str(path))
+    conn.execute("""
+        CREATE TABLE strain_readings (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            timestamp REAL NOT NULL,
+            strain_value REAL NOT NULL,
+            raw_adc_value INTEGER NOT NULL,
+            sensor_id TEXT NOT NULL,
+            battery_level INTEGER NOT NULL,
+            temperature REAL NOT NULL,
+            checksum TEXT,
+            created_at REAL DEFAULT (datetime('now'))
+        )
+    """)
+    conn.execute("CREATE INDEX idx_readings_timestamp ON strain_readings(timestamp)")
+    conn.execute("CREATE INDEX idx_readings_sensor ON strain_readings(sensor_id)")
+    conn.executemany("""
+        INSERT INTO strain_readings
+        (timestamp, strain_value, raw_adc_value, sensor_id, battery_level, temperature, checksum)
+        VALUES (?, ?, ?, ?, ?, ?, ?)
+    """, [
+        (r.timestamp.timestamp(), r.strain_value, r.raw_adc_value, r.sensor_id,
+         r.battery_level, r.temperature, r.checksum)
+        for r in (_reading(i, "HX711_00" + str(i % 2)) for i in range(count))
+    ])
+    conn.commit()
+    conn.close()
+
+
+class TestDatabaseManager:
+    """Testes para o banco de dados (schema v2)."""
+    
+    def test_store_and_query(self, tmp_path):
+        """Testa gravação e consulta por sensor e intervalo."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        database.store_readings([_reading(i, "HX711_00" + str(i % 2)) for i in range(100)])
+        
+        readings = database.get_readings(
+            sensor_id="HX711_001",
+            start_time=START + timedelta(seconds=2),
+            end_time=START + timedelta(seconds=4)
+        )
+        
+        assert [r.strain_value for r in readings] == [float(i) for i in range(39, 20, -2)]
+        assert readings[0].timestamp == START + timedelta(milliseconds=3900)
+        assert len(database.get_readings(limit=7)) == 7
+        assert database.get_readings(sensor_id="INEXISTENTE") == []
+        
+        version = database._get_connection().execute("PRAGMA user_version").fetchone()[0]
+        mode = database._get_connection().execute("PRAGMA journal_mode").fetchone()[0]
+        assert version == DatabaseManager.SCHEMA_VERSION
+        assert mode == "wal"
+        database.close()
+    
+    def test_cleanup_old_data(self, tmp_path):
+        """Testa remoção de leituras antigas."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        old, recent = _reading(0), _reading(1)
+        old.timestamp = datetime.now() - timedelta(days=40)
+        recent.timestamp = datetime.now()
+        database.store_readings([old, recent])
+        
+        assert database.cleanup_old_data(days=30) == 1
+        assert len(database.get_readings()) == 1
+        database.close()
+    
+    def test_migration_from_v1(self, tmp_path):
+        """Testa migração do schema v1 preservando as leituras."""
+        path = tmp_path / "legacy.db"
+        _create_v1_database(path, 5000)
+        DatabaseManager.MIGRATION_BATCH_SIZE, batch_size = 1000, DatabaseManager.MIGRATION_BATCH_SIZE
+        try:
+            database = DatabaseManager(path)
+            # Durante a migração as consultas veem dados v1 e v2
+            assert len(database.get_readings(sensor_id="HX711_000", limit=10)) == 10
+            assert database.wait_migration(timeout=30)
+        finally:
+            DatabaseManager.MIGRATION_BATCH_SIZE = batch_size
+        
+        readings = database.get_readings(sensor_id="HX711_001")
+        tables = {row[0] for row in database._get_connection().execute(
+            "SELECT name FROM sqlite_master WHERE type = 'table'")}
+        
+        assert len(readings) == 2500
+        assert readings[-1].strain_value == 1.0
+        assert "strain_readings" not in tables
+        database.close()
+    
+    def test_iteration_merges_pending_migration(self, tmp_path):
+        """Testa iter_rows/iter_readings sem esperar a migração, sem perdas nem duplicatas."""
+        path = tmp_path / "legacy.db"
+        _create_v1_database(path, 200)
+        gate = threading.Event()
+        
+        class StalledDatabase(DatabaseManager):
+            def _migrate_legacy(self):
+                gate.wait(30)
+                super()._migrate_legacy()
+        
+        database = StalledDatabase(path)
+        try:
+            # Linha já copiada para a partição e ainda presente na tabela v1
+            database.store_readings([_reading(10, "HX711_000"), _reading(500, "HX711_001")])
+            
+            rows = list(database.iter_rows(descending=False))
+            chunks = list(database.iter_readings("HX711_000", chunk_size=64))
+            
+            assert not database.wait_migration(timeout=0)
+            assert len(rows) == 201
+            assert [row[0] for row in rows] == sorted(row[0] for row in rows)
+            assert rows[-1][1] == "HX711_001" and rows[-1][2] == 500.0
+            assert sum(len(chunk) for chunk in chunks) == 100
+            assert chunks[0].to_readings()[5].strain_value == 10.0
+            assert {chunk.sensor_id(0) for chunk in chunks} == {"HX711_000"}
+        finally:
+            gate.set()
+        
+        assert database.wait_migration(timeout=30)
+        assert len(list(database.iter_rows())) == 201
+        database.close()
+    
+    def test_migration_from_v2_table(self, tmp_path):
+        """Testa migração da tabela readings (v2) do banco principal."""
+        path = tmp_path / "v2.db"
+        conn = sqlite3.connect(str(path))
+        conn.execute("CREATE TABLE sensors (sensor_key INTEGER PRIMARY KEY, sensor_id TEXT NOT NULL UNIQUE)")
+        conn.execute("""
+            CREATE TABLE readings (
+                sensor_key INTEGER NOT NULL, ts_ms INTEGER NOT NULL,
+                strain_value REAL NOT NULL, raw_adc_value INTEGER NOT NULL,
+                battery_level INTEGER NOT NULL, temperature REAL NOT NULL,
+                PRIMARY KEY (sensor_key, ts_ms)
+            ) WITHOUT ROWID
+        """)
+        conn.execute("INSERT INTO sensors VALUES (1, 'HX711_001')")
+        conn.executemany("INSERT INTO readings VALUES (1, ?, ?, 0, 80, 25.0)", [
+            (round((START + timedelta(milliseconds=100 * i)).timestamp() * 1000), float(i))
+            for i in range(300)
+        ])
+        conn.execute("PRAGMA user_version = 2")
+        conn.commit()
+        conn.close()
+        
+        database = DatabaseManager(path, migrate_in_background=False)
+        
+        assert len(database.get_readings(sensor_id="HX711_001")) == 300
+        assert database.get_readings(limit=1)[0].strain_value == 299.0
+        assert database._get_connection().execute("PRAGMA user_version").fetchone()[0] == 3
+        database.close()
+    
+    def test_queries_span_daily_partitions(self, tmp_path):
+        """Testa consultas que atravessam partições de dias diferentes."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        readings = []
+        for day in range(3):
+            for i in range(10):
+                reading = _reading(i)
+                reading.timestamp = START + timedelta(days=day, minutes=i)
+                reading.strain_value = day * 100.0 + i
+                readings.append(reading)
+        database.store_readings(readings)
+        
+        latest = database.get_readings(limit=12)
+        window = database.get_readings(
+            start_time=START + timedelta(days=1, minutes=5),
+            end_time=START + timedelta(days=2, minutes=2)
+        )
+        
+        assert len(database.partitions.days()) == 3
+        assert [r.strain_value for r in latest[:3]] == [209.0, 208.0, 207.0]
+        assert latest[-1].strain_value == 108.0
+        assert [r.strain_value for r in window] == [202.0, 201.0, 200.0, 109.0, 108.0,
+                                                    107.0, 106.0, 105.0]
+        database.close()
+    
+    def test_iter_readings_is_chronological(self, tmp_path):
+        """Testa leitura em blocos intercalando sensores e partições."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        readings = []
+        for day in range(2):
+            for i in range(20):
+                reading = _reading(i, f"HX711_00{i % 3}")
+                reading.timestamp = START + timedelta(days=day, seconds=i)
+                readings.append(reading)
+        database.store_readings(readings)
+        
+        chunks = list(database.iter_readings(chunk_size=7))
+        timestamps = [ts for chunk in chunks for ts in chunk.timestamps_us]
+        sensors = [chunk.sensor_id(i) for chunk in chunks for i in range(len(chunk))]
+        
+        assert max(len(chunk) for chunk in chunks) == 7
+        assert timestamps == sorted(timestamps) and len(timestamps) == 40
+        assert sensors == [r.sensor_id for r in readings]
+        
+        only = list(database.iter_readings("HX711_001", end_time=START + timedelta(seconds=30)))
+        assert [r.strain_value for r in only[0].to_readings()] == [1.0, 4.0, 7.0, 10.0,
+                                                                 13.0, 16.0, 19.0]
+        database.close()
+    
+    def test_retention_drops_partition_files(self, tmp_path):
+        """Testa retenção removendo arquivos de partição inteiros."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        readings = []
+        for days_ago in (45, 40, 0):
+            for i in range(5):
+                reading = _reading(i)
+                reading.timestamp = datetime.now() - timedelta(days=days_ago, seconds=i)
+                readings.append(reading)
+        database.store_readings(readings)
+        directory = tmp_path / "daq_partitions"
+        assert len(list(directory.glob("*.db"))) == 3
+        
+        assert database.cleanup_old_data(days=30) == 10
+        
+        assert len(list(directory.glob("*.db"))) == 1
+        assert len(database.get_readings()) == 5
+        database.store_readings([_reading(99)])  # dia já removido é recriado
+        assert len(database.partitions.days()) == 2
+        database.close()
+    
+    def test_retention_leaves_connections_to_their_thread(self, tmp_path):
+        """Testa que a remoção de partição não fecha a conexão de outro thread."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        reading = _reading(0)
+        reading.timestamp = datetime.now() - timedelta(days=45)
+        database.store_readings([reading])
+        day = database.partitions.days()[0]
+        opened, dropped = threading.Event(), threading.Event()
+        result = {}
+        
+        def owner():
+            conn = database.partitions.connection(day)
+            opened.set()
+            dropped.wait(5)
+            result['usable'] = conn.execute("SELECT 1").fetchone()[0] == 1
+            result['fresh'] = database.partitions.connection(day) is not conn
+            try:
+                conn.execute("SELECT 1")
+                result['closed'] = False
+            except sqlite3.ProgrammingError:
+                result['closed'] = True
+        
+        thread = threading.Thread(target=owner)
+        thread.start()
+        opened.wait(5)
+        assert database.cleanup_old_data(days=30) == 1
+        dropped.set()
+        thread.join(5)
+        
+        assert result == {'usable': True, 'fresh': True, 'closed': True}
+        database.close()
+    
+    def test_storage_is_smaller_than_v1(self, tmp_path):
+        """Testa que o layout atual ocupa bem menos espaço que o v1."""
+        legacy = tmp_path / "legacy.db"
+        _create_v1_database(legacy, 20000)
+        
+        database = DatabaseManager(tmp_path / "daq.db")
+        database.store_readings([_reading(i, "HX711_00" + str(i % 2)) for i in range(20000)])
+        database.close()
+        
+        size = sum(f.stat().st_size for f in tmp_path.glob("daq*")
+                   if f.is_file()) + sum(
+            f.stat().st_size for f in (tmp_path / "daq_partitions").iterdir())
+        assert size < 0.6 * legacy.stat().st_size
+
+
+class _PendingWriter:
+    """Writer falso com lotes em trânsito fixos."""
+    
+    def __init__(self, batches):
+        self.batches = batches
+    
+    def pending(self):
+        return self.batches
+
+
+class TestReadingQuery:
+    """Testes para a consulta intercalada buffer + writer + banco."""
+    
+    def _query(self, tmp_path, stored, pending, buffered):
+        database = DatabaseManager(tmp_path / "daq.db", migrate_in_background=False)
+        database.store_readings(stored)
+        buffer = DataBuffer(max_size=1000)
+        buffer.add_readings(buffered)
+        writer = _PendingWriter([ReadingColumns.from_readings(pending)])
+        return ReadingQuery(buffer, writer, database), database
+    
+    def test_limit_merges_sources_newest_first(self, tmp_path):
+        """Testa limite aplicado depois da intercalação, sem duplicatas."""
+        readings = [_reading(i, "HX711_00" + str(i % 2)) for i in range(300)]
+        # Sobreposição entre fontes: a do buffer (mais recente) prevalece
+        changed = _reading(250, "HX711_000")
+        changed.strain_value = -1.0
+        query, database = self._query(tmp_path, readings[:260], readings[200:280],
+                                      [changed] + readings[270:])
+        
+        newest = list(query.readings(limit=5))
+        recent_a = list(query.readings("HX711_000", end_time=START + timedelta(seconds=25),
+                                       limit=3))
+        
+        assert [r.strain_value for r in newest] == [299.0, 298.0, 297.0, 296.0, 295.0]
+        assert [r.strain_value for r in recent_a] == [-1.0, 248.0, 246.0]
+        assert len(list(query.readings(descending=False))) == 300
+        database.close()
+    
+    def test_buffer_drained_mid_iteration_is_not_lost(self, tmp_path):
+        """Testa consulta maior que um bloco com o buffer esvaziado durante a iteração."""
+        database = DatabaseManager(tmp_path / "daq.db", migrate_in_background=False)
+        buffer = DataBuffer(max_size=5000)
+        buffer.add_readings([_reading(i) for i in range(3000)])
+        writer = _PendingWriter([])
+        query = ReadingQuery(buffer, writer, database)
+        
+        rows = query.readings()
+        first = next(rows)
+        writer.batches.append(buffer.drain())  # flush entre blocos
+        seen = [first.strain_value] + [r.strain_value for r in rows]
+        
+        assert seen == [float(i) for i in range(2999, -1, -1)]
+        database.close()
+    
+    def test_cursor_pagination_covers_range_once(self, tmp_path):
+        """Testa paginação por cursor nas duas ordens."""
+        readings = [_reading(i // 3, "HX711_00" + str(i % 3)) for i in range(600)]
+        query, database = self._query(tmp_path, readings[:300], readings[300:400],
+                                      readings[350:])
+        
+        for descending in (True, False):
+            seen, cursor = [], None
+            while True:
+                page, cursor = query.page(page_size=64, descending=descending, cursor=cursor)
+                seen.extend((r.timestamp_us, r.sensor_id) for r in page)
+                if cursor is None:
+                    break
+                assert isinstance(cursor, QueryCursor) and len(page) == 64
+            assert len(seen) == len(set(seen)) == 600
+            assert seen == sorted(seen, reverse=descending)
+        database.close()
+    
+    def test_data_manager_recent_readings_limit(self, tmp_path):
+        """Testa get_recent_readings com limite sobre banco e buffer."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        start = datetime.now() - timedelta(minutes=5)
+        readings = [_reading(i) for i in range(500)]
+        for i, reading in enumerate(readings):
+            reading.timestamp = start + timedelta(milliseconds=100 * i)
+        manager.add_readings(readings[:400])
+        manager.flush()
+        manager.add_readings(readings[400:])
+        
+        recent = manager.get_recent_readings(minutes=10, max_count=150)
+        
+        assert [r.strain_value for r in recent] == [float(i) for i in range(350, 500)]
+        assert len(manager.get_recent_readings(minutes=10)) == 500
+        manager.close()
+
+
+class TestRollups:
+    """Testes para os agregados multi-resolução."""
+    
+    def test_split_range(self):
+        """Testa decomposição da janela em buckets inteiros e bordas."""
+        segments = rollups.split_range(3_599_500, 7_261_250)
+        
+        assert segments == [
+            (None, 3_599_500, 3_600_000),
+            ('1h', 3_600_000, 7_200_000),
+            ('1m', 7_200_000, 7_260_000),
+            ('1s', 7_260_000, 7_261_000),
+            (None, 7_261_000, 7_261_250),
+        ]
+    
+    def test_aggregates_match_raw_readings(self, tmp_path):
+        """Testa estatísticas por rollup contra cálculo direto."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        readings = []
+        for i in range(9000):
+            reading = _reading(i, "HX711_00" + str(i % 3))
+            reading.timestamp = START + timedelta(milliseconds=733 * i)
+            reading.strain_value = float((i * 37) % 101 - 50)
+            reading.battery_level = 20 + i % 70
+            readings.append(reading)
+        for start in range(0, len(readings), 1000):
+            database.store_readings(readings[start:start + 1000])
+        
+        start_time = START + timedelta(minutes=3, seconds=2, milliseconds=250)
+        end_time = START + timedelta(hours=1, minutes=41, seconds=7)
+        selected = [r for r in readings if r.sensor_id == "HX711_001" and
+                    start_time <= r.timestamp <= end_time]
+        
+        stats = database.get_aggregates("HX711_001", start_time, end_time)["HX711_001"]
+        
+        values = [r.strain_value for r in selected]
+        assert stats['count'] == len(selected)
+        assert stats['min'] == min(values)
+        assert stats['max'] == max(values)
+        assert stats['avg'] == pytest.approx(sum(values) / len(values))
+        assert stats['battery_min'] == min(r.battery_level for r in selected)
+        assert stats['last_ts_ms'] == round(selected[-1].timestamp.timestamp() * 1000)
+        assert set(database.get_aggregates()) == {"HX711_000", "HX711_001", "HX711_002"}
+        
+        hourly = database.get_rollups('1h', sensor_id="HX711_002")
+        assert sum(bucket['count'] for bucket in hourly) == 3000
+        database.close()
+
+    
+    def test_replayed_and_replaced_rows_counted_once(self, tmp_path):
+        """Testa rollups e contagem do catálogo após replay e substituição de leituras."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        readings = [_reading(i) for i in range(200)]
+        database.store_readings(readings)
+        database.store_readings(readings[50:150])  # replay (ex.: spill reenviado)
+        changed = _reading(120)
+        changed.strain_value = -500.0
+        database.store_readings([changed, _reading(120)])  # repetido no lote: vale o último
+        changed.strain_value = 900.0
+        database.store_readings([changed])
+        
+        values = [float(i) for i in range(200) if i != 120] + [900.0]
+        stats = database.get_aggregates("HX711_001")["HX711_001"]
+        minutes = database.get_rollups('1m', sensor_id="HX711_001")
+        
+        assert stats['count'] == 200 and stats['max'] == 900.0
+        assert stats['avg'] == pytest.approx(sum(values) / 200)
+        assert sum(bucket['count'] for bucket in minutes) == 200
+        assert database.partitions.row_count() == 200
+        database.close()
+    
+    def test_interrupted_write_rebuilds_main_rollups(self, tmp_path):
+        """Testa reconstrução de rollups e catálogo de partição com gravação incompleta."""
+        database = DatabaseManager(tmp_path / "daq.db")
+        database.store_readings([_reading(i) for i in range(100)])
+        # Simula queda entre o commit da partição e o do catálogo
+        with database._get_connection() as conn:
+            conn.execute("DELETE FROM rollup_1m")
+            conn.execute("UPDATE partitions SET row_count = 7, version = version - 1")
+        database.close()
+        
+        database = DatabaseManager(tmp_path / "daq.db")
+        minutes = database.get_rollups('1m', sensor_id="HX711_001")
+        
+        assert sum(bucket['count'] for bucket in minutes) == 100
+        assert database.partitions.row_count() == 100
+        assert database.partitions.stale_days() == []
+        database.close()
+    
+    def test_store_batches_without_reading_objects(self, tmp_path):
+        """Testa gravação direta de lotes colunares e rollups."""
+        db = DatabaseManager(tmp_path / "daq.db")
+        db.store_batches([
+            ReadingColumns.from_readings([_reading(i, "HX711_001" if i % 2 else "HX711_002")
+                                          for i in range(40)]),
+            ReadingColumns.from_readings([_reading(i, "HX711_003") for i in range(5)])
+        ])
+        
+        readings = db.get_readings(sensor_id="HX711_001")
+        assert sorted(r.strain_value for r in readings) == [float(i) for i in range(1, 40, 2)]
+        assert db.get_aggregates("HX711_003")["HX711_003"]['count'] == 5
+        db.close()
+    
+    def test_statistics_count_group_once_while_committing(self, tmp_path):
+        """Testa get_statistics sem contar duas vezes o grupo já gravado e ainda em trânsito."""
+        manager = DataManager(db_path=tmp_path / "daq.db", warm_start=False)
+        committed, release = threading.Event(), threading.Event()
+        store = manager._store_batches
+        manager.writer._store = lambda batches: (store(batches), committed.set(),
+                                                 release.wait())
+        start = datetime.now() - timedelta(minutes=1)
+        readings = [_reading(i) for i in range(50)]
+        for i, reading in enumerate(readings):
+            reading.timestamp = start + timedelta(milliseconds=100 * i)
+        manager.add_readings(readings)
+        manager._flush_buffer()
+        assert committed.wait(5)
+        
+        results = []
+        reader = threading.Thread(target=lambda: results.append(manager.get_statistics()))
+        reader.start()
+        time.sleep(0.05)  # commit feito, _in_flight ainda não limpo
+        release.set()
+        reader.join(5)
+        
+        assert results[0]['total_readings'] == 50
+        manager.close()
+
+class TestDataExporter:
+    """Testes para a exportação em fluxo."""
+    
+    @staticmethod
+    def _manager(tmp_path) -> DataManager:
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        manager.database.store_readings(
+            [_reading(i, f"HX711_00{i % 2}") for i in range(2500)]
+        )
+        return manager
+    
+    def test_export_json_and_csv(self, tmp_path):
+        """Testa JSON completo e CSV com metadados dos rollups."""
+        manager = self._manager(tmp_path)
+        manager.export_data('json', tmp_path / "out.json", chunk_size=300)
+        manager.export_data('csv', tmp_path / "out.csv", sensor_id="HX711_001")
+        
+        document = json.loads((tmp_path / "out.json").read_text(encoding='utf-8'))
+        lines = (tmp_path / "out.csv").read_text(encoding='utf-8').splitlines()
+        
+        assert document['metadata']['total_readings'] == 2500
+        assert [r['strain_value'] for r in document['readings']] == [float(i) for i in range(2500)]
+        assert '# Total de leituras: 1250' in lines
+        assert lines[lines.index('#') + 1].startswith('timestamp,')
+        assert len(lines) - lines.index('#') - 2 == 1250
+        manager.close()
+    
+    def test_export_jsonl_gzip(self, tmp_path):
+        """Testa JSON Lines comprimido por extensão .gz."""
+        manager = self._manager(tmp_path)
+        start = START + timedelta(seconds=10)
+        manager.export_data('jsonl', tmp_path / "out.jsonl.gz", start_time=start,
+                            end_time=start + timedelta(seconds=5))
+        
+        with gzip.open(tmp_path / "out.jsonl.gz", 'rt', encoding='utf-8') as f:
+            rows = [json.loads(line) for line in f]
+        
+        assert len(rows) == 51
+        assert rows[0]['strain_value'] == 100.0 and rows[0]['sensor_id'] == "HX711_000"
+        manager.close()
+    
+    def test_export_reading_list(self, tmp_path):
+        """Testa exportação de lista de StrainReading (API anterior)."""
+        readings = [_reading(i) for i in range(5)]
+        
+        DataExporter.export_to_json(readings, tmp_path / "list.json")
+        
+        document = json.loads((tmp_path / "list.json").read_text(encoding='utf-8'))
+        assert document['metadata']['total_readings'] == 5
+        assert document['readings'][4] == {
+            'timestamp': readings[4].timestamp.isoformat(),
+            'strain_value': 4.0,
+            'raw_adc_value': 1004,
+            'sensor_id': "HX711_001",
+            'battery_level': 80,
+            'temperature': 25.0,
+            'checksum': readings[4].checksum
+        }
+
+
+async def _ws_connect(port: int):
+    """Abre conexão WebSocket crua com o servidor de teste."""
+    reader, writer = await asyncio.open_connection('127.0.0.1', port)
+    writer.write(
+        b"GET /oscilloscope HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+        b"Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        b"Sec-WebSocket-Version: 13\r\n\r\n"
+    )
+    response = await reader.readuntil(b'\r\n\r\n')
+    return reader, writer, response
+
+
+def _masked_text(message: dict) -> bytes:
+    """Quadro de texto mascarado (cliente -> servidor)."""
+    payload = json.dumps(message).encode('utf-8')
+    mask = os.urandom(4)
+    masked = bytes(b ^ mask[i % 4] for i, b in enumerate(payload))
+    return bytes([0x80 | OP_TEXT, 0x80 | len(payload)]) + mask + masked
+
+
+class TestWebSocketServer:
+    """Testes para o servidor WebSocket do osciloscópio."""
+    
+    @pytest.mark.asyncio
+    async def test_handshake_full_window_and_deltas(self, tmp_path):
+        """Testa handshake, janela completa ao conectar e deltas binários."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        streamer = WebSocketStreamer(OscilloscopeAPI(manager))
+        server = OscilloscopeWebSocketServer(streamer, host='127.0.0.1', port=0,
+                                             update_rate=100.0, snapshot_interval=60.0)
+        manager.oscilloscope_streamer.add_readings([_reading(i) for i in range(5)])
+        await server.start()
+        try:
+            await asyncio.sleep(0.05)
+            reader, writer, response = await _ws_connect(server.port)
+            assert response.startswith(b"HTTP/1.1 101")
+            assert b"Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=" in response
+            
+            writer.write(_masked_text({'type': 'subscribe', 'sensors': ["HX711_001"]}))
+            frames = []
+            while not any(f['kind'] == TRACE_FULL for f in frames):
+                opcode, _, payload = await asyncio.wait_for(read_frame(reader, 1 << 20), 2.0)
+                if opcode == OP_BINARY:
+                    frames.append(decode_trace(payload))
+            
+            manager.oscilloscope_streamer.add_readings([_reading(i) for i in range(5, 8)])
+            while frames[-1]['kind'] != TRACE_DELTA:
+                opcode, _, payload = await asyncio.wait_for(read_frame(reader, 1 << 20), 2.0)
+                if opcode == OP_BINARY:
+                    frames.append(decode_trace(payload))
+            
+            full, delta = frames[0], frames[-1]
+            assert full['sensor_id'] == "HX711_001" and full['seq'] == 0
+            assert full['values'] == [0.0, 1.0, 2.0, 3.0, 4.0]
+            assert delta['seq'] == 5 and delta['values'] == [5.0, 6.0, 7.0]
+            assert delta['times'][2] - delta['times'][0] == pytest.approx(200.0)
+            assert server.get_stats()['clients'] == 1
+            writer.close()
+        finally:
+            await server.stop()
+            manager.close()
+        assert server.get_stats()['clients'] == 0
+    
+    @pytest.mark.asyncio
+    async def test_half_open_connections_count_and_time_out(self, tmp_path):
+        """Testa conexões sem cabeçalhos ocupando vaga e encerradas no prazo do handshake."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        server = OscilloscopeWebSocketServer(WebSocketStreamer(OscilloscopeAPI(manager)),
+                                             host='127.0.0.1', port=0, max_clients=2,
+                                             handshake_timeout=0.2)
+        await server.start()
+        try:
+            silent = [await asyncio.open_connection('127.0.0.1', server.port)
+                      for _ in range(2)]
+            await asyncio.sleep(0.05)
+            assert server.get_stats()['handshaking'] == 2
+            _, rejected, response = await _ws_connect(server.port)
+            assert response.startswith(b"HTTP/1.1 503")
+            rejected.close()
+            
+            for reader, writer in silent:
+                assert await asyncio.wait_for(reader.read(), 1.0) == b''
+                writer.close()
+            stats = server.get_stats()
+            assert stats['handshake_timeouts'] == 2 and stats['handshaking'] == 0
+            
+            _, writer, response = await _ws_connect(server.port)
+            assert response.startswith(b"HTTP/1.1 101")
+            writer.close()
+        finally:
+            await server.stop()
+            manager.close()
+    
+    def test_slow_client_queue_is_bounded(self, tmp_path):
+        """Testa fila limitada, coalescência de snapshots e ressincronização."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        server = OscilloscopeWebSocketServer(WebSocketStreamer(OscilloscopeAPI(manager)),
+                                             queue_size=4)
+        client = _Client("lento", writer=None)
+        
+        for i in range(3):
+            server._enqueue(client, 'snapshot', None, encode_frame(OP_TEXT, b'{}'))
+        for i in range(10):
+            server._enqueue(client, 'delta', "HX711_001", encode_frame(OP_BINARY, bytes([i])))
+        
+        assert len(client.queue) == 4
+        assert [entry[0] for entry in client.queue] == ['delta'] * 4
+        assert client.queue[-1][2].endswith(bytes([9]))
+        assert client.resync == {"HX711_001"}
+        assert client.frames_dropped == 2 + 7
+        manager.close()
+
+
+class TestCapture:
+    """Testes para o formato de captura .daqcap."""
+    
+    def test_data_manager_capture_sink(self, tmp_path):
+        """Testa captura paralela ao banco e leitura de intervalo sem cópia."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        manager.start_capture(tmp_path / "run.daqcap", sample_rate_hz=10.0,
+                              calibration={"HX711_001": {'calibration_factor': 2.5}})
+        readings = [_reading(i, "HX711_001" if i % 3 else "HX711_002") for i in range(3000)]
+        manager.add_readings(readings[:1000])
+        manager.flush()
+        manager.add_readings(readings[1000:])
+        manager.close()
+        
+        with CaptureReader(tmp_path / "run.daqcap") as reader:
+            assert reader.complete and reader.sample_rate_hz == 10.0
+            assert sorted(reader.sensors) == ["HX711_001", "HX711_002"]
+            assert reader.calibration("HX711_001")['calibration_factor'] == 2.5
+            assert reader.count("HX711_001") == 2000 and reader.count("HX711_002") == 1000
+            
+            start = START + timedelta(seconds=30)
+            parts = list(reader.read("HX711_002", start, start + timedelta(seconds=60)))
+            values = [v for part in parts for v in part.strain_values]
+            assert isinstance(parts[0].strain_values, memoryview)
+            assert values == [float(i) for i in range(300, 901, 3)]
+            
+            times, peaks = reader.decimate("HX711_001", width=100)
+            assert len(times) <= 2 * 100 + 4 and max(peaks) == 2999.0
+            del parts
+    
+    def test_capture_receives_writer_drained_batches(self, tmp_path):
+        """Testa que lotes retirados pelo writer (baixa taxa) também vão à captura."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        manager.start_capture(tmp_path / "slow.daqcap", sample_rate_hz=10.0)
+        manager.add_readings([_reading(i) for i in range(40)])
+
+        # Abaixo do limite de flush: só o writer retira o buffer (a cada max_latency)
+        deadline = time.monotonic() + 10.0
+        while manager.writer.readings_written < 40 and time.monotonic() < deadline:
+            time.sleep(0.05)
+        assert manager.writer.readings_written == 40
+        manager.close()
+
+        database = DatabaseManager(tmp_path / "daq.db")
+        stored = len(list(database.iter_rows()))
+        database.close()
+        with CaptureReader(tmp_path / "slow.daqcap") as reader:
+            assert reader.count("HX711_001") == stored == 40
+
+    def test_unfinished_capture_is_recovered(self, tmp_path):
+        """Testa leitura de captura sem índice final (gravação interrompida)."""
+        writer = CaptureWriter(tmp_path / "crash.daqcap", segment_records=64, index_interval=16)
+        for start in range(0, 500, 100):
+            writer.write(ReadingColumns.from_readings([_reading(i) for i in range(start, start + 100)]))
+        writer.flush()
+        
+        reader = CaptureReader(tmp_path / "crash.daqcap")
+        parts = list(reader.read("HX711_001", START + timedelta(seconds=10), START + timedelta(seconds=20)))
+        
+        assert not reader.complete and reader.count("HX711_001") == 500
+        assert [v for part in parts for v in part.strain_values] == [float(i) for i in range(100, 201)]
+        del parts
+        reader.close()
+        writer.close()
+        
+        with CaptureReader(tmp_path / "crash.daqcap") as reader:
+            assert reader.complete
+            assert list(reader.read("HX711_001", START, START))[0].raw_adc_values.tolist() == [1000]
+
+    def test_replay_through_ingest_path(self, tmp_path):
+        """Testa replay intercalado pelo protocolo até streamer e banco."""
+        with CaptureWriter(tmp_path / "field.daqcap") as writer:
+            for sensor_id in ("HX711_001", "HX711_002"):
+                writer.write(ReadingColumns.from_readings([_reading(i, sensor_id) for i in range(200)]))
+        
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        with CaptureReader(tmp_path / "field.daqcap") as reader:
+            replayer = CaptureReplayer(reader, manager, speed=None, packet_size=25)
+            delivered = []
+            original = manager.add_batch
+            manager.add_batch = lambda batch: (delivered.append(batch.sensor_id(0)),
+                                               original(batch))
+            stats = replayer.run()
+        
+        assert stats['readings'] == 400 and stats['packets'] == 16 and stats['errors'] == 0
+        assert delivered[:4] == ["HX711_001", "HX711_002", "HX711_001", "HX711_002"]
+        assert manager.database.get_aggregates("HX711_002")["HX711_002"]['count'] == 200
+        assert manager.get_realtime_values()["HX711_001"]['v'] == pytest.approx(199.0)
+        manager.close()
+    
+    def test_replay_speed_factor(self, tmp_path):
+        """Testa ritmo do replay (2 s de gravação a 10x)."""
+        with CaptureWriter(tmp_path / "rt.daqcap") as writer:
+            writer.write(ReadingColumns.from_readings([_reading(i) for i in range(21)]))
+        
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        with CaptureReader(tmp_path / "rt.daqcap") as reader:
+            started = time.perf_counter()
+            stats = CaptureReplayer(reader, manager, speed=10.0, packet_size=5).run()
+            elapsed = time.perf_counter() - started
+        
+        assert stats['readings'] == 21
+        assert 0.19 <= elapsed < 2.0
+        manager.close()
+
+
+class TestWarmStart:
+    """Testes para o snapshot de partida rápida e a restauração pelo banco."""
+    
+    @staticmethod
+    def _recent(count: int, sensor_id: str):
+        start = datetime.now() - timedelta(seconds=count)
+        return [StrainReading(timestamp=start + timedelta(milliseconds=100 * i),
+                              strain_value=float(i % 50), raw_adc_value=i,
+                              sensor_id=sensor_id, battery_level=90, temperature=25.0)
+                for i in range(count)]
+    
+    def test_snapshot_restores_windows_and_pending_batches(self, tmp_path):
+        """Testa janelas restauradas via mmap e lotes não gravados persistidos na volta."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        for sensor_id in ("HX711_001", "HX711_002"):
+            manager.add_readings(self._recent(300, sensor_id))
+        before = manager.oscilloscope_streamer.get_stream_stats()
+        manager.close()
+        assert snapshot_path(tmp_path / "daq.db").exists()
+        
+        restored = DataManager(db_path=tmp_path / "daq.db")
+        after = restored.oscilloscope_streamer.get_stream_stats()
+        window = restored.get_oscilloscope_data("HX711_002")
+        assert restored.warm_start_info['source'] == 'snapshot'
+        assert restored.warm_start_info['points'] == 600
+        assert after['sensors'] == before['sensors']
+        assert list(window.values[-3:]) == [47.0, 48.0, 49.0]
+        assert not snapshot_path(tmp_path / "daq.db").exists()
+        
+        restored.close()
+        
+        disabled = DataManager(db_path=tmp_path / "daq.db", warm_start=False)
+        assert disabled.warm_start_info['source'] is None
+        assert disabled.oscilloscope_streamer.get_stream_stats()['active_sensors'] == 0
+        disabled.close()
+    
+    def test_close_timeout_snapshots_only_unwritten_batches(self, tmp_path):
+        """Testa close com writer lento: sem leituras duplicadas nem perdidas na volta."""
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        release = threading.Event()
+        store = manager._store_batches
+        manager.writer._store = lambda batches: (release.wait(), store(batches))
+        for start in range(0, 3000, 1000):
+            manager.add_readings(self._recent(3000, "HX711_001")[start:start + 1000])
+        time.sleep(0.2)  # writer bloqueado no primeiro grupo
+        
+        manager.close(timeout=0.1)
+        with SnapshotReader(snapshot_path(tmp_path / "daq.db")) as reader:
+            snapshot_readings = sum(len(batch) for batch in reader.pending())
+        release.set()
+        assert manager.writer.close(timeout=5)
+        written = manager.writer.readings_written
+        manager.database.close()
+        
+        # Grupo em gravação fica fora do snapshot
+        assert snapshot_readings + written == 3000 and written > 0
+        restored = DataManager(db_path=tmp_path / "daq.db")
+        assert restored.flush(timeout=5)
+        stored = restored.database.get_readings(sensor_id="HX711_001")
+        assert len(stored) == len({r.timestamp for r in stored}) == 3000
+        assert restored.database.partitions.row_count() == 3000
+        restored.close()
+    
+    def test_database_tail_fallback_and_pending_restore(self, tmp_path):
+        """Testa restauração pela cauda de cada sensor e reingestão de lotes pendentes."""
+        manager = DataManager(db_path=tmp_path / "daq.db", warm_start=False)
+        manager.add_readings(self._recent(1500, "HX711_001"))
+        manager.add_readings(self._recent(20, "HX711_002"))
+        manager.close()
+        
+        pending = StrainBatch.from_readings(self._recent(5, "HX711_003"))
+        write_snapshot(snapshot_path(tmp_path / "daq.db"), _SensorStream.COLUMNS, {},
+                       [pending])
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        assert manager.warm_start_info['source'] == 'snapshot'
+        assert manager.flush(timeout=5)
+        assert len(manager.database.get_readings(sensor_id="HX711_003")) == 5
+        manager.close()
+        snapshot_path(tmp_path / "daq.db").unlink()
+        
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        stats = manager.oscilloscope_streamer.get_stream_stats()['sensors']
+        assert manager.warm_start_info['source'] == 'database'
+        assert stats['HX711_001']['points'] == config.OSCILLOSCOPE_MAX_POINTS
+        assert stats['HX711_002']['points'] == 20
+        assert list(manager.get_oscilloscope_data("HX711_001").values[-2:]) == [48.0, 49.0]
+        assert manager.warm_start_info['seconds'] < 1.0
+        manager.close()
+    
+    def test_stale_or_disabled_snapshot_still_persists_pending(self, tmp_path):
+        """Testa lotes do snapshot gravados mesmo antigo ou sem warm start; ilegível é preservado."""
+        path = snapshot_path(tmp_path / "daq.db")
+        pending = StrainBatch.from_readings(self._recent(5, "HX711_003"))
+        write_snapshot(path, _SensorStream.COLUMNS, {}, [pending])
+        data = bytearray(path.read_bytes())
+        struct.pack_into('<q', data, 16, int((time.time() - 2 * config.WARM_START_MAX_AGE) * 1e6))
+        path.write_bytes(bytes(data))
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        assert manager.warm_start_info['source'] != 'snapshot'
+        assert not path.exists()
+        assert len(manager.database.get_readings(sensor_id="HX711_003")) == 5
+        manager.close()
+        path.unlink()
+        
+        write_snapshot(path, _SensorStream.COLUMNS, {},
+                       [StrainBatch.from_readings(self._recent(7, "HX711_004"))])
+        manager = DataManager(db_path=tmp_path / "daq.db", warm_start=False)
+        assert not path.exists()
+        assert len(manager.database.get_readings(sensor_id="HX711_004")) == 7
+        manager.close()
+        
+        path.write_bytes(b'DAQSNP01 truncado')
+        manager = DataManager(db_path=tmp_path / "daq.db", warm_start=False)
+        assert not path.exists()
+        assert [f.read_bytes() for f in tmp_path.glob(path.name + '.*.failed')] == [
+            b'DAQSNP01 truncado']
+        manager.close()
+
+
+class TestShardedIngest:
+    """Testes para a ingestão em workers com rings em memória compartilhada."""
+    
+    def test_shared_ring_attach_reads_owner_writes(self):
+        """Testa ring anexado lendo índices e colunas gravados pelo dono."""
+        owner = SharedColumnRing(4, [('t', 'd'), ('r', 'i')])
+        reader = SharedColumnRing.attach(owner.name, [('t', 'd'), ('r', 'i')])
+        try:
+            owner.extend([[1.0, 2.0, 3.0, 4.0, 5.0, 6.0], [1, 2, 3, 4, 5, 6]])
+            owner.publish_stats(3.0, 6.0, 4.5)
+            
+            assert reader.capacity == 4 and reader.first_index == 2 and reader.end_index == 6
+            assert list(reader.view('t', 0, 6)) == [3.0, 4.0, 5.0, 6.0]
+            assert reader.copy('r', 4, 6).tolist() == [5, 6]
+            assert reader.read_stats() == (3.0, 6.0, 4.5)
+        finally:
+            reader.close()
+            owner.close()
+            owner.unlink()
+    
+    def test_shared_ring_releases_slots_before_overwrite(self):
+        """Testa first avançado antes da gravação e estatísticas sob seqlock."""
+        observed = []
+        
+        class ProbeRing(SharedColumnRing):
+            def _write(self, column, slot, values):
+                # Janela vista por um leitor no meio da gravação
+                observed.append((self.first_index, self.end_index))
+                super()._write(column, slot, values)
+        
+        owner = ProbeRing(4, [('t', 'd')])
+        try:
+            owner.extend([[1.0, 2.0, 3.0, 4.0]])
+            owner.extend([[5.0, 6.0]])
+            owner.extend([[7.0] * 9])
+            owner.publish_stats(7.0, 7.0, 7.0)
+            
+            assert observed[0] == (0, 0)
+            assert observed[1] == (2, 4)  # slots 0 e 1 liberados antes de sobrescrever
+            assert observed[2] == (6, 6)  # lote maior que a janela: janela vazia
+            assert (owner.first_index, owner.end_index) == (11, 15)
+            assert owner._sequence[0] % 2 == 0 and owner.read_stats() == (7.0, 7.0, 7.0)
+        finally:
+            owner.close()
+            owner.unlink()
+    
+    def test_workers_feed_streamer_and_database(self, tmp_path):
+        """Testa sensores em 2 workers, visíveis sem cópia e persistidos pelo DataManager."""
+        sensors = ["HX711_001", "HX711_002", "HX711_003", "HX711_004"]
+        streamer = OscilloscopeStreamer(max_points=100)
+        manager = DataManager(db_path=tmp_path / "daq.db", warm_start=False)
+        manager.start_capture(tmp_path / "shards.daqcap", sample_rate_hz=10.0)
+        ingest = ShardedIngest(streamer, shards=2, capacity=100,
+                               data_manager=manager, send_chunks=4)
+        
+        with ingest:
+            for start in range(0, 150, 50):
+                for sensor_id in sensors:
+                    readings = [_reading(i, sensor_id) for i in range(start, start + 50)]
+                    message = DataPacketEncoder.create_batch_message(
+                        DataPacket("", sensor_id, readings, START))
+                    # Frame partido entre blocos, como chega do link
+                    ingest.submit(sensor_id, message[:7])
+                    ingest.submit(sensor_id, message[7:])
+            assert ingest.sync(timeout=30)
+            
+            window = streamer.get_stream_data("HX711_003")
+            stats = streamer.get_stream_stats()
+            assert list(window.values) == [float(i) for i in range(50, 150)]
+            assert stats['sensors']["HX711_002"]['min_value'] == 50.0
+            assert stats['sensors']["HX711_002"]['avg_value'] == pytest.approx(99.5)
+            since, first, end = streamer.get_since("HX711_001", 140)
+            assert (first, end) == (140, 150) and since.values[0] == 140.0
+            assert {ingest.shard_for(sensor_id) for sensor_id in sensors} == {0, 1}
+            assert ingest.get_stats()['readings'] == 600
+            assert ingest.get_stats()['forwarded'] == 600
+            # Lotes entregues ao buffer do DataManager, fora do osciloscópio dele
+            assert len(list(manager.query_readings("HX711_004"))) == 150
+            assert manager.oscilloscope_streamer.get_stream_stats()['active_sensors'] == 0
+            del window, since
+        
+        assert streamer.get_stream_stats()['active_sensors'] == 0
+        manager.close()
+        database = DatabaseManager(tmp_path / "daq.db")
+        assert database.get_aggregates("HX711_004")["HX711_004"]['count'] == 150
+        database.close()
+        with CaptureReader(tmp_path / "shards.daqcap") as reader:
+            assert reader.count("HX711_002") == 150
+
+
+class TestMetrics:
+    """Testes para o registro de métricas e o endpoint /metrics."""
+    
+    def test_render_text_format(self):
+        """Testa contador, gauge rotulado e buckets cumulativos do histograma."""
+        registry = MetricsRegistry()
+        registry.counter('t_events_total', 'Eventos').inc(3)
+        registry.gauge('t_depth', 'Profundidade', ['queue']).labels('a').set(7)
+        latency = registry.histogram('t_latency_seconds', 'Latência', buckets=(0.1, 1.0))
+        for value in (0.05, 0.5, 2.0):
+            latency.observe(value)
+        
+        text = registry.render()
+        assert '# TYPE t_events_total counter\nt_events_total 3' in text
+        assert 't_depth{queue="a"} 7' in text
+        assert 't_latency_seconds_bucket{le="0.1"} 1' in text
+        assert 't_latency_seconds_bucket{le="1"} 2' in text
+        assert 't_latency_seconds_bucket{le="+Inf"} 3' in text
+        assert 't_latency_seconds_count 3' in text
+    
+    def test_link_and_ingest_series(self, tmp_path):
+        """Testa contadores por link do FrameDecoder e coletor do DataManager."""
+        decoder = FrameDecoder(link='teste_link')
+        message = MessageProtocol.create_message(MessageType.PING, {'n': 1})
+        assert len(decoder.feed(b'\x00' * 3 + message)) == 1
+        
+        manager = DataManager(db_path=tmp_path / "daq.db")
+        before = manager.get_ingest_metrics()['readings_total']
+        manager.add_readings([_reading(i) for i in range(10)])
+        
+        text = metrics.render()
+        assert f'daq_link_frames_decoded_total{{link="teste_link"}} 1' in text
+        assert f'daq_link_bytes_dropped_total{{link="teste_link"}} 3' in text
+        assert 'daq_buffer_readings 10' in text
+        assert 'daq_memory_bytes{structure="streamer"}' in text
+        assert manager.get_ingest_metrics()['readings_total'] == before + 10
+        manager.close()
+    
+    @pytest.mark.asyncio
+    async def test_http_scrape(self):
+        """Testa scrape HTTP do endpoint /metrics."""
+        registry = MetricsRegistry()
+        registry.counter('t_scraped_total', 'Teste').inc()
+        server = MetricsHTTPServer(registry, host='127.0.0.1', port=0)
+        await server.start()
+        try:
+            reader, writer = await asyncio.open_connection('127.0.0.1', server.port)
+            writer.write(b"GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n")
+            response = await asyncio.wait_for(reader.read(), 2.0)
+            writer.close()
+        finally:
+            await server.stop()
+        
+        assert response.startswith(b"HTTP/1.1 200 OK")
+        assert b"text/plain; version=0.0.4" in response
+        assert b"t_scraped_total 1" in response
+        assert server.scrapes == 1
+
+
+if __name__ == "__main__":
+    # Executa testes se arquivo for chamado diretamente
+    pytest.main([__file__, "-v"])
@@ -123,6 +123,29 @@ class TestStrainReading:
         
         # Mas ainda mantém o valor original
         assert reading.checksum == original_checksum
+    
+    def test_strain_reading_integer_timestamp(self):
+        """Testa timestamp inteiro em µs e ausência de __dict__."""
+        timestamp = datetime(2024, 1, 1, 12, 0, 0, 250)
+        reading = StrainReading(timestamp, 1.0, 10, "TEST", 50, 20.0)
+        same = StrainReading(reading.timestamp_us, 1.0, 10, "TEST", 50, 20.0)
+        
+        assert isinstance(reading.timestamp_us, int)
+        assert same.timestamp == timestamp
+        assert same == reading
+        assert not hasattr(reading, '__dict__')
+    
+    def test_strain_reading_checksum_is_deterministic(self):
+        """Testa checksum CRC32 estável entre processos e após reconstrução."""
+        reading = StrainReading(1_704_110_400_000_000, 100.0, 1000, "TEST", 50, 20.0)
+        assert reading.checksum == "76903ea6"
+        
+        # Reconstruída com o checksum recebido (ex.: banco ou outro processo)
+        received = StrainReading(reading.timestamp_us, 100.0, 1000, "TEST", 50, 20.0,
+                                 checksum=reading.checksum)
+        assert received.is_valid()
+        received.raw_adc_value = 1001
+        assert not received.is_valid()
 
 
 class TestSensorConfiguration:
@@ -0,0 +1,716 @@
+"""
+Testes unitários para o protocolo de comunicação.
+Valida o enquadramento das mensagens e a codificação colunar de lotes.
+"""
+
+import asyncio
+import json
+import math
+import random
+import struct
+import zlib
+
+import pytest
+from datetime import datetime, timedelta
+import sys
+from pathlib import Path
+
+# Adiciona diretório pai ao path para importações
+sys.path.append(str(Path(__file__).parent.parent))
+
+from src.core.models import StrainReading, StrainBatch, DataPacket
+from src.communication.protocol import (
+    MessageProtocol,
+    MessageType,
+    CompressionType,
+    PayloadEncoding,
+    DataPacketEncoder,
+    FrameDecoder,
+    ProtocolError
+)
+from src.communication.columnar import ColumnarCodec
+from src.communication.timeseries import TimeSeriesCodec, TimeSeriesDecoder, TimeSeriesEncoder
+from src.communication.transfer import FragmentSender, TransferReceiver
+from src.communication.link_manager import (
+    LinkManager, LinkState, IngestScheduler, ReconnectBackoff
+)
+from src.communication.ble_simulator import BLESimulator
+from src.core.clock import VirtualClock
+
+
+def _make_packet(count: int, sensor_id: str = "HX711_001") -> DataPacket:
+    """Cria pacote com leituras sequenciais a 10 Hz."""
+    start = datetime(2024, 1, 15, 10, 30, 0, 123456)
+    readings = [
+        StrainReading(
+            timestamp=start + timedelta(milliseconds=100 * i),
+            strain_value=245.678 - i * 1.5,
+            raw_adc_value=(-1) ** i * (1000 + i * 37),
+            sensor_id=sensor_id,
+            battery_level=85 - (i % 3),
+            temperature=23.45 + i * 0.01
+        )
+        for i in range(count)
+    ]
+    return DataPacket(
+        packet_id="PKT00001",
+        sensor_id=sensor_id,
+        readings=readings,
+        timestamp=start,
+        sequence_number=2,
+        total_packets=5
+    )
+
+
+class TestMessageProtocol:
+    """Testes para o enquadramento de mensagens."""
+
+    def test_json_message_roundtrip(self):
+        """Testa criação e análise de mensagem JSON."""
+        payload = {'error_code': 7, 'error_message': 'teste'}
+        data = MessageProtocol.create_message(MessageType.ERROR, payload)
+
+        message = MessageProtocol.parse_message(data)
+
+        assert message['type'] == MessageType.ERROR
+        assert message['encoding'] == PayloadEncoding.JSON
+        assert message['payload'] == payload
+
+    def test_zlib_message_roundtrip(self):
+        """Testa mensagem com compressão zlib."""
+        payload = {'values': list(range(200))}
+        data = MessageProtocol.create_message(
+            MessageType.STATUS_RESPONSE, payload, CompressionType.ZLIB
+        )
+
+        message = MessageProtocol.parse_message(data)
+
+        assert message['compression'] == CompressionType.ZLIB
+        assert message['payload'] == payload
+
+    def test_corrupted_payload_rejected(self):
+        """Testa rejeição de payload corrompido."""
+        data = bytearray(MessageProtocol.create_message(MessageType.PING, {'x': 1}))
+        data[-1] ^= 0xFF
+
+        with pytest.raises(ProtocolError):
+            MessageProtocol.parse_message(bytes(data))
+
+    def test_columnar_requires_data_type(self):
+        """Testa que payload colunar só é aceito em mensagens de dados."""
+        with pytest.raises(ProtocolError):
+            MessageProtocol.create_message(
+                MessageType.PING, b'\x01', encoding=PayloadEncoding.COLUMNAR
+            )
+
+
+class TestColumnarEncoding:
+    """Testes para a codificação colunar de lotes."""
+
+    def test_batch_roundtrip(self):
+        """Testa ida e volta de um lote pelo protocolo."""
+        packet = _make_packet(50)
+        data = DataPacketEncoder.create_batch_message(packet)
+
+        message = MessageProtocol.parse_message(data)
+        columns = message['payload']
+
+        assert message['type'] == MessageType.DATA_BATCH
+        assert message['encoding'] == PayloadEncoding.COLUMNAR
+        assert columns['sensor_id'] == packet.sensor_id
+        assert columns['packet_id'] == packet.packet_id
+        assert columns['sequence_number'] == 2
+        assert columns['total_packets'] == 5
+        assert columns['count'] == 50
+
+        for i, reading in enumerate(packet.readings):
+            assert columns['timestamps_us'][i] == round(reading.timestamp.timestamp() * 1e6)
+            assert columns['raw_adc_values'][i] == reading.raw_adc_value
+            assert columns['battery_levels'][i] == reading.battery_level
+            assert abs(columns['strain_values'][i] - reading.strain_value) < 0.0005
+            assert abs(columns['temperatures'][i] - reading.temperature) < 0.005
+
+    def test_int24_sign_extension(self):
+        """Testa extremos da faixa de 24 bits do ADC."""
+        packet = _make_packet(4)
+        extremes = [-2**23, -1, 0, 2**23 - 1]
+        for reading, value in zip(packet.readings, extremes):
+            reading.raw_adc_value = value
+
+        columns = ColumnarCodec.decode(ColumnarCodec.encode_packet(packet))
+
+        assert list(columns['raw_adc_values']) == extremes
+
+    def test_adc_out_of_range_rejected(self):
+        """Testa rejeição de valor ADC acima de 24 bits."""
+        packet = _make_packet(1)
+        packet.readings[0].raw_adc_value = 2**23
+
+        with pytest.raises(ProtocolError):
+            DataPacketEncoder.create_batch_message(packet)
+
+    def test_decode_to_packet(self):
+        """Testa materialização das colunas em DataPacket."""
+        packet = _make_packet(10)
+        message = MessageProtocol.parse_message(
+            DataPacketEncoder.create_batch_message(packet, MessageType.DATA_BUFFER)
+        )
+
+        decoded = DataPacketEncoder.decode_columnar_packet(message['payload'])
+
+        assert decoded.sensor_id == packet.sensor_id
+        assert len(decoded.readings) == 10
+        assert decoded.readings[3].timestamp == packet.readings[3].timestamp
+        assert decoded.readings[3].raw_adc_value == packet.readings[3].raw_adc_value
+
+    def test_decode_batch_columnar_and_json(self):
+        """Testa StrainBatch a partir de payload colunar e de pacote JSON."""
+        packet = _make_packet(10)
+        columnar = MessageProtocol.parse_message(DataPacketEncoder.create_batch_message(packet))
+        json_payload = DataPacketEncoder.encode_data_packet(packet)
+
+        for payload in (columnar['payload'], json_payload):
+            batch = DataPacketEncoder.decode_batch(payload)
+            assert len(batch) == 10 and batch.sensor_id(9) == "HX711_001"
+            assert list(batch.timestamps_us) == [r.timestamp_us for r in packet.readings]
+            assert list(batch.raw_adc_values) == [r.raw_adc_value for r in packet.readings]
+
+    def test_capacity_gain_over_json(self):
+        """Testa que o formato colunar cabe muito mais leituras por frame."""
+        limit = MessageProtocol.MAX_PAYLOAD_SIZE
+        columnar_capacity = ColumnarCodec.max_readings(limit, "PKT00001", "HX711_001")
+
+        packet = _make_packet(20)
+        json_size = len(MessageProtocol.create_message(
+            MessageType.DATA_BATCH, DataPacketEncoder.encode_data_packet(packet)
+        ))
+        json_capacity = limit // (json_size / 20)
+
+        assert columnar_capacity >= 5 * json_capacity
+
+        # O lote máximo deve caber em um único frame
+        full = _make_packet(columnar_capacity)
+        data = DataPacketEncoder.create_batch_message(full)
+        assert len(data) <= MessageProtocol.HEADER_SIZE + limit
+
+
+
+def _slow_signal(count: int) -> dict:
+    """Colunas de um sinal de strain lento amostrado a 100 Hz."""
+    start_us = 1_705_314_600_000_000
+    strain = [round(80.0 * math.sin(i / 200.0), 3) for i in range(count)]
+    return {
+        'timestamps_us': [start_us + 10_000 * i for i in range(count)],
+        'strain_values': strain,
+        'raw_adc_values': [round(s * 120) for s in strain],
+        'temperatures': [round(24.0 + i / 5000.0, 2) for i in range(count)],
+        'battery_levels': [90 - i // 250 for i in range(count)]
+    }
+
+
+class TestTimeSeriesCompression:
+    """Testes para a compressão de séries temporais (CompressionType.TIMESERIES)."""
+
+    def test_roundtrip_matches_columnar(self):
+        """Testa que o frame comprimido decodifica nas mesmas colunas do colunar."""
+        packet = _make_packet(50)
+        plain = MessageProtocol.parse_message(DataPacketEncoder.create_batch_message(packet))
+        data = DataPacketEncoder.create_batch_message(
+            packet, MessageType.DATA_BUFFER, CompressionType.TIMESERIES
+        )
+        message = MessageProtocol.parse_message(data)
+
+        assert message['compression'] == CompressionType.TIMESERIES
+        for name in ('timestamps_us', 'strain_values', 'raw_adc_values',
+                     'temperatures', 'battery_levels'):
+            assert list(message['payload'][name]) == list(plain['payload'][name])
+        assert message['payload']['sequence_number'] == 2
+        assert DataPacketEncoder.decode_batch(message['payload']).sensor_id(0) == "HX711_001"
+
+        # Transcodificação de payload colunar pelo create_message
+        transcoded = MessageProtocol.create_message(
+            MessageType.DATA_BUFFER, ColumnarCodec.encode_packet(packet),
+            CompressionType.TIMESERIES, PayloadEncoding.COLUMNAR
+        )
+        assert transcoded == data
+
+    def test_edge_values(self):
+        """Testa saltos de timestamp, sinais em torno de zero e bateria variando."""
+        columns = {
+            'timestamps_us': [0, 10, 20, 5_000_000, 5_000_007, 2**40],
+            'strain_values': [0.0, -0.001, 0.001, -8000.5, 8000.5, 0.0],
+            'raw_adc_values': [0, -1, 2**23 - 1, -2**23, 5, 5],
+            'temperatures': [-40.0, 85.0, 85.0, 0.01, -0.01, 25.0],
+            'battery_levels': [100, 100, 0, 255, 7, 7]
+        }
+        payload = TimeSeriesCodec.encode_columns("P", "S", 2**40, **columns)
+        decoded = TimeSeriesCodec.decode(payload)
+
+        for name, values in columns.items():
+            assert list(decoded[name]) == values
+
+    def test_streaming_encode_decode(self):
+        """Testa codificação em blocos e leitura incremental."""
+        columns = _slow_signal(300)
+        encoder = TimeSeriesEncoder("HX711_001", "PKT")
+        for start in range(0, 300, 70):
+            encoder.append_columns(*(columns[name][start:start + 70] for name in (
+                'timestamps_us', 'strain_values', 'raw_adc_values',
+                'temperatures', 'battery_levels')))
+        payload = encoder.finish()
+        assert len(payload) == encoder.nbytes
+        assert payload == TimeSeriesCodec.encode_columns(
+            "PKT", "HX711_001", columns['timestamps_us'][-1], **columns)
+
+        decoder = TimeSeriesDecoder(payload)
+        parts = [decoder.read(128) for _ in range(3)]
+        assert decoder.remaining == 0
+        assert sum((list(p['timestamps_us']) for p in parts), []) == columns['timestamps_us']
+        assert sum((list(p['strain_values']) for p in parts), []) == columns['strain_values']
+
+    def test_compression_ratio_on_slow_signal(self):
+        """Testa ganho sobre colunar e sobre zlib em JSON para sinal lento."""
+        columns = _slow_signal(500)
+        compressed = TimeSeriesCodec.encode_columns("PKT", "HX711_001", 0, **columns)
+        columnar = ColumnarCodec.encode_columns("PKT", "HX711_001", 0, **columns)
+        readings = [dict(zip(columns, values)) for values in zip(*columns.values())]
+        json_zlib = zlib.compress(json.dumps({'readings': readings}).encode('utf-8'))
+
+        assert len(columnar) / len(compressed) >= 3
+        assert len(json_zlib) / len(compressed) >= 2.5
+
+    def test_requires_columnar_encoding(self):
+        """Testa rejeição de TIMESERIES com payload JSON."""
+        with pytest.raises(ProtocolError):
+            MessageProtocol.create_message(
+                MessageType.DATA_BATCH, {'a': 1}, CompressionType.TIMESERIES
+            )
+
+class TestFrameDecoder:
+    """Testes para o decodificador incremental de frames."""
+
+    def _frames(self, count: int) -> list:
+        return [
+            MessageProtocol.create_message(MessageType.STATUS_RESPONSE, {'seq': i})
+            for i in range(count)
+        ]
+
+    def test_crc_matches_ccitt_false(self):
+        """Testa CRC contra o valor de verificação do CRC-16/CCITT-FALSE."""
+        assert MessageProtocol._calculate_crc16(b'123456789') == 0x29B1
+
+    def test_byte_by_byte_feed(self):
+        """Testa frames entregues um byte por vez."""
+        decoder = FrameDecoder()
+        stream = b''.join(self._frames(3))
+
+        frames = []
+        for i in range(len(stream)):
+            frames.extend(decoder.feed(stream[i:i + 1]))
+
+        assert [f.decode()['payload']['seq'] for f in frames] == [0, 1, 2]
+        assert decoder.pending_bytes == 0
+        assert decoder.bytes_dropped == 0
+
+    def test_multiple_frames_single_chunk(self):
+        """Testa vários frames no mesmo bloco, sem cópia do payload."""
+        decoder = FrameDecoder()
+        chunk = b''.join(self._frames(5))
+
+        frames = decoder.feed(memoryview(chunk))
+
+        assert len(frames) == 5
+        assert frames[0].payload.obj is chunk
+        assert decoder.frames_decoded == 5
+
+    def test_boundary_frame_copied_rest_of_chunk_not(self):
+        """Testa que só o frame que cruza blocos é copiado; os seguintes referenciam o bloco."""
+        decoder = FrameDecoder()
+        first, *rest = self._frames(4)
+        chunk = first[5:] + b''.join(rest)
+
+        assert decoder.feed(first[:5]) == []
+        frames = decoder.feed(chunk)
+
+        assert [f.decode()['payload']['seq'] for f in frames] == [0, 1, 2, 3]
+        assert frames[0].payload.obj is not chunk
+        assert all(f.payload.obj is chunk for f in frames[1:])
+        assert decoder.pending_bytes == 0
+
+    def test_resync_after_garbage(self):
+        """Testa ressincronização após lixo e frame corrompido."""
+        decoder = FrameDecoder()
+        good = self._frames(2)
+        corrupted = bytearray(good[0])
+        corrupted[-2] ^= 0x55
+
+        stream = b'\x00\x13\xDA' + bytes(corrupted) + good[1] + b'\xFF\xFF'
+        frames = []
+        for start in range(0, len(stream), 7):
+            frames.extend(decoder.feed(stream[start:start + 7]))
+
+        assert [f.decode()['payload']['seq'] for f in frames] == [1]
+        assert decoder.crc_failures == 1
+        assert decoder.bytes_dropped == len(stream) - len(good[1])
+
+    def test_columnar_frame_decode(self):
+        """Testa decodificação de frame colunar via decoder."""
+        decoder = FrameDecoder()
+        data = DataPacketEncoder.create_batch_message(_make_packet(30))
+
+        frames = decoder.feed(data[:11]) + decoder.feed(data[11:])
+
+        assert len(frames) == 1
+        assert frames[0].encoding == PayloadEncoding.COLUMNAR
+        assert frames[0].decode()['payload']['count'] == 30
+
+
+
+def _run_transfer(sender: FragmentSender, receiver: TransferReceiver,
+                  loss: float = 0.0, ack_loss: float = 0.0, seed: int = 1,
+                  max_rounds: int = 10000) -> int:
+    """Executa a transferência por um link simulado com perdas; retorna as rodadas."""
+    rng = random.Random(seed)
+    to_receiver, to_sender = FrameDecoder(), FrameDecoder()
+    now = 0.0
+    for rounds in range(1, max_rounds + 1):
+        now += 0.01
+        for message in sender.poll(now):
+            if rng.random() < loss:
+                continue
+            for frame in to_receiver.feed(message):
+                ack = receiver.handle(frame, now)
+                if ack is not None and rng.random() >= ack_loss:
+                    for ack_frame in to_sender.feed(ack):
+                        sender.handle(ack_frame)
+        if sender.complete:
+            return rounds
+    raise AssertionError("Transferência não concluída")
+
+
+class TestFragmentedTransfer:
+    """Testes para a transferência fragmentada com ACK seletivo."""
+
+    def test_large_buffer_roundtrip(self):
+        """Testa backlog acima de MAX_PAYLOAD_SIZE remontado em DATA_BUFFER."""
+        packet = _make_packet(3000)
+        sender = FragmentSender.for_packet(packet, transfer_id=7,
+                                           compression=CompressionType.NONE, mtu=244)
+        receiver = TransferReceiver()
+
+        assert sender.size > MessageProtocol.MAX_PAYLOAD_SIZE
+        _run_transfer(sender, receiver)
+
+        frames = receiver.pop_completed()
+        assert len(frames) == 1
+        assert frames[0].message_type == MessageType.DATA_BUFFER
+        batch = frames[0].to_batch()
+        assert len(batch) == 3000
+        assert list(batch.timestamps_us) == [r.timestamp_us for r in packet.readings]
+        assert sender.retransmissions == 0
+        assert receiver.get_stats()['active_transfers'] == 0
+
+    def test_lossy_link_retransmits_only_missing(self):
+        """Testa que perdas geram retransmissão seletiva, não da janela inteira."""
+        payload = bytes(random.Random(3).getrandbits(8) for _ in range(100_000))
+        sender = FragmentSender(MessageType.DATA_BUFFER, payload, transfer_id=1,
+                                mtu=244, window=64, rto=0.5)
+        receiver = TransferReceiver()
+
+        rounds = _run_transfer(sender, receiver, loss=0.1, ack_loss=0.1)
+
+        assert bytes(receiver.pop_completed()[0].payload) == payload
+        # ~10% de perda: retransmissões próximas da perda, sem repetir a janela
+        assert sender.fragments_sent < sender.total * 1.3
+        # Janela cheia por rodada: longe do stop-and-wait (uma rodada por fragmento)
+        assert rounds < sender.total / 4
+
+    def test_out_of_order_and_duplicates(self):
+        """Testa remontagem fora de ordem e reconfirmação de duplicados."""
+        payload = bytes(range(256)) * 20
+        sender = FragmentSender(MessageType.DATA_BUFFER, payload, mtu=120, window=1000)
+        receiver = TransferReceiver(ack_interval=1000)
+        messages = sender.poll(0.0)
+        decoder = FrameDecoder()
+        frames = [decoder.feed(m)[0] for m in messages]
+
+        acks = [receiver.handle(frame, 0.0) for frame in reversed(frames[1:])]
+        assert acks[0] is not None  # Buraco detectado no primeiro fragmento
+        assert receiver.handle(frames[0], 0.0) is not None
+        assert bytes(receiver.pop_completed()[0].payload) == payload
+
+        # Fragmento repetido após a conclusão: ACK final novamente
+        ack = receiver.handle(frames[3], 0.0)
+        assert sender.on_ack(FrameDecoder().feed(ack)[0].payload)
+        assert receiver.duplicates == 1
+
+    def test_crc_failure_nacks_and_restarts(self):
+        """Testa NACK após CRC32 inválido: reinício do emissor e falha explícita no limite."""
+        payload = bytes(range(256)) * 20
+
+        def run(transfer_id, corrupt_rounds):
+            sender = FragmentSender(MessageType.DATA_BUFFER, payload, transfer_id=transfer_id,
+                                    mtu=244, max_restarts=1)
+            receiver = TransferReceiver()
+            to_sender = FrameDecoder()
+            for now in range(50):
+                for message in sender.poll(float(now)):
+                    frame = FrameDecoder().feed(message)[0]
+                    index = struct.unpack_from('<H', frame.payload, 2)[0]
+                    if index == 0 and sender.restarts < corrupt_rounds:
+                        # Dado corrompido antes do enquadramento: CRC16 do frame válido
+                        data = bytearray(frame.payload)
+                        data[-1] ^= 0x01
+                        frame = FrameDecoder().feed(MessageProtocol.frame_payload(
+                            MessageType.TRANSFER_FRAGMENT, 0, bytes(data)))[0]
+                    reply = receiver.handle(frame, float(now))
+                    if reply is not None:
+                        for reply_frame in to_sender.feed(reply):
+                            sender.handle(reply_frame)
+                if sender.complete or sender.failed:
+                    break
+            return sender, receiver
+
+        sender, receiver = run(5, corrupt_rounds=1)
+        assert sender.complete and sender.restarts == 1
+        assert bytes(receiver.pop_completed()[0].payload) == payload
+        assert receiver.get_stats()['crc_failures'] == 1
+
+        sender, receiver = run(6, corrupt_rounds=2)
+        assert sender.failed and not sender.complete
+        assert sender.poll(100.0) == []
+        assert receiver.pop_completed() == []
+        assert receiver.get_stats()['crc_failures'] == 2
+
+    def test_invalid_fragment_rejected(self):
+        """Testa rejeição de fragmentos fora dos limites e MTU inválido."""
+        receiver = TransferReceiver(max_transfer_size=1024)
+        sender = FragmentSender(MessageType.DATA_BUFFER, bytes(4096), mtu=512)
+        frame = FrameDecoder().feed(sender.poll(0.0)[0])[0]
+
+        with pytest.raises(ProtocolError):
+            receiver.handle(frame)
+        with pytest.raises(ProtocolError):
+            FragmentSender(MessageType.DATA_BUFFER, b'x', mtu=20)
+
+    def test_stale_transfer_expired(self):
+        """Testa descarte de transferência incompleta após o timeout."""
+        sender = FragmentSender(MessageType.DATA_BUFFER, bytes(2000), mtu=244)
+        receiver = TransferReceiver(timeout=10.0)
+        receiver.handle(FrameDecoder().feed(sender.poll(0.0)[0])[0], 0.0)
+
+        assert receiver.expire(5.0) == 0
+        assert receiver.expire(10.0) == 1
+        assert receiver.get_stats()['transfers_failed'] == 1
+
+    def test_reassembly_limits_and_stale_eviction(self):
+        """Testa limites de transferências simultâneas e de bytes pré-alocados."""
+        def first_fragment(transfer_id, size=2000):
+            sender = FragmentSender(MessageType.DATA_BUFFER, bytes(size),
+                                    transfer_id=transfer_id, mtu=244)
+            return FrameDecoder().feed(sender.poll(0.0)[0])[0]
+
+        receiver = TransferReceiver(timeout=10.0, max_transfers=2, max_buffered_bytes=5000)
+        receiver.handle(first_fragment(1), 0.0)
+        receiver.handle(first_fragment(2), 1.0)
+        with pytest.raises(ProtocolError):
+            receiver.handle(first_fragment(3), 2.0)  # limite de transferências
+        with pytest.raises(ProtocolError):
+            receiver.handle(first_fragment(2, size=4000), 2.0)  # reinício maior que o espaço
+
+        # A transferência 1 expirou: a nova ocupa o seu lugar
+        receiver.handle(first_fragment(3), 10.0)
+        stats = receiver.get_stats()
+        assert stats['active_transfers'] == 1 and stats['buffered_bytes'] == 2000
+        assert stats['transfers_rejected'] == 2 and stats['transfers_failed'] == 1
+
+
+class TestLinkScheduler:
+    """Testes para o gerenciador de links e o escalonador de ingestão."""
+
+    def test_coalesces_batches_per_sensor(self):
+        """Testa que vários pacotes de um sensor viram um lote por drenagem."""
+        delivered = []
+        manager = LinkManager()
+        scheduler = IngestScheduler(manager, delivered.append)
+        packets = [DataPacketEncoder.create_batch_message(_make_packet(20, f"S{i % 2}"))
+                   for i in range(10)]
+        for i, message in enumerate(packets):
+            manager.receive(f"link{i % 2}", message, now=0.0)
+
+        assert scheduler.drain(now=0.0) == 200
+        assert sorted(batch.sensor_names[0] for batch in delivered) == ["S0", "S1"]
+        assert all(len(batch) == 100 for batch in delivered)
+        assert manager.queued_bytes == 0
+
+    def test_noisy_link_does_not_starve_others(self):
+        """Testa que o deficit round robin atende o link quieto na primeira fatia."""
+        delivered = []
+        manager = LinkManager()
+        scheduler = IngestScheduler(manager, delivered.append, quantum_bytes=1024)
+        noisy = DataPacketEncoder.create_batch_message(_make_packet(30, "NOISY"))
+        for _ in range(200):
+            manager.receive("noisy", noisy, now=0.0)
+        manager.receive("quiet", DataPacketEncoder.create_batch_message(_make_packet(5, "QUIET")),
+                        now=0.0)
+
+        scheduler.drain(now=0.0, budget_bytes=4 * len(noisy))
+
+        assert "QUIET" in [batch.sensor_names[0] for batch in delivered]
+        assert manager.links["noisy"].queue  # Backlog do link ruidoso continua na fila
+        scheduler.drain(now=0.0)
+        assert manager.queued_bytes == 0
+
+    def test_bounded_queue_drops_oldest(self):
+        """Testa descarte dos blocos mais antigos apenas no link cheio."""
+        delivered = []
+        message = DataPacketEncoder.create_batch_message(_make_packet(10))
+        manager = LinkManager(max_queue_bytes=3 * len(message))
+        scheduler = IngestScheduler(manager, delivered.append)
+
+        results = [manager.receive("full", message, now=0.0) for _ in range(5)]
+        manager.receive("other", message, now=0.0)
+
+        assert results == [True, True, True, False, False]
+        assert manager.links["full"].chunks_dropped == 2
+        assert manager.links["other"].chunks_dropped == 0
+        assert scheduler.drain(now=1.0) == 40
+        assert manager.links["full"].get_stats()['max_delay_ms'] == pytest.approx(1000.0)
+
+    def test_reconnect_backoff(self):
+        """Testa backoff exponencial com teto, jitter e reinício ao conectar."""
+        backoff = ReconnectBackoff(base=1.0, maximum=8.0, jitter=0.0)
+        assert [backoff.next_delay() for _ in range(5)] == [1.0, 2.0, 4.0, 8.0, 8.0]
+
+        jittered = ReconnectBackoff(base=1.0, maximum=8.0, jitter=0.5, rng=random.Random(1))
+        assert all(0.5 <= jittered.next_delay() / 2 ** i <= 1.0 for i in range(3))
+
+        manager = LinkManager(seed=1)
+        manager.connected("a")
+        delay = manager.disconnected("a", now=100.0)
+        assert manager.links["a"].state == LinkState.BACKOFF
+        assert manager.due_reconnects(now=100.0 + delay / 2) == []
+        assert manager.due_reconnects(now=100.0 + delay) == ["a"]
+        assert manager.links["a"].state == LinkState.CONNECTING
+        manager.connected("a")
+        assert manager.links["a"].backoff.attempts == 0
+
+    def test_reconnect_due_runs_attempts(self):
+        """Testa reconexão paralela e novo backoff após falha."""
+        manager = LinkManager(seed=2)
+        for address in ("ok", "fail"):
+            manager.disconnected(address, now=0.0)
+
+        async def connect(address):
+            return address == "ok"
+
+        assert asyncio.run(manager.reconnect_due(connect, now=1000.0)) == 1
+        assert manager.links["ok"].state == LinkState.CONNECTED
+        assert manager.links["fail"].state == LinkState.BACKOFF
+        assert manager.links["fail"].backoff.attempts == 2
+
+    def test_disconnect_resets_decoder_in_queue_order(self):
+        """Testa que a queda só descarta o frame parcial depois dos blocos enfileirados."""
+        delivered = []
+        manager = LinkManager()
+        scheduler = IngestScheduler(manager, delivered.append)
+        message = DataPacketEncoder.create_batch_message(_make_packet(10))
+
+        manager.connected("node")
+        manager.receive("node", message + message[:len(message) // 2], now=0.0)
+        manager.disconnected("node", now=0.0)
+        manager.receive("node", message, now=0.0)
+        scheduler.drain(now=0.0)
+
+        decoder = manager.links["node"].decoder
+        assert sum(len(batch) for batch in delivered) == 20
+        assert decoder.crc_failures == 0 and decoder.invalid_headers == 0
+        assert decoder.bytes_dropped == len(message) // 2
+
+    def test_send_acks_keeps_unsent_in_order(self):
+        """Testa envio das outboxes só em links conectados, preservando ACKs não enviados."""
+        manager = LinkManager()
+        for address in ("up", "flaky"):
+            manager.connected(address)
+            manager.link(address).outbox.extend([b"a1", b"a2"])
+        manager.link("down").outbox.append(b"d1")
+        sent = []
+
+        async def send(address, data):
+            if address == "flaky" and data == b"a2":
+                return False
+            sent.append((address, data))
+            return True
+
+        assert asyncio.run(manager.send_acks(send)) == 3
+        assert sorted(sent) == [("flaky", b"a1"), ("up", b"a1"), ("up", b"a2")]
+        assert list(manager.links["flaky"].outbox) == [b"a2"]
+        assert list(manager.links["down"].outbox) == [b"d1"]
+
+    def test_ble_links_share_one_task_and_slow_callbacks_do_not_block(self):
+        """Testa manutenção das conexões BLE em uma task e callbacks sem espera em série."""
+        clock = VirtualClock()
+        ble = BLESimulator(clock=clock, rng=random.Random(3))
+        manager = LinkManager()
+        manager.attach(ble)
+        received = []
+
+        async def slow_consumer(address, data):
+            await clock.sleep(3600)
+
+        ble.add_data_callback(slow_consumer)
+        ble.add_data_callback(lambda address, data: received.append(address))
+
+        async def scenario():
+            for address in ble.discovered_devices:
+                manager.track(address, now=0.0)
+            while any(link.state != LinkState.CONNECTED for link in manager.links.values()):
+                await manager.reconnect_due(ble.connect, now=1e9)
+            await clock.sleep(30)
+            tasks = [task for task in asyncio.all_tasks() if task not in ble._callback_tasks]
+            slow = len(ble._callback_tasks)
+            await ble.stop()
+            return len(tasks), slow
+
+        tasks, slow = clock.run(scenario())
+
+        assert tasks == 2  # cenário + manutenção única das conexões
+        assert slow > len(ble.discovered_devices)  # consumidor lento ainda pendente
+        assert set(received) == set(ble.discovered_devices)
+        assert all(link.state == LinkState.BACKOFF for link in manager.links.values())
+
+    def test_fragmented_transfer_over_link(self):
+        """Testa remontagem por link com ACKs na outbox."""
+        delivered = []
+        manager = LinkManager()
+        scheduler = IngestScheduler(manager, delivered.append)
+        sender = FragmentSender.for_packet(_make_packet(1000), transfer_id=3, mtu=244)
+
+        for message in sender.poll(0.0):
+            manager.receive("node", message, now=0.0)
+        while not sender.complete:
+            scheduler.drain(now=0.0)
+            link = manager.links["node"]
+            while link.outbox:
+                for frame in FrameDecoder().feed(link.outbox.popleft()):
+                    sender.handle(frame)
+            for message in sender.poll(0.0):
+                manager.receive("node", message, now=0.0)
+
+        assert sum(len(batch) for batch in delivered) == 1000
+
+    def test_strain_batch_concat(self):
+        """Testa junção de lotes com sensores diferentes."""
+        first = StrainBatch.from_readings(_make_packet(3, "A").readings)
+        second = StrainBatch.from_readings(_make_packet(2, "B").readings +
+                                           _make_packet(1, "A").readings)
+        merged = StrainBatch.concat([first, second])
+
+        assert len(merged) == 6
+        assert [merged.sensor_id(i) for i in range(6)] == ["A", "A", "A", "B", "B", "A"]
+        assert list(merged.strain_values) == (list(first.strain_values) +
+                                              list(second.strain_values))
+
+if __name__ == "__main__":
+    # Executa testes se arquivo for chamado diretamente
+    pytest.main([__file__, "-v"])